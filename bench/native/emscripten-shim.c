@@ -0,0 +1,147 @@
+#define _GNU_SOURCE
+#include <assert.h>
+#include <errno.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "emscripten/emscripten.h"
+#include "emscripten/threading.h"
+#include "emscripten-shim.h"
+
+double emscripten_get_now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+int emscripten_num_logical_cores(void) {
+	long cores = sysconf(_SC_NPROCESSORS_ONLN);
+	return cores > 0 ? (int)cores : 1;
+}
+
+/* Main thread call queue */
+
+typedef struct _MainThreadCall {
+	void (*func)(void *, float);
+	void *arg;
+	float delta;
+	int sync;
+	int done;
+	struct _MainThreadCall *next;
+} MainThreadCall;
+
+static pthread_mutex_t call_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t call_queued = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t call_done = PTHREAD_COND_INITIALIZER;
+static MainThreadCall *call_head = NULL;
+static MainThreadCall *call_tail = NULL;
+
+static void queue_call(MainThreadCall *call) {
+	call->next = NULL;
+	if (call_tail) {
+		call_tail->next = call;
+	} else {
+		call_head = call;
+	}
+	call_tail = call;
+	pthread_cond_signal(&call_queued);
+}
+
+static void run_in_main_thread(int sig, void *func_ptr, va_list args, int sync) {
+	assert(sig == EM_FUNC_SIG_VIF);
+
+	MainThreadCall stack_call;
+	MainThreadCall *call = sync ? &stack_call : malloc(sizeof(MainThreadCall));
+	call->func = (void (*)(void *, float))func_ptr;
+	call->arg = va_arg(args, void *);
+	call->delta = (float)va_arg(args, double);
+	call->sync = sync;
+	call->done = 0;
+
+	pthread_mutex_lock(&call_mutex);
+	queue_call(call);
+	if (sync) {
+		while (!call->done) {
+			pthread_cond_wait(&call_done, &call_mutex);
+		}
+	}
+	pthread_mutex_unlock(&call_mutex);
+}
+
+void emscripten_sync_run_in_main_runtime_thread_(int sig, void *func_ptr, ...) {
+	va_list args;
+	va_start(args, func_ptr);
+	run_in_main_thread(sig, func_ptr, args, 1);
+	va_end(args);
+}
+
+void emscripten_async_run_in_main_runtime_thread_(int sig, void *func_ptr, ...) {
+	va_list args;
+	va_start(args, func_ptr);
+	run_in_main_thread(sig, func_ptr, args, 0);
+	va_end(args);
+}
+
+int ogv_native_run_main_thread_calls(double timeout_ms) {
+	pthread_mutex_lock(&call_mutex);
+	if (!call_head && timeout_ms > 0) {
+		struct timespec deadline;
+		clock_gettime(CLOCK_REALTIME, &deadline);
+		long long ns = deadline.tv_nsec + (long long)(timeout_ms * 1000000.0);
+		deadline.tv_sec += ns / 1000000000LL;
+		deadline.tv_nsec = ns % 1000000000LL;
+		while (!call_head) {
+			if (pthread_cond_timedwait(&call_queued, &call_mutex, &deadline) == ETIMEDOUT) {
+				break;
+			}
+		}
+	}
+	MainThreadCall *calls = call_head;
+	call_head = NULL;
+	call_tail = NULL;
+	pthread_mutex_unlock(&call_mutex);
+
+	int count = 0;
+	while (calls) {
+		MainThreadCall *call = calls;
+		calls = call->next;
+		call->func(call->arg, call->delta);
+		count++;
+		if (call->sync) {
+			pthread_mutex_lock(&call_mutex);
+			call->done = 1;
+			pthread_cond_broadcast(&call_done);
+			pthread_mutex_unlock(&call_mutex);
+		} else {
+			free(call);
+		}
+	}
+	return count;
+}
+
+/* Futexes */
+
+int emscripten_futex_wait(volatile void *addr, uint32_t val, double maxWaitMilliseconds) {
+	struct timespec timeout, *timeoutp = NULL;
+	if (!isinf(maxWaitMilliseconds)) {
+		timeout.tv_sec = (time_t)(maxWaitMilliseconds / 1000.0);
+		timeout.tv_nsec = (long)(fmod(maxWaitMilliseconds, 1000.0) * 1000000.0);
+		timeoutp = &timeout;
+	}
+	if (syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, val, timeoutp, NULL, 0) < 0) {
+		return -errno;
+	}
+	return 0;
+}
+
+int emscripten_futex_wake(volatile void *addr, int count) {
+	long ret = syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, count < 0 ? INT_MAX : count, NULL, NULL, 0);
+	return ret < 0 ? -errno : (int)ret;
+}
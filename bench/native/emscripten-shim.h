@@ -0,0 +1,13 @@
+#ifndef OGV_NATIVE_EMSCRIPTEN_SHIM_H
+#define OGV_NATIVE_EMSCRIPTEN_SHIM_H
+
+/**
+ * Run any calls that decode threads have queued for the main thread,
+ * as emscripten's runtime would from the browser event loop.
+ *
+ * @param timeout_ms how long to wait if nothing is queued yet
+ * @return number of calls run
+ */
+extern int ogv_native_run_main_thread_calls(double timeout_ms);
+
+#endif
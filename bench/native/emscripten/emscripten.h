@@ -0,0 +1,10 @@
+#ifndef OGV_NATIVE_EMSCRIPTEN_H
+#define OGV_NATIVE_EMSCRIPTEN_H
+
+// Native stand-ins for the few Emscripten APIs used by src/c,
+// implemented in bench/native/emscripten-shim.c for ogv-bench.
+
+extern double emscripten_get_now(void);
+extern int emscripten_num_logical_cores(void);
+
+#endif
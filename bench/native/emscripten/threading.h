@@ -0,0 +1,15 @@
+#ifndef OGV_NATIVE_EMSCRIPTEN_THREADING_H
+#define OGV_NATIVE_EMSCRIPTEN_THREADING_H
+
+#include <stdint.h>
+
+// Only the signatures actually used by src/c are supported.
+#define EM_FUNC_SIG_VIF 1
+
+extern void emscripten_sync_run_in_main_runtime_thread_(int sig, void *func_ptr, ...);
+extern void emscripten_async_run_in_main_runtime_thread_(int sig, void *func_ptr, ...);
+
+extern int emscripten_futex_wait(volatile void *addr, uint32_t val, double maxWaitMilliseconds);
+extern int emscripten_futex_wake(volatile void *addr, int count);
+
+#endif
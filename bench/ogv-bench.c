@@ -0,0 +1,713 @@
+/**
+ * Headless native demux/decode benchmark for the src/c modules.
+ *
+ * Each demuxer and decoder is built as its own shared object (see
+ * buildscripts/compileNativeBench.sh) and loaded on demand by codec
+ * name, much as the JS side loads one emscripten module per codec.
+ * This file supplies the ogvjs_callback_* hooks those modules expect.
+ *
+ * Usage: ogv-bench [--threads] [--crc] [--chunk-size bytes]
+ *                  [--join offset] [--rgba WxH] [--audio-rate hz] [--tempo x]
+ *                  [--module-dir dir] file.ogv|file.webm
+ *
+ * --join feeds only the file's headers, then picks up the input at the
+ * given byte offset the way a late joiner to a live stream would.
+ *
+ * --rgba switches the decoder to RGBA output, scaled to WxH; 0x0 keeps
+ * the frame size.
+ *
+ * --audio-rate and --tempo run decoded audio through the audio decoder's
+ * resampler and tempo stage, as the player does for the audio device.
+ */
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <libgen.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+
+#include "native/emscripten/emscripten.h"
+#include "native/emscripten-shim.h"
+
+/* Options */
+
+static int opt_threads = 0;
+static int opt_crc = 0;
+static size_t opt_chunk_size = 65536;
+static long opt_join = -1;
+static int opt_rgba = 0;
+static int opt_rgba_width = 0;
+static int opt_rgba_height = 0;
+static int opt_audio_rate = 0;
+static double opt_tempo = 1.0;
+static const char *opt_module_dir = NULL;
+
+/* Timing */
+
+static double cpu_now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static double process_cpu_now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static double demux_time = 0.0;
+static double video_time = 0.0;
+static double audio_time = 0.0;
+static double output_time = 0.0;
+
+/* CRC-32, same polynomial as bench/crc32.js */
+
+static uint32_t crc_table[256];
+
+static void crc_init(void) {
+	for (uint32_t i = 0; i < 256; i++) {
+		uint32_t c = i;
+		for (int k = 0; k < 8; k++) {
+			c = (c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1);
+		}
+		crc_table[i] = c;
+	}
+}
+
+static uint32_t crc_update(uint32_t crc, const unsigned char *data, size_t len) {
+	for (size_t i = 0; i < len; i++) {
+		crc = crc_table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+	}
+	return crc;
+}
+
+/* Packet queues, filled by the demuxer callbacks */
+
+typedef struct {
+	char *data;
+	size_t len;
+	float timestamp;
+	double discardPadding;
+} Packet;
+
+typedef struct {
+	Packet *items;
+	size_t start;
+	size_t len;
+	size_t max;
+} PacketQueue;
+
+static PacketQueue videoPackets;
+static PacketQueue audioPackets;
+
+static void packet_push(PacketQueue *queue, const char *buffer, size_t len, float timestamp, double discardPadding) {
+	if (queue->start + queue->len == queue->max) {
+		if (queue->start > 0) {
+			memmove(queue->items, queue->items + queue->start, queue->len * sizeof(Packet));
+			queue->start = 0;
+		} else {
+			queue->max = queue->max ? queue->max * 2 : 64;
+			queue->items = realloc(queue->items, queue->max * sizeof(Packet));
+		}
+	}
+	Packet *packet = &queue->items[queue->start + queue->len++];
+	// The demuxer's buffer is only valid during the callback.
+	packet->data = malloc(len ? len : 1);
+	memcpy(packet->data, buffer, len);
+	packet->len = len;
+	packet->timestamp = timestamp;
+	packet->discardPadding = discardPadding;
+}
+
+static Packet *packet_peek(PacketQueue *queue) {
+	return queue->len ? &queue->items[queue->start] : NULL;
+}
+
+static void packet_shift(PacketQueue *queue) {
+	free(queue->items[queue->start].data);
+	queue->start++;
+	queue->len--;
+}
+
+/* Module loading */
+
+// Each module hands back an opaque per-stream handle from create(),
+// which every other entry point and callback takes first.
+
+typedef struct {
+	void *(*create)(void);
+	void (*receive_input)(void *demuxer, const char *buffer, int bufsize);
+	int (*process)(void *demuxer);
+	void (*destroy)(void *demuxer);
+	void (*resync)(void *demuxer);
+	void *handle;
+} DemuxerModule;
+
+typedef struct {
+	void *(*create)(void);
+	int (*async)(void *decoder);
+	int (*process_header)(void *decoder, const char *data, size_t data_len);
+	int (*process_frame)(void *decoder, const char *data, size_t data_len);
+	void (*destroy)(void *decoder);
+	void (*stats)(void *decoder);
+	void (*release_frame)(void *decoder, int slot, unsigned int serial);
+	void (*set_rgba_output)(void *decoder, int enabled, int width, int height, int matrix, int fullRange);
+	void *handle;
+} VideoDecoderModule;
+
+typedef struct {
+	void *(*create)(void);
+	int (*process_header)(void *decoder, const char *data, size_t data_len);
+	int (*process_audio)(void *decoder, const char *data, size_t data_len, double discardPadding);
+	void (*set_output_rate)(void *decoder, int rate);
+	void (*set_tempo)(void *decoder, double tempo);
+	int (*drain)(void *decoder);
+	void (*destroy)(void *decoder);
+	void *handle;
+} AudioDecoderModule;
+
+static void *load_module(const char *name) {
+	char path[4096];
+	snprintf(path, sizeof(path), "%s/%s.so", opt_module_dir, name);
+	void *handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+	if (!handle) {
+		fprintf(stderr, "ogv-bench: %s\n", dlerror());
+		exit(1);
+	}
+	return handle;
+}
+
+static void *load_symbol(void *handle, const char *name) {
+	void *sym = dlsym(handle, name);
+	if (!sym) {
+		fprintf(stderr, "ogv-bench: missing %s\n", name);
+		exit(1);
+	}
+	return sym;
+}
+
+/* Callback state */
+
+static char *videoCodec = NULL;
+static char *audioCodec = NULL;
+static int loadedMetadata = 0;
+static int videoFormatKnown = 0;
+static int audioFormatKnown = 0;
+
+static int framesDecoded = 0;
+static VideoDecoderModule videoDecoder;
+static long long samplesDecoded = 0;
+
+// Packets handed to an async decoder, in submission order. The data
+// must stay valid until the decoder reports back on it.
+typedef struct {
+	double submitTime;
+	float timestamp;
+	char *data;
+} PendingPacket;
+
+static PendingPacket *pending = NULL;
+static size_t pendingStart = 0;
+static size_t pendingLen = 0;
+static size_t pendingMax = 0;
+
+static double *latencies = NULL;
+static size_t latencyLen = 0;
+static size_t latencyMax = 0;
+
+static double lastFrameTime = 0.0;
+static float frameTimestamp = -1;
+static double firstFrameTime = -1;
+static float firstFrameTimestamp = -1;
+
+static void record_latency(double ms) {
+	if (latencyLen == latencyMax) {
+		latencyMax = latencyMax ? latencyMax * 2 : 1024;
+		latencies = realloc(latencies, latencyMax * sizeof(double));
+	}
+	latencies[latencyLen++] = ms;
+}
+
+static void pending_push(double submitTime, float timestamp, char *data) {
+	if (pendingStart + pendingLen == pendingMax) {
+		memmove(pending, pending + pendingStart, pendingLen * sizeof(PendingPacket));
+		pendingStart = 0;
+		if (pendingLen == pendingMax) {
+			pendingMax = pendingMax ? pendingMax * 2 : 256;
+			pending = realloc(pending, pendingMax * sizeof(PendingPacket));
+		}
+	}
+	PendingPacket *packet = &pending[pendingStart + pendingLen++];
+	packet->submitTime = submitTime;
+	packet->timestamp = timestamp;
+	packet->data = data;
+}
+
+// Timestamp of the packet a frame callback belongs to. An async decoder
+// reports frames back while the packet is still at the head of the
+// pending queue, which may be well behind the last one submitted.
+static float output_timestamp(void) {
+	if (pendingLen > 0) {
+		return pending[pendingStart].timestamp;
+	}
+	return frameTimestamp;
+}
+
+void ogvjs_callback_init_audio(void *handle, int channels, int rate) {
+	audioFormatKnown = 1;
+}
+
+void ogvjs_callback_init_video(void *handle,
+                               int frameWidth, int frameHeight,
+                               int chromaWidth, int chromaHeight,
+                               double fps,
+                               int picWidth, int picHeight,
+                               int picX, int picY,
+                               int displayWidth, int displayHeight) {
+	videoFormatKnown = 1;
+}
+
+void ogvjs_callback_loaded_metadata(void *handle, const char *videoCodecStr, const char *audioCodecStr) {
+	videoCodec = videoCodecStr ? strdup(videoCodecStr) : NULL;
+	audioCodec = audioCodecStr ? strdup(audioCodecStr) : NULL;
+	loadedMetadata = 1;
+}
+
+void ogvjs_callback_video_packet(void *handle, const char *buffer, size_t len, float frameTimestamp, float keyframeTimestamp, int isKeyframe) {
+	packet_push(&videoPackets, buffer, len, frameTimestamp, 0);
+}
+
+void ogvjs_callback_audio_packet(void *handle, const char *buffer, size_t len, float audioTimestamp, double discardPadding) {
+	packet_push(&audioPackets, buffer, len, audioTimestamp, discardPadding);
+}
+
+int ogvjs_callback_frame_ready(void *handle) {
+	return videoPackets.len > 0;
+}
+
+int ogvjs_callback_audio_ready(void *handle) {
+	return audioPackets.len > 0;
+}
+
+void ogvjs_callback_seek(void *handle, int64_t offset) {
+	// Input is read straight through; nothing to do.
+}
+
+void ogvjs_callback_frame(void *handle, int slot, unsigned int serial,
+                          unsigned char *bufferY,
+                          unsigned char *bufferCb,
+                          unsigned char *bufferCr,
+                          int width, int height,
+                          int chromaWidth, int chromaHeight,
+                          int displayWidth, int displayHeight) {
+	double start = cpu_now();
+
+	// Planes arrive cropped and packed, as JS reads them in place.
+	if (opt_crc) {
+		uint32_t crc = 0xffffffff;
+		crc = crc_update(crc, bufferY, (size_t)width * height);
+		crc = crc_update(crc, bufferCb, (size_t)chromaWidth * chromaHeight);
+		crc = crc_update(crc, bufferCr, (size_t)chromaWidth * chromaHeight);
+		printf("frame %d %.3f %08x\n", framesDecoded, output_timestamp(), crc ^ 0xffffffff);
+	}
+	if (!framesDecoded) {
+		firstFrameTime = emscripten_get_now();
+		firstFrameTimestamp = output_timestamp();
+	}
+	framesDecoded++;
+	videoDecoder.release_frame(handle, slot, serial);
+
+	output_time += cpu_now() - start;
+}
+
+void ogvjs_callback_frame_rgba(void *handle, int slot, unsigned int serial,
+                               unsigned char *bufferRGBA,
+                               int width, int height,
+                               int picWidth, int picHeight,
+                               int displayWidth, int displayHeight) {
+	double start = cpu_now();
+
+	if (opt_crc) {
+		uint32_t crc = crc_update(0xffffffff, bufferRGBA, (size_t)width * height * 4);
+		printf("frame %d %.3f %08x\n", framesDecoded, output_timestamp(), crc ^ 0xffffffff);
+	}
+	if (!framesDecoded) {
+		firstFrameTime = emscripten_get_now();
+		firstFrameTimestamp = output_timestamp();
+	}
+	framesDecoded++;
+	videoDecoder.release_frame(handle, slot, serial);
+
+	output_time += cpu_now() - start;
+}
+
+void ogvjs_callback_async_complete(void *handle, int ret, double cpuTime) {
+	double now = emscripten_get_now();
+	if (pendingLen > 0) {
+		PendingPacket *packet = &pending[pendingStart++];
+		pendingLen--;
+		if (packet->data) {
+			record_latency(now - packet->submitTime);
+			free(packet->data);
+		}
+	}
+	if (ret) {
+		lastFrameTime = now;
+	}
+}
+
+void ogvjs_callback_stat(void *handle, const char *name, double value) {
+	printf("  %-20s %g\n", name, value);
+}
+
+void ogvjs_callback_audio(void *handle, float **buffers, int channels, int sampleCount, double duration) {
+	samplesDecoded += sampleCount;
+}
+
+/* Main loop */
+
+static DemuxerModule demuxer;
+static AudioDecoderModule audioDecoder;
+static int hasVideoDecoder = 0;
+static int hasAudioDecoder = 0;
+static int videoAsync = 0;
+
+static void load_demuxer(const unsigned char *magic, size_t len) {
+	const char *name;
+	if (len >= 4 && memcmp(magic, "OggS", 4) == 0) {
+		name = "ogv-demuxer-ogg";
+	} else if (len >= 4 && memcmp(magic, "\x1a\x45\xdf\xa3", 4) == 0) {
+		name = "ogv-demuxer-webm";
+	} else {
+		fprintf(stderr, "ogv-bench: unrecognized file type\n");
+		exit(1);
+	}
+	void *handle = load_module(name);
+	demuxer.create = load_symbol(handle, "ogv_demuxer_create");
+	demuxer.receive_input = load_symbol(handle, "ogv_demuxer_receive_input");
+	demuxer.process = load_symbol(handle, "ogv_demuxer_process");
+	demuxer.destroy = load_symbol(handle, "ogv_demuxer_destroy");
+	demuxer.resync = load_symbol(handle, "ogv_demuxer_resync");
+}
+
+/**
+ * Length of the headers at the start of a file, as a live host would
+ * cache them for late joiners: everything before the first WebM Cluster,
+ * or the Ogg pages before the first one with a granulepos past zero.
+ * @returns 0 if they don't fit in the data given
+ */
+static size_t init_segment_length(const unsigned char *data, size_t len) {
+	if (len >= 4 && memcmp(data, "OggS", 4) == 0) {
+		size_t pos = 0;
+		while (pos + 27 <= len && memcmp(data + pos, "OggS", 4) == 0) {
+			int64_t granulepos = 0;
+			for (int i = 7; i >= 0; i--) {
+				granulepos = granulepos << 8 | data[pos + 6 + i];
+			}
+			if (granulepos > 0) {
+				return pos;
+			}
+			size_t segments = data[pos + 26];
+			size_t size = 27 + segments;
+			if (pos + size > len) {
+				break;
+			}
+			for (size_t i = 0; i < segments; i++) {
+				size += data[pos + 27 + i];
+			}
+			pos += size;
+		}
+		return 0;
+	}
+	for (size_t i = 0; i + 4 <= len; i++) {
+		if (memcmp(data + i, "\x1f\x43\xb6\x75", 4) == 0) {
+			return i;
+		}
+	}
+	return 0;
+}
+
+static void load_decoders(void) {
+	char name[256];
+	if (videoCodec) {
+		snprintf(name, sizeof(name), "ogv-decoder-video-%s%s", videoCodec,
+		         opt_threads ? "-mt" : "");
+		void *handle = load_module(name);
+		videoDecoder.create = load_symbol(handle, "ogv_video_decoder_create");
+		videoDecoder.async = load_symbol(handle, "ogv_video_decoder_async");
+		videoDecoder.process_header = load_symbol(handle, "ogv_video_decoder_process_header");
+		videoDecoder.process_frame = load_symbol(handle, "ogv_video_decoder_process_frame");
+		videoDecoder.destroy = load_symbol(handle, "ogv_video_decoder_destroy");
+		videoDecoder.stats = load_symbol(handle, "ogv_video_decoder_stats");
+		videoDecoder.release_frame = load_symbol(handle, "ogv_video_decoder_release_frame");
+		videoDecoder.set_rgba_output = load_symbol(handle, "ogv_video_decoder_set_rgba_output");
+		videoDecoder.handle = videoDecoder.create();
+		if (opt_rgba) {
+			videoDecoder.set_rgba_output(videoDecoder.handle, 1, opt_rgba_width, opt_rgba_height, 0, 0);
+		}
+		videoAsync = videoDecoder.async(videoDecoder.handle);
+		hasVideoDecoder = 1;
+	}
+	if (audioCodec) {
+		snprintf(name, sizeof(name), "ogv-decoder-audio-%s", audioCodec);
+		void *handle = load_module(name);
+		audioDecoder.create = load_symbol(handle, "ogv_audio_decoder_create");
+		audioDecoder.process_header = load_symbol(handle, "ogv_audio_decoder_process_header");
+		audioDecoder.process_audio = load_symbol(handle, "ogv_audio_decoder_process_audio");
+		audioDecoder.set_output_rate = load_symbol(handle, "ogv_audio_decoder_set_output_rate");
+		audioDecoder.set_tempo = load_symbol(handle, "ogv_audio_decoder_set_tempo");
+		audioDecoder.drain = load_symbol(handle, "ogv_audio_decoder_drain");
+		audioDecoder.destroy = load_symbol(handle, "ogv_audio_decoder_destroy");
+		audioDecoder.handle = audioDecoder.create();
+		audioDecoder.set_output_rate(audioDecoder.handle, opt_audio_rate);
+		audioDecoder.set_tempo(audioDecoder.handle, opt_tempo);
+		hasAudioDecoder = 1;
+	}
+}
+
+static void decode_video_packet(Packet *packet) {
+	double cpuStart = cpu_now();
+	double outputStart = output_time;
+	double wallStart = emscripten_get_now();
+	frameTimestamp = packet->timestamp;
+
+	if (!videoFormatKnown) {
+		int ret = videoDecoder.process_header(videoDecoder.handle, packet->data, packet->len);
+		if (ret && videoFormatKnown && videoAsync) {
+			// The packet that ended the headers was queued as the first
+			// frame, from a copy; wait on its completion like the rest.
+			pending_push(wallStart, packet->timestamp, NULL);
+		}
+	} else if (videoAsync) {
+		while (!videoDecoder.process_frame(videoDecoder.handle, packet->data, packet->len)) {
+			// Decode queue is full; wait for something to come back.
+			ogv_native_run_main_thread_calls(1000.0);
+		}
+		pending_push(wallStart, packet->timestamp, packet->data);
+		packet->data = NULL;
+	} else {
+		if (videoDecoder.process_frame(videoDecoder.handle, packet->data, packet->len)) {
+			lastFrameTime = emscripten_get_now();
+			record_latency(lastFrameTime - wallStart);
+		}
+	}
+
+	video_time += (cpu_now() - cpuStart) - (output_time - outputStart);
+}
+
+static void decode_audio_packet(Packet *packet) {
+	double start = cpu_now();
+	if (!audioFormatKnown) {
+		audioDecoder.process_header(audioDecoder.handle, packet->data, packet->len);
+	} else {
+		audioDecoder.process_audio(audioDecoder.handle, packet->data, packet->len, packet->discardPadding);
+	}
+	audio_time += cpu_now() - start;
+}
+
+static void run_async_calls(double timeout_ms) {
+	double cpuStart = cpu_now();
+	double outputStart = output_time;
+	ogv_native_run_main_thread_calls(timeout_ms);
+	video_time += (cpu_now() - cpuStart) - (output_time - outputStart);
+}
+
+static int compare_doubles(const void *a, const void *b) {
+	double x = *(const double *)a, y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+static double percentile(double p) {
+	if (latencyLen == 0) {
+		return 0.0;
+	}
+	size_t i = (size_t)(p / 100.0 * (latencyLen - 1) + 0.5);
+	return latencies[i];
+}
+
+static void usage(void) {
+	fprintf(stderr, "usage: ogv-bench [--threads] [--crc] [--chunk-size bytes] [--join offset] [--rgba WxH]\n"
+	                "                 [--audio-rate hz] [--tempo x] [--module-dir dir] file\n");
+	exit(1);
+}
+
+int main(int argc, char **argv) {
+	const char *filename = NULL;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--threads") == 0) {
+			opt_threads = 1;
+		} else if (strcmp(argv[i], "--crc") == 0) {
+			opt_crc = 1;
+		} else if (strcmp(argv[i], "--chunk-size") == 0 && i + 1 < argc) {
+			opt_chunk_size = strtoul(argv[++i], NULL, 10);
+		} else if (strcmp(argv[i], "--join") == 0 && i + 1 < argc) {
+			opt_join = strtol(argv[++i], NULL, 10);
+		} else if (strcmp(argv[i], "--rgba") == 0 && i + 1 < argc) {
+			if (sscanf(argv[++i], "%dx%d", &opt_rgba_width, &opt_rgba_height) != 2) {
+				usage();
+			}
+			opt_rgba = 1;
+		} else if (strcmp(argv[i], "--audio-rate") == 0 && i + 1 < argc) {
+			opt_audio_rate = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--tempo") == 0 && i + 1 < argc) {
+			opt_tempo = atof(argv[++i]);
+		} else if (strcmp(argv[i], "--module-dir") == 0 && i + 1 < argc) {
+			opt_module_dir = argv[++i];
+		} else if (argv[i][0] == '-' || filename) {
+			usage();
+		} else {
+			filename = argv[i];
+		}
+	}
+	if (!filename || opt_chunk_size == 0) {
+		usage();
+	}
+	if (!opt_module_dir) {
+		// Modules live in lib/ next to the binary by default.
+		static char dir[4096];
+		char self[4096];
+		snprintf(self, sizeof(self), "%s", argv[0]);
+		snprintf(dir, sizeof(dir), "%s/lib", dirname(self));
+		opt_module_dir = dir;
+	}
+	crc_init();
+
+	FILE *file = fopen(filename, "rb");
+	if (!file) {
+		perror(filename);
+		return 1;
+	}
+	char *chunk = malloc(opt_chunk_size);
+	size_t chunkLen = fread(chunk, 1, opt_chunk_size, file);
+	load_demuxer((unsigned char *)chunk, chunkLen);
+
+	double wallStart = emscripten_get_now();
+	double processStart = process_cpu_now();
+	double start = cpu_now();
+	demuxer.handle = demuxer.create();
+	int eof = (chunkLen < opt_chunk_size);
+	if (opt_join >= 0) {
+		char head[65536];
+		fseek(file, 0, SEEK_SET);
+		size_t initLen = init_segment_length((unsigned char *)head, fread(head, 1, sizeof(head), file));
+		if (!initLen) {
+			fprintf(stderr, "ogv-bench: can't find the end of the headers\n");
+			return 1;
+		}
+		demuxer.receive_input(demuxer.handle, head, (int)initLen);
+		demuxer.resync(demuxer.handle);
+		fseek(file, opt_join, SEEK_SET);
+		chunkLen = fread(chunk, 1, opt_chunk_size, file);
+		eof = (chunkLen < opt_chunk_size);
+	}
+	demuxer.receive_input(demuxer.handle, chunk, (int)chunkLen);
+	demux_time += cpu_now() - start;
+
+	while (1) {
+		if (loadedMetadata && !hasVideoDecoder && !hasAudioDecoder) {
+			load_decoders();
+		}
+		if (videoAsync) {
+			run_async_calls(0);
+		}
+
+		Packet *packet;
+		if (hasVideoDecoder && (packet = packet_peek(&videoPackets))) {
+			decode_video_packet(packet);
+			packet_shift(&videoPackets);
+			continue;
+		}
+		if (hasAudioDecoder && (packet = packet_peek(&audioPackets))) {
+			decode_audio_packet(packet);
+			packet_shift(&audioPackets);
+			continue;
+		}
+
+		start = cpu_now();
+		int more = demuxer.process(demuxer.handle);
+		demux_time += cpu_now() - start;
+		if (more) {
+			continue;
+		}
+		if (eof) {
+			break;
+		}
+		chunkLen = fread(chunk, 1, opt_chunk_size, file);
+		eof = (chunkLen < opt_chunk_size);
+		start = cpu_now();
+		demuxer.receive_input(demuxer.handle, chunk, (int)chunkLen);
+		demux_time += cpu_now() - start;
+	}
+
+	if (hasAudioDecoder && audioFormatKnown) {
+		// Collect what the output stage is holding back, as the player
+		// does at the end of the stream.
+		start = cpu_now();
+		audioDecoder.drain(audioDecoder.handle);
+		audio_time += cpu_now() - start;
+	}
+
+	if (videoAsync) {
+		// Flush out frames the decoder is holding on to, then wait
+		// until the decode thread goes quiet.
+		while (!videoDecoder.process_frame(videoDecoder.handle, NULL, 0)) {
+			run_async_calls(1000.0);
+		}
+		pending_push(emscripten_get_now(), frameTimestamp, NULL);
+		do {
+			run_async_calls(0);
+		} while (ogv_native_run_main_thread_calls(500.0) > 0);
+	}
+
+	double wallTime = (lastFrameTime > 0 ? lastFrameTime : emscripten_get_now()) - wallStart;
+	double processTime = process_cpu_now() - processStart;
+	if (videoAsync) {
+		// Work on the decoder's own threads counts as decoding.
+		video_time += processTime - (demux_time + video_time + audio_time + output_time);
+	}
+
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	qsort(latencies, latencyLen, sizeof(double), compare_doubles);
+
+	printf("file:        %s\n", filename);
+	printf("codecs:      %s / %s%s\n", videoCodec ? videoCodec : "-", audioCodec ? audioCodec : "-",
+	       videoAsync ? " (threaded)" : "");
+	printf("frames:      %d in %.1f ms, %.2f fps\n", framesDecoded, wallTime,
+	       wallTime > 0 ? framesDecoded * 1000.0 / wallTime : 0.0);
+	printf("samples:     %lld\n", samplesDecoded);
+	printf("cpu time:    demux %.1f ms, video %.1f ms, audio %.1f ms, output %.1f ms, total %.1f ms\n",
+	       demux_time, video_time, audio_time, output_time, processTime);
+	if (opt_join >= 0) {
+		printf("join:        at byte %ld, first frame %.3f s after %.1f ms\n", opt_join,
+		       firstFrameTimestamp, firstFrameTime - wallStart);
+	}
+	printf("latency:     p50 %.2f ms, p90 %.2f ms, p99 %.2f ms, max %.2f ms\n",
+	       percentile(50), percentile(90), percentile(99), percentile(100));
+	printf("peak rss:    %ld KiB\n", usage.ru_maxrss);
+	if (hasVideoDecoder) {
+		printf("decoder stats:\n");
+		videoDecoder.stats(videoDecoder.handle);
+	}
+
+	fclose(file);
+	free(chunk);
+	if (hasAudioDecoder) {
+		audioDecoder.destroy(audioDecoder.handle);
+	}
+	if (hasVideoDecoder) {
+		videoDecoder.destroy(videoDecoder.handle);
+		if (videoAsync) {
+			// Threaded teardown finishes on the main thread once the
+			// decode thread has exited.
+			while (ogv_native_run_main_thread_calls(500.0) > 0) {
+			}
+		}
+	}
+	demuxer.destroy(demuxer.handle);
+	return 0;
+}
@@ -0,0 +1,20 @@
+#!/bin/bash
+
+# Decodes each file with the single-threaded and threaded native video
+# decoders and checks they output the same frames, by timestamp and CRC.
+
+BENCH=build/native/ogv-bench
+
+status=0
+for file in "$@"; do
+  single=$($BENCH --crc "$file" | grep '^frame ')
+  threaded=$($BENCH --threads --crc "$file" | grep '^frame ')
+  if [ "$single" != "$threaded" ]; then
+    echo "$file: threaded decode differs ($(echo "$single" | grep -c .) vs $(echo "$threaded" | grep -c .) frames)"
+    diff <(echo "$single") <(echo "$threaded") | head -5
+    status=1
+  else
+    echo "$file: $(echo "$single" | grep -c .) frames match"
+  fi
+done
+exit $status
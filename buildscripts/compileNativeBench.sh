@@ -0,0 +1,75 @@
+#!/bin/bash
+
+# Builds each of our C modules as a host shared library, plus the
+# ogv-bench driver that loads them.
+
+CC=${CC:-cc}
+CFLAGS=${CFLAGS:--O2 -g}
+
+ROOT=build/native/root
+OUT=build/native
+LIB=$OUT/lib
+
+mkdir -p $LIB
+
+module() {
+  name=$1
+  shift
+  $CC $CFLAGS -fPIC -shared \
+    -Ibench/native \
+    -I$ROOT/include \
+    "$@" \
+    -o $LIB/$name.so || exit 1
+}
+
+module ogv-demuxer-ogg \
+  src/c/ogv-demuxer-ogg.c src/c/ogv-buffer-queue.c src/c/ogv-seek-index.c \
+  -L$ROOT/lib -lskeleton -loggz -logg
+
+module ogv-demuxer-webm \
+  src/c/ogv-demuxer-webm.c src/c/ogv-buffer-queue.c src/c/ogv-seek-index.c \
+  -L$ROOT/lib -lnestegg
+
+module ogv-decoder-audio-vorbis \
+  src/c/ogv-decoder-audio-vorbis.c src/c/ogv-audio-output.c src/c/ogv-ogg-support.c \
+  -L$ROOT/lib -lvorbis -logg -lm
+
+module ogv-decoder-audio-opus \
+  src/c/ogv-decoder-audio-opus.c src/c/ogv-audio-output.c src/c/ogv-ogg-support.c \
+  src/c/opus_header.c src/c/opus_helper.c \
+  -L$ROOT/lib -lopus -logg -lm
+
+for mt in "" "-mt"; do
+  if [ "$mt" = "-mt" ]; then
+    threads="-D__EMSCRIPTEN_PTHREADS__ -pthread"
+  else
+    threads=""
+  fi
+
+  module ogv-decoder-video-theora$mt $threads \
+    src/c/ogv-decoder-video-theora.c src/c/ogv-frame-ring.c src/c/ogv-rgba-output.c src/c/ogv-ogg-support.c \
+    -L$ROOT/lib -ltheoradec -logg
+
+  module ogv-decoder-video-vp8$mt $threads \
+    -D OGV_VP8 \
+    src/c/ogv-decoder-video-vpx.c src/c/ogv-frame-ring.c src/c/ogv-rgba-output.c \
+    -L$ROOT/lib -lvpx -lm
+
+  module ogv-decoder-video-vp9$mt $threads \
+    -D OGV_VP9 \
+    src/c/ogv-decoder-video-vpx.c src/c/ogv-frame-ring.c src/c/ogv-rgba-output.c \
+    -L$ROOT/lib -lvpx -lm
+
+  module ogv-decoder-video-av1$mt $threads \
+    src/c/ogv-decoder-video-av1.c src/c/ogv-frame-ring.c src/c/ogv-rgba-output.c \
+    -L$ROOT/lib -ldav1d -lm
+done
+
+# The modules resolve the ogvjs_callback_* functions and the emscripten
+# shims against the executable.
+$CC $CFLAGS -rdynamic -pthread \
+  -Ibench \
+  bench/ogv-bench.c \
+  bench/native/emscripten-shim.c \
+  -ldl -lm \
+  -o $OUT/ogv-bench
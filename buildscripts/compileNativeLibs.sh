@@ -0,0 +1,86 @@
+#!/bin/bash
+
+# Host-native builds of the bundled codec libraries, for bench/ogv-bench.
+# Assembly is left off and libvpx uses the generic target so that the
+# same C code paths get exercised as in the wasm builds.
+
+dir=`pwd`
+
+# set up the build directory
+mkdir -p build
+cd build
+
+mkdir -p native
+cd native
+
+mkdir -p root
+
+for lib in libogg libvorbis libopus libtheora libskeleton liboggz libnestegg; do
+  mkdir -p $lib
+  cd $lib
+  case $lib in
+    libtheora)
+      extra="--disable-oggtest --with-ogg=$dir/build/native/root --disable-asm --disable-examples --disable-encode --enable-threads"
+      ;;
+    libvorbis)
+      extra="--disable-oggtest --with-ogg=$dir/build/native/root"
+      ;;
+    libopus)
+      extra="--disable-asm --disable-intrinsics --disable-doc --disable-extra-programs"
+      ;;
+    *)
+      extra=""
+      ;;
+  esac
+  CFLAGS="-O2 -fPIC" \
+  PKG_CONFIG_PATH="$dir/build/native/root/lib/pkgconfig" \
+    ../../../$lib/configure \
+      --prefix="$dir/build/native/root" \
+      --disable-shared \
+      $extra \
+  || exit 1
+  make -j4 || exit 1
+  make install || exit 1
+  cd ..
+done
+
+# compile libvpx
+mkdir -p libvpx
+cd libvpx
+../../../libvpx/configure \
+    --prefix="$dir/build/native/root" \
+    --target=generic-gnu \
+    --enable-pic \
+    --enable-multithread \
+    --enable-vp9-decoder \
+    --disable-vp8-encoder \
+    --disable-vp9-encoder \
+    --disable-shared \
+    --disable-docs \
+    --disable-examples \
+    --disable-tools \
+    --disable-unit-tests \
+|| exit 1
+make -j4 || exit 1
+make install || exit 1
+cd ..
+
+# compile dav1d
+mkdir -p dav1d
+cd dav1d
+meson ../../../dav1d \
+  --prefix="$dir/build/native/root" \
+  --libdir=lib \
+  -Denable_asm=false \
+  -Denable_tests=false \
+  -Denable_tools=false \
+  -Dbitdepths='["8"]' \
+  -Ddefault_library=static \
+  -Db_staticpic=true \
+  --buildtype release && \
+ninja -v && \
+ninja install || exit 1
+cd ..
+
+cd ..
+cd ..
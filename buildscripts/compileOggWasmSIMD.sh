@@ -0,0 +1,29 @@
+#!/bin/bash
+
+dir=`pwd`
+
+# set up the build directory
+mkdir -p build
+cd build
+
+mkdir -p wasm-simd
+cd wasm-simd
+
+mkdir -p root
+mkdir -p libogg
+cd libogg
+
+# finally, run configuration script
+CFLAGS="-O3 -s WASM=1 -msimd128" \
+  emconfigure ../../../libogg/configure \
+    --prefix="$dir/build/wasm-simd/root" \
+    --disable-shared \
+|| exit 1
+
+# compile libogg
+emmake make -j4 || exit 1
+emmake make install || exit 1
+
+cd ..
+cd ..
+cd ..
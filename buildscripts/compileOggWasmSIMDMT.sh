@@ -0,0 +1,30 @@
+#!/bin/bash
+
+dir=`pwd`
+
+# set up the build directory
+mkdir -p build
+cd build
+
+mkdir -p wasm-simd-mt
+cd wasm-simd-mt
+
+mkdir -p root
+mkdir -p libogg
+cd libogg
+
+# finally, run configuration script
+CFLAGS="-O3 -pthread -s USE_PTHREADS=1 -s WASM=1 -msimd128" \
+LDFLAGS=-pthread \
+  emconfigure ../../../libogg/configure \
+    --prefix="$dir/build/wasm-simd-mt/root" \
+    --disable-shared \
+|| exit 1
+
+# compile libogg
+emmake make -j4 || exit 1
+emmake make install || exit 1
+
+cd ..
+cd ..
+cd ..
@@ -14,6 +14,7 @@ emcc \
   --pre-js src/js/modules/ogv-module-pre.js \
   --post-js src/js/modules/ogv-decoder-audio.js \
   src/c/ogv-decoder-audio-opus.c \
+  src/c/ogv-audio-output.c \
   src/c/ogv-ogg-support.c \
   src/c/opus_header.c \
   src/c/opus_helper.c \
@@ -35,6 +36,7 @@ emcc \
   --pre-js src/js/modules/ogv-module-pre.js \
   --post-js src/js/modules/ogv-decoder-audio.js \
   src/c/ogv-decoder-audio-opus.c \
+  src/c/ogv-audio-output.c \
   src/c/ogv-ogg-support.c \
   src/c/opus_header.c \
   src/c/opus_helper.c \
@@ -14,6 +14,7 @@ emcc \
   --pre-js src/js/modules/ogv-module-pre.js \
   --post-js src/js/modules/ogv-decoder-audio.js \
   src/c/ogv-decoder-audio-vorbis.c \
+  src/c/ogv-audio-output.c \
   src/c/ogv-ogg-support.c \
   -Lbuild/js/root/lib \
   -lvorbis \
@@ -31,6 +32,7 @@ emcc \
   --pre-js src/js/modules/ogv-module-pre.js \
   --post-js src/js/modules/ogv-decoder-audio.js \
   src/c/ogv-decoder-audio-vorbis.c \
+  src/c/ogv-audio-output.c \
   src/c/ogv-ogg-support.c \
   -Lbuild/js/root/lib \
   -lvorbis \
@@ -0,0 +1,23 @@
+#!/bin/bash
+
+. ./buildscripts/compile-options.sh
+
+# compile wrapper around libogg + libvorbis
+emcc \
+  $EMCC_COMMON_OPTIONS \
+  $EMCC_WASM_OPTIONS \
+  $EMCC_NOTHREAD_OPTIONS \
+  -msimd128 \
+  -s EXPORT_NAME="'OGVDecoderAudioVorbisSIMDW'" \
+  -s EXPORTED_FUNCTIONS="`< src/js/modules/ogv-decoder-audio-exports.json`" \
+  -Ibuild/wasm-simd/root/include \
+  --js-library src/js/modules/ogv-decoder-audio-callbacks.js \
+  --pre-js src/js/modules/ogv-module-pre.js \
+  --post-js src/js/modules/ogv-decoder-audio.js \
+  src/c/ogv-decoder-audio-vorbis.c \
+  src/c/ogv-audio-output.c \
+  src/c/ogv-ogg-support.c \
+  -Lbuild/wasm-simd/root/lib \
+  -lvorbis \
+  -logg \
+  -o build/ogv-decoder-audio-vorbis-simd-wasm.js
@@ -14,6 +14,8 @@ emcc \
   --pre-js src/js/modules/ogv-module-pre.js \
   --post-js src/js/modules/ogv-decoder-video.js \
   src/c/ogv-decoder-video-av1.c \
+  src/c/ogv-frame-ring.c \
+  src/c/ogv-rgba-output.c \
   -Lbuild/wasm-mt/root/lib \
   -ldav1d \
   -o build/ogv-decoder-video-av1-mt-wasm.js
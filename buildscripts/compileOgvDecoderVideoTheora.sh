@@ -14,6 +14,8 @@ emcc \
   --pre-js src/js/modules/ogv-module-pre.js \
   --post-js src/js/modules/ogv-decoder-video.js \
   src/c/ogv-decoder-video-theora.c \
+  src/c/ogv-frame-ring.c \
+  src/c/ogv-rgba-output.c \
   src/c/ogv-ogg-support.c \
   -Lbuild/js/root/lib \
   -logg \
@@ -31,6 +33,8 @@ emcc \
   --pre-js src/js/modules/ogv-module-pre.js \
   --post-js src/js/modules/ogv-decoder-video.js \
   src/c/ogv-decoder-video-theora.c \
+  src/c/ogv-frame-ring.c \
+  src/c/ogv-rgba-output.c \
   src/c/ogv-ogg-support.c \
   -Lbuild/js/root/lib \
   -ltheora \
@@ -0,0 +1,23 @@
+#!/bin/bash
+
+. ./buildscripts/compile-options.sh
+
+# compile wrapper around libogg + libtheora
+emcc \
+  $EMCC_COMMON_OPTIONS \
+  $EMCC_WASM_OPTIONS \
+  $EMCC_THREADED_OPTIONS \
+  -s EXPORT_NAME="'OGVDecoderVideoTheoraMTW'" \
+  -s EXPORTED_FUNCTIONS="`< src/js/modules/ogv-decoder-video-exports.json`" \
+  -Ibuild/wasm-mt/root/include \
+  --js-library src/js/modules/ogv-decoder-video-callbacks.js \
+  --pre-js src/js/modules/ogv-module-pre.js \
+  --post-js src/js/modules/ogv-decoder-video.js \
+  src/c/ogv-decoder-video-theora.c \
+  src/c/ogv-frame-ring.c \
+  src/c/ogv-rgba-output.c \
+  src/c/ogv-ogg-support.c \
+  -Lbuild/wasm-mt/root/lib \
+  -ltheora \
+  -logg \
+  -o build/ogv-decoder-video-theora-mt-wasm.js
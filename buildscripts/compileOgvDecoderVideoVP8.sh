@@ -15,6 +15,8 @@ emcc \
   --post-js src/js/modules/ogv-decoder-video.js \
   -D OGV_VP8 \
   src/c/ogv-decoder-video-vpx.c \
+  src/c/ogv-frame-ring.c \
+  src/c/ogv-rgba-output.c \
   -Lbuild/js/root/lib \
   -lvpx \
   -o build/ogv-decoder-video-vp8.js \
@@ -33,6 +35,8 @@ emcc \
   --post-js src/js/modules/ogv-decoder-video.js \
   -D OGV_VP8 \
   src/c/ogv-decoder-video-vpx.c \
+  src/c/ogv-frame-ring.c \
+  src/c/ogv-rgba-output.c \
   -Lbuild/wasm/root/lib \
   -lvpx \
   -o build/ogv-decoder-video-vp8-wasm.js
@@ -15,6 +15,8 @@ emcc \
   --post-js src/js/modules/ogv-decoder-video.js \
   -D OGV_VP9 \
   src/c/ogv-decoder-video-vpx.c \
+  src/c/ogv-frame-ring.c \
+  src/c/ogv-rgba-output.c \
   -Lbuild/wasm-mt/root/lib \
   -lvpx \
   -o build/ogv-decoder-video-vp9-mt-wasm.js
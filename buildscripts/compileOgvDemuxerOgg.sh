@@ -15,6 +15,7 @@ emcc \
   --post-js src/js/modules/ogv-demuxer.js \
   src/c/ogv-demuxer-ogg.c \
   src/c/ogv-buffer-queue.c \
+  src/c/ogv-seek-index.c \
   -Lbuild/js/root/lib \
   -lskeleton \
   -loggz \
@@ -33,6 +34,7 @@ emcc \
   --post-js src/js/modules/ogv-demuxer.js \
   src/c/ogv-demuxer-ogg.c \
   src/c/ogv-buffer-queue.c \
+  src/c/ogv-seek-index.c \
   -Lbuild/js/root/lib \
   -lskeleton \
   -loggz \
@@ -15,6 +15,7 @@ emcc \
   --post-js src/js/modules/ogv-demuxer.js \
   src/c/ogv-demuxer-webm.c \
   src/c/ogv-buffer-queue.c \
+  src/c/ogv-seek-index.c \
   -Lbuild/js/root/lib \
   -lnestegg \
   -o build/ogv-demuxer-webm.js \
@@ -31,6 +32,7 @@ emcc \
   --post-js src/js/modules/ogv-demuxer.js \
   src/c/ogv-demuxer-webm.c \
   src/c/ogv-buffer-queue.c \
+  src/c/ogv-seek-index.c \
   -Lbuild/js/root/lib \
   -lnestegg \
   -o build/ogv-demuxer-webm-wasm.js
@@ -0,0 +1,33 @@
+#!/bin/bash
+
+dir=`pwd`
+
+# set up the build directory
+mkdir -p build
+cd build
+
+mkdir -p wasm-simd
+cd wasm-simd
+
+mkdir -p root
+mkdir -p libopus
+cd libopus
+
+# finally, run configuration script
+emconfigure ../../../libopus/configure \
+  --disable-asm \
+  --disable-intrinsics \
+  --enable-simd128 \
+  --disable-doc \
+  --disable-extra-programs \
+  --prefix="$dir/build/wasm-simd/root" \
+  --disable-shared \
+  CFLAGS="-O3 -s WASM=1 -msimd128" || exit 1
+
+# compile libopus
+emmake make -j4 || exit 1
+emmake make install || exit 1
+
+cd ..
+cd ..
+cd ..
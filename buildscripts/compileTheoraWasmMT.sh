@@ -0,0 +1,36 @@
+#!/bin/bash
+
+dir=`pwd`
+
+# set up the build directory
+mkdir -p build
+cd build
+
+mkdir -p wasm-mt
+cd wasm-mt
+
+mkdir -p root
+mkdir -p libtheora
+cd libtheora
+
+# finally, run configuration script
+CFLAGS="-O3 -pthread -s USE_PTHREADS=1 -s WASM=1" \
+LDFLAGS=-pthread \
+  emconfigure ../../../libtheora/configure \
+    --disable-oggtest \
+    --prefix="$dir/build/wasm-mt/root" \
+    --with-ogg="$dir/build/wasm-mt/root" \
+    --disable-asm \
+    --disable-examples \
+    --disable-encode \
+    --disable-shared \
+    --enable-threads \
+|| exit 1
+
+# compile libtheora
+emmake make -j4 || exit 1
+emmake make install || exit 1
+
+cd ..
+cd ..
+cd ..
@@ -0,0 +1,35 @@
+#!/bin/bash
+
+dir=`pwd`
+
+# set up the build directory
+mkdir -p build
+cd build
+
+mkdir -p wasm-simd
+cd wasm-simd
+
+mkdir -p root
+mkdir -p libtheora
+cd libtheora
+
+# finally, run configuration script
+CFLAGS="-O3 -s WASM=1 -msimd128" \
+  emconfigure ../../../libtheora/configure \
+    --disable-oggtest \
+    --prefix="$dir/build/wasm-simd/root" \
+    --with-ogg="$dir/build/wasm-simd/root" \
+    --disable-asm \
+    --disable-examples \
+    --disable-encode \
+    --disable-shared \
+    --enable-simd128 \
+|| exit 1
+
+# compile libtheora
+emmake make -j4 || exit 1
+emmake make install || exit 1
+
+cd ..
+cd ..
+cd ..
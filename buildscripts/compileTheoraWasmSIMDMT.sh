@@ -0,0 +1,37 @@
+#!/bin/bash
+
+dir=`pwd`
+
+# set up the build directory
+mkdir -p build
+cd build
+
+mkdir -p wasm-simd-mt
+cd wasm-simd-mt
+
+mkdir -p root
+mkdir -p libtheora
+cd libtheora
+
+# finally, run configuration script
+CFLAGS="-O3 -pthread -s USE_PTHREADS=1 -s WASM=1 -msimd128" \
+LDFLAGS=-pthread \
+  emconfigure ../../../libtheora/configure \
+    --disable-oggtest \
+    --prefix="$dir/build/wasm-simd-mt/root" \
+    --with-ogg="$dir/build/wasm-simd-mt/root" \
+    --disable-asm \
+    --disable-examples \
+    --disable-encode \
+    --disable-shared \
+    --enable-threads \
+    --enable-simd128 \
+|| exit 1
+
+# compile libtheora
+emmake make -j4 || exit 1
+emmake make install || exit 1
+
+cd ..
+cd ..
+cd ..
@@ -0,0 +1,32 @@
+#!/bin/bash
+
+dir=`pwd`
+
+# set up the build directory
+mkdir -p build
+cd build
+
+mkdir -p wasm-simd
+cd wasm-simd
+
+mkdir -p root
+mkdir -p libvorbis
+cd libvorbis
+
+# finally, run configuration script
+CFLAGS="-O3 -s WASM=1 -msimd128" \
+  emconfigure ../../../libvorbis/configure \
+    --disable-oggtest \
+    --prefix="$dir/build/wasm-simd/root" \
+    --with-ogg="$dir/build/wasm-simd/root" \
+    --disable-shared \
+    --enable-simd128 \
+|| exit 1
+
+# compile libvorbis
+emmake make -j4 || exit 1
+emmake make install || exit 1
+
+cd ..
+cd ..
+cd ..
@@ -45,6 +45,8 @@ typedef struct Dav1dRef Dav1dRef;
 
 #define DAV1D_MAX_FRAME_THREADS 256
 #define DAV1D_MAX_TILE_THREADS 64
+#define DAV1D_MAX_THREADS 64
+#define DAV1D_MAX_FRAME_DELAY 256
 
 typedef struct Dav1dLogger {
     void *cookie; ///< Custom data to pass to the callback.
@@ -65,7 +67,11 @@ typedef struct Dav1dSettings {
     int operating_point; ///< select an operating point for scalable AV1 bitstreams (0 - 31)
     int all_layers; ///< output all spatial layers of a scalable AV1 biststream
     unsigned frame_size_limit; ///< maximum frame size, in pixels (0 = unlimited)
-    uint8_t reserved[32]; ///< reserved for future use
+    int n_threads; ///< size of the worker pool shared by frame, tile and post-filter
+                   ///< tasks (0 = n_frame_threads * n_tile_threads)
+    int max_frame_delay; ///< frames decoded in parallel, trading latency for throughput
+                         ///< (0 = n_frame_threads, or about sqrt(n_threads) if that is set)
+    uint8_t reserved[24]; ///< reserved for future use
     Dav1dPicAllocator allocator;
     Dav1dLogger logger;
 } Dav1dSettings;
@@ -4097,7 +4097,8 @@ void dav1d_cdf_thread_copy(CdfContext *const dst, const CdfThreadContext *const
 }
 
 int dav1d_cdf_thread_alloc(CdfThreadContext *const cdf,
-                           struct thread_data *const t)
+                           struct TaskThreadData *const t,
+                           const unsigned seq)
 {
     cdf->ref = dav1d_ref_create(sizeof(CdfContext) +
                                 (t != NULL) * sizeof(atomic_uint));
@@ -4107,6 +4108,7 @@ int dav1d_cdf_thread_alloc(CdfThreadContext *const cdf,
         cdf->progress = (atomic_uint *) &cdf->data.cdf[1];
         atomic_init(cdf->progress, 0);
         cdf->t = t;
+        cdf->seq = seq;
     }
     return 0;
 }
@@ -4131,7 +4133,8 @@ void dav1d_cdf_thread_wait(CdfThreadContext *const cdf) {
     if (atomic_load(cdf->progress)) return;
     pthread_mutex_lock(&cdf->t->lock);
     while (!atomic_load(cdf->progress))
-        pthread_cond_wait(&cdf->t->cond, &cdf->t->lock);
+        if (!dav1d_task_thread_help(cdf->t, cdf->seq))
+            pthread_cond_wait(&cdf->t->cond, &cdf->t->lock);
     pthread_mutex_unlock(&cdf->t->lock);
 }
 
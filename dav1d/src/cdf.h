@@ -135,12 +135,14 @@ typedef struct CdfThreadContext {
         CdfContext *cdf; // if ref != NULL
         unsigned qcat; // if ref == NULL, from static CDF tables
     } data;
-    struct thread_data *t;
+    struct TaskThreadData *t;
+    unsigned seq;
     atomic_uint *progress;
 } CdfThreadContext;
 
 void dav1d_cdf_thread_init_static(CdfThreadContext *cdf, int qidx);
-int dav1d_cdf_thread_alloc(CdfThreadContext *cdf, struct thread_data *t);
+int dav1d_cdf_thread_alloc(CdfThreadContext *cdf, struct TaskThreadData *t,
+                           unsigned seq);
 void dav1d_cdf_thread_copy(CdfContext *dst, const CdfThreadContext *src);
 void dav1d_cdf_thread_ref(CdfThreadContext *dst, CdfThreadContext *src);
 void dav1d_cdf_thread_unref(CdfThreadContext *cdf);
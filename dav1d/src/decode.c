@@ -2387,7 +2387,7 @@ static void setup_tile(Dav1dTileState *const ts,
         ts->lr_ref[p]->sgr_weights[1] = 31;
     }
 
-    if (f->n_tc > 1)
+    if (f->c->n_workers)
         atomic_init(&ts->progress, row_sb_start);
 }
 
@@ -2602,91 +2602,33 @@ int dav1d_decode_frame(Dav1dFrameContext *const f) {
     const Dav1dContext *const c = f->c;
     int retval = DAV1D_ERR(ENOMEM);
 
-    if (f->n_tc > 1) {
-        const int titsati_sz = f->frame_hdr->tiling.cols * f->sbh;
-        if (titsati_sz != f->tile_thread.titsati_sz) {
-            freep(&f->tile_thread.task_idx_to_sby_and_tile_idx);
-            f->tile_thread.task_idx_to_sby_and_tile_idx =
-                malloc(sizeof(*f->tile_thread.task_idx_to_sby_and_tile_idx) *
-                       titsati_sz);
-            if (!f->tile_thread.task_idx_to_sby_and_tile_idx) {
-                f->tile_thread.titsati_sz = 0;
-                goto error;
-            }
-            f->tile_thread.titsati_sz = titsati_sz;
-        }
-        if (f->tile_thread.titsati_init[0] != f->frame_hdr->tiling.cols ||
-            f->tile_thread.titsati_init[1] != f->frame_hdr->tiling.rows ||
-            memcmp(f->frame_hdr->tiling.row_start_sb, f->tile_thread.titsati_index_rows,
-                   sizeof(*f->tile_thread.titsati_index_rows) *
-                       (f->frame_hdr->tiling.rows + 1)))
-        {
-            for (int tile_row = 0, tile_idx = 0;
-                 tile_row < f->frame_hdr->tiling.rows; tile_row++)
-            {
-                for (int sby = f->frame_hdr->tiling.row_start_sb[tile_row];
-                     sby < f->frame_hdr->tiling.row_start_sb[tile_row + 1]; sby++)
-                {
-                    for (int tile_col = 0; tile_col < f->frame_hdr->tiling.cols;
-                         tile_col++, tile_idx++)
-                    {
-                        f->tile_thread.task_idx_to_sby_and_tile_idx[tile_idx][0] = sby;
-                        f->tile_thread.task_idx_to_sby_and_tile_idx[tile_idx][1] =
-                            tile_row * f->frame_hdr->tiling.cols + tile_col;
-                    }
-                }
-            }
-            f->tile_thread.titsati_init[0] = f->frame_hdr->tiling.cols;
-            f->tile_thread.titsati_init[1] = f->frame_hdr->tiling.rows;
-            memcpy(f->tile_thread.titsati_index_rows, f->frame_hdr->tiling.row_start_sb,
-                   sizeof(*f->tile_thread.titsati_index_rows) *
-                       (f->frame_hdr->tiling.rows + 1));
+    const int n_ts = f->frame_hdr->tiling.cols * f->frame_hdr->tiling.rows;
+    if (c->n_workers && n_ts > f->task_thread.tiles_sz) {
+        freep(&f->task_thread.tiles);
+        f->task_thread.tiles = malloc(sizeof(*f->task_thread.tiles) * n_ts);
+        if (!f->task_thread.tiles) {
+            f->task_thread.tiles_sz = 0;
+            goto error;
         }
+        f->task_thread.tiles_sz = n_ts;
     }
-
-    const int n_ts = f->frame_hdr->tiling.cols * f->frame_hdr->tiling.rows;
     if (n_ts != f->n_ts) {
         if (c->n_fc > 1) {
             freep(&f->frame_thread.tile_start_off);
             f->frame_thread.tile_start_off =
                 malloc(sizeof(*f->frame_thread.tile_start_off) * n_ts);
             if (!f->frame_thread.tile_start_off) {
-                for (int n = 0; n < f->n_ts; n++) {
-                    Dav1dTileState *const ts = &f->ts[n];
-                    pthread_cond_destroy(&ts->tile_thread.cond);
-                    pthread_mutex_destroy(&ts->tile_thread.lock);
-                }
                 f->n_ts = 0;
                 goto error;
             }
         }
-        Dav1dTileState *ts_new = dav1d_alloc_aligned(sizeof(*f->ts) * n_ts, 32);
-        if (!ts_new) goto error;
-        if (n_ts > f->n_ts) {
-            if (f->ts) {
-                memcpy(ts_new, f->ts, sizeof(*f->ts) * f->n_ts);
-                dav1d_free_aligned(f->ts);
-            }
-            f->ts = ts_new;
-            for (int n = f->n_ts; n < n_ts; f->n_ts = ++n) {
-                Dav1dTileState *const ts = &f->ts[n];
-                if (pthread_mutex_init(&ts->tile_thread.lock, NULL)) goto error;
-                if (pthread_cond_init(&ts->tile_thread.cond, NULL)) {
-                    pthread_mutex_destroy(&ts->tile_thread.lock);
-                    goto error;
-                }
-            }
-        } else {
-            for (int n = n_ts; n < f->n_ts; n++) {
-                Dav1dTileState *const ts = &f->ts[n];
-                pthread_cond_destroy(&ts->tile_thread.cond);
-                pthread_mutex_destroy(&ts->tile_thread.lock);
-            }
-            memcpy(ts_new, f->ts, sizeof(*f->ts) * n_ts);
-            dav1d_free_aligned(f->ts);
-            f->n_ts = n_ts;
-            f->ts = ts_new;
+        dav1d_free_aligned(f->ts);
+        f->ts = dav1d_alloc_aligned(sizeof(*f->ts) * n_ts, 32);
+        if (!f->ts) {
+            f->n_ts = 0;
+            goto error;
         }
+        f->n_ts = n_ts;
     }
 
     const int a_sz = f->sb128w * f->frame_hdr->tiling.rows;
@@ -3035,12 +2977,11 @@ int dav1d_decode_frame(Dav1dFrameContext *const f) {
         for (int n = 0; n < f->sb128w * f->frame_hdr->tiling.rows; n++)
             reset_context(&f->a[n], !(f->frame_hdr->frame_type & 1), f->frame_thread.pass);
 
-        if (f->n_tc == 1) {
+        if (!c->n_workers) {
             Dav1dTileContext *const t = f->tc;
 
-            // no tile threading - we explicitly interleave tile/sbrow decoding
-            // and post-filtering, so that the full process runs in-line, so
-            // that frame threading is still possible
+            // no worker pool - we explicitly interleave tile/sbrow decoding
+            // and post-filtering, so that the full process runs in-line
             for (int tile_row = 0; tile_row < f->frame_hdr->tiling.rows; tile_row++) {
                 const int sbh_end =
                     imin(f->frame_hdr->tiling.row_start_sb[tile_row + 1], f->sbh);
@@ -3061,70 +3002,9 @@ int dav1d_decode_frame(Dav1dFrameContext *const f) {
                                                 progress_plane_type);
                 }
             }
-        } else {
-            // signal available tasks to worker threads
-            int num_tasks;
-
-            pthread_mutex_lock(&f->tile_thread.lock);
-            assert(!f->tile_thread.tasks_left);
-            if (f->frame_thread.pass == 1 || f->n_tc >= f->frame_hdr->tiling.cols) {
-                // we can (or in fact, if >, we need to) do full tile decoding.
-                // loopfilter happens below
-                num_tasks = f->frame_hdr->tiling.cols * f->frame_hdr->tiling.rows;
-            } else {
-                // we need to interleave sbrow decoding for all tile cols in a
-                // tile row, since otherwise subsequent threads will be blocked
-                // waiting for the post-filter to complete
-                num_tasks = f->sbh * f->frame_hdr->tiling.cols;
-            }
-            f->tile_thread.num_tasks = f->tile_thread.tasks_left = num_tasks;
-            pthread_cond_broadcast(&f->tile_thread.cond);
-            pthread_mutex_unlock(&f->tile_thread.lock);
-
-            // loopfilter + cdef + restoration
-            for (int tile_row = 0; tile_row < f->frame_hdr->tiling.rows; tile_row++) {
-                for (int sby = f->frame_hdr->tiling.row_start_sb[tile_row];
-                     sby < f->frame_hdr->tiling.row_start_sb[tile_row + 1]; sby++)
-                {
-                    for (int tile_col = 0; tile_col < f->frame_hdr->tiling.cols;
-                         tile_col++)
-                    {
-                        int progress;
-                        Dav1dTileState *const ts =
-                            &f->ts[tile_row * f->frame_hdr->tiling.cols + tile_col];
-
-                        if ((progress = atomic_load(&ts->progress)) <= sby) {
-                            pthread_mutex_lock(&ts->tile_thread.lock);
-                            while ((progress = atomic_load(&ts->progress)) <= sby)
-                                pthread_cond_wait(&ts->tile_thread.cond,
-                                                  &ts->tile_thread.lock);
-                            pthread_mutex_unlock(&ts->tile_thread.lock);
-                        }
-                        if (progress == TILE_ERROR) {
-                            dav1d_thread_picture_signal(&f->sr_cur, FRAME_ERROR,
-                                                        PLANE_TYPE_ALL);
-                            const uint64_t all_mask = ~0ULL >> (64 - f->n_tc);
-                            pthread_mutex_lock(&f->tile_thread.lock);
-                            while (f->tile_thread.available != all_mask)
-                                pthread_cond_wait(&f->tile_thread.icond, &f->tile_thread.lock);
-                            pthread_mutex_unlock(&f->tile_thread.lock);
-                            goto error;
-                        }
-                    }
-
-                    // loopfilter + cdef + restoration
-                    if (f->frame_thread.pass != 1)
-                        f->bd_fn.filter_sbrow(f, sby);
-                    dav1d_thread_picture_signal(&f->sr_cur, (sby + 1) * f->sb_step * 4,
-                                                progress_plane_type);
-                }
-            }
-
-            const uint64_t all_mask = ~0ULL >> (64 - f->n_tc);
-            pthread_mutex_lock(&f->tile_thread.lock);
-            while (f->tile_thread.available != all_mask)
-                pthread_cond_wait(&f->tile_thread.icond, &f->tile_thread.lock);
-            pthread_mutex_unlock(&f->tile_thread.lock);
+        } else if (dav1d_task_thread_decode_pass(f)) {
+            dav1d_thread_picture_signal(&f->sr_cur, FRAME_ERROR, PLANE_TYPE_ALL);
+            goto error;
         }
 
         if (f->frame_thread.pass <= 1 && f->frame_hdr->refresh_context) {
@@ -3150,7 +3030,7 @@ int dav1d_decode_frame(Dav1dFrameContext *const f) {
                     (uint8_t*)f->frame_thread.cf +
                         ((tile_start_off * size_mul[0]) >> !f->seq_hdr->hbd) :
                     NULL;
-                if (f->n_tc > 0) {
+                if (c->n_workers) {
                     const unsigned row_sb_start =
                         f->frame_hdr->tiling.row_start_sb[ts->tiling.row];
                     atomic_init(&ts->progress, row_sb_start);
@@ -3206,10 +3086,7 @@ int dav1d_submit_frame(Dav1dContext *const c) {
             c->frame_thread.next = 0;
 
         f = &c->fc[next];
-        pthread_mutex_lock(&f->frame_thread.td.lock);
-        while (f->n_tile_data > 0)
-            pthread_cond_wait(&f->frame_thread.td.cond,
-                              &f->frame_thread.td.lock);
+        dav1d_task_thread_wait_frame(f);
         out_delayed = &c->frame_thread.out_delayed[next];
         if (out_delayed->p.data[0]) {
             const unsigned progress = atomic_load_explicit(&out_delayed->progress[1],
@@ -3221,6 +3098,7 @@ int dav1d_submit_frame(Dav1dContext *const c) {
     } else {
         f = c->fc;
     }
+    f->task_thread.seq = c->task_thread.seq++;
 
     f->seq_hdr = c->seq_hdr;
     f->seq_hdr_ref = c->seq_hdr_ref;
@@ -3336,7 +3214,8 @@ int dav1d_submit_frame(Dav1dContext *const c) {
         dav1d_cdf_thread_ref(&f->in_cdf, &c->cdf[pri_ref]);
     }
     if (f->frame_hdr->refresh_context) {
-        res = dav1d_cdf_thread_alloc(&f->out_cdf, c->n_fc > 1 ? &f->frame_thread.td : NULL);
+        res = dav1d_cdf_thread_alloc(&f->out_cdf, c->n_fc > 1 ? &c->task_thread : NULL,
+                                     f->task_thread.seq);
         if (res < 0) goto error;
     }
 
@@ -3524,7 +3403,13 @@ int dav1d_submit_frame(Dav1dContext *const c) {
     }
 
     if (c->n_fc == 1) {
-        if ((res = dav1d_decode_frame(f)) < 0) {
+        if (c->n_workers) {
+            dav1d_task_thread_submit_frame(f);
+            res = dav1d_task_thread_wait_frame(f);
+        } else {
+            res = dav1d_decode_frame(f);
+        }
+        if (res < 0) {
             dav1d_picture_unref_internal(&c->out);
             for (int i = 0; i < 8; i++) {
                 if (refresh_frame_flags & (1 << i)) {
@@ -3538,8 +3423,7 @@ int dav1d_submit_frame(Dav1dContext *const c) {
             return res;
         }
     } else {
-        pthread_cond_signal(&f->frame_thread.td.cond);
-        pthread_mutex_unlock(&f->frame_thread.td.lock);
+        dav1d_task_thread_submit_frame(f);
     }
 
     return 0;
@@ -3566,10 +3450,5 @@ error:
         dav1d_data_unref_internal(&f->tile[i].data);
     f->n_tile_data = 0;
 
-    if (c->n_fc > 1) {
-        pthread_cond_signal(&f->frame_thread.td.cond);
-        pthread_mutex_unlock(&f->frame_thread.td.lock);
-    }
-
     return res;
 }
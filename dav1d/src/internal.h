@@ -67,6 +67,19 @@ typedef struct Dav1dDSPContext {
     Dav1dLoopRestorationDSPContext lr;
 } Dav1dDSPContext;
 
+enum TaskType {
+    DAV1D_TASK_FRAME,  // frame setup, then waits for its tile/filter tasks
+    DAV1D_TASK_FILTER, // post-filter one sbrow and signal picture progress
+    DAV1D_TASK_TILE,   // decode one sbrow of one tile
+};
+
+typedef struct Dav1dTask {
+    struct Dav1dTask *next;
+    Dav1dFrameContext *f;
+    enum TaskType type;
+    int sby, tile_idx;
+} Dav1dTask;
+
 struct Dav1dTileGroup {
     Dav1dData data;
     int start, end;
@@ -106,6 +119,11 @@ struct Dav1dContext {
         atomic_int flush_mem, *flush;
     } frame_thread;
 
+    // one worker pool for all frames, tiles and post-filters
+    struct TaskThreadData task_thread;
+    pthread_t *workers;
+    int n_workers;
+
     // reference/entropy state
     struct {
         Dav1dThreadPicture p;
@@ -192,8 +210,7 @@ struct Dav1dFrameContext {
     int bitdepth_max;
 
     struct {
-        struct thread_data td;
-        int pass, die;
+        int pass;
         // indexed using t->by * f->b4_stride + t->bx
         Av1Block *b;
         struct CodedBlockInfo {
@@ -233,17 +250,19 @@ struct Dav1dFrameContext {
         int restore_planes; // enum LrRestorePlanes
     } lf;
 
-    // threading (refer to tc[] for per-thread things)
-    struct FrameTileThreadData {
-        uint64_t available;
-        pthread_mutex_t lock;
-        pthread_cond_t cond, icond;
-        int tasks_left, num_tasks;
-        int (*task_idx_to_sby_and_tile_idx)[2];
-        int titsati_sz, titsati_init[2];
-        uint16_t titsati_index_rows[1 + DAV1D_MAX_TILE_ROWS];
-        int inited;
-    } tile_thread;
+    // threading (refer to tc[] for per-thread things); protected by
+    // c->task_thread.lock
+    struct {
+        struct TaskThreadData *ttd;
+        Dav1dTask frame, filter;
+        Dav1dTask *tiles; // one per tile, requeued for each of its sbrows
+        int tiles_sz;
+        unsigned seq; // submission order, see TaskThreadData.seq
+        int pending; // tile/filter tasks queued or running in this pass
+        int filter_sby; // next sbrow to post-filter
+        int filter_queued, error, retval;
+        uint64_t tc_available; // free entries in tc[]
+    } task_thread;
 };
 
 struct Dav1dTileState {
@@ -256,10 +275,6 @@ struct Dav1dTileState {
     } tiling;
 
     atomic_int progress; // in sby units, TILE_ERROR after a decoding error
-    struct {
-        pthread_mutex_t lock;
-        pthread_cond_t cond;
-    } tile_thread;
     struct {
         uint8_t *pal_idx;
         coef *cf;
@@ -337,12 +352,6 @@ struct Dav1dTileContext {
     // a 4x4 area, but the top/left one can go out of cache already, so this
     // keeps it accessible
     enum Filter2d tl_4x4_filter;
-
-    struct {
-        struct thread_data td;
-        struct FrameTileThreadData *fttd;
-        int die;
-    } tile_thread;
 };
 
 #endif /* DAV1D_SRC_INTERNAL_H */
@@ -46,5 +46,6 @@ typedef struct Dav1dInvTxfmDSPContext {
 bitfn_decls(void dav1d_itx_dsp_init, Dav1dInvTxfmDSPContext *c);
 bitfn_decls(void dav1d_itx_dsp_init_arm, Dav1dInvTxfmDSPContext *c);
 bitfn_decls(void dav1d_itx_dsp_init_x86, Dav1dInvTxfmDSPContext *c);
+bitfn_decls(void dav1d_itx_dsp_init_wasm, Dav1dInvTxfmDSPContext *c);
 
 #endif /* DAV1D_SRC_ITX_H */
@@ -254,5 +254,8 @@ COLD void bitfn(dav1d_itx_dsp_init)(Dav1dInvTxfmDSPContext *const c) {
 #if ARCH_X86
     bitfn(dav1d_itx_dsp_init_x86)(c);
 #endif
+#if ARCH_WASM
+    bitfn(dav1d_itx_dsp_init_wasm)(c);
+#endif
 #endif
 }
@@ -38,6 +38,7 @@
 #include "dav1d/dav1d.h"
 #include "dav1d/data.h"
 
+#include "common/intops.h"
 #include "common/mem.h"
 #include "common/validate.h"
 
@@ -75,6 +76,8 @@ COLD void dav1d_default_settings(Dav1dSettings *const s) {
     s->operating_point = 0;
     s->all_layers = 1; // just until the tests are adjusted
     s->frame_size_limit = 0;
+    s->n_threads = 0;
+    s->max_frame_delay = 0;
 }
 
 static void close_internal(Dav1dContext **const c_out, int flush);
@@ -105,6 +108,10 @@ COLD int dav1d_open(Dav1dContext **const c_out, const Dav1dSettings *const s) {
                           s->n_tile_threads <= DAV1D_MAX_TILE_THREADS, DAV1D_ERR(EINVAL));
     validate_input_or_ret(s->n_frame_threads >= 1 &&
                           s->n_frame_threads <= DAV1D_MAX_FRAME_THREADS, DAV1D_ERR(EINVAL));
+    validate_input_or_ret(s->n_threads >= 0 &&
+                          s->n_threads <= DAV1D_MAX_THREADS, DAV1D_ERR(EINVAL));
+    validate_input_or_ret(s->max_frame_delay >= 0 &&
+                          s->max_frame_delay <= DAV1D_MAX_FRAME_DELAY, DAV1D_ERR(EINVAL));
     validate_input_or_ret(s->allocator.alloc_picture_callback != NULL,
                           DAV1D_ERR(EINVAL));
     validate_input_or_ret(s->allocator.release_picture_callback != NULL,
@@ -142,70 +149,67 @@ COLD int dav1d_open(Dav1dContext **const c_out, const Dav1dSettings *const s) {
 
     c->frame_thread.flush = &c->frame_thread.flush_mem;
     atomic_init(c->frame_thread.flush, 0);
-    c->n_fc = s->n_frame_threads;
-    c->fc = dav1d_alloc_aligned(sizeof(*c->fc) * s->n_frame_threads, 32);
+    // Frame, tile and post-filter work all runs on one pool of n_threads
+    // workers; the frame delay only sets how many frames may be in flight.
+    // The legacy settings map to the same total thread budget.
+    const int n_threads = s->n_threads ? s->n_threads :
+        imin(s->n_frame_threads * s->n_tile_threads, DAV1D_MAX_THREADS);
+    int n_fc = s->max_frame_delay;
+    if (!n_fc && s->n_threads)
+        while (n_fc < 8 && n_fc * n_fc < n_threads) n_fc++;
+    else if (!n_fc)
+        n_fc = s->n_frame_threads;
+    c->n_fc = imin(n_fc, n_threads);
+    const int n_workers = n_threads > 1 || c->n_fc > 1 ? n_threads : 0;
+
+    c->fc = dav1d_alloc_aligned(sizeof(*c->fc) * c->n_fc, 32);
     if (!c->fc) goto error;
-    memset(c->fc, 0, sizeof(*c->fc) * s->n_frame_threads);
+    memset(c->fc, 0, sizeof(*c->fc) * c->n_fc);
     if (c->n_fc > 1) {
         c->frame_thread.out_delayed =
             calloc(c->n_fc, sizeof(*c->frame_thread.out_delayed));
         if (!c->frame_thread.out_delayed) goto error;
     }
-    for (int n = 0; n < s->n_frame_threads; n++) {
+    for (unsigned n = 0; n < c->n_fc; n++) {
         Dav1dFrameContext *const f = &c->fc[n];
         f->c = c;
         f->lf.last_sharpness = -1;
-        f->n_tc = s->n_tile_threads;
-        f->tc = dav1d_alloc_aligned(sizeof(*f->tc) * s->n_tile_threads, 64);
+        f->n_tc = n_workers ? n_workers : 1;
+        f->tc = dav1d_alloc_aligned(sizeof(*f->tc) * f->n_tc, 64);
         if (!f->tc) goto error;
-        memset(f->tc, 0, sizeof(*f->tc) * s->n_tile_threads);
-        if (f->n_tc > 1) {
-            if (pthread_mutex_init(&f->tile_thread.lock, NULL)) goto error;
-            if (pthread_cond_init(&f->tile_thread.cond, NULL)) {
-                pthread_mutex_destroy(&f->tile_thread.lock);
-                goto error;
-            }
-            if (pthread_cond_init(&f->tile_thread.icond, NULL)) {
-                pthread_mutex_destroy(&f->tile_thread.lock);
-                pthread_cond_destroy(&f->tile_thread.cond);
-                goto error;
-            }
-            f->tile_thread.inited = 1;
-        }
-        for (int m = 0; m < s->n_tile_threads; m++) {
+        memset(f->tc, 0, sizeof(*f->tc) * f->n_tc);
+        for (int m = 0; m < f->n_tc; m++) {
             Dav1dTileContext *const t = &f->tc[m];
             t->f = f;
             memset(t->cf_16bpc, 0, sizeof(t->cf_16bpc));
-            if (f->n_tc > 1) {
-                if (pthread_mutex_init(&t->tile_thread.td.lock, NULL)) goto error;
-                if (pthread_cond_init(&t->tile_thread.td.cond, NULL)) {
-                    pthread_mutex_destroy(&t->tile_thread.td.lock);
-                    goto error;
-                }
-                t->tile_thread.fttd = &f->tile_thread;
-                if (pthread_create(&t->tile_thread.td.thread, &thread_attr, dav1d_tile_task, t)) {
-                    pthread_cond_destroy(&t->tile_thread.td.cond);
-                    pthread_mutex_destroy(&t->tile_thread.td.lock);
-                    goto error;
-                }
-                t->tile_thread.td.inited = 1;
-            }
         }
+        f->task_thread.ttd = &c->task_thread;
+        f->task_thread.tc_available = ~0ULL >> (64 - f->n_tc);
+        f->task_thread.frame.f = f;
+        f->task_thread.frame.type = DAV1D_TASK_FRAME;
+        f->task_thread.frame.sby = -1;
+        f->task_thread.filter.f = f;
+        f->task_thread.filter.type = DAV1D_TASK_FILTER;
         f->libaom_cm = dav1d_alloc_ref_mv_common();
         if (!f->libaom_cm) goto error;
-        if (c->n_fc > 1) {
-            if (pthread_mutex_init(&f->frame_thread.td.lock, NULL)) goto error;
-            if (pthread_cond_init(&f->frame_thread.td.cond, NULL)) {
-                pthread_mutex_destroy(&f->frame_thread.td.lock);
-                goto error;
-            }
-            if (pthread_create(&f->frame_thread.td.thread, &thread_attr, dav1d_frame_task, f)) {
-                pthread_cond_destroy(&f->frame_thread.td.cond);
-                pthread_mutex_destroy(&f->frame_thread.td.lock);
+    }
+
+    if (n_workers) {
+        struct TaskThreadData *const ttd = &c->task_thread;
+        if (pthread_mutex_init(&ttd->lock, NULL)) goto error;
+        if (pthread_cond_init(&ttd->cond, NULL)) {
+            pthread_mutex_destroy(&ttd->lock);
+            goto error;
+        }
+        ttd->inited = 1;
+        c->workers = malloc(sizeof(*c->workers) * n_workers);
+        if (!c->workers) goto error;
+        for (; c->n_workers < n_workers; c->n_workers++)
+            if (pthread_create(&c->workers[c->n_workers], &thread_attr,
+                               dav1d_worker_task, c))
+            {
                 goto error;
             }
-            f->frame_thread.td.inited = 1;
-        }
     }
 
     // intra edge tree
@@ -350,11 +354,7 @@ static int drain_picture(Dav1dContext *const c, Dav1dPicture *const out) {
     do {
         const unsigned next = c->frame_thread.next;
         Dav1dFrameContext *const f = &c->fc[next];
-        pthread_mutex_lock(&f->frame_thread.td.lock);
-        while (f->n_tile_data > 0)
-            pthread_cond_wait(&f->frame_thread.td.cond,
-                              &f->frame_thread.td.lock);
-        pthread_mutex_unlock(&f->frame_thread.td.lock);
+        dav1d_task_thread_wait_frame(f);
         Dav1dThreadPicture *const out_delayed =
             &c->frame_thread.out_delayed[next];
         if (++c->frame_thread.next == c->n_fc)
@@ -445,14 +445,8 @@ void dav1d_flush(Dav1dContext *const c) {
     for (unsigned n = 0, next = c->frame_thread.next; n < c->n_fc; n++, next++) {
         if (next == c->n_fc) next = 0;
         Dav1dFrameContext *const f = &c->fc[next];
-        pthread_mutex_lock(&f->frame_thread.td.lock);
-        if (f->n_tile_data > 0) {
-            while (f->n_tile_data > 0)
-                pthread_cond_wait(&f->frame_thread.td.cond,
-                                  &f->frame_thread.td.lock);
-            assert(!f->cur.data[0]);
-        }
-        pthread_mutex_unlock(&f->frame_thread.td.lock);
+        dav1d_task_thread_wait_frame(f);
+        assert(!f->cur.data[0]);
         Dav1dThreadPicture *const out_delayed = &c->frame_thread.out_delayed[next];
         if (out_delayed->p.data[0])
             dav1d_thread_picture_unref(out_delayed);
@@ -473,57 +467,32 @@ static COLD void close_internal(Dav1dContext **const c_out, int flush) {
 
     if (flush) dav1d_flush(c);
 
+    // clean-up threading stuff
+    if (c->task_thread.inited) {
+        struct TaskThreadData *const ttd = &c->task_thread;
+        pthread_mutex_lock(&ttd->lock);
+        ttd->die = 1;
+        pthread_cond_broadcast(&ttd->cond);
+        pthread_mutex_unlock(&ttd->lock);
+        for (int n = 0; n < c->n_workers; n++)
+            pthread_join(c->workers[n], NULL);
+        pthread_cond_destroy(&ttd->cond);
+        pthread_mutex_destroy(&ttd->lock);
+    }
+    free(c->workers);
+
     for (unsigned n = 0; c->fc && n < c->n_fc; n++) {
         Dav1dFrameContext *const f = &c->fc[n];
 
-        // clean-up threading stuff
-        if (c->n_fc > 1 && f->frame_thread.td.inited) {
-            pthread_mutex_lock(&f->frame_thread.td.lock);
-            f->frame_thread.die = 1;
-            pthread_cond_signal(&f->frame_thread.td.cond);
-            pthread_mutex_unlock(&f->frame_thread.td.lock);
-            pthread_join(f->frame_thread.td.thread, NULL);
+        if (c->n_fc > 1) {
             freep(&f->frame_thread.b);
             dav1d_freep_aligned(&f->frame_thread.pal_idx);
             dav1d_freep_aligned(&f->frame_thread.cf);
             freep(&f->frame_thread.tile_start_off);
             dav1d_freep_aligned(&f->frame_thread.pal);
             freep(&f->frame_thread.cbi);
-            pthread_mutex_destroy(&f->frame_thread.td.lock);
-            pthread_cond_destroy(&f->frame_thread.td.cond);
-        }
-        if (f->n_tc > 1 && f->tc && f->tile_thread.inited) {
-            pthread_mutex_lock(&f->tile_thread.lock);
-            for (int m = 0; m < f->n_tc; m++) {
-                Dav1dTileContext *const t = &f->tc[m];
-                t->tile_thread.die = 1;
-                // mark not created tile threads as available
-                if (!t->tile_thread.td.inited)
-                    f->tile_thread.available |= 1ULL<<m;
-            }
-            pthread_cond_broadcast(&f->tile_thread.cond);
-            while (f->tile_thread.available != ~0ULL >> (64 - f->n_tc))
-                pthread_cond_wait(&f->tile_thread.icond,
-                                  &f->tile_thread.lock);
-            pthread_mutex_unlock(&f->tile_thread.lock);
-            for (int m = 0; m < f->n_tc; m++) {
-                Dav1dTileContext *const t = &f->tc[m];
-                if (f->n_tc > 1 && t->tile_thread.td.inited) {
-                    pthread_join(t->tile_thread.td.thread, NULL);
-                    pthread_mutex_destroy(&t->tile_thread.td.lock);
-                    pthread_cond_destroy(&t->tile_thread.td.cond);
-                }
-            }
-            pthread_mutex_destroy(&f->tile_thread.lock);
-            pthread_cond_destroy(&f->tile_thread.cond);
-            pthread_cond_destroy(&f->tile_thread.icond);
-            freep(&f->tile_thread.task_idx_to_sby_and_tile_idx);
-        }
-        for (int m = 0; f->ts && m < f->n_ts; m++) {
-            Dav1dTileState *const ts = &f->ts[m];
-            pthread_cond_destroy(&ts->tile_thread.cond);
-            pthread_mutex_destroy(&ts->tile_thread.lock);
         }
+        free(f->task_thread.tiles);
         dav1d_free_aligned(f->ts);
         dav1d_free_aligned(f->tc);
         dav1d_free_aligned(f->ipred_edge[0]);
@@ -179,7 +179,8 @@ int dav1d_thread_picture_alloc(Dav1dContext *const c, Dav1dFrameContext *const f
                                const int bpc)
 {
     Dav1dThreadPicture *const p = &f->sr_cur;
-    p->t = c->n_fc > 1 ? &f->frame_thread.td : NULL;
+    p->t = c->n_fc > 1 ? &c->task_thread : NULL;
+    p->seq = f->task_thread.seq;
 
     const int res =
         picture_alloc_with_edges(c, &p->p, f->frame_hdr->width[1], f->frame_hdr->height,
@@ -255,6 +256,7 @@ void dav1d_thread_picture_ref(Dav1dThreadPicture *dst,
 {
     dav1d_picture_ref(&dst->p, &src->p);
     dst->t = src->t;
+    dst->seq = src->seq;
     dst->visible = src->visible;
     dst->progress = src->progress;
 }
@@ -303,7 +305,8 @@ int dav1d_thread_picture_wait(const Dav1dThreadPicture *const p,
 
     pthread_mutex_lock(&p->t->lock);
     while ((state = atomic_load_explicit(progress, memory_order_relaxed)) < y)
-        pthread_cond_wait(&p->t->cond, &p->t->lock);
+        if (!dav1d_task_thread_help(p->t, p->seq))
+            pthread_cond_wait(&p->t->cond, &p->t->lock);
     pthread_mutex_unlock(&p->t->lock);
     return state == FRAME_ERROR;
 }
@@ -46,7 +46,8 @@ enum PlaneType {
 typedef struct Dav1dThreadPicture {
     Dav1dPicture p;
     int visible;
-    struct thread_data *t;
+    struct TaskThreadData *t;
+    unsigned seq; // decode order of the producing frame
     // [0] block data (including segmentation map and motion vectors)
     // [1] pixel data
     atomic_uint *progress;
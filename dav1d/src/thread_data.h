@@ -30,11 +30,23 @@
 
 #include "src/thread.h"
 
-struct thread_data {
-    pthread_t thread;
-    pthread_cond_t cond;
+struct Dav1dTask;
+
+// state shared by the worker pool; the lock also protects picture and
+// cdf progress, tile progress and the task state of every frame
+struct TaskThreadData {
     pthread_mutex_t lock;
+    pthread_cond_t cond;
+    struct Dav1dTask *tasks; // queued tasks, oldest frame first
+    unsigned seq; // submission counter, to order frames by age
+    int die;
     int inited;
 };
 
+// Runs the oldest queued task if it belongs to frame seq or an earlier one,
+// dropping ttd->lock (which must be held) while it runs. Returns 0 if there
+// was no such task. Threads that wait on another frame's progress call this
+// instead of blocking, so a frame's dependencies never starve for workers.
+int dav1d_task_thread_help(struct TaskThreadData *ttd, unsigned seq);
+
 #endif /* DAV1D_SRC_THREAD_DATA_H */
@@ -27,117 +27,210 @@
 
 #include "config.h"
 
+#include <assert.h>
+#include <string.h>
+
+#include "common/intops.h"
+
 #include "src/thread_task.h"
 
-void *dav1d_frame_task(void *const data) {
-    Dav1dFrameContext *const f = data;
+// Tasks are ordered by frame age first. The oldest frame in flight only
+// depends on itself, so running its tasks first (and letting threads that
+// wait for an older frame run that frame's tasks meanwhile, see
+// dav1d_task_thread_help()) guarantees progress with any number of workers.
+static int task_before(const Dav1dTask *const a, const Dav1dTask *const b) {
+    const int diff = (int) (a->f->task_thread.seq - b->f->task_thread.seq);
+    if (diff) return diff < 0;
+    if (a->sby != b->sby) return a->sby < b->sby;
+    return a->type < b->type;
+}
 
-    dav1d_set_thread_name("dav1d-frame");
-    pthread_mutex_lock(&f->frame_thread.td.lock);
-    for (;;) {
-        while (!f->n_tile_data && !f->frame_thread.die) {
-            pthread_cond_wait(&f->frame_thread.td.cond,
-                              &f->frame_thread.td.lock);
-        }
-        if (f->frame_thread.die) break;
-        pthread_mutex_unlock(&f->frame_thread.td.lock);
+static void queue_task(struct TaskThreadData *const ttd, Dav1dTask *const task) {
+    Dav1dTask **p = &ttd->tasks;
+    while (*p && !task_before(task, *p))
+        p = &(*p)->next;
+    task->next = *p;
+    *p = task;
+}
+
+static inline int tile_row_end(const Dav1dFrameContext *const f, const int tile_row) {
+    return imin(f->frame_hdr->tiling.row_start_sb[tile_row + 1], f->sbh);
+}
+
+// sbrows are post-filtered strictly in order, each one as soon as all tile
+// columns have decoded it
+static void queue_filter(struct TaskThreadData *const ttd,
+                         Dav1dFrameContext *const f)
+{
+    const int sby = f->task_thread.filter_sby;
+    if (f->task_thread.filter_queued || f->task_thread.error || sby >= f->sbh)
+        return;
+
+    const int cols = f->frame_hdr->tiling.cols;
+    int tile_row = 0;
+    while (tile_row + 1 < f->frame_hdr->tiling.rows &&
+           sby >= f->frame_hdr->tiling.row_start_sb[tile_row + 1])
+    {
+        tile_row++;
+    }
+    for (int tile_col = 0; tile_col < cols; tile_col++)
+        if (atomic_load(&f->ts[tile_row * cols + tile_col].progress) <= sby)
+            return;
+
+    f->task_thread.filter.sby = sby;
+    f->task_thread.filter_queued = 1;
+    f->task_thread.pending++;
+    queue_task(ttd, &f->task_thread.filter);
+}
+
+// called with ttd->lock held, which is dropped while the task runs
+static void run_task(struct TaskThreadData *const ttd, Dav1dTask *const task) {
+    Dav1dFrameContext *const f = task->f;
 
+    switch (task->type) {
+    case DAV1D_TASK_FRAME: {
+        pthread_mutex_unlock(&ttd->lock);
         const int res = dav1d_decode_frame(f);
-        if (res)
+        if (res && f->c->n_fc > 1)
             memset(f->frame_thread.cf, 0,
                    (size_t)f->frame_thread.cf_sz * 128 * 128 / 2);
-
-        pthread_mutex_lock(&f->frame_thread.td.lock);
+        pthread_mutex_lock(&ttd->lock);
+        f->task_thread.retval = res;
         f->n_tile_data = 0;
-        pthread_cond_signal(&f->frame_thread.td.cond);
+        break;
+    }
+    case DAV1D_TASK_TILE: {
+        // a worker only nests tasks of older frames inside a tile task, so
+        // there are never more tile tasks of one frame running than workers
+        assert(f->task_thread.tc_available);
+        const int tc_idx = u64log2(f->task_thread.tc_available);
+        f->task_thread.tc_available &= ~(1ULL << tc_idx);
+        pthread_mutex_unlock(&ttd->lock);
+
+        Dav1dTileContext *const t = &f->tc[tc_idx];
+        Dav1dTileState *const ts = t->ts = &f->ts[task->tile_idx];
+        t->by = task->sby << f->sb_shift;
+        const int error = dav1d_decode_tile_sbrow(t);
+
+        pthread_mutex_lock(&ttd->lock);
+        f->task_thread.tc_available |= 1ULL << tc_idx;
+        atomic_store(&ts->progress, error ? TILE_ERROR : task->sby + 1);
+        f->task_thread.error |= error;
+        if (!f->task_thread.error &&
+            ++task->sby < tile_row_end(f, ts->tiling.row))
+        {
+            queue_task(ttd, task);
+        } else {
+            f->task_thread.pending--;
+        }
+        queue_filter(ttd, f);
+        break;
+    }
+    case DAV1D_TASK_FILTER: {
+        const int sby = task->sby;
+        pthread_mutex_unlock(&ttd->lock);
+
+        // loopfilter + cdef + restoration
+        if (f->frame_thread.pass != 1)
+            f->bd_fn.filter_sbrow(f, sby);
+        dav1d_thread_picture_signal(&f->sr_cur, (sby + 1) * f->sb_step * 4,
+                                    f->frame_thread.pass == 0 ? PLANE_TYPE_ALL :
+                                    f->frame_thread.pass == 1 ? PLANE_TYPE_BLOCK :
+                                                                PLANE_TYPE_Y);
+
+        pthread_mutex_lock(&ttd->lock);
+        f->task_thread.filter_sby = sby + 1;
+        f->task_thread.filter_queued = 0;
+        f->task_thread.pending--;
+        queue_filter(ttd, f);
+        break;
+    }
+    }
+    pthread_cond_broadcast(&ttd->cond);
+}
+
+int dav1d_task_thread_help(struct TaskThreadData *const ttd, const unsigned seq) {
+    Dav1dTask *const task = ttd->tasks;
+    if (!task || (int) (task->f->task_thread.seq - seq) > 0)
+        return 0;
+
+    ttd->tasks = task->next;
+    run_task(ttd, task);
+    return 1;
+}
+
+void *dav1d_worker_task(void *const data) {
+    Dav1dContext *const c = data;
+    struct TaskThreadData *const ttd = &c->task_thread;
+
+    dav1d_set_thread_name("dav1d-worker");
+    pthread_mutex_lock(&ttd->lock);
+    while (!ttd->die) {
+        Dav1dTask *const task = ttd->tasks;
+        if (!task) {
+            pthread_cond_wait(&ttd->cond, &ttd->lock);
+            continue;
+        }
+        ttd->tasks = task->next;
+        run_task(ttd, task);
     }
-    pthread_mutex_unlock(&f->frame_thread.td.lock);
+    pthread_mutex_unlock(&ttd->lock);
 
     return NULL;
 }
 
-void *dav1d_tile_task(void *const data) {
-    Dav1dTileContext *const t = data;
-    struct FrameTileThreadData *const fttd = t->tile_thread.fttd;
-    const Dav1dFrameContext *const f = t->f;
-    const int tile_thread_idx = (int) (t - f->tc);
-    const uint64_t mask = 1ULL << tile_thread_idx;
-
-    dav1d_set_thread_name("dav1d-tile");
-
-    for (;;) {
-        pthread_mutex_lock(&fttd->lock);
-        fttd->available |= mask;
-        int did_signal = 0;
-        while (!fttd->tasks_left && !t->tile_thread.die) {
-            if (!did_signal) {
-                did_signal = 1;
-                pthread_cond_signal(&fttd->icond);
-            }
-            pthread_cond_wait(&fttd->cond, &fttd->lock);
-        }
-        if (t->tile_thread.die) {
-            pthread_cond_signal(&fttd->icond);
-            pthread_mutex_unlock(&fttd->lock);
-            break;
-        }
-        fttd->available &= ~mask;
-        const int task_idx = fttd->num_tasks - fttd->tasks_left--;
-        pthread_mutex_unlock(&fttd->lock);
-
-        if (f->frame_thread.pass == 1 || f->n_tc >= f->frame_hdr->tiling.cols) {
-            // we can (or in fact, if >, we need to) do full tile decoding.
-            // loopfilter happens in the main thread
-            Dav1dTileState *const ts = t->ts = &f->ts[task_idx];
-            for (t->by = ts->tiling.row_start; t->by < ts->tiling.row_end;
-                 t->by += f->sb_step)
-            {
-                int error = dav1d_decode_tile_sbrow(t);
-                int progress = error ? TILE_ERROR : 1 + (t->by >> f->sb_shift);
-
-                // signal progress
-                pthread_mutex_lock(&ts->tile_thread.lock);
-                atomic_store(&ts->progress, progress);
-                pthread_cond_signal(&ts->tile_thread.cond);
-                pthread_mutex_unlock(&ts->tile_thread.lock);
-                if (error) break;
-            }
-        } else {
-            const int sby = f->tile_thread.task_idx_to_sby_and_tile_idx[task_idx][0];
-            const int tile_idx = f->tile_thread.task_idx_to_sby_and_tile_idx[task_idx][1];
-            Dav1dTileState *const ts = &f->ts[tile_idx];
-            int progress;
-
-            // the interleaved decoding can sometimes cause dependency issues
-            // if one part of the frame decodes signifcantly faster than others.
-            // Ideally, we'd "skip" tile_sbrows where dependencies are missing,
-            // and resume them later as dependencies are met. This also would
-            // solve the broadcast() below and allow us to use signal(). However,
-            // for now, we use linear dependency tracking because it's simpler.
-            if ((progress = atomic_load(&ts->progress)) < sby) {
-                pthread_mutex_lock(&ts->tile_thread.lock);
-                while ((progress = atomic_load(&ts->progress)) < sby)
-                    pthread_cond_wait(&ts->tile_thread.cond,
-                                      &ts->tile_thread.lock);
-                pthread_mutex_unlock(&ts->tile_thread.lock);
-            }
-            if (progress == TILE_ERROR) continue;
-
-            // we need to interleave sbrow decoding for all tile cols in a
-            // tile row, since otherwise subsequent threads will be blocked
-            // waiting for the post-filter to complete
-            t->ts = ts;
-            t->by = sby << f->sb_shift;
-            int error = dav1d_decode_tile_sbrow(t);
-            progress = error ? TILE_ERROR : 1 + sby;
-
-            // signal progress
-            pthread_mutex_lock(&ts->tile_thread.lock);
-            atomic_store(&ts->progress, progress);
-            pthread_cond_broadcast(&ts->tile_thread.cond);
-            pthread_mutex_unlock(&ts->tile_thread.lock);
+void dav1d_task_thread_submit_frame(Dav1dFrameContext *const f) {
+    struct TaskThreadData *const ttd = f->task_thread.ttd;
+
+    pthread_mutex_lock(&ttd->lock);
+    queue_task(ttd, &f->task_thread.frame);
+    pthread_cond_broadcast(&ttd->cond);
+    pthread_mutex_unlock(&ttd->lock);
+}
+
+int dav1d_task_thread_wait_frame(Dav1dFrameContext *const f) {
+    struct TaskThreadData *const ttd = f->task_thread.ttd;
+
+    pthread_mutex_lock(&ttd->lock);
+    while (f->n_tile_data > 0)
+        pthread_cond_wait(&ttd->cond, &ttd->lock);
+    const int res = f->task_thread.retval;
+    pthread_mutex_unlock(&ttd->lock);
+
+    return res;
+}
+
+int dav1d_task_thread_decode_pass(Dav1dFrameContext *const f) {
+    struct TaskThreadData *const ttd = f->task_thread.ttd;
+    const int cols = f->frame_hdr->tiling.cols;
+
+    pthread_mutex_lock(&ttd->lock);
+    f->task_thread.filter_sby = 0;
+    f->task_thread.filter_queued = 0;
+    f->task_thread.error = 0;
+    for (int tile_row = 0, tile_idx = 0;
+         tile_row < f->frame_hdr->tiling.rows; tile_row++)
+    {
+        const int sby = f->frame_hdr->tiling.row_start_sb[tile_row];
+        for (int tile_col = 0; tile_col < cols; tile_col++, tile_idx++) {
+            if (sby >= tile_row_end(f, tile_row)) continue;
+            Dav1dTask *const task = &f->task_thread.tiles[tile_idx];
+            task->f = f;
+            task->type = DAV1D_TASK_TILE;
+            task->sby = sby;
+            task->tile_idx = tile_idx;
+            f->task_thread.pending++;
+            queue_task(ttd, task);
         }
     }
+    pthread_cond_broadcast(&ttd->cond);
 
-    return NULL;
+    // this runs on a worker itself, so help rather than block
+    while (f->task_thread.pending)
+        if (!dav1d_task_thread_help(ttd, f->task_thread.seq))
+            pthread_cond_wait(&ttd->cond, &ttd->lock);
+    const int error = f->task_thread.error;
+    pthread_mutex_unlock(&ttd->lock);
+
+    return error;
 }
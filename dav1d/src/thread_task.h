@@ -36,9 +36,16 @@
 #define TILE_ERROR (INT_MAX - 1)
 
 int dav1d_decode_frame(Dav1dFrameContext *f);
-void *dav1d_frame_task(void *data);
-
 int dav1d_decode_tile_sbrow(Dav1dTileContext *t);
-void *dav1d_tile_task(void *data);
+
+void *dav1d_worker_task(void *data);
+
+// queue a frame for decoding on the worker pool
+void dav1d_task_thread_submit_frame(Dav1dFrameContext *f);
+// wait (without helping) until a submitted frame is done; returns its
+// dav1d_decode_frame() result
+int dav1d_task_thread_wait_frame(Dav1dFrameContext *f);
+// run all tile and post-filter tasks of the current pass of f
+int dav1d_task_thread_decode_pass(Dav1dFrameContext *f);
 
 #endif /* DAV1D_SRC_THREAD_TASK_H */
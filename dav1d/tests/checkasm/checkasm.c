@@ -107,6 +107,8 @@ static const struct {
     { "NEON",               "neon",      DAV1D_ARM_CPU_FLAG_NEON },
 #elif ARCH_PPC64LE
     { "VSX",                "vsx",       DAV1D_PPC_CPU_FLAG_VSX },
+#elif ARCH_WASM
+    { "SIMD128",            "simd128",   DAV1D_WASM_CPU_FLAG_SIMD_128 },
 #endif
     { 0 }
 };
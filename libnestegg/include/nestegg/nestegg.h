@@ -351,6 +351,29 @@ int nestegg_read_packet(nestegg * context, nestegg_packet ** packet);
     @param packet #nestegg_packet to be freed. @see nestegg_read_packet */
 void nestegg_free_packet(nestegg_packet * packet);
 
+/** User supplied borrow callback, for reading packet data in place.
+    @param buffer   Storage for a pointer to the next @a length bytes of the
+                    stream.  On success the stream position moves past them,
+                    and they must stay valid and unchanged until the packet
+                    they're read into is freed.
+    @param length   Number of bytes to borrow.
+    @param userdata The #userdata supplied in #nestegg_io.
+    @retval  1 Borrow succeeded.
+    @retval  0 The bytes can't be lent in place; they are read with a copy.
+    @retval -1 Error. */
+typedef int (* nestegg_borrow)(void const ** buffer, size_t length, void * userdata);
+
+/** Recycle packets and their frame storage within the context rather than
+    allocating and freeing them for each nestegg_read_packet call.  All
+    packets read from the context must be freed before #nestegg_destroy.
+    @param context Stream context initialized by #nestegg_init.
+    @param borrow  Optional callback; if given, frame data points straight
+                   into the caller's buffers where possible rather than
+                   being copied out.
+    @retval  0 Success.
+    @retval -1 Error. */
+int nestegg_set_pooled_packets(nestegg * context, nestegg_borrow borrow);
+
 /** Query the keyframe status for a given packet.
     @param packet Packet initialized by #nestegg_read_packet.
     @retval #NESTEGG_PACKET_HAS_KEYFRAME_FALSE   Packet contains no keyframes.
@@ -353,6 +353,10 @@ struct frame {
   size_t length;
   struct frame_encryption * frame_encryption;
   struct frame * next;
+  /* Owned storage, which data points into unless it was borrowed.  Kept
+     across reuse in pooled packet mode. */
+  unsigned char * buffer;
+  size_t capacity;
 };
 
 struct block_additional {
@@ -379,6 +383,11 @@ struct nestegg {
   uint64_t cluster_timecode;
   int read_cluster_timecode;
   struct saved_state saved;
+  /* Pooled packet mode, see nestegg_set_pooled_packets. */
+  int pooled_packets;
+  nestegg_borrow borrow;
+  struct nestegg_packet * free_packets;
+  struct frame * free_frames;
 };
 
 struct nestegg_packet {
@@ -393,6 +402,10 @@ struct nestegg_packet {
   int64_t reference_block;
   int read_reference_block;
   uint8_t keyframe;
+  /* Owning context if pooled, otherwise NULL. */
+  struct nestegg * ctx;
+  /* Next free packet in the pool. */
+  struct nestegg_packet * next;
 };
 
 /* Element Descriptor */
@@ -1367,12 +1380,20 @@ ne_find_track_entry(nestegg * ctx, unsigned int track)
 }
 
 static struct frame *
-ne_alloc_frame(void)
+ne_alloc_frame(nestegg * ctx)
 {
-  struct frame * f = ne_alloc(sizeof(*f));
+  struct frame * f;
 
-  if (!f)
-    return NULL;
+  if (ctx->free_frames) {
+    f = ctx->free_frames;
+    ctx->free_frames = f->next;
+  } else {
+    f = ne_alloc(sizeof(*f));
+    if (!f)
+      return NULL;
+    f->buffer = NULL;
+    f->capacity = 0;
+  }
 
   f->data = NULL;
   f->length = 0;
@@ -1400,7 +1421,7 @@ ne_alloc_frame_encryption(void)
 }
 
 static void
-ne_free_frame(struct frame * f)
+ne_free_frame(nestegg * ctx, struct frame * f)
 {
   if (f->frame_encryption) {
     free(f->frame_encryption->iv);
@@ -1408,10 +1429,69 @@ ne_free_frame(struct frame * f)
   }
 
   free(f->frame_encryption);
-  free(f->data);
+
+  if (ctx && ctx->pooled_packets) {
+    f->next = ctx->free_frames;
+    ctx->free_frames = f;
+    return;
+  }
+
+  free(f->buffer);
   free(f);
 }
 
+static nestegg_packet *
+ne_alloc_packet(nestegg * ctx)
+{
+  nestegg_packet * pkt;
+
+  if (!ctx->pooled_packets)
+    return ne_alloc(sizeof(*pkt));
+
+  pkt = ctx->free_packets;
+  if (pkt)
+    ctx->free_packets = pkt->next;
+  else
+    pkt = malloc(sizeof(*pkt));
+  if (!pkt)
+    return NULL;
+
+  memset(pkt, 0, sizeof(*pkt));
+  pkt->ctx = ctx;
+
+  return pkt;
+}
+
+static int
+ne_read_frame_data(nestegg * ctx, struct frame * f, size_t length)
+{
+  void const * borrowed;
+  int r;
+
+  if (ctx->borrow) {
+    r = ctx->borrow(&borrowed, length, ctx->io->userdata);
+    if (r == 1) {
+      f->data = (unsigned char *) borrowed;
+      f->length = length;
+      return 1;
+    }
+    if (r != 0)
+      return r;
+  }
+
+  if (!f->buffer || f->capacity < length) {
+    free(f->buffer);
+    f->buffer = ne_alloc(length);
+    f->capacity = f->buffer ? length : 0;
+    if (!f->buffer)
+      return -1;
+  }
+  f->data = f->buffer;
+  f->length = length;
+
+  return ne_io_read(ctx->io, f->data, length);
+}
+
 static int
 ne_read_block(nestegg * ctx, uint64_t block_id, uint64_t block_size, nestegg_packet ** data)
 {
@@ -1556,7 +1636,7 @@ ne_read_block(nestegg * ctx, uint64_t block_id, uint64_t block_size, nestegg_pac
       abs_timecode = 0;
   }
 
-  pkt = ne_alloc(sizeof(*pkt));
+  pkt = ne_alloc_packet(ctx);
   if (!pkt)
     return -1;
   pkt->track = track;
@@ -1572,7 +1652,7 @@ ne_read_block(nestegg * ctx, uint64_t block_id, uint64_t block_size, nestegg_pac
       nestegg_free_packet(pkt);
       return -1;
     }
-    f = ne_alloc_frame();
+    f = ne_alloc_frame(ctx);
     if (!f) {
       nestegg_free_packet(pkt);
       return -1;
@@ -1581,13 +1661,13 @@ ne_read_block(nestegg * ctx, uint64_t block_id, uint64_t block_size, nestegg_pac
     if (encoding_type == NESTEGG_ENCODING_ENCRYPTION) {
       r = ne_io_read(ctx->io, &signal_byte, SIGNAL_BYTE_SIZE);
       if (r != 1) {
-        ne_free_frame(f);
+        ne_free_frame(ctx, f);
         nestegg_free_packet(pkt);
         return r;
       }
       f->frame_encryption = ne_alloc_frame_encryption();
       if (!f->frame_encryption) {
-        ne_free_frame(f);
+        ne_free_frame(ctx, f);
         nestegg_free_packet(pkt);
         return -1;
       }
@@ -1595,13 +1675,13 @@ ne_read_block(nestegg * ctx, uint64_t block_id, uint64_t block_size, nestegg_pac
       if ((signal_byte & ENCRYPTED_BIT_MASK) == PACKET_ENCRYPTED) {
         f->frame_encryption->iv = ne_alloc(IV_SIZE);
         if (!f->frame_encryption->iv) {
-          ne_free_frame(f);
+          ne_free_frame(ctx, f);
           nestegg_free_packet(pkt);
           return -1;
         }
         r = ne_io_read(ctx->io, f->frame_encryption->iv, IV_SIZE);
         if (r != 1) {
-          ne_free_frame(f);
+          ne_free_frame(ctx, f);
           nestegg_free_packet(pkt);
           return r;
         }
@@ -1611,7 +1691,7 @@ ne_read_block(nestegg * ctx, uint64_t block_id, uint64_t block_size, nestegg_pac
         if ((signal_byte & PARTITIONED_BIT_MASK) == PACKET_PARTITIONED) {
           r = ne_io_read(ctx->io, &f->frame_encryption->num_partitions, NUM_PACKETS_SIZE);
           if (r != 1) {
-            ne_free_frame(f);
+            ne_free_frame(ctx, f);
             nestegg_free_packet(pkt);
             return r;
           }
@@ -1631,7 +1711,7 @@ ne_read_block(nestegg * ctx, uint64_t block_id, uint64_t block_size, nestegg_pac
 
           /* If any of the partition offsets did not return 1, then fail. */
           if (j != f->frame_encryption->num_partitions) {
-            ne_free_frame(f);
+            ne_free_frame(ctx, f);
             nestegg_free_packet(pkt);
             return r;
           }
@@ -1643,22 +1723,15 @@ ne_read_block(nestegg * ctx, uint64_t block_id, uint64_t block_size, nestegg_pac
       encryption_size = 0;
     }
     if (encryption_size > frame_sizes[i]) {
-      ne_free_frame(f);
+      ne_free_frame(ctx, f);
       nestegg_free_packet(pkt);
       return -1;
     }
     data_size = frame_sizes[i] - encryption_size;
     /* Encryption parsed */
-    f->data = ne_alloc(data_size);
-    if (!f->data) {
-      ne_free_frame(f);
-      nestegg_free_packet(pkt);
-      return -1;
-    }
-    f->length = data_size;
-    r = ne_io_read(ctx->io, f->data, data_size);
+    r = ne_read_frame_data(ctx, f, data_size);
     if (r != 1) {
-      ne_free_frame(f);
+      ne_free_frame(ctx, f);
       nestegg_free_packet(pkt);
       return r;
     }
@@ -2175,12 +2248,34 @@ nestegg_init(nestegg ** context, nestegg_io io, nestegg_log callback, int64_t ma
 void
 nestegg_destroy(nestegg * ctx)
 {
+  nestegg_packet * pkt;
+  struct frame * f;
+
   assert(ctx->ancestor == NULL);
+  while (ctx->free_packets) {
+    pkt = ctx->free_packets;
+    ctx->free_packets = pkt->next;
+    free(pkt);
+  }
+  while (ctx->free_frames) {
+    f = ctx->free_frames;
+    ctx->free_frames = f->next;
+    free(f->buffer);
+    free(f);
+  }
   ne_pool_destroy(ctx->alloc_pool);
   free(ctx->io);
   free(ctx);
 }
 
+int
+nestegg_set_pooled_packets(nestegg * ctx, nestegg_borrow borrow)
+{
+  ctx->pooled_packets = 1;
+  ctx->borrow = borrow;
+  return 0;
+}
+
 int
 nestegg_duration(nestegg * ctx, uint64_t * duration)
 {
@@ -2959,11 +3054,17 @@ nestegg_free_packet(nestegg_packet * pkt)
     frame = pkt->frame;
     pkt->frame = frame->next;
 
-    ne_free_frame(frame);
+    ne_free_frame(pkt->ctx, frame);
   }
 
   ne_free_block_additions(pkt->block_additional);
 
+  if (pkt->ctx) {
+    pkt->next = pkt->ctx->free_packets;
+    pkt->ctx->free_packets = pkt;
+    return;
+  }
+
   free(pkt);
 }
 
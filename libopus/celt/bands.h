@@ -65,6 +65,10 @@ void denormalise_bands(const CELTMode *m, const celt_norm * OPUS_RESTRICT X,
       celt_sig * OPUS_RESTRICT freq, const opus_val16 *bandE, int start,
       int end, int M, int downsample, int silence);
 
+#if defined(OPUS_SIMD128) && !defined(FIXED_POINT)
+#include "simd128/bands_simd128.h"
+#endif
+
 #define SPREAD_NONE       (0)
 #define SPREAD_LIGHT      (1)
 #define SPREAD_NORMAL     (2)
@@ -41,10 +41,15 @@
 #include "mathops.h"
 #include "stack_alloc.h"
 
+#if defined(OPUS_SIMD128) && !defined(FIXED_POINT)
+#include "simd128/kiss_fft_simd128.h"
+#endif
+
 /* The guts header contains all the multiplication and addition macros that are defined for
    complex numbers.  It also delares the kf_ internal functions.
 */
 
+#ifndef OVERRIDE_kf_bfly2
 static void kf_bfly2(
                      kiss_fft_cpx * Fout,
                      int m,
@@ -100,7 +105,9 @@ static void kf_bfly2(
       }
    }
 }
+#endif /* OVERRIDE_kf_bfly2 */
 
+#ifndef OVERRIDE_kf_bfly4
 static void kf_bfly4(
                      kiss_fft_cpx * Fout,
                      const size_t fstride,
@@ -169,10 +176,12 @@ static void kf_bfly4(
       }
    }
 }
+#endif /* OVERRIDE_kf_bfly4 */
 
 
 #ifndef RADIX_TWO_ONLY
 
+#ifndef OVERRIDE_kf_bfly3
 static void kf_bfly3(
                      kiss_fft_cpx * Fout,
                      const size_t fstride,
@@ -229,6 +238,7 @@ static void kf_bfly3(
       } while(--k);
    }
 }
+#endif /* OVERRIDE_kf_bfly3 */
 
 
 #ifndef OVERRIDE_kf_bfly5
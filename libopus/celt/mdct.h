@@ -74,6 +74,10 @@ void clt_mdct_backward_c(const mdct_lookup *l, kiss_fft_scalar *in,
       const opus_val16 * OPUS_RESTRICT window,
       int overlap, int shift, int stride, int arch);
 
+#if defined(OPUS_SIMD128) && !defined(FIXED_POINT)
+#include "simd128/mdct_simd128.h"
+#endif
+
 #if !defined(OVERRIDE_OPUS_MDCT)
 /* Is run-time CPU detection enabled on this platform? */
 #if defined(OPUS_HAVE_RTCD) && defined(HAVE_ARM_NE10)
@@ -50,6 +50,10 @@
 # include "arm/pitch_arm.h"
 #endif
 
+#if defined(OPUS_SIMD128) && !defined(FIXED_POINT)
+#include "simd128/pitch_simd128.h"
+#endif
+
 void pitch_downsample(celt_sig * OPUS_RESTRICT x[], opus_val16 * OPUS_RESTRICT x_lp,
       int len, int C, int arch);
 
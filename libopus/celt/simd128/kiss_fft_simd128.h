@@ -0,0 +1,382 @@
+/* Copyright (c) 2020 Xiph.Org Foundation */
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+/* Radix 2, 3, 4 and 5 butterflies working on two complex values per vector.
+   Every lane does the same float operations in the same order as the C
+   butterflies in kiss_fft.c (a-b as a+(-b), and sign flips by xor), so the
+   output is bit-exact.  Only included from kiss_fft.c. */
+
+#ifndef KISS_FFT_SIMD128_H
+#define KISS_FFT_SIMD128_H
+
+#include "simd128.h"
+
+#define kf_load2cpx(p)       vf4_load((const float *)(p))
+#define kf_store2cpx(p,v)    vf4_store((float *)(p),v)
+#define kf_load1cpx(p)       vf4_load2((const float *)(p))
+#define kf_store1cpx(p,v)    vf4_store2((float *)(p),v)
+#define kf_load2tw(p,stride) \
+    vf4_load2x2((const float *)(p),(const float *)((p)+(stride)))
+
+/* (a.r*b.r - a.i*b.i, a.r*b.i + a.i*b.r), as C_MUL() */
+static OPUS_INLINE vf4 kf_cmul_simd128(vf4 a, vf4 b)
+{
+   return vf4_add(vf4_mul(vf4_shuffle(a, a, 0, 0, 2, 2), b),
+                  vf4_xor(vf4_mul(vf4_shuffle(a, a, 1, 1, 3, 3), vf4_swapri(b)),
+                          vf4_negeven()));
+}
+
+/* (c.i, -c.r) for both complex values */
+#define kf_rot_simd128(c) vf4_xor(vf4_swapri(c), vf4_negodd())
+
+#define OVERRIDE_kf_bfly2
+static void kf_bfly2(
+                     kiss_fft_cpx * Fout,
+                     int m,
+                     int N
+                    )
+{
+   int i;
+   (void)m;
+#ifdef CUSTOM_MODES
+   if (m==1)
+   {
+      for (i=0;i<N;i++)
+      {
+         kiss_fft_cpx t;
+         kiss_fft_cpx * Fout2;
+         Fout2 = Fout + 1;
+         t = *Fout2;
+         C_SUB( *Fout2 ,  *Fout , t );
+         C_ADDTO( *Fout ,  t );
+         Fout += 2;
+      }
+   } else
+#endif
+   {
+      vf4 tw;
+      vf4 lsign, wsign;
+      tw = vf4_splat(QCONST16(0.7071067812f, 15));
+      lsign = vf4_set(0.f, -0.f, -0.f, 0.f);
+      wsign = vf4_set(0.f, 0.f, 0.f, -0.f);
+      celt_assert(m==4);
+      for (i=0;i<N;i++)
+      {
+         vf4 f01, f23, x01, x23, v, w, t01, t23;
+         f01 = kf_load2cpx(Fout);
+         f23 = kf_load2cpx(Fout+2);
+         x01 = kf_load2cpx(Fout+4);
+         x23 = kf_load2cpx(Fout+6);
+         /* v = (x1.r, x1.i, x3.r, x3.i), and w the two twiddled values
+            ((x1.r+x1.i)*tw, (x1.i-x1.r)*tw, (x3.i-x3.r)*tw, -(x3.i+x3.r)*tw) */
+         v = vf4_shuffle(x01, x23, 2, 3, 2, 3);
+         w = vf4_add(vf4_shuffle(v, v, 0, 1, 3, 3),
+                     vf4_xor(vf4_shuffle(v, v, 1, 0, 2, 2), lsign));
+         w = vf4_mul(vf4_xor(w, wsign), tw);
+         t01 = vf4_shuffle(x01, w, 0, 1, 0, 1);
+         t23 = vf4_shuffle(kf_rot_simd128(x23), w, 0, 1, 2, 3);
+         kf_store2cpx(Fout+4, vf4_sub(f01, t01));
+         kf_store2cpx(Fout+6, vf4_sub(f23, t23));
+         kf_store2cpx(Fout, vf4_add(f01, t01));
+         kf_store2cpx(Fout+2, vf4_add(f23, t23));
+         Fout += 8;
+      }
+   }
+}
+
+static OPUS_INLINE void kf_bfly4_step_simd128(vf4 *f0, vf4 *f1, vf4 *f2, vf4 *f3,
+      vf4 w1, vf4 w2, vf4 w3)
+{
+   vf4 s0, s1, s2, s3, s4, s5, t;
+   s0 = kf_cmul_simd128(*f1, w1);
+   s1 = kf_cmul_simd128(*f2, w2);
+   s2 = kf_cmul_simd128(*f3, w3);
+   s5 = vf4_sub(*f0, s1);
+   *f0 = vf4_add(*f0, s1);
+   s3 = vf4_add(s0, s2);
+   s4 = vf4_sub(s0, s2);
+   *f2 = vf4_sub(*f0, s3);
+   *f0 = vf4_add(*f0, s3);
+   /* (s4.i, -s4.r) */
+   t = kf_rot_simd128(s4);
+   *f1 = vf4_add(s5, t);
+   *f3 = vf4_sub(s5, t);
+}
+
+#define OVERRIDE_kf_bfly4
+static void kf_bfly4(
+                     kiss_fft_cpx * Fout,
+                     const size_t fstride,
+                     const kiss_fft_state *st,
+                     int m,
+                     int N,
+                     int mm
+                    )
+{
+   int i;
+
+   if (m==1)
+   {
+      /* Degenerate case where all the twiddles are 1. */
+      for (i=0;i<N;i++)
+      {
+         vf4 a, b, s, d, p, q;
+         a = kf_load2cpx(Fout);
+         b = kf_load2cpx(Fout+2);
+         s = vf4_add(a, b);
+         d = vf4_sub(a, b);
+         p = vf4_shuffle(s, d, 0, 1, 0, 1);
+         q = vf4_shuffle(s, kf_rot_simd128(d), 2, 3, 2, 3);
+         kf_store2cpx(Fout, vf4_add(p, q));
+         kf_store2cpx(Fout+2, vf4_sub(p, q));
+         Fout+=4;
+      }
+   } else {
+      int j;
+      const kiss_twiddle_cpx *tw1,*tw2,*tw3;
+      const int m2=2*m;
+      const int m3=3*m;
+      kiss_fft_cpx * Fout_beg = Fout;
+      for (i=0;i<N;i++)
+      {
+         vf4 f0, f1, f2, f3;
+         Fout = Fout_beg + i*mm;
+         tw3 = tw2 = tw1 = st->twiddles;
+         for (j=0;j<m-1;j+=2)
+         {
+            f0 = kf_load2cpx(Fout);
+            f1 = kf_load2cpx(Fout+m);
+            f2 = kf_load2cpx(Fout+m2);
+            f3 = kf_load2cpx(Fout+m3);
+            kf_bfly4_step_simd128(&f0, &f1, &f2, &f3, kf_load2tw(tw1, fstride),
+                  kf_load2tw(tw2, fstride*2), kf_load2tw(tw3, fstride*3));
+            kf_store2cpx(Fout, f0);
+            kf_store2cpx(Fout+m, f1);
+            kf_store2cpx(Fout+m2, f2);
+            kf_store2cpx(Fout+m3, f3);
+            tw1 += fstride*2;
+            tw2 += fstride*4;
+            tw3 += fstride*6;
+            Fout += 2;
+         }
+         if (j<m)
+         {
+            f0 = kf_load1cpx(Fout);
+            f1 = kf_load1cpx(Fout+m);
+            f2 = kf_load1cpx(Fout+m2);
+            f3 = kf_load1cpx(Fout+m3);
+            kf_bfly4_step_simd128(&f0, &f1, &f2, &f3, kf_load1cpx(tw1),
+                  kf_load1cpx(tw2), kf_load1cpx(tw3));
+            kf_store1cpx(Fout, f0);
+            kf_store1cpx(Fout+m, f1);
+            kf_store1cpx(Fout+m2, f2);
+            kf_store1cpx(Fout+m3, f3);
+         }
+      }
+   }
+}
+
+#ifndef RADIX_TWO_ONLY
+
+static OPUS_INLINE void kf_bfly3_step_simd128(vf4 *f0, vf4 *f1, vf4 *f2,
+      vf4 w1, vf4 w2, vf4 epi3, vf4 half)
+{
+   vf4 s0, s1, s2, s3, h, t;
+   s1 = kf_cmul_simd128(*f1, w1);
+   s2 = kf_cmul_simd128(*f2, w2);
+   s3 = vf4_add(s1, s2);
+   s0 = vf4_sub(s1, s2);
+   h = vf4_sub(*f0, vf4_mul(s3, half));
+   s0 = vf4_mul(s0, epi3);
+   *f0 = vf4_add(*f0, s3);
+   /* (s0.i, -s0.r) */
+   t = kf_rot_simd128(s0);
+   *f2 = vf4_add(h, t);
+   *f1 = vf4_sub(h, t);
+}
+
+#define OVERRIDE_kf_bfly3
+static void kf_bfly3(
+                     kiss_fft_cpx * Fout,
+                     const size_t fstride,
+                     const kiss_fft_state *st,
+                     int m,
+                     int N,
+                     int mm
+                    )
+{
+   int i;
+   int k;
+   const size_t m2 = 2*m;
+   const kiss_twiddle_cpx *tw1,*tw2;
+   vf4 epi3, half;
+   kiss_fft_cpx * Fout_beg = Fout;
+   epi3 = vf4_splat(st->twiddles[fstride*m].i);
+   half = vf4_splat(.5f);
+   for (i=0;i<N;i++)
+   {
+      vf4 f0, f1, f2;
+      Fout = Fout_beg + i*mm;
+      tw1=tw2=st->twiddles;
+      for (k=0;k<m-1;k+=2)
+      {
+         f0 = kf_load2cpx(Fout);
+         f1 = kf_load2cpx(Fout+m);
+         f2 = kf_load2cpx(Fout+m2);
+         kf_bfly3_step_simd128(&f0, &f1, &f2, kf_load2tw(tw1, fstride),
+               kf_load2tw(tw2, fstride*2), epi3, half);
+         kf_store2cpx(Fout, f0);
+         kf_store2cpx(Fout+m, f1);
+         kf_store2cpx(Fout+m2, f2);
+         tw1 += fstride*2;
+         tw2 += fstride*4;
+         Fout += 2;
+      }
+      if (k<m)
+      {
+         f0 = kf_load1cpx(Fout);
+         f1 = kf_load1cpx(Fout+m);
+         f2 = kf_load1cpx(Fout+m2);
+         kf_bfly3_step_simd128(&f0, &f1, &f2, kf_load1cpx(tw1),
+               kf_load1cpx(tw2), epi3, half);
+         kf_store1cpx(Fout, f0);
+         kf_store1cpx(Fout+m, f1);
+         kf_store1cpx(Fout+m2, f2);
+      }
+   }
+}
+
+static OPUS_INLINE void kf_bfly5_step_simd128(vf4 *f0, vf4 *f1, vf4 *f2,
+      vf4 *f3, vf4 *f4, vf4 w1, vf4 w2, vf4 w3, vf4 w4,
+      vf4 yar, vf4 ybr, vf4 yai, vf4 ybi, vf4 yab, vf4 yba)
+{
+   vf4 s0, s1, s2, s3, s4, s5, s6, s7, s8, s9, s10, s11, s12, l, r;
+   s0 = *f0;
+   s1 = kf_cmul_simd128(*f1, w1);
+   s2 = kf_cmul_simd128(*f2, w2);
+   s3 = kf_cmul_simd128(*f3, w3);
+   s4 = kf_cmul_simd128(*f4, w4);
+   s7 = vf4_add(s1, s4);
+   s10 = vf4_sub(s1, s4);
+   s8 = vf4_add(s2, s3);
+   s9 = vf4_sub(s2, s3);
+   *f0 = vf4_add(s0, vf4_add(s7, s8));
+   s5 = vf4_add(s0, vf4_add(vf4_mul(s7, yar), vf4_mul(s8, ybr)));
+   /* (q.i, -q.r) with q = s10*ya.i + s9*yb.i */
+   s6 = kf_rot_simd128(vf4_add(vf4_mul(s10, yai), vf4_mul(s9, ybi)));
+   *f1 = vf4_sub(s5, s6);
+   *f4 = vf4_add(s5, s6);
+   s11 = vf4_add(s0, vf4_add(vf4_mul(s7, ybr), vf4_mul(s8, yar)));
+   /* (s9.i*ya.i - s10.i*yb.i, s10.r*yb.i - s9.r*ya.i) */
+   l = vf4_shuffle(s9, s10, 1, 3, 0, 2);
+   r = vf4_shuffle(s10, s9, 1, 3, 0, 2);
+   l = vf4_shuffle(l, l, 0, 2, 1, 3);
+   r = vf4_shuffle(r, r, 0, 2, 1, 3);
+   s12 = vf4_sub(vf4_mul(l, yab), vf4_mul(r, yba));
+   *f2 = vf4_add(s11, s12);
+   *f3 = vf4_sub(s11, s12);
+}
+
+#define OVERRIDE_kf_bfly5
+static void kf_bfly5(
+                     kiss_fft_cpx * Fout,
+                     const size_t fstride,
+                     const kiss_fft_state *st,
+                     int m,
+                     int N,
+                     int mm
+                    )
+{
+   kiss_fft_cpx *Fout0,*Fout1,*Fout2,*Fout3,*Fout4;
+   int i, u;
+   const kiss_twiddle_cpx *tw;
+   kiss_twiddle_cpx ya,yb;
+   vf4 yar, ybr, yai, ybi, yab, yba;
+   kiss_fft_cpx * Fout_beg = Fout;
+
+   ya = st->twiddles[fstride*m];
+   yb = st->twiddles[fstride*2*m];
+   yar = vf4_splat(ya.r);
+   ybr = vf4_splat(yb.r);
+   yai = vf4_splat(ya.i);
+   ybi = vf4_splat(yb.i);
+   yab = vf4_set(ya.i, yb.i, ya.i, yb.i);
+   yba = vf4_set(yb.i, ya.i, yb.i, ya.i);
+   tw=st->twiddles;
+
+   for (i=0;i<N;i++)
+   {
+      vf4 f0, f1, f2, f3, f4;
+      Fout = Fout_beg + i*mm;
+      Fout0=Fout;
+      Fout1=Fout0+m;
+      Fout2=Fout0+2*m;
+      Fout3=Fout0+3*m;
+      Fout4=Fout0+4*m;
+
+      for ( u=0; u<m-1; u+=2 ) {
+         f0 = kf_load2cpx(Fout0);
+         f1 = kf_load2cpx(Fout1);
+         f2 = kf_load2cpx(Fout2);
+         f3 = kf_load2cpx(Fout3);
+         f4 = kf_load2cpx(Fout4);
+         kf_bfly5_step_simd128(&f0, &f1, &f2, &f3, &f4,
+               kf_load2tw(tw+u*fstride, fstride),
+               kf_load2tw(tw+2*u*fstride, 2*fstride),
+               kf_load2tw(tw+3*u*fstride, 3*fstride),
+               kf_load2tw(tw+4*u*fstride, 4*fstride),
+               yar, ybr, yai, ybi, yab, yba);
+         kf_store2cpx(Fout0, f0);
+         kf_store2cpx(Fout1, f1);
+         kf_store2cpx(Fout2, f2);
+         kf_store2cpx(Fout3, f3);
+         kf_store2cpx(Fout4, f4);
+         Fout0+=2;Fout1+=2;Fout2+=2;Fout3+=2;Fout4+=2;
+      }
+      if (u<m)
+      {
+         f0 = kf_load1cpx(Fout0);
+         f1 = kf_load1cpx(Fout1);
+         f2 = kf_load1cpx(Fout2);
+         f3 = kf_load1cpx(Fout3);
+         f4 = kf_load1cpx(Fout4);
+         kf_bfly5_step_simd128(&f0, &f1, &f2, &f3, &f4,
+               kf_load1cpx(tw+u*fstride), kf_load1cpx(tw+2*u*fstride),
+               kf_load1cpx(tw+3*u*fstride), kf_load1cpx(tw+4*u*fstride),
+               yar, ybr, yai, ybi, yab, yba);
+         kf_store1cpx(Fout0, f0);
+         kf_store1cpx(Fout1, f1);
+         kf_store1cpx(Fout2, f2);
+         kf_store1cpx(Fout3, f3);
+         kf_store1cpx(Fout4, f4);
+      }
+   }
+}
+
+#endif /* RADIX_TWO_ONLY */
+
+#endif
@@ -0,0 +1,224 @@
+/* Copyright (c) 2020 Xiph.Org Foundation */
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "mdct.h"
+#include "kiss_fft.h"
+#include "_kiss_fft_guts.h"
+#include "mathops.h"
+
+#if defined(OPUS_SIMD128) && !defined(FIXED_POINT)
+
+#include "simd128.h"
+
+/* (a0,b0,a1,b1) */
+static OPUS_INLINE vf4 interleave_lo(vf4 a, vf4 b)
+{
+   vf4 t = vf4_shuffle(a, b, 0, 1, 0, 1);
+   return vf4_shuffle(t, t, 0, 2, 1, 3);
+}
+
+/* (a2,b2,a3,b3) */
+static OPUS_INLINE vf4 interleave_hi(vf4 a, vf4 b)
+{
+   vf4 t = vf4_shuffle(a, b, 2, 3, 2, 3);
+   return vf4_shuffle(t, t, 0, 2, 1, 3);
+}
+
+/* Same arithmetic as clt_mdct_backward_c(), four rotations at a time, so the
+   output is bit-exact. */
+void clt_mdct_backward_simd128(const mdct_lookup *l, kiss_fft_scalar *in, kiss_fft_scalar * OPUS_RESTRICT out,
+      const opus_val16 * OPUS_RESTRICT window, int overlap, int shift, int stride, int arch)
+{
+   int i;
+   int N, N2, N4;
+   const kiss_twiddle_scalar *trig;
+   (void) arch;
+
+   N = l->n;
+   trig = l->trig;
+   for (i=0;i<shift;i++)
+   {
+      N >>= 1;
+      trig += N;
+   }
+   N2 = N>>1;
+   N4 = N>>2;
+
+   /* Pre-rotate */
+   {
+      /* Temp pointers to make it really clear to the compiler what we're doing */
+      const kiss_fft_scalar * OPUS_RESTRICT xp1 = in;
+      const kiss_fft_scalar * OPUS_RESTRICT xp2 = in+stride*(N2-1);
+      kiss_fft_scalar * OPUS_RESTRICT yp = out+(overlap>>1);
+      const kiss_twiddle_scalar * OPUS_RESTRICT t = &trig[0];
+      const opus_int16 * OPUS_RESTRICT bitrev = l->kfft[shift]->bitrev;
+      for(i=0;i<N4-3;i+=4)
+      {
+         vf4 x1, x2, t0, t1, yr, yi, y;
+         if (stride==1)
+         {
+            x1 = vf4_shuffle(vf4_load(xp1), vf4_load(xp1+4), 0, 2, 0, 2);
+            x2 = vf4_shuffle(vf4_load(xp2-3), vf4_load(xp2-7), 3, 1, 3, 1);
+         } else {
+            x1 = vf4_set(xp1[0], xp1[2*stride], xp1[4*stride], xp1[6*stride]);
+            x2 = vf4_set(xp2[0], xp2[-2*stride], xp2[-4*stride], xp2[-6*stride]);
+         }
+         t0 = vf4_load(t+i);
+         t1 = vf4_load(t+N4+i);
+         yr = vf4_add(vf4_mul(x2, t0), vf4_mul(x1, t1));
+         yi = vf4_sub(vf4_mul(x1, t0), vf4_mul(x2, t1));
+         /* We swap real and imag because we use an FFT instead of an IFFT, and
+            store the pre-rotation directly in the bitrev order. */
+         y = interleave_lo(yi, yr);
+         vf4_store2(yp+2*bitrev[i], y);
+         vf4_store2_hi(yp+2*bitrev[i+1], y);
+         y = interleave_hi(yi, yr);
+         vf4_store2(yp+2*bitrev[i+2], y);
+         vf4_store2_hi(yp+2*bitrev[i+3], y);
+         xp1+=8*stride;
+         xp2-=8*stride;
+      }
+      for(;i<N4;i++)
+      {
+         int rev;
+         kiss_fft_scalar yr, yi;
+         rev = bitrev[i];
+         yr = ADD32_ovflw(S_MUL(*xp2, t[i]), S_MUL(*xp1, t[N4+i]));
+         yi = SUB32_ovflw(S_MUL(*xp1, t[i]), S_MUL(*xp2, t[N4+i]));
+         yp[2*rev+1] = yr;
+         yp[2*rev] = yi;
+         xp1+=2*stride;
+         xp2-=2*stride;
+      }
+   }
+
+   opus_fft_impl(l->kfft[shift], (kiss_fft_cpx*)(out+(overlap>>1)));
+
+   /* Post-rotate and de-shuffle from both ends of the buffer at once to make
+      it in-place. */
+   {
+      kiss_fft_scalar * yp0 = out+(overlap>>1);
+      kiss_fft_scalar * yp1 = out+(overlap>>1)+N2-2;
+      const kiss_twiddle_scalar *t = &trig[0];
+      /* Four pairs from each end while the two ends don't meet. */
+      for(i=0;2*i+8<=N4;i+=4)
+      {
+         vf4 f0, f1, b0, b1, re, im, t0, t1, yr, yi, yr1, yi1;
+         f0 = vf4_load(yp0);
+         f1 = vf4_load(yp0+4);
+         b0 = vf4_load(yp1-6);
+         b1 = vf4_load(yp1-2);
+         /* We swap real and imag because we're using an FFT instead of an IFFT. */
+         re = vf4_shuffle(f0, f1, 1, 3, 1, 3);
+         im = vf4_shuffle(f0, f1, 0, 2, 0, 2);
+         t0 = vf4_load(t+i);
+         t1 = vf4_load(t+N4+i);
+         /* We'd scale up by 2 here, but instead it's done when mixing the windows */
+         yr = vf4_add(vf4_mul(re, t0), vf4_mul(im, t1));
+         yi = vf4_sub(vf4_mul(re, t1), vf4_mul(im, t0));
+         re = vf4_shuffle(b1, b0, 3, 1, 3, 1);
+         im = vf4_shuffle(b1, b0, 2, 0, 2, 0);
+         t0 = vf4_reverse(vf4_load(t+N4-i-4));
+         t1 = vf4_reverse(vf4_load(t+N2-i-4));
+         yr1 = vf4_add(vf4_mul(re, t0), vf4_mul(im, t1));
+         yi1 = vf4_sub(vf4_mul(re, t1), vf4_mul(im, t0));
+         vf4_store(yp0, interleave_lo(yr, yi1));
+         vf4_store(yp0+4, interleave_hi(yr, yi1));
+         yr1 = vf4_reverse(yr1);
+         yi = vf4_reverse(yi);
+         vf4_store(yp1-6, interleave_lo(yr1, yi));
+         vf4_store(yp1-2, interleave_hi(yr1, yi));
+         yp0 += 8;
+         yp1 -= 8;
+      }
+      /* Loop to (N4+1)>>1 to handle odd N4. When N4 is odd, the
+         middle pair will be computed twice. */
+      for(;i<(N4+1)>>1;i++)
+      {
+         kiss_fft_scalar re, im, yr, yi;
+         kiss_twiddle_scalar t0, t1;
+         re = yp0[1];
+         im = yp0[0];
+         t0 = t[i];
+         t1 = t[N4+i];
+         yr = ADD32_ovflw(S_MUL(re,t0), S_MUL(im,t1));
+         yi = SUB32_ovflw(S_MUL(re,t1), S_MUL(im,t0));
+         re = yp1[1];
+         im = yp1[0];
+         yp0[0] = yr;
+         yp1[1] = yi;
+
+         t0 = t[(N4-i-1)];
+         t1 = t[(N2-i-1)];
+         yr = ADD32_ovflw(S_MUL(re,t0), S_MUL(im,t1));
+         yi = SUB32_ovflw(S_MUL(re,t1), S_MUL(im,t0));
+         yp1[0] = yr;
+         yp0[1] = yi;
+         yp0 += 2;
+         yp1 -= 2;
+      }
+   }
+
+   /* Mirror on both sides for TDAC */
+   {
+      kiss_fft_scalar * OPUS_RESTRICT xp1 = out+overlap-1;
+      kiss_fft_scalar * OPUS_RESTRICT yp1 = out;
+      const opus_val16 * OPUS_RESTRICT wp1 = window;
+      const opus_val16 * OPUS_RESTRICT wp2 = window+overlap-1;
+
+      for(i = 0; i+4 <= overlap/2; i+=4)
+      {
+         vf4 x1, x2, w1, w2;
+         x1 = vf4_reverse(vf4_load(xp1-3));
+         x2 = vf4_load(yp1);
+         w1 = vf4_load(wp1);
+         w2 = vf4_reverse(vf4_load(wp2-3));
+         vf4_store(yp1, vf4_sub(vf4_mul(w2, x2), vf4_mul(w1, x1)));
+         vf4_store(xp1-3, vf4_reverse(vf4_add(vf4_mul(w1, x2), vf4_mul(w2, x1))));
+         yp1 += 4;
+         xp1 -= 4;
+         wp1 += 4;
+         wp2 -= 4;
+      }
+      for(; i < overlap/2; i++)
+      {
+         kiss_fft_scalar x1, x2;
+         x1 = *xp1;
+         x2 = *yp1;
+         *yp1++ = SUB32_ovflw(MULT16_32_Q15(*wp2, x2), MULT16_32_Q15(*wp1, x1));
+         *xp1-- = ADD32_ovflw(MULT16_32_Q15(*wp1, x2), MULT16_32_Q15(*wp2, x1));
+         wp1++;
+         wp2--;
+      }
+   }
+}
+
+#endif
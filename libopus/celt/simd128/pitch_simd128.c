@@ -0,0 +1,174 @@
+/* Copyright (c) 2020 Xiph.Org Foundation */
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "macros.h"
+#include "celt_lpc.h"
+#include "stack_alloc.h"
+#include "mathops.h"
+#include "pitch.h"
+
+#if defined(OPUS_SIMD128) && !defined(FIXED_POINT)
+
+#include "simd128.h"
+
+#ifdef OPUS_CHECK_ASM
+/* Equal, or both NaN (the decoder tests feed garbage packets). */
+static int simd128_same(opus_val32 a, opus_val32 b)
+{
+   return a == b || (a != a && b != b);
+}
+#endif
+
+void xcorr_kernel_simd128(const opus_val16 *x, const opus_val16 *y, opus_val32 sum[4], int len)
+{
+   int j;
+   vf4 xsum;
+#ifdef OPUS_CHECK_ASM
+   opus_val32 sum_c[4];
+   OPUS_COPY(sum_c, sum, 4);
+   xcorr_kernel_c(x, y, sum_c, len);
+#endif
+   /* A single accumulator adds the products into each sum in the same order
+      as xcorr_kernel_c(), so the result is bit-exact. */
+   xsum = vf4_load(sum);
+   for (j = 0; j < len; j++)
+      xsum = vf4_add(xsum, vf4_mul(vf4_splat(x[j]), vf4_load(y+j)));
+   vf4_store(sum, xsum);
+#ifdef OPUS_CHECK_ASM
+   celt_assert(simd128_same(sum_c[0], sum[0]) && simd128_same(sum_c[1], sum[1])
+         && simd128_same(sum_c[2], sum[2]) && simd128_same(sum_c[3], sum[3]));
+#endif
+}
+
+#ifdef OPUS_CHECK_ASM
+
+/* These simulate the order of the vector additions below, so both should
+   give bit-exact output. */
+static opus_val32 celt_inner_prod_simd128_c_simulation(const opus_val16 *x, const opus_val16 *y, int N)
+{
+   int i;
+   opus_val32 xy, xy0 = 0, xy1 = 0, xy2 = 0, xy3 = 0;
+   for (i = 0; i < N - 3; i += 4) {
+      xy0 = MAC16_16(xy0, x[i + 0], y[i + 0]);
+      xy1 = MAC16_16(xy1, x[i + 1], y[i + 1]);
+      xy2 = MAC16_16(xy2, x[i + 2], y[i + 2]);
+      xy3 = MAC16_16(xy3, x[i + 3], y[i + 3]);
+   }
+   xy = (xy0 + xy2) + (xy1 + xy3);
+   for (; i < N; i++)
+      xy = MAC16_16(xy, x[i], y[i]);
+   return xy;
+}
+
+#endif /* OPUS_CHECK_ASM */
+
+opus_val32 celt_inner_prod_simd128(const opus_val16 *x, const opus_val16 *y, int N)
+{
+   int i;
+   opus_val32 xy;
+   vf4 xyv = vf4_zero();
+   for (i = 0; i < N - 3; i += 4)
+      xyv = vf4_add(xyv, vf4_mul(vf4_load(x+i), vf4_load(y+i)));
+   xy = vf4_hsum(xyv);
+   for (; i < N; i++)
+      xy = MAC16_16(xy, x[i], y[i]);
+#ifdef OPUS_CHECK_ASM
+   celt_assert(simd128_same(celt_inner_prod_simd128_c_simulation(x, y, N), xy));
+#endif
+   return xy;
+}
+
+void dual_inner_prod_simd128(const opus_val16 *x, const opus_val16 *y01, const opus_val16 *y02,
+      int N, opus_val32 *xy1, opus_val32 *xy2)
+{
+   int i;
+   opus_val32 xy01, xy02;
+   vf4 xy01v = vf4_zero();
+   vf4 xy02v = vf4_zero();
+   for (i = 0; i < N - 3; i += 4)
+   {
+      vf4 xi = vf4_load(x+i);
+      xy01v = vf4_add(xy01v, vf4_mul(xi, vf4_load(y01+i)));
+      xy02v = vf4_add(xy02v, vf4_mul(xi, vf4_load(y02+i)));
+   }
+   xy01 = vf4_hsum(xy01v);
+   xy02 = vf4_hsum(xy02v);
+   for (; i < N; i++)
+   {
+      xy01 = MAC16_16(xy01, x[i], y01[i]);
+      xy02 = MAC16_16(xy02, x[i], y02[i]);
+   }
+   *xy1 = xy01;
+   *xy2 = xy02;
+#ifdef OPUS_CHECK_ASM
+   celt_assert(simd128_same(celt_inner_prod_simd128_c_simulation(x, y01, N), xy01));
+   celt_assert(simd128_same(celt_inner_prod_simd128_c_simulation(x, y02, N), xy02));
+#endif
+}
+
+void comb_filter_const_simd128(opus_val32 *y, opus_val32 *x, int T, int N,
+      opus_val16 g10, opus_val16 g11, opus_val16 g12)
+{
+   int i;
+   vf4 x0v;
+   vf4 g10v, g11v, g12v;
+   g10v = vf4_splat(g10);
+   g11v = vf4_splat(g11);
+   g12v = vf4_splat(g12);
+   /* Each lane adds the three taps in the same order as
+      comb_filter_const_c(), so this is bit-exact, and like the C code it
+      works in place since T>=COMBFILTER_MINPERIOD. */
+   x0v = vf4_load(&x[-T-2]);
+   for (i = 0; i < N-3; i += 4)
+   {
+      vf4 yi, x1v, x2v, x3v, x4v;
+      const opus_val32 *xp = &x[i-T-2];
+      yi = vf4_load(x+i);
+      x4v = vf4_load(xp+4);
+      x2v = vf4_shuffle(x0v, x4v, 2, 3, 0, 1);
+      x1v = vf4_shuffle(x0v, x2v, 1, 2, 1, 2);
+      x3v = vf4_shuffle(x2v, x4v, 1, 2, 1, 2);
+      yi = vf4_add(yi, vf4_mul(g10v, x2v));
+      yi = vf4_add(yi, vf4_mul(g11v, vf4_add(x3v, x1v)));
+      yi = vf4_add(yi, vf4_mul(g12v, vf4_add(x4v, x0v)));
+      x0v = x4v;
+      vf4_store(y+i, yi);
+   }
+   for (; i < N; i++)
+   {
+      y[i] = x[i]
+               + MULT16_32_Q15(g10,x[i-T])
+               + MULT16_32_Q15(g11,ADD32(x[i-T+1],x[i-T-1]))
+               + MULT16_32_Q15(g12,ADD32(x[i-T+2],x[i-T-2]));
+   }
+}
+
+#endif
@@ -0,0 +1,106 @@
+/* Copyright (c) 2020 Xiph.Org Foundation */
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+/* Four-wide float vector operations for the SIMD128 backend.  Each one is a
+   single WebAssembly SIMD128 instruction where there is one, and the
+   equivalent SSE2 sequence otherwise, so the kernels can be checked natively
+   against the C code. */
+
+#ifndef SIMD128_H
+#define SIMD128_H
+
+#include "arch.h"
+
+#if defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+
+typedef v128_t vf4;
+
+#define vf4_set(a,b,c,d)  wasm_f32x4_make(a,b,c,d)
+#define vf4_splat(x)      wasm_f32x4_splat(x)
+#define vf4_zero()        wasm_f32x4_const(0.f,0.f,0.f,0.f)
+#define vf4_load(p)       wasm_v128_load(p)
+#define vf4_store(p,v)    wasm_v128_store(p,v)
+#define vf4_add(a,b)      wasm_f32x4_add(a,b)
+#define vf4_sub(a,b)      wasm_f32x4_sub(a,b)
+#define vf4_mul(a,b)      wasm_f32x4_mul(a,b)
+#define vf4_xor(a,b)      wasm_v128_xor(a,b)
+/* (a[i0],a[i1],b[i2],b[i3]), as SSE's shufps */
+#define vf4_shuffle(a,b,i0,i1,i2,i3) \
+    wasm_i32x4_shuffle(a,b,i0,i1,(i2)+4,(i3)+4)
+#define vf4_load2(p)      wasm_v128_load64_zero(p)
+/* two floats from p in the low half, two from q in the high half */
+#define vf4_load2x2(p,q)  wasm_v128_load64_lane(q,wasm_v128_load64_zero(p),1)
+#define vf4_store2(p,v)   wasm_v128_store64_lane(p,v,0)
+#define vf4_store2_hi(p,v) wasm_v128_store64_lane(p,v,1)
+#define vf4_lane0(v)      wasm_f32x4_extract_lane(v,0)
+
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+
+typedef __m128 vf4;
+
+#define vf4_set(a,b,c,d)  _mm_setr_ps(a,b,c,d)
+#define vf4_splat(x)      _mm_set1_ps(x)
+#define vf4_zero()        _mm_setzero_ps()
+#define vf4_load(p)       _mm_loadu_ps(p)
+#define vf4_store(p,v)    _mm_storeu_ps(p,v)
+#define vf4_add(a,b)      _mm_add_ps(a,b)
+#define vf4_sub(a,b)      _mm_sub_ps(a,b)
+#define vf4_mul(a,b)      _mm_mul_ps(a,b)
+#define vf4_xor(a,b)      _mm_xor_ps(a,b)
+#define vf4_shuffle(a,b,i0,i1,i2,i3) \
+    _mm_shuffle_ps(a,b,_MM_SHUFFLE(i3,i2,i1,i0))
+#define vf4_load2(p)      _mm_loadl_pi(_mm_setzero_ps(),(const __m64 *)(p))
+#define vf4_load2x2(p,q) \
+    _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(),(const __m64 *)(p)), \
+                 (const __m64 *)(q))
+#define vf4_store2(p,v)   _mm_storel_pi((__m64 *)(p),v)
+#define vf4_store2_hi(p,v) _mm_storeh_pi((__m64 *)(p),v)
+#define vf4_lane0(v)      _mm_cvtss_f32(v)
+
+#else
+#error "OPUS_SIMD128 requires WebAssembly SIMD128 or SSE2."
+#endif
+
+#define vf4_reverse(a)    vf4_shuffle(a,a,3,2,1,0)
+/* swaps the real and imaginary parts of two complex values */
+#define vf4_swapri(a)     vf4_shuffle(a,a,1,0,3,2)
+/* sign masks: xor with these negates the selected lanes exactly */
+#define vf4_negall()      vf4_splat(-0.f)
+#define vf4_negodd()      vf4_set(0.f,-0.f,0.f,-0.f)
+#define vf4_negeven()     vf4_set(-0.f,0.f,-0.f,0.f)
+
+/* (v0+v2)+(v1+v3) */
+static OPUS_INLINE float vf4_hsum(vf4 v)
+{
+   v = vf4_add(v, vf4_shuffle(v, v, 2, 3, 2, 3));
+   v = vf4_add(v, vf4_shuffle(v, v, 1, 1, 1, 1));
+   return vf4_lane0(v);
+}
+
+#endif
@@ -45,6 +45,10 @@
 #include "mips/vq_mipsr1.h"
 #endif
 
+#if defined(OPUS_SIMD128) && !defined(FIXED_POINT)
+#include "simd128/vq_simd128.h"
+#endif
+
 void exp_rotation(celt_norm *X, int len, int dir, int stride, int K, int spread);
 
 opus_val16 op_pvq_search_c(celt_norm *X, int *iy, int K, int N, int arch);
@@ -48,6 +48,12 @@ celt/mips/kiss_fft_mipsr1.h \
 celt/mips/mdct_mipsr1.h \
 celt/mips/pitch_mipsr1.h \
 celt/mips/vq_mipsr1.h \
+celt/simd128/bands_simd128.h \
+celt/simd128/kiss_fft_simd128.h \
+celt/simd128/mdct_simd128.h \
+celt/simd128/pitch_simd128.h \
+celt/simd128/simd128.h \
+celt/simd128/vq_simd128.h \
 celt/x86/pitch_sse.h \
 celt/x86/vq_sse.h \
 celt/x86/x86cpu.h
@@ -30,6 +30,12 @@ CELT_SOURCES_SSE4_1 = \
 celt/x86/celt_lpc_sse.c \
 celt/x86/pitch_sse4_1.c
 
+CELT_SOURCES_SIMD128 = \
+celt/simd128/bands_simd128.c \
+celt/simd128/mdct_simd128.c \
+celt/simd128/pitch_simd128.c \
+celt/simd128/vq_simd128.c
+
 CELT_SOURCES_ARM = \
 celt/arm/armcpu.c \
 celt/arm/arm_celt_map.c
@@ -100,6 +100,21 @@ extern "C" {
 #define TH_DECCTL_SET_TELEMETRY_QI (13)
 /**Enables telemetry and sets the bitstream breakdown visualization mode */
 #define TH_DECCTL_SET_TELEMETRY_BITS (15)
+/**Sets the number of threads used to reconstruct each frame.
+ * DC prediction reversal and fragment reconstruction, and loop filtering and
+ *  post-processing, are run over the MCU rows of each color plane as separate
+ *  jobs, so up to six threads can be kept busy, counting the one that calls
+ *  th_decode_packetin().
+ * Striped decode callbacks are still made in order from the calling thread.
+ *
+ * \param[in] _buf <tt>int</tt>: The total number of threads to use.
+ *                  0 or 1 decodes on the calling thread alone.
+ * \retval TH_EFAULT \a _dec_ctx or \a _buf is <tt>NULL</tt>, or the
+ *                    worker threads could not be started.
+ * \retval TH_EINVAL \a _buf_sz is not <tt>sizeof(int)</tt>, or the number
+ *                    of threads is negative.
+ * \retval TH_EIMPL  libtheora was built without thread support.*/
+#define TH_DECCTL_SET_THREADS (17)
 /*@}*/
 
 
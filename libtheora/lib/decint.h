@@ -23,10 +23,14 @@
 # include "bitpack.h"
 # include "huffdec.h"
 # include "dequant.h"
+# if defined(OC_DEC_THREADS)
+#  include <pthread.h>
+# endif
 
 typedef struct th_setup_info         oc_setup_info;
 typedef struct oc_dec_opt_vtable     oc_dec_opt_vtable;
 typedef struct oc_dec_pipeline_state oc_dec_pipeline_state;
+typedef struct oc_dec_threads        oc_dec_threads;
 typedef struct th_dec_ctx            oc_dec_ctx;
 
 
@@ -112,6 +116,39 @@ struct oc_dec_pipeline_state{
 };
 
 
+
+# if defined(OC_DEC_THREADS)
+/*The reconstruction of each plane is split into two stages: DC prediction
+   reversal and fragment reconstruction, then loop filtering, border filling
+   and post-processing.
+  Each stage walks the MCU rows of its plane in order, and the second stage
+   of a plane follows one MCU row behind the first.*/
+#  define OC_DEC_NSTAGES (2)
+#  define OC_DEC_NJOBS   (3*OC_DEC_NSTAGES)
+
+/*The worker pool used to reconstruct a frame's planes in parallel.*/
+struct oc_dec_threads{
+  /*A private copy of the pipeline state for each plane and stage.*/
+  oc_dec_pipeline_state  pipes[OC_DEC_NJOBS];
+  pthread_t             *workers;
+  int                    nworkers;
+  pthread_mutex_t        mutex;
+  /*Signaled when a new frame's jobs are available, or on shutdown.*/
+  pthread_cond_t         work_cond;
+  /*Signaled whenever a job finishes an MCU row.*/
+  pthread_cond_t         progress_cond;
+  /*The next job to hand out; OC_DEC_NJOBS when there are none left.*/
+  int                    next_job;
+  int                    njobs_done;
+  /*The number of MCU rows each job has finished in the current frame.*/
+  int                    progress[OC_DEC_NJOBS];
+  /*The reference frame buffer being reconstructed.*/
+  int                    refi;
+  int                    shutdown;
+};
+# endif
+
+
 struct th_dec_ctx{
   /*Shared encoder/decoder state.*/
   oc_theora_state        state;
@@ -156,6 +193,10 @@ struct th_dec_ctx{
   /*The striped decode callback function.*/
   th_stripe_callback     stripe_cb;
   oc_dec_pipeline_state  pipe;
+# if defined(OC_DEC_THREADS)
+  /*Reconstruction worker pool, or NULL to decode on the calling thread.*/
+  oc_dec_threads        *threads;
+# endif
 # if defined(OC_DEC_USE_VTABLE)
   /*Table for decoder acceleration functions.*/
   oc_dec_opt_vtable      opt_vtable;
@@ -416,6 +416,9 @@ static int oc_dec_init(oc_dec_ctx *_dec,const th_info *_info,
   _dec->pp_frame_data=NULL;
   _dec->stripe_cb.ctx=NULL;
   _dec->stripe_cb.stripe_decoded=NULL;
+#if defined(OC_DEC_THREADS)
+  _dec->threads=NULL;
+#endif
 #if defined(HAVE_CAIRO)
   _dec->telemetry=0;
   _dec->telemetry_bits=0;
@@ -427,7 +430,14 @@ static int oc_dec_init(oc_dec_ctx *_dec,const th_info *_info,
   return 0;
 }
 
+#if defined(OC_DEC_THREADS)
+static void oc_dec_threads_free(oc_dec_ctx *_dec);
+#endif
+
 static void oc_dec_clear(oc_dec_ctx *_dec){
+#if defined(OC_DEC_THREADS)
+  oc_dec_threads_free(_dec);
+#endif
 #if defined(HAVE_CAIRO)
   _ogg_free(_dec->telemetry_frame_data);
 #endif
@@ -1955,6 +1965,286 @@ static void oc_dec_dering_frag_rows(oc_dec_ctx *_dec,th_img_plane *_img,
 }
 
 
+/*Compute the first and last fragment row of the current MCU for one plane,
+   given the first luma fragment row of the MCU.*/
+static void oc_dec_mcu_plane_rows(oc_dec_ctx *_dec,
+ oc_dec_pipeline_state *_pipe,int _pli,int _stripe_fragy){
+  int frag_shift;
+  frag_shift=_pli!=0&&!(_dec->state.info.pixel_fmt&2);
+  _pipe->fragy0[_pli]=_stripe_fragy>>frag_shift;
+  _pipe->fragy_end[_pli]=OC_MINI(_dec->state.fplanes[_pli].nvfrags,
+   _pipe->fragy0[_pli]+(_pipe->mcu_nvfrags>>frag_shift));
+}
+
+/*Undo the DC prediction in and reconstruct one plane of an MCU.*/
+static void oc_dec_mcu_plane_recon(oc_dec_ctx *_dec,
+ oc_dec_pipeline_state *_pipe,int _pli){
+  oc_dec_dc_unpredict_mcu_plane(_dec,_pipe,_pli);
+  oc_dec_frags_recon_mcu_plane(_dec,_pipe,_pli);
+}
+
+/*Run the loop filter, border filling, and out-of-loop post-processing over
+   one plane of an MCU.
+  Each filter lags one fragment row behind the one before it, except at the
+   start and end of the frame.*/
+static void oc_dec_mcu_plane_filter(oc_dec_ctx *_dec,
+ oc_dec_pipeline_state *_pipe,int _refi,int _pli,int _notstart,int _notdone){
+  int pp_offset;
+  int sdelay;
+  int edelay;
+  sdelay=edelay=0;
+  if(_pipe->loop_filter){
+    sdelay+=_notstart;
+    edelay+=_notdone;
+    oc_state_loop_filter_frag_rows(&_dec->state,
+     _pipe->bounding_values,OC_FRAME_SELF,_pli,
+     _pipe->fragy0[_pli]-sdelay,_pipe->fragy_end[_pli]-edelay);
+  }
+  /*To fill the borders, we have an additional two pixel delay, since a
+     fragment in the next row could filter its top edge, using two pixels
+     from a fragment in this row.
+    But there's no reason to delay a full fragment between the two.*/
+  oc_state_borders_fill_rows(&_dec->state,_refi,_pli,
+   (_pipe->fragy0[_pli]-sdelay<<3)-(sdelay<<1),
+   (_pipe->fragy_end[_pli]-edelay<<3)-(edelay<<1));
+  /*Out-of-loop post-processing.*/
+  pp_offset=3*(_pli!=0);
+  if(_pipe->pp_level>=OC_PP_LEVEL_DEBLOCKY+pp_offset){
+    /*Perform de-blocking in one plane.*/
+    sdelay+=_notstart;
+    edelay+=_notdone;
+    oc_dec_deblock_frag_rows(_dec,_dec->pp_frame_buf,
+     _dec->state.ref_frame_bufs[_refi],_pli,
+     _pipe->fragy0[_pli]-sdelay,_pipe->fragy_end[_pli]-edelay);
+    if(_pipe->pp_level>=OC_PP_LEVEL_DERINGY+pp_offset){
+      /*Perform de-ringing in one plane.*/
+      sdelay+=_notstart;
+      edelay+=_notdone;
+      oc_dec_dering_frag_rows(_dec,_dec->pp_frame_buf,_pli,
+       _pipe->fragy0[_pli]-sdelay,_pipe->fragy_end[_pli]-edelay);
+    }
+  }
+}
+
+/*Intersect the luma fragment rows available for output in one plane of an
+   MCU with those of the planes before it.
+  If chroma is sub-sampled, the effect of each of its delays is doubled, but
+   luma might have more post-processing filters enabled than chroma, so we
+   don't know up front which one is the limiting factor.*/
+static void oc_dec_mcu_plane_avail(oc_dec_ctx *_dec,
+ const oc_dec_pipeline_state *_pipe,int _pli,int _notstart,int _notdone,
+ int *_avail_fragy0,int *_avail_fragy_end){
+  int frag_shift;
+  int pp_offset;
+  int ndelays;
+  frag_shift=_pli!=0&&!(_dec->state.info.pixel_fmt&2);
+  ndelays=_pipe->loop_filter;
+  pp_offset=3*(_pli!=0);
+  if(_pipe->pp_level>=OC_PP_LEVEL_DEBLOCKY+pp_offset){
+    ndelays++;
+    if(_pipe->pp_level>=OC_PP_LEVEL_DERINGY+pp_offset)ndelays++;
+  }
+  /*If no post-processing is done, we still need to delay a row for the
+     loop filter, thanks to the strange filtering order VP3 chose.*/
+  else ndelays+=_pipe->loop_filter;
+  *_avail_fragy0=OC_MINI(*_avail_fragy0,
+   _pipe->fragy0[_pli]-ndelays*_notstart<<frag_shift);
+  *_avail_fragy_end=OC_MINI(*_avail_fragy_end,
+   _pipe->fragy_end[_pli]-ndelays*_notdone<<frag_shift);
+}
+
+
+
+#if defined(OC_DEC_THREADS)
+/*Run one plane and stage of the current frame's reconstruction.
+  Jobs 0...2 reconstruct each plane, and jobs 3...5 filter them, one MCU row
+   behind.*/
+static void oc_dec_threads_run_job(oc_dec_ctx *_dec,int _jobi){
+  oc_dec_threads        *threads;
+  oc_dec_pipeline_state *pipe;
+  int                    stripe_fragy;
+  int                    stripei;
+  int                    notstart;
+  int                    notdone;
+  int                    pli;
+  threads=_dec->threads;
+  pipe=threads->pipes+_jobi;
+  pli=_jobi%3;
+  notstart=0;
+  notdone=1;
+  for(stripei=stripe_fragy=0;notdone;
+   stripei++,stripe_fragy+=pipe->mcu_nvfrags){
+    notdone=stripe_fragy+pipe->mcu_nvfrags<_dec->state.fplanes[0].nvfrags;
+    oc_dec_mcu_plane_rows(_dec,pipe,pli,stripe_fragy);
+    if(_jobi<3)oc_dec_mcu_plane_recon(_dec,pipe,pli);
+    else{
+      /*None of the filters touch rows past the end of the current MCU, so
+         reconstruction of the next one can carry on underneath us.*/
+      pthread_mutex_lock(&threads->mutex);
+      while(threads->progress[pli]<=stripei){
+        pthread_cond_wait(&threads->progress_cond,&threads->mutex);
+      }
+      pthread_mutex_unlock(&threads->mutex);
+      oc_dec_mcu_plane_filter(_dec,pipe,threads->refi,pli,notstart,notdone);
+    }
+    pthread_mutex_lock(&threads->mutex);
+    threads->progress[_jobi]=stripei+1;
+    pthread_cond_broadcast(&threads->progress_cond);
+    pthread_mutex_unlock(&threads->mutex);
+    notstart=1;
+  }
+}
+
+/*Run jobs for the current frame until there are none left to hand out.
+  The mutex must be held on entry, and is held again on return.*/
+static void oc_dec_threads_work(oc_dec_ctx *_dec){
+  oc_dec_threads *threads;
+  threads=_dec->threads;
+  while(threads->next_job<OC_DEC_NJOBS){
+    int jobi;
+    jobi=threads->next_job++;
+    pthread_mutex_unlock(&threads->mutex);
+    oc_dec_threads_run_job(_dec,jobi);
+    pthread_mutex_lock(&threads->mutex);
+    if(++threads->njobs_done>=OC_DEC_NJOBS){
+      pthread_cond_broadcast(&threads->progress_cond);
+    }
+  }
+}
+
+static void *oc_dec_threads_main(void *_arg){
+  oc_dec_ctx     *dec;
+  oc_dec_threads *threads;
+  dec=(oc_dec_ctx *)_arg;
+  threads=dec->threads;
+  pthread_mutex_lock(&threads->mutex);
+  for(;;){
+    while(!threads->shutdown&&threads->next_job>=OC_DEC_NJOBS){
+      pthread_cond_wait(&threads->work_cond,&threads->mutex);
+    }
+    if(threads->shutdown)break;
+    oc_dec_threads_work(dec);
+  }
+  pthread_mutex_unlock(&threads->mutex);
+  return NULL;
+}
+
+/*Reconstruct the current frame on the worker pool.
+  Jobs are handed out in order, so a filtering job only ever waits on a
+   reconstruction job that is already running, however few workers there are.
+  The calling thread makes the striped decode callbacks as MCU rows are
+   finished, or if there are none to make, takes jobs itself.*/
+static void oc_dec_threads_recon(oc_dec_ctx *_dec,int _refi,
+ th_ycbcr_buffer _stripe_buf,int _stripe_cb){
+  oc_dec_threads *threads;
+  int             stripe_fragy;
+  int             stripei;
+  int             notstart;
+  int             notdone;
+  int             jobi;
+  int             pli;
+  threads=_dec->threads;
+  for(jobi=0;jobi<OC_DEC_NJOBS;jobi++){
+    memcpy(threads->pipes+jobi,&_dec->pipe,sizeof(_dec->pipe));
+  }
+  pthread_mutex_lock(&threads->mutex);
+  memset(threads->progress,0,sizeof(threads->progress));
+  threads->refi=_refi;
+  threads->njobs_done=0;
+  threads->next_job=0;
+  pthread_cond_broadcast(&threads->work_cond);
+  if(!_stripe_cb)oc_dec_threads_work(_dec);
+  else{
+    notstart=0;
+    notdone=1;
+    for(stripei=stripe_fragy=0;notdone;
+     stripei++,stripe_fragy+=_dec->pipe.mcu_nvfrags){
+      int avail_fragy0;
+      int avail_fragy_end;
+      avail_fragy0=avail_fragy_end=_dec->state.fplanes[0].nvfrags;
+      notdone=stripe_fragy+_dec->pipe.mcu_nvfrags<avail_fragy_end;
+      for(pli=0;pli<3;pli++){
+        while(threads->progress[3+pli]<=stripei){
+          pthread_cond_wait(&threads->progress_cond,&threads->mutex);
+        }
+        oc_dec_mcu_plane_rows(_dec,&_dec->pipe,pli,stripe_fragy);
+        oc_dec_mcu_plane_avail(_dec,&_dec->pipe,pli,notstart,notdone,
+         &avail_fragy0,&avail_fragy_end);
+      }
+      pthread_mutex_unlock(&threads->mutex);
+      oc_restore_fpu(&_dec->state);
+      (*_dec->stripe_cb.stripe_decoded)(_dec->stripe_cb.ctx,_stripe_buf,
+       _dec->state.fplanes[0].nvfrags-avail_fragy_end,
+       _dec->state.fplanes[0].nvfrags-avail_fragy0);
+      pthread_mutex_lock(&threads->mutex);
+      notstart=1;
+    }
+  }
+  while(threads->njobs_done<OC_DEC_NJOBS){
+    pthread_cond_wait(&threads->progress_cond,&threads->mutex);
+  }
+  pthread_mutex_unlock(&threads->mutex);
+}
+
+static void oc_dec_threads_free(oc_dec_ctx *_dec){
+  oc_dec_threads *threads;
+  int             ti;
+  threads=_dec->threads;
+  if(threads==NULL)return;
+  pthread_mutex_lock(&threads->mutex);
+  threads->shutdown=1;
+  pthread_cond_broadcast(&threads->work_cond);
+  pthread_mutex_unlock(&threads->mutex);
+  for(ti=0;ti<threads->nworkers;ti++)pthread_join(threads->workers[ti],NULL);
+  pthread_cond_destroy(&threads->progress_cond);
+  pthread_cond_destroy(&threads->work_cond);
+  pthread_mutex_destroy(&threads->mutex);
+  _ogg_free(threads->workers);
+  oc_aligned_free(threads);
+  _dec->threads=NULL;
+}
+
+/*Start a worker pool so that frames are reconstructed with _nthreads threads
+   in total, counting the one calling th_decode_packetin().*/
+static int oc_dec_threads_init(oc_dec_ctx *_dec,int _nthreads){
+  oc_dec_threads *threads;
+  int             nworkers;
+  int             ti;
+  oc_dec_threads_free(_dec);
+  if(_nthreads<=1)return 0;
+  /*There's no use in more threads than jobs.*/
+  nworkers=OC_MINI(_nthreads,OC_DEC_NJOBS)-1;
+  threads=(oc_dec_threads *)oc_aligned_malloc(sizeof(*threads),16);
+  if(threads==NULL)return TH_EFAULT;
+  threads->workers=(pthread_t *)_ogg_malloc(
+   nworkers*sizeof(*threads->workers));
+  if(threads->workers==NULL){
+    oc_aligned_free(threads);
+    return TH_EFAULT;
+  }
+  pthread_mutex_init(&threads->mutex,NULL);
+  pthread_cond_init(&threads->work_cond,NULL);
+  pthread_cond_init(&threads->progress_cond,NULL);
+  threads->nworkers=0;
+  threads->next_job=threads->njobs_done=OC_DEC_NJOBS;
+  threads->shutdown=0;
+  _dec->threads=threads;
+  for(ti=0;ti<nworkers;ti++){
+    if(pthread_create(threads->workers+ti,NULL,oc_dec_threads_main,_dec)){
+      break;
+    }
+    threads->nworkers++;
+  }
+  /*Striped decode callbacks need at least one worker to make progress.*/
+  if(threads->nworkers<=0){
+    oc_dec_threads_free(_dec);
+    return TH_EFAULT;
+  }
+  return 0;
+}
+#endif
+
+
 
 th_dec_ctx *th_decode_alloc(const th_info *_info,const th_setup_info *_setup){
   oc_dec_ctx *dec;
@@ -2015,6 +2305,16 @@ int th_decode_ctl(th_dec_ctx *_dec,int _req,void *_buf,
     _dec->stripe_cb.stripe_decoded=cb->stripe_decoded;
     return 0;
   }break;
+#if defined(OC_DEC_THREADS)
+  case TH_DECCTL_SET_THREADS:{
+    int nthreads;
+    if(_dec==NULL||_buf==NULL)return TH_EFAULT;
+    if(_buf_sz!=sizeof(int))return TH_EINVAL;
+    nthreads=*(int *)_buf;
+    if(nthreads<0)return TH_EINVAL;
+    return oc_dec_threads_init(_dec,nthreads);
+  }break;
+#endif
 #ifdef HAVE_CAIRO
   case TH_DECCTL_SET_TELEMETRY_MBMODE:{
     if(_dec==NULL||_buf==NULL)return TH_EFAULT;
@@ -2856,73 +3156,31 @@ int th_decode_packetin(th_dec_ctx *_dec,const ogg_packet *_op,
     oc_ycbcr_buffer_flip(stripe_buf,_dec->pp_frame_buf);
     notstart=0;
     notdone=1;
+#if defined(OC_DEC_THREADS)
+    /*With a worker pool, the same pipeline runs with each plane and each of
+       its two halves on its own thread instead.*/
+    if(_dec->threads!=NULL){
+# ifdef HAVE_CAIRO
+      oc_dec_threads_recon(_dec,refi,stripe_buf,
+       _dec->stripe_cb.stripe_decoded!=NULL&&!telemetry);
+# else
+      oc_dec_threads_recon(_dec,refi,stripe_buf,
+       _dec->stripe_cb.stripe_decoded!=NULL);
+# endif
+      notdone=0;
+    }
+#endif
     for(stripe_fragy=0;notdone;stripe_fragy+=_dec->pipe.mcu_nvfrags){
       int avail_fragy0;
       int avail_fragy_end;
       avail_fragy0=avail_fragy_end=_dec->state.fplanes[0].nvfrags;
       notdone=stripe_fragy+_dec->pipe.mcu_nvfrags<avail_fragy_end;
       for(pli=0;pli<3;pli++){
-        oc_fragment_plane *fplane;
-        int                frag_shift;
-        int                pp_offset;
-        int                sdelay;
-        int                edelay;
-        fplane=_dec->state.fplanes+pli;
-        /*Compute the first and last fragment row of the current MCU for this
-           plane.*/
-        frag_shift=pli!=0&&!(_dec->state.info.pixel_fmt&2);
-        _dec->pipe.fragy0[pli]=stripe_fragy>>frag_shift;
-        _dec->pipe.fragy_end[pli]=OC_MINI(fplane->nvfrags,
-         _dec->pipe.fragy0[pli]+(_dec->pipe.mcu_nvfrags>>frag_shift));
-        oc_dec_dc_unpredict_mcu_plane(_dec,&_dec->pipe,pli);
-        oc_dec_frags_recon_mcu_plane(_dec,&_dec->pipe,pli);
-        sdelay=edelay=0;
-        if(_dec->pipe.loop_filter){
-          sdelay+=notstart;
-          edelay+=notdone;
-          oc_state_loop_filter_frag_rows(&_dec->state,
-           _dec->pipe.bounding_values,OC_FRAME_SELF,pli,
-           _dec->pipe.fragy0[pli]-sdelay,_dec->pipe.fragy_end[pli]-edelay);
-        }
-        /*To fill the borders, we have an additional two pixel delay, since a
-           fragment in the next row could filter its top edge, using two pixels
-           from a fragment in this row.
-          But there's no reason to delay a full fragment between the two.*/
-        oc_state_borders_fill_rows(&_dec->state,refi,pli,
-         (_dec->pipe.fragy0[pli]-sdelay<<3)-(sdelay<<1),
-         (_dec->pipe.fragy_end[pli]-edelay<<3)-(edelay<<1));
-        /*Out-of-loop post-processing.*/
-        pp_offset=3*(pli!=0);
-        if(_dec->pipe.pp_level>=OC_PP_LEVEL_DEBLOCKY+pp_offset){
-          /*Perform de-blocking in one plane.*/
-          sdelay+=notstart;
-          edelay+=notdone;
-          oc_dec_deblock_frag_rows(_dec,_dec->pp_frame_buf,
-           _dec->state.ref_frame_bufs[refi],pli,
-           _dec->pipe.fragy0[pli]-sdelay,_dec->pipe.fragy_end[pli]-edelay);
-          if(_dec->pipe.pp_level>=OC_PP_LEVEL_DERINGY+pp_offset){
-            /*Perform de-ringing in one plane.*/
-            sdelay+=notstart;
-            edelay+=notdone;
-            oc_dec_dering_frag_rows(_dec,_dec->pp_frame_buf,pli,
-             _dec->pipe.fragy0[pli]-sdelay,_dec->pipe.fragy_end[pli]-edelay);
-          }
-        }
-        /*If no post-processing is done, we still need to delay a row for the
-           loop filter, thanks to the strange filtering order VP3 chose.*/
-        else if(_dec->pipe.loop_filter){
-          sdelay+=notstart;
-          edelay+=notdone;
-        }
-        /*Compute the intersection of the available rows in all planes.
-          If chroma is sub-sampled, the effect of each of its delays is
-           doubled, but luma might have more post-processing filters enabled
-           than chroma, so we don't know up front which one is the limiting
-           factor.*/
-        avail_fragy0=OC_MINI(avail_fragy0,
-         _dec->pipe.fragy0[pli]-sdelay<<frag_shift);
-        avail_fragy_end=OC_MINI(avail_fragy_end,
-         _dec->pipe.fragy_end[pli]-edelay<<frag_shift);
+        oc_dec_mcu_plane_rows(_dec,&_dec->pipe,pli,stripe_fragy);
+        oc_dec_mcu_plane_recon(_dec,&_dec->pipe,pli);
+        oc_dec_mcu_plane_filter(_dec,&_dec->pipe,refi,pli,notstart,notdone);
+        oc_dec_mcu_plane_avail(_dec,&_dec->pipe,pli,notstart,notdone,
+         &avail_fragy0,&avail_fragy_end);
       }
 #ifdef HAVE_CAIRO
       if(_dec->stripe_cb.stripe_decoded!=NULL&&!telemetry){
@@ -0,0 +1,123 @@
+/********************************************************************
+ *                                                                  *
+ * THIS FILE IS PART OF THE OggTheora SOFTWARE CODEC SOURCE CODE.   *
+ * USE, DISTRIBUTION AND REPRODUCTION OF THIS LIBRARY SOURCE IS     *
+ * GOVERNED BY A BSD-STYLE SOURCE LICENSE INCLUDED WITH THIS SOURCE *
+ * IN 'COPYING'. PLEASE READ THESE TERMS BEFORE DISTRIBUTING.       *
+ *                                                                  *
+ * THE Theora SOURCE CODE IS COPYRIGHT (C) 2002-2009                *
+ * by the Xiph.Org Foundation and contributors http://www.xiph.org/ *
+ *                                                                  *
+ ********************************************************************
+
+  function:
+    last mod: $Id$
+
+ ********************************************************************/
+
+/*128-bit vector fragment copy and reconstruction.
+  Two rows of an 8x8 fragment share a vector wherever the pixels are 8 bits,
+   and each row of residue fills one vector on its own.*/
+#include "simd128vec.h"
+
+#if defined(OC_SIMD128)
+
+/*Copies an 8x8 block of pixels from _src to _dst, assuming _ystride bytes
+   between rows.*/
+void oc_frag_copy_simd128(unsigned char *_dst,
+ const unsigned char *_src,int _ystride){
+  int i;
+  for(i=0;i<8;i++){
+    oc_v128_store64(_dst,oc_v128_load64(_src));
+    _dst+=_ystride;
+    _src+=_ystride;
+  }
+}
+
+/*Copies the fragments specified by the lists of fragment indices from one
+   frame to another.
+  _dst_frame:     The reference frame to copy to.
+  _src_frame:     The reference frame to copy from.
+  _ystride:       The row stride of the reference frames.
+  _fragis:        A pointer to a list of fragment indices.
+  _nfragis:       The number of fragment indices to copy.
+  _frag_buf_offs: The offsets of fragments in the reference frames.*/
+void oc_frag_copy_list_simd128(unsigned char *_dst_frame,
+ const unsigned char *_src_frame,int _ystride,
+ const ptrdiff_t *_fragis,ptrdiff_t _nfragis,const ptrdiff_t *_frag_buf_offs){
+  ptrdiff_t fragii;
+  for(fragii=0;fragii<_nfragis;fragii++){
+    ptrdiff_t frag_buf_off;
+    frag_buf_off=_frag_buf_offs[_fragis[fragii]];
+    oc_frag_copy_simd128(_dst_frame+frag_buf_off,
+     _src_frame+frag_buf_off,_ystride);
+  }
+}
+
+/*The residue is added with signed saturation before narrowing, which clamps
+   exactly as the C version's int arithmetic does: any sum that saturates at
+   32767 still ends up at 255.*/
+void oc_frag_recon_intra_simd128(unsigned char *_dst,int _ystride,
+ const ogg_int16_t *_residue){
+  oc_v128 bias;
+  int     i;
+  bias=oc_v128_splat16(128);
+  for(i=0;i<8;i+=2){
+    oc_v128 r0;
+    oc_v128 r1;
+    oc_v128 p;
+    r0=oc_v128_adds16(oc_v128_load(_residue+i*8),bias);
+    r1=oc_v128_adds16(oc_v128_load(_residue+i*8+8),bias);
+    p=oc_v128_packus16(r0,r1);
+    oc_v128_store64(_dst,p);
+    oc_v128_store64_hi(_dst+_ystride,p);
+    _dst+=_ystride<<1;
+  }
+}
+
+void oc_frag_recon_inter_simd128(unsigned char *_dst,
+ const unsigned char *_src,int _ystride,const ogg_int16_t *_residue){
+  int i;
+  for(i=0;i<8;i+=2){
+    oc_v128 r0;
+    oc_v128 r1;
+    oc_v128 p;
+    r0=oc_v128_adds16(oc_v128_load(_residue+i*8),oc_v128_load_u8x8(_src));
+    r1=oc_v128_adds16(oc_v128_load(_residue+i*8+8),
+     oc_v128_load_u8x8(_src+_ystride));
+    p=oc_v128_packus16(r0,r1);
+    oc_v128_store64(_dst,p);
+    oc_v128_store64_hi(_dst+_ystride,p);
+    _dst+=_ystride<<1;
+    _src+=_ystride<<1;
+  }
+}
+
+/*The predictor is the truncated average of the two references, so it is
+   formed in 16 bits rather than with a rounding byte average.*/
+void oc_frag_recon_inter2_simd128(unsigned char *_dst,
+ const unsigned char *_src1,const unsigned char *_src2,int _ystride,
+ const ogg_int16_t *_residue){
+  int i;
+  for(i=0;i<8;i+=2){
+    oc_v128 s0;
+    oc_v128 s1;
+    oc_v128 r0;
+    oc_v128 r1;
+    oc_v128 p;
+    s0=oc_v128_srli16(oc_v128_add16(oc_v128_load_u8x8(_src1),
+     oc_v128_load_u8x8(_src2)),1);
+    s1=oc_v128_srli16(oc_v128_add16(oc_v128_load_u8x8(_src1+_ystride),
+     oc_v128_load_u8x8(_src2+_ystride)),1);
+    r0=oc_v128_adds16(oc_v128_load(_residue+i*8),s0);
+    r1=oc_v128_adds16(oc_v128_load(_residue+i*8+8),s1);
+    p=oc_v128_packus16(r0,r1);
+    oc_v128_store64(_dst,p);
+    oc_v128_store64_hi(_dst+_ystride,p);
+    _dst+=_ystride<<1;
+    _src1+=_ystride<<1;
+    _src2+=_ystride<<1;
+  }
+}
+
+#endif
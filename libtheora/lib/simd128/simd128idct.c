@@ -0,0 +1,153 @@
+/********************************************************************
+ *                                                                  *
+ * THIS FILE IS PART OF THE OggTheora SOFTWARE CODEC SOURCE CODE.   *
+ * USE, DISTRIBUTION AND REPRODUCTION OF THIS LIBRARY SOURCE IS     *
+ * GOVERNED BY A BSD-STYLE SOURCE LICENSE INCLUDED WITH THIS SOURCE *
+ * IN 'COPYING'. PLEASE READ THESE TERMS BEFORE DISTRIBUTING.       *
+ *                                                                  *
+ * THE Theora SOURCE CODE IS COPYRIGHT (C) 2002-2009                *
+ * by the Xiph.Org Foundation and contributors http://www.xiph.org/ *
+ *                                                                  *
+ ********************************************************************
+
+  function:
+    last mod: $Id$
+
+ ********************************************************************/
+
+/*128-bit vector inverse DCT.
+  Each vector holds one row of 16-bit values, so the butterflies of idct8()
+   in idct.c transform all eight columns at once.
+  The coefficients arrive in the transposed order given by the accelerated
+   zig-zag table, so the first pass needs no transpose, and the second needs
+   just one.*/
+#include "simd128vec.h"
+#include "../dct.h"
+
+#if defined(OC_SIMD128)
+
+/*The C transform multiplies 16-bit values by 16-bit unsigned constants and
+   keeps the top half of the 32-bit product.
+  Constants of 32768 and up don't fit in a signed multiplier, so multiply by
+   _c-65536 instead and add _x back in, which gives the same bits.*/
+#define OC_MUL_LO(_x,_c) \
+  oc_v128_mulhi16(_x,oc_v128_splat16((ogg_int16_t)(_c)))
+#define OC_MUL_HI(_x,_c) \
+  oc_v128_add16(oc_v128_mulhi16(_x, \
+   oc_v128_splat16((ogg_int16_t)((_c)-65536))),_x)
+
+/*One pass of the 1D transform, with the same truncation as idct8().
+  All of the intermediate sums wrap to 16 bits here, where the C version keeps
+   them in 32; that only matters for the values fed to a multiply, and those
+   are explicitly truncated to 16 bits there too.*/
+static void oc_idct8_simd128(oc_v128 _y[8],const oc_v128 _x[8]){
+  oc_v128 t[8];
+  oc_v128 r;
+  /*Stage 1:*/
+  /*0-1 butterfly.*/
+  t[0]=OC_MUL_HI(oc_v128_add16(_x[0],_x[4]),OC_C4S4);
+  t[1]=OC_MUL_HI(oc_v128_sub16(_x[0],_x[4]),OC_C4S4);
+  /*2-3 rotation by 6pi/16.*/
+  t[2]=oc_v128_sub16(OC_MUL_LO(_x[2],OC_C6S2),OC_MUL_HI(_x[6],OC_C2S6));
+  t[3]=oc_v128_add16(OC_MUL_HI(_x[2],OC_C2S6),OC_MUL_LO(_x[6],OC_C6S2));
+  /*4-7 rotation by 7pi/16.*/
+  t[4]=oc_v128_sub16(OC_MUL_LO(_x[1],OC_C7S1),OC_MUL_HI(_x[7],OC_C1S7));
+  /*5-6 rotation by 3pi/16.*/
+  t[5]=oc_v128_sub16(OC_MUL_HI(_x[5],OC_C3S5),OC_MUL_HI(_x[3],OC_C5S3));
+  t[6]=oc_v128_add16(OC_MUL_HI(_x[5],OC_C5S3),OC_MUL_HI(_x[3],OC_C3S5));
+  t[7]=oc_v128_add16(OC_MUL_HI(_x[1],OC_C1S7),OC_MUL_LO(_x[7],OC_C7S1));
+  /*Stage 2:*/
+  /*4-5 butterfly.*/
+  r=oc_v128_add16(t[4],t[5]);
+  t[5]=OC_MUL_HI(oc_v128_sub16(t[4],t[5]),OC_C4S4);
+  t[4]=r;
+  /*7-6 butterfly.*/
+  r=oc_v128_add16(t[7],t[6]);
+  t[6]=OC_MUL_HI(oc_v128_sub16(t[7],t[6]),OC_C4S4);
+  t[7]=r;
+  /*Stage 3:*/
+  /*0-3 butterfly.*/
+  r=oc_v128_add16(t[0],t[3]);
+  t[3]=oc_v128_sub16(t[0],t[3]);
+  t[0]=r;
+  /*1-2 butterfly.*/
+  r=oc_v128_add16(t[1],t[2]);
+  t[2]=oc_v128_sub16(t[1],t[2]);
+  t[1]=r;
+  /*6-5 butterfly.*/
+  r=oc_v128_add16(t[6],t[5]);
+  t[5]=oc_v128_sub16(t[6],t[5]);
+  t[6]=r;
+  /*Stage 4:*/
+  _y[0]=oc_v128_add16(t[0],t[7]);
+  _y[1]=oc_v128_add16(t[1],t[6]);
+  _y[2]=oc_v128_add16(t[2],t[5]);
+  _y[3]=oc_v128_add16(t[3],t[4]);
+  _y[4]=oc_v128_sub16(t[3],t[4]);
+  _y[5]=oc_v128_sub16(t[2],t[5]);
+  _y[6]=oc_v128_sub16(t[1],t[6]);
+  _y[7]=oc_v128_sub16(t[0],t[7]);
+}
+
+/*Transposes an 8x8 block of 16-bit values held one row per vector.*/
+static void oc_transpose8x8_simd128(oc_v128 _y[8],const oc_v128 _x[8]){
+  oc_v128 a[8];
+  oc_v128 b[8];
+  a[0]=oc_v128_unpacklo16(_x[0],_x[1]);
+  a[1]=oc_v128_unpackhi16(_x[0],_x[1]);
+  a[2]=oc_v128_unpacklo16(_x[2],_x[3]);
+  a[3]=oc_v128_unpackhi16(_x[2],_x[3]);
+  a[4]=oc_v128_unpacklo16(_x[4],_x[5]);
+  a[5]=oc_v128_unpackhi16(_x[4],_x[5]);
+  a[6]=oc_v128_unpacklo16(_x[6],_x[7]);
+  a[7]=oc_v128_unpackhi16(_x[6],_x[7]);
+  b[0]=oc_v128_unpacklo32(a[0],a[2]);
+  b[1]=oc_v128_unpackhi32(a[0],a[2]);
+  b[2]=oc_v128_unpacklo32(a[1],a[3]);
+  b[3]=oc_v128_unpackhi32(a[1],a[3]);
+  b[4]=oc_v128_unpacklo32(a[4],a[6]);
+  b[5]=oc_v128_unpackhi32(a[4],a[6]);
+  b[6]=oc_v128_unpacklo32(a[5],a[7]);
+  b[7]=oc_v128_unpackhi32(a[5],a[7]);
+  _y[0]=oc_v128_unpacklo64(b[0],b[4]);
+  _y[1]=oc_v128_unpackhi64(b[0],b[4]);
+  _y[2]=oc_v128_unpacklo64(b[1],b[5]);
+  _y[3]=oc_v128_unpackhi64(b[1],b[5]);
+  _y[4]=oc_v128_unpacklo64(b[2],b[6]);
+  _y[5]=oc_v128_unpackhi64(b[2],b[6]);
+  _y[6]=oc_v128_unpacklo64(b[3],b[7]);
+  _y[7]=oc_v128_unpackhi64(b[3],b[7]);
+}
+
+/*Performs an inverse 8x8 Type-II DCT transform.
+  The reduced transforms oc_idct8x8_c() uses for short blocks give the same
+   results as the full one when the remaining coefficients are zero, and the
+   full transform is only a few dozen vector operations, so _last_zzi is
+   ignored.*/
+void oc_idct8x8_simd128(ogg_int16_t _y[64],ogg_int16_t _x[64],int _last_zzi){
+  oc_v128 x[8];
+  oc_v128 w[8];
+  oc_v128 zero;
+  int     i;
+  (void)_last_zzi;
+  zero=oc_v128_zero();
+  for(i=0;i<8;i++){
+    x[i]=oc_v128_load(_x+i*8);
+    /*Clear input data for next block.*/
+    oc_v128_store(_x+i*8,zero);
+  }
+  /*The rows of the transposed input are the columns of x, so this transforms
+     the rows of x into the rows of w.*/
+  oc_idct8_simd128(w,x);
+  oc_transpose8x8_simd128(x,w);
+  oc_idct8_simd128(w,x);
+  for(i=0;i<8;i++){
+    /*Adjust for the scale factor.
+      This is (y+8>>4) rearranged so the bias can't overflow 16 bits.*/
+    w[i]=oc_v128_srai16(oc_v128_add16(oc_v128_srai16(w[i],1),
+     oc_v128_splat16(4)),3);
+    oc_v128_store(_y+i*8,w[i]);
+  }
+}
+
+#endif
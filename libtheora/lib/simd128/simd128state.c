@@ -0,0 +1,243 @@
+/********************************************************************
+ *                                                                  *
+ * THIS FILE IS PART OF THE OggTheora SOFTWARE CODEC SOURCE CODE.   *
+ * USE, DISTRIBUTION AND REPRODUCTION OF THIS LIBRARY SOURCE IS     *
+ * GOVERNED BY A BSD-STYLE SOURCE LICENSE INCLUDED WITH THIS SOURCE *
+ * IN 'COPYING'. PLEASE READ THESE TERMS BEFORE DISTRIBUTING.       *
+ *                                                                  *
+ * THE Theora SOURCE CODE IS COPYRIGHT (C) 2002-2009                *
+ * by the Xiph.Org Foundation and contributors http://www.xiph.org/ *
+ *                                                                  *
+ ********************************************************************
+
+  function:
+    last mod: $Id$
+
+ ********************************************************************/
+
+/*128-bit vector fragment reconstruction and loop filter.*/
+#include "simd128vec.h"
+
+#if defined(OC_SIMD128)
+
+/*This table has been modified from OC_FZIG_ZAG by baking an 8x8 transpose into
+   the destination, as oc_idct8x8_simd128() expects.*/
+static const unsigned char OC_FZIG_ZAG_SIMD128[128]={
+   0, 8, 1, 2, 9,16,24,17,
+  10, 3, 4,11,18,25,32,40,
+  33,26,19,12, 5, 6,13,20,
+  27,34,41,48,56,49,42,35,
+  28,21,14, 7,15,22,29,36,
+  43,50,57,58,51,44,37,30,
+  23,31,38,45,52,59,60,53,
+  46,39,47,54,61,62,55,63,
+  64,64,64,64,64,64,64,64,
+  64,64,64,64,64,64,64,64,
+  64,64,64,64,64,64,64,64,
+  64,64,64,64,64,64,64,64,
+  64,64,64,64,64,64,64,64,
+  64,64,64,64,64,64,64,64,
+  64,64,64,64,64,64,64,64,
+  64,64,64,64,64,64,64,64
+};
+
+void oc_state_accel_init_simd128(oc_theora_state *_state){
+  oc_state_accel_init_c(_state);
+  _state->opt_data.dct_fzig_zag=OC_FZIG_ZAG_SIMD128;
+}
+
+void oc_state_frag_recon_simd128(const oc_theora_state *_state,
+ ptrdiff_t _fragi,int _pli,ogg_int16_t _dct_coeffs[128],int _last_zzi,
+ ogg_uint16_t _dc_quant){
+  unsigned char *dst;
+  ptrdiff_t      frag_buf_off;
+  int            ystride;
+  int            refi;
+  /*Apply the inverse transform.*/
+  /*Special case only having a DC component.*/
+  if(_last_zzi<2){
+    oc_v128 p;
+    int     i;
+    /*We round this dequant product (and not any of the others) because there's
+       no iDCT rounding.*/
+    p=oc_v128_splat16(
+     (ogg_int16_t)(_dct_coeffs[0]*(ogg_int32_t)_dc_quant+15>>5));
+    for(i=0;i<8;i++)oc_v128_store(_dct_coeffs+64+i*8,p);
+  }
+  else{
+    /*First, dequantize the DC coefficient.*/
+    _dct_coeffs[0]=(ogg_int16_t)(_dct_coeffs[0]*(int)_dc_quant);
+    oc_idct8x8_simd128(_dct_coeffs+64,_dct_coeffs,_last_zzi);
+  }
+  /*Fill in the target buffer.*/
+  frag_buf_off=_state->frag_buf_offs[_fragi];
+  refi=_state->frags[_fragi].refi;
+  ystride=_state->ref_ystride[_pli];
+  dst=_state->ref_frame_data[OC_FRAME_SELF]+frag_buf_off;
+  if(refi==OC_FRAME_SELF){
+    oc_frag_recon_intra_simd128(dst,ystride,_dct_coeffs+64);
+  }
+  else{
+    const unsigned char *ref;
+    int                  mvoffsets[2];
+    ref=_state->ref_frame_data[refi]+frag_buf_off;
+    if(oc_state_get_mv_offsets(_state,mvoffsets,_pli,
+     _state->frag_mvs[_fragi])>1){
+      oc_frag_recon_inter2_simd128(dst,ref+mvoffsets[0],ref+mvoffsets[1],
+       ystride,_dct_coeffs+64);
+    }
+    else{
+      oc_frag_recon_inter_simd128(dst,ref+mvoffsets[0],ystride,
+       _dct_coeffs+64);
+    }
+  }
+}
+
+/*Computes the filtered values of the two pixels on either side of an edge,
+   for 8 positions along it.
+  On entry, _a, _b, _c and _d hold the two pixels on each side, zero-extended
+   to 16 bits.
+  The bounding values function of Section 7.10 of the spec is evaluated
+   directly rather than by table lookup:
+   lflim(R,L)=sign(R)*min(abs(R),max(2*L-abs(R),0)).
+  Returns {b0+lflim(R_0,L),...,b7+lflim(R_7,L),c0-lflim(R_0,L),...} as
+   bytes.*/
+static oc_v128 oc_loop_filter8_simd128(oc_v128 _a,oc_v128 _b,oc_v128 _c,
+ oc_v128 _d,oc_v128 _ll2){
+  oc_v128 f;
+  oc_v128 m;
+  oc_v128 r;
+  f=oc_v128_sub16(_c,_b);
+  f=oc_v128_add16(oc_v128_sub16(_a,_d),
+   oc_v128_add16(f,oc_v128_add16(f,f)));
+  r=oc_v128_srai16(oc_v128_add16(f,oc_v128_splat16(4)),3);
+  /*m=-1 where R is negative, so (x^m)-m negates there.*/
+  m=oc_v128_cmplt16(r,oc_v128_zero());
+  r=oc_v128_sub16(oc_v128_xor(r,m),m);
+  r=oc_v128_min16(r,oc_v128_max16(oc_v128_sub16(_ll2,r),oc_v128_zero()));
+  r=oc_v128_sub16(oc_v128_xor(r,m),m);
+  return oc_v128_packus16(oc_v128_add16(_b,r),oc_v128_sub16(_c,r));
+}
+
+/*Filters the vertical edge to the left of _pix.*/
+static void loop_filter_h(unsigned char *_pix,int _ystride,oc_v128 _ll2){
+  oc_v128 zero;
+  oc_v128 r[8];
+  oc_v128 lo;
+  oc_v128 hi;
+  oc_v128 p;
+  int     i;
+  _pix-=2;
+  /*Gather the 4 pixels of each row and transpose them into 8-pixel columns.*/
+  for(i=0;i<8;i++)r[i]=oc_v128_load32(_pix+i*_ystride);
+  r[0]=oc_v128_unpacklo16(oc_v128_unpacklo8(r[0],r[1]),
+   oc_v128_unpacklo8(r[2],r[3]));
+  r[4]=oc_v128_unpacklo16(oc_v128_unpacklo8(r[4],r[5]),
+   oc_v128_unpacklo8(r[6],r[7]));
+  /*lo={a0,...,a7,b0,...,b7}, hi={c0,...,c7,d0,...,d7}*/
+  lo=oc_v128_unpacklo32(r[0],r[4]);
+  hi=oc_v128_unpackhi32(r[0],r[4]);
+  zero=oc_v128_zero();
+  p=oc_loop_filter8_simd128(oc_v128_unpacklo8(lo,zero),
+   oc_v128_unpackhi8(lo,zero),oc_v128_unpacklo8(hi,zero),
+   oc_v128_unpackhi8(hi,zero),_ll2);
+  /*p={b0,c0,b1,c1,...}*/
+  p=oc_v128_unpacklo8(p,oc_v128_unpackhi64(p,p));
+# define OC_LOOP_FILTER_H_STORE(_i) \
+  do{ \
+    int v; \
+    v=oc_v128_extract16(p,_i); \
+    _pix[(_i)*_ystride+1]=(unsigned char)v; \
+    _pix[(_i)*_ystride+2]=(unsigned char)(v>>8); \
+  } \
+  while(0)
+  OC_LOOP_FILTER_H_STORE(0);
+  OC_LOOP_FILTER_H_STORE(1);
+  OC_LOOP_FILTER_H_STORE(2);
+  OC_LOOP_FILTER_H_STORE(3);
+  OC_LOOP_FILTER_H_STORE(4);
+  OC_LOOP_FILTER_H_STORE(5);
+  OC_LOOP_FILTER_H_STORE(6);
+  OC_LOOP_FILTER_H_STORE(7);
+# undef OC_LOOP_FILTER_H_STORE
+}
+
+/*Filters the horizontal edge above _pix.*/
+static void loop_filter_v(unsigned char *_pix,int _ystride,oc_v128 _ll2){
+  oc_v128 p;
+  _pix-=_ystride*2;
+  p=oc_loop_filter8_simd128(oc_v128_load_u8x8(_pix),
+   oc_v128_load_u8x8(_pix+_ystride),oc_v128_load_u8x8(_pix+_ystride*2),
+   oc_v128_load_u8x8(_pix+_ystride*3),_ll2);
+  oc_v128_store64(_pix+_ystride,p);
+  oc_v128_store64_hi(_pix+_ystride*2,p);
+}
+
+/*The filter works out the bounding values itself, so only the limit needs to
+   be saved.*/
+void oc_loop_filter_init_simd128(signed char _bv[256],int _flimit){
+  _bv[0]=(signed char)_flimit;
+}
+
+/*Apply the loop filter to a given set of fragment rows in the given plane.
+  The filter may be run on the bottom edge, affecting pixels in the next row of
+   fragments, so this row also needs to be available.
+  _bv:        The bounding values array.
+  _refi:      The index of the frame buffer to filter.
+  _pli:       The color plane to filter.
+  _fragy0:    The Y coordinate of the first fragment row to filter.
+  _fragy_end: The Y coordinate of the fragment row to stop filtering at.*/
+void oc_state_loop_filter_frag_rows_simd128(const oc_theora_state *_state,
+ signed char _bv[256],int _refi,int _pli,int _fragy0,int _fragy_end){
+  const oc_fragment_plane *fplane;
+  const oc_fragment       *frags;
+  const ptrdiff_t         *frag_buf_offs;
+  unsigned char           *ref_frame_data;
+  ptrdiff_t                fragi_top;
+  ptrdiff_t                fragi_bot;
+  ptrdiff_t                fragi0;
+  ptrdiff_t                fragi0_end;
+  int                      ystride;
+  int                      nhfrags;
+  oc_v128                  ll2;
+  ll2=oc_v128_splat16(_bv[0]<<1);
+  fplane=_state->fplanes+_pli;
+  nhfrags=fplane->nhfrags;
+  fragi_top=fplane->froffset;
+  fragi_bot=fragi_top+fplane->nfrags;
+  fragi0=fragi_top+_fragy0*(ptrdiff_t)nhfrags;
+  fragi0_end=fragi_top+_fragy_end*(ptrdiff_t)nhfrags;
+  ystride=_state->ref_ystride[_pli];
+  frags=_state->frags;
+  frag_buf_offs=_state->frag_buf_offs;
+  ref_frame_data=_state->ref_frame_data[_refi];
+  /*The following loops are constructed somewhat non-intuitively on purpose.
+    The main idea is: if a block boundary has at least one coded fragment on
+     it, the filter is applied to it.
+    However, the order that the filters are applied in matters, and VP3 chose
+     the somewhat strange ordering used below.*/
+  while(fragi0<fragi0_end){
+    ptrdiff_t fragi;
+    ptrdiff_t fragi_end;
+    fragi=fragi0;
+    fragi_end=fragi+nhfrags;
+    while(fragi<fragi_end){
+      if(frags[fragi].coded){
+        unsigned char *ref;
+        ref=ref_frame_data+frag_buf_offs[fragi];
+        if(fragi>fragi0)loop_filter_h(ref,ystride,ll2);
+        if(fragi0>fragi_top)loop_filter_v(ref,ystride,ll2);
+        if(fragi+1<fragi_end&&!frags[fragi+1].coded){
+          loop_filter_h(ref+8,ystride,ll2);
+        }
+        if(fragi+nhfrags<fragi_bot&&!frags[fragi+nhfrags].coded){
+          loop_filter_v(ref+(ystride<<3),ystride,ll2);
+        }
+      }
+      fragi++;
+    }
+    fragi0+=nhfrags;
+  }
+}
+
+#endif
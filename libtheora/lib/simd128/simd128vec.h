@@ -0,0 +1,122 @@
+/********************************************************************
+ *                                                                  *
+ * THIS FILE IS PART OF THE OggTheora SOFTWARE CODEC SOURCE CODE.   *
+ * USE, DISTRIBUTION AND REPRODUCTION OF THIS LIBRARY SOURCE IS     *
+ * GOVERNED BY A BSD-STYLE SOURCE LICENSE INCLUDED WITH THIS SOURCE *
+ * IN 'COPYING'. PLEASE READ THESE TERMS BEFORE DISTRIBUTING.       *
+ *                                                                  *
+ * THE Theora SOURCE CODE IS COPYRIGHT (C) 2002-2009                *
+ * by the Xiph.Org Foundation and contributors http://www.xiph.org/ *
+ *                                                                  *
+ ********************************************************************
+
+  function:
+    last mod: $Id$
+
+ ********************************************************************/
+
+/*The small set of 128-bit vector operations the SIMD128 backend is written
+   against.
+  Each one maps to a single WebAssembly SIMD128 instruction where there is
+   one, and to the equivalent SSE2 sequence otherwise, so the same code can be
+   checked natively against the C routines.*/
+#if !defined(_simd128_simd128vec_H)
+# define _simd128_simd128vec_H (1)
+# include <string.h>
+# include "simd128int.h"
+
+# if defined(__wasm_simd128__)
+#  include <wasm_simd128.h>
+
+typedef v128_t oc_v128;
+
+#  define oc_v128_zero() wasm_i64x2_const(0,0)
+#  define oc_v128_splat16(_x) wasm_i16x8_splat(_x)
+#  define oc_v128_load(_p) wasm_v128_load(_p)
+#  define oc_v128_store(_p,_v) wasm_v128_store(_p,_v)
+#  define oc_v128_load64(_p) wasm_v128_load64_zero(_p)
+#  define oc_v128_load32(_p) wasm_v128_load32_zero(_p)
+#  define oc_v128_store64(_p,_v) wasm_v128_store64_lane(_p,_v,0)
+#  define oc_v128_store64_hi(_p,_v) wasm_v128_store64_lane(_p,_v,1)
+/*Loads 8 unsigned bytes, zero-extended to 16 bits.*/
+#  define oc_v128_load_u8x8(_p) wasm_u16x8_load8x8(_p)
+#  define oc_v128_add16(_a,_b) wasm_i16x8_add(_a,_b)
+#  define oc_v128_adds16(_a,_b) wasm_i16x8_add_sat(_a,_b)
+#  define oc_v128_sub16(_a,_b) wasm_i16x8_sub(_a,_b)
+#  define oc_v128_min16(_a,_b) wasm_i16x8_min(_a,_b)
+#  define oc_v128_max16(_a,_b) wasm_i16x8_max(_a,_b)
+#  define oc_v128_cmplt16(_a,_b) wasm_i16x8_lt(_a,_b)
+#  define oc_v128_xor(_a,_b) wasm_v128_xor(_a,_b)
+#  define oc_v128_srai16(_a,_n) wasm_i16x8_shr(_a,_n)
+#  define oc_v128_srli16(_a,_n) wasm_u16x8_shr(_a,_n)
+/*Narrows two signed 16-bit vectors to bytes with unsigned saturation.*/
+#  define oc_v128_packus16(_a,_b) wasm_u8x16_narrow_i16x8(_a,_b)
+#  define oc_v128_unpacklo8(_a,_b) \
+  wasm_i8x16_shuffle(_a,_b,0,16,1,17,2,18,3,19,4,20,5,21,6,22,7,23)
+#  define oc_v128_unpackhi8(_a,_b) \
+  wasm_i8x16_shuffle(_a,_b,8,24,9,25,10,26,11,27,12,28,13,29,14,30,15,31)
+#  define oc_v128_unpacklo16(_a,_b) \
+  wasm_i16x8_shuffle(_a,_b,0,8,1,9,2,10,3,11)
+#  define oc_v128_unpackhi16(_a,_b) \
+  wasm_i16x8_shuffle(_a,_b,4,12,5,13,6,14,7,15)
+#  define oc_v128_unpacklo32(_a,_b) wasm_i32x4_shuffle(_a,_b,0,4,1,5)
+#  define oc_v128_unpackhi32(_a,_b) wasm_i32x4_shuffle(_a,_b,2,6,3,7)
+#  define oc_v128_unpacklo64(_a,_b) wasm_i64x2_shuffle(_a,_b,0,2)
+#  define oc_v128_unpackhi64(_a,_b) wasm_i64x2_shuffle(_a,_b,1,3)
+#  define oc_v128_extract16(_a,_i) wasm_u16x8_extract_lane(_a,_i)
+
+/*The high 16 bits of the signed 32-bit products.
+  There's no single instruction for this, so take the odd halves of the two
+   extended multiplies.*/
+static inline oc_v128 oc_v128_mulhi16(oc_v128 _a,oc_v128 _b){
+  return wasm_i16x8_shuffle(wasm_i32x4_extmul_low_i16x8(_a,_b),
+   wasm_i32x4_extmul_high_i16x8(_a,_b),1,3,5,7,9,11,13,15);
+}
+
+# elif defined(__SSE2__)
+#  include <emmintrin.h>
+
+typedef __m128i oc_v128;
+
+#  define oc_v128_zero() _mm_setzero_si128()
+#  define oc_v128_splat16(_x) _mm_set1_epi16(_x)
+#  define oc_v128_load(_p) _mm_loadu_si128((const __m128i *)(_p))
+#  define oc_v128_store(_p,_v) _mm_storeu_si128((__m128i *)(_p),_v)
+#  define oc_v128_load64(_p) _mm_loadl_epi64((const __m128i *)(_p))
+#  define oc_v128_store64(_p,_v) _mm_storel_epi64((__m128i *)(_p),_v)
+#  define oc_v128_store64_hi(_p,_v) \
+  _mm_storel_epi64((__m128i *)(_p),_mm_unpackhi_epi64(_v,_v))
+#  define oc_v128_load_u8x8(_p) \
+  _mm_unpacklo_epi8(oc_v128_load64(_p),_mm_setzero_si128())
+#  define oc_v128_add16(_a,_b) _mm_add_epi16(_a,_b)
+#  define oc_v128_adds16(_a,_b) _mm_adds_epi16(_a,_b)
+#  define oc_v128_sub16(_a,_b) _mm_sub_epi16(_a,_b)
+#  define oc_v128_min16(_a,_b) _mm_min_epi16(_a,_b)
+#  define oc_v128_max16(_a,_b) _mm_max_epi16(_a,_b)
+#  define oc_v128_cmplt16(_a,_b) _mm_cmplt_epi16(_a,_b)
+#  define oc_v128_xor(_a,_b) _mm_xor_si128(_a,_b)
+#  define oc_v128_srai16(_a,_n) _mm_srai_epi16(_a,_n)
+#  define oc_v128_srli16(_a,_n) _mm_srli_epi16(_a,_n)
+#  define oc_v128_packus16(_a,_b) _mm_packus_epi16(_a,_b)
+#  define oc_v128_unpacklo8(_a,_b) _mm_unpacklo_epi8(_a,_b)
+#  define oc_v128_unpackhi8(_a,_b) _mm_unpackhi_epi8(_a,_b)
+#  define oc_v128_unpacklo16(_a,_b) _mm_unpacklo_epi16(_a,_b)
+#  define oc_v128_unpackhi16(_a,_b) _mm_unpackhi_epi16(_a,_b)
+#  define oc_v128_unpacklo32(_a,_b) _mm_unpacklo_epi32(_a,_b)
+#  define oc_v128_unpackhi32(_a,_b) _mm_unpackhi_epi32(_a,_b)
+#  define oc_v128_unpacklo64(_a,_b) _mm_unpacklo_epi64(_a,_b)
+#  define oc_v128_unpackhi64(_a,_b) _mm_unpackhi_epi64(_a,_b)
+#  define oc_v128_extract16(_a,_i) _mm_extract_epi16(_a,_i)
+#  define oc_v128_mulhi16(_a,_b) _mm_mulhi_epi16(_a,_b)
+
+static inline oc_v128 oc_v128_load32(const void *_p){
+  int v;
+  memcpy(&v,_p,sizeof(v));
+  return _mm_cvtsi32_si128(v);
+}
+
+# else
+#  error "OC_SIMD128 requires WebAssembly SIMD128 or SSE2."
+# endif
+
+#endif
@@ -23,6 +23,7 @@
 #include "scales.h"
 #include "misc.h"
 #include "os.h"
+#include "simd128.h"
 
 /* packs the given codebook into the bitstream **************************/
 
@@ -402,6 +403,18 @@ long vorbis_book_decodev_add(codebook *book,float *a,oggpack_buffer *b,int n){
       entry = decode_packed_entry_number(book,b);
       if(entry==-1)return(-1);
       t     = book->valuelist+entry*book->dim;
+#ifdef VORBIS_SIMD128
+      /* whole entries of any even dim, four (or two) values at a time */
+      if(!(book->dim&1) && i+book->dim<=n){
+        for(j=0;j+4<=book->dim;j+=4,i+=4)
+          vf4_store(a+i,vf4_add(vf4_load(a+i),vf4_load(t+j)));
+        if(j<book->dim){
+          vf4_store2(a+i,vf4_add(vf4_load2(a+i),vf4_load2(t+j)));
+          i+=2;
+        }
+        continue;
+      }
+#endif
       for(j=0;i<n && j<book->dim;)
         a[i++]+=t[j++];
     }
@@ -447,6 +460,32 @@ long vorbis_book_decodevv_add(codebook *book,float **a,long offset,int ch,
       if(entry==-1)return(-1);
       {
         const float *t = book->valuelist+entry*book->dim;
+#ifdef VORBIS_SIMD128
+        /* stereo with an even dim, the usual residue 2 case: entries
+           never straddle a frame, so deinterleave them whole */
+        if(ch==2 && !(book->dim&1) && i+book->dim/2<=m){
+          float *a0=a[0]+i;
+          float *a1=a[1]+i;
+          for(j=0;j+8<=book->dim;j+=8,a0+=4,a1+=4){
+            vf4 t0=vf4_load(t+j);
+            vf4 t1=vf4_load(t+j+4);
+            vf4_store(a0,vf4_add(vf4_load(a0),vf4_shuffle(t0,t1,0,2,0,2)));
+            vf4_store(a1,vf4_add(vf4_load(a1),vf4_shuffle(t0,t1,1,3,1,3)));
+          }
+          if(j+4<=book->dim){
+            vf4 t0=vf4_load(t+j);
+            vf4_store2(a0,vf4_add(vf4_load2(a0),vf4_shuffle(t0,t0,0,2,0,2)));
+            vf4_store2(a1,vf4_add(vf4_load2(a1),vf4_shuffle(t0,t0,1,3,1,3)));
+            j+=4;
+          }
+          if(j<book->dim){
+            a[0][i+book->dim/2-1]+=t[j];
+            a[1][i+book->dim/2-1]+=t[j+1];
+          }
+          i+=book->dim/2;
+          continue;
+        }
+#endif
         for (j=0;i<m && j<book->dim;j++){
           a[chptr++][i]+=t[j];
           if(chptr==ch){
@@ -44,6 +44,11 @@
 #include "mdct.h"
 #include "os.h"
 #include "misc.h"
+#include "simd128.h"
+
+#if defined(VORBIS_SIMD128) && !defined(MDCT_INTEGERIZED)
+#define MDCT_SIMD128
+#endif
 
 /* build lookups for trig functions; also pre-figure scaling and
    some window function algebra. */
@@ -393,10 +398,384 @@ STIN void mdct_bitreverse(mdct_lookup *init,
   }while(w0<w1);
 }
 
+#ifdef MDCT_SIMD128
+
+/* The vector paths below do the same float operations per output value
+   as the scalar code above, only four at a time. */
+
+/* first and generic N/stage butterfly, eight points per iteration; the
+   first stage is the generic one with a trig stride of 4 */
+static void mdct_butterfly_generic_simd(DATA_TYPE *T,
+                                        DATA_TYPE *x,
+                                        int points,
+                                        int trigint){
+
+  DATA_TYPE *x1 = x + points      - 8;
+  DATA_TYPE *x2 = x + (points>>1) - 8;
+  vf4 neg       = vf4_negodd();
+
+  do{
+    vf4 a1 = vf4_load(x1);
+    vf4 b1 = vf4_load(x1+4);
+    vf4 a2 = vf4_load(x2);
+    vf4 b2 = vf4_load(x2+4);
+    vf4 ra = vf4_sub(a1,a2);
+    vf4 rb = vf4_sub(b1,b2);
+    /* x[0..3] take the third and second twiddles, x[4..7] the first
+       and zeroth */
+    vf4 ta = vf4_load2x2(T+trigint*3,T+trigint*2);
+    vf4 tb = vf4_load2x2(T+trigint,T);
+
+    vf4_store(x1,vf4_add(a1,a2));
+    vf4_store(x1+4,vf4_add(b1,b2));
+
+    /* (r1*t1 + r0*t0, r1*t0 - r0*t1) for each pair */
+    vf4_store(x2,vf4_add(
+      vf4_mul(vf4_shuffle(ra,ra,1,1,3,3),vf4_shuffle(ta,ta,1,0,3,2)),
+      vf4_xor(vf4_mul(vf4_shuffle(ra,ra,0,0,2,2),ta),neg)));
+    vf4_store(x2+4,vf4_add(
+      vf4_mul(vf4_shuffle(rb,rb,1,1,3,3),vf4_shuffle(tb,tb,1,0,3,2)),
+      vf4_xor(vf4_mul(vf4_shuffle(rb,rb,0,0,2,2),tb),neg)));
+
+    T+=trigint*4;
+    x1-=8;
+    x2-=8;
+
+  }while(x2>=x);
+}
+
+/* The 32 point butterfly has no useful parallelism within a block, so
+   run four blocks side by side, one per lane. */
+STIN void mdct_butterfly_8_simd(vf4 *x){
+  vf4 r0   = vf4_add(x[6],x[2]);
+  vf4 r1   = vf4_sub(x[6],x[2]);
+  vf4 r2   = vf4_add(x[4],x[0]);
+  vf4 r3   = vf4_sub(x[4],x[0]);
+
+      x[6] = vf4_add(r0,r2);
+      x[4] = vf4_sub(r0,r2);
+
+      r0   = vf4_sub(x[5],x[1]);
+      r2   = vf4_sub(x[7],x[3]);
+      x[0] = vf4_add(r1,r0);
+      x[2] = vf4_sub(r1,r0);
+
+      r0   = vf4_add(x[5],x[1]);
+      r1   = vf4_add(x[7],x[3]);
+      x[3] = vf4_add(r2,r3);
+      x[1] = vf4_sub(r2,r3);
+      x[7] = vf4_add(r1,r0);
+      x[5] = vf4_sub(r1,r0);
+}
+
+STIN void mdct_butterfly_16_simd(vf4 *x){
+  vf4 c2    = vf4_splat(cPI2_8);
+  vf4 r0    = vf4_sub(x[1],x[9]);
+  vf4 r1    = vf4_sub(x[0],x[8]);
+
+      x[8]  = vf4_add(x[8],x[0]);
+      x[9]  = vf4_add(x[9],x[1]);
+      x[0]  = vf4_mul(vf4_add(r0,r1),c2);
+      x[1]  = vf4_mul(vf4_sub(r0,r1),c2);
+
+      r0    = vf4_sub(x[3],x[11]);
+      r1    = vf4_sub(x[10],x[2]);
+      x[10] = vf4_add(x[10],x[2]);
+      x[11] = vf4_add(x[11],x[3]);
+      x[2]  = r0;
+      x[3]  = r1;
+
+      r0    = vf4_sub(x[12],x[4]);
+      r1    = vf4_sub(x[13],x[5]);
+      x[12] = vf4_add(x[12],x[4]);
+      x[13] = vf4_add(x[13],x[5]);
+      x[4]  = vf4_mul(vf4_sub(r0,r1),c2);
+      x[5]  = vf4_mul(vf4_add(r0,r1),c2);
+
+      r0    = vf4_sub(x[14],x[6]);
+      r1    = vf4_sub(x[15],x[7]);
+      x[14] = vf4_add(x[14],x[6]);
+      x[15] = vf4_add(x[15],x[7]);
+      x[6]  = r0;
+      x[7]  = r1;
+
+      mdct_butterfly_8_simd(x);
+      mdct_butterfly_8_simd(x+8);
+}
+
+STIN void mdct_butterfly_32_simd(vf4 *x){
+  vf4 c1    = vf4_splat(cPI1_8);
+  vf4 c2    = vf4_splat(cPI2_8);
+  vf4 c3    = vf4_splat(cPI3_8);
+  vf4 r0    = vf4_sub(x[30],x[14]);
+  vf4 r1    = vf4_sub(x[31],x[15]);
+
+      x[30] = vf4_add(x[30],x[14]);
+      x[31] = vf4_add(x[31],x[15]);
+      x[14] = r0;
+      x[15] = r1;
+
+      r0    = vf4_sub(x[28],x[12]);
+      r1    = vf4_sub(x[29],x[13]);
+      x[28] = vf4_add(x[28],x[12]);
+      x[29] = vf4_add(x[29],x[13]);
+      x[12] = vf4_sub(vf4_mul(r0,c1),vf4_mul(r1,c3));
+      x[13] = vf4_add(vf4_mul(r0,c3),vf4_mul(r1,c1));
+
+      r0    = vf4_sub(x[26],x[10]);
+      r1    = vf4_sub(x[27],x[11]);
+      x[26] = vf4_add(x[26],x[10]);
+      x[27] = vf4_add(x[27],x[11]);
+      x[10] = vf4_mul(vf4_sub(r0,r1),c2);
+      x[11] = vf4_mul(vf4_add(r0,r1),c2);
+
+      r0    = vf4_sub(x[24],x[8]);
+      r1    = vf4_sub(x[25],x[9]);
+      x[24] = vf4_add(x[24],x[8]);
+      x[25] = vf4_add(x[25],x[9]);
+      x[8]  = vf4_sub(vf4_mul(r0,c3),vf4_mul(r1,c1));
+      x[9]  = vf4_add(vf4_mul(r1,c3),vf4_mul(r0,c1));
+
+      r0    = vf4_sub(x[22],x[6]);
+      r1    = vf4_sub(x[7],x[23]);
+      x[22] = vf4_add(x[22],x[6]);
+      x[23] = vf4_add(x[23],x[7]);
+      x[6]  = r1;
+      x[7]  = r0;
+
+      r0    = vf4_sub(x[4],x[20]);
+      r1    = vf4_sub(x[5],x[21]);
+      x[20] = vf4_add(x[20],x[4]);
+      x[21] = vf4_add(x[21],x[5]);
+      x[4]  = vf4_add(vf4_mul(r1,c1),vf4_mul(r0,c3));
+      x[5]  = vf4_sub(vf4_mul(r1,c3),vf4_mul(r0,c1));
+
+      r0    = vf4_sub(x[2],x[18]);
+      r1    = vf4_sub(x[3],x[19]);
+      x[18] = vf4_add(x[18],x[2]);
+      x[19] = vf4_add(x[19],x[3]);
+      x[2]  = vf4_mul(vf4_add(r1,r0),c2);
+      x[3]  = vf4_mul(vf4_sub(r1,r0),c2);
+
+      r0    = vf4_sub(x[0],x[16]);
+      r1    = vf4_sub(x[1],x[17]);
+      x[16] = vf4_add(x[16],x[0]);
+      x[17] = vf4_add(x[17],x[1]);
+      x[0]  = vf4_add(vf4_mul(r1,c3),vf4_mul(r0,c1));
+      x[1]  = vf4_sub(vf4_mul(r1,c1),vf4_mul(r0,c3));
+
+      mdct_butterfly_16_simd(x);
+      mdct_butterfly_16_simd(x+16);
+}
+
+/* four consecutive 32 point blocks */
+static void mdct_butterfly_32x4_simd(DATA_TYPE *x){
+  vf4 v[32];
+  int i;
+
+  for(i=0;i<32;i+=4){
+    vf4 r0=vf4_load(x+i);
+    vf4 r1=vf4_load(x+i+32);
+    vf4 r2=vf4_load(x+i+64);
+    vf4 r3=vf4_load(x+i+96);
+    vf4_transpose(r0,r1,r2,r3);
+    v[i]=r0;
+    v[i+1]=r1;
+    v[i+2]=r2;
+    v[i+3]=r3;
+  }
+
+  mdct_butterfly_32_simd(v);
+
+  for(i=0;i<32;i+=4){
+    vf4 r0=v[i];
+    vf4 r1=v[i+1];
+    vf4 r2=v[i+2];
+    vf4 r3=v[i+3];
+    vf4_transpose(r0,r1,r2,r3);
+    vf4_store(x+i,r0);
+    vf4_store(x+i+32,r1);
+    vf4_store(x+i+64,r2);
+    vf4_store(x+i+96,r3);
+  }
+}
+
+static void mdct_butterflies_simd(mdct_lookup *init,
+                                  DATA_TYPE *x,
+                                  int points){
+
+  DATA_TYPE *T=init->trig;
+  int stages=init->log2n-5;
+  int i,j;
+
+  if(--stages>0){
+    mdct_butterfly_generic_simd(T,x,points,4);
+  }
+
+  for(i=1;--stages>0;i++){
+    for(j=0;j<(1<<i);j++)
+      mdct_butterfly_generic_simd(T,x+(points>>i)*j,points>>i,4<<i);
+  }
+
+  for(j=0;j+128<=points;j+=128)
+    mdct_butterfly_32x4_simd(x+j);
+  for(;j<points;j+=32)
+    mdct_butterfly_32(x+j);
+
+}
+
+static void mdct_bitreverse_simd(mdct_lookup *init,
+                                 DATA_TYPE *x){
+  int        n       = init->n;
+  int       *bit     = init->bitrev;
+  DATA_TYPE *w0      = x;
+  DATA_TYPE *w1      = x = w0+(n>>1);
+  DATA_TYPE *T       = init->trig+n;
+  vf4        neg     = vf4_negodd();
+  vf4        half    = vf4_splat(.5f);
+
+  do{
+    /* both pairs at once, one per half of the vector */
+    vf4 x0 = vf4_load2x2(x+bit[0],x+bit[2]);
+    vf4 x1 = vf4_load2x2(x+bit[1],x+bit[3]);
+    vf4 t  = vf4_load(T);
+    vf4 s  = vf4_add(x0,x1);
+    vf4 d  = vf4_sub(x0,x1);
+
+    /* (r2,r3) per pair, with r1=s[0] and r0=d[1] */
+    vf4 r  = vf4_add(vf4_mul(vf4_shuffle(s,s,0,0,2,2),t),
+                     vf4_xor(vf4_mul(vf4_shuffle(d,d,1,1,3,3),
+                                     vf4_shuffle(t,t,1,0,3,2)),neg));
+    /* HALVE()d (r0,r1) per pair */
+    vf4 h  = vf4_shuffle(s,d,1,3,0,2);
+        h  = vf4_mul(vf4_shuffle(h,h,0,2,1,3),half);
+
+    w1    -= 4;
+
+    vf4_store(w0,vf4_add(h,r));
+    r      = vf4_xor(vf4_sub(h,r),neg);
+    vf4_store(w1,vf4_shuffle(r,r,2,3,0,1));
+
+    T     += 4;
+    bit   += 4;
+    w0    += 4;
+
+  }while(w0<w1);
+}
+
 void mdct_backward(mdct_lookup *init, DATA_TYPE *in, DATA_TYPE *out){
   int n=init->n;
   int n2=n>>1;
   int n4=n>>2;
+  vf4 neg=vf4_negodd();
+  vf4 negall=vf4_negall();
+
+  /* rotate */
+
+  DATA_TYPE *iX = in+n2-7;
+  DATA_TYPE *oX = out+n2+n4;
+  DATA_TYPE *T  = init->trig+n4;
+
+  do{
+    /* iX[7] is read but unused; it's in[n2] at most */
+    vf4 e  = vf4_shuffle(vf4_load(iX),vf4_load(iX+4),0,2,0,2);
+    vf4 t  = vf4_load(T);
+    oX    -= 4;
+    vf4_store(oX,vf4_sub(
+      vf4_xor(vf4_mul(vf4_shuffle(e,e,1,0,3,2),vf4_shuffle(t,t,3,3,1,1)),
+              vf4_set(-0.f,0.f,-0.f,0.f)),
+      vf4_mul(e,vf4_shuffle(t,t,2,2,0,0))));
+    iX    -= 8;
+    T     += 4;
+  }while(iX>=in);
+
+  iX            = in+n2-8;
+  oX            = out+n2+n4;
+  T             = init->trig+n4;
+
+  do{
+    vf4 e, t;
+    T     -= 4;
+    e      = vf4_shuffle(vf4_load(iX),vf4_load(iX+4),0,2,0,2);
+    t      = vf4_load(T);
+    vf4_store(oX,vf4_add(
+      vf4_mul(vf4_shuffle(e,e,2,2,0,0),vf4_reverse(t)),
+      vf4_xor(vf4_mul(vf4_shuffle(e,e,3,3,1,1),vf4_shuffle(t,t,2,3,0,1)),
+              neg)));
+    iX    -= 8;
+    oX    += 4;
+  }while(iX>=in);
+
+  mdct_butterflies_simd(init,out+n2,n2);
+  mdct_bitreverse_simd(init,out);
+
+  /* roatate + window */
+
+  {
+    DATA_TYPE *oX1=out+n2+n4;
+    DATA_TYPE *oX2=out+n2+n4;
+    DATA_TYPE *iX =out;
+    T             =init->trig+n2;
+
+    do{
+      vf4 a  = vf4_load(iX);
+      vf4 b  = vf4_load(iX+4);
+      vf4 ta = vf4_load(T);
+      vf4 tb = vf4_load(T+4);
+      vf4 e  = vf4_shuffle(a,b,0,2,0,2);
+      vf4 o  = vf4_shuffle(a,b,1,3,1,3);
+      vf4 te = vf4_shuffle(ta,tb,0,2,0,2);
+      vf4 to = vf4_shuffle(ta,tb,1,3,1,3);
+
+      oX1-=4;
+
+      vf4_store(oX1,vf4_reverse(vf4_sub(vf4_mul(e,to),vf4_mul(o,te))));
+      vf4_store(oX2,vf4_xor(vf4_add(vf4_mul(e,te),vf4_mul(o,to)),negall));
+
+      oX2+=4;
+      iX    +=   8;
+      T     +=   8;
+    }while(iX<oX1);
+
+    iX=out+n2+n4;
+    oX1=out+n4;
+    oX2=oX1;
+
+    do{
+      vf4 v;
+      oX1-=4;
+      iX-=4;
+
+      v=vf4_load(iX);
+      vf4_store(oX1,v);
+      vf4_store(oX2,vf4_xor(vf4_reverse(v),negall));
+
+      oX2+=4;
+    }while(oX2<iX);
+
+    iX=out+n2+n4;
+    oX1=out+n2+n4;
+    oX2=out+n2;
+    do{
+      oX1-=4;
+      vf4_store(oX1,vf4_reverse(vf4_load(iX)));
+      iX+=4;
+    }while(oX1>oX2);
+  }
+}
+
+#endif
+
+#if !defined(MDCT_SIMD128) || defined(_V_SELFTEST)
+#ifdef MDCT_SIMD128
+/* kept as the reference the self test checks the vector path against */
+static void mdct_backward_c(mdct_lookup *init, DATA_TYPE *in, DATA_TYPE *out){
+#else
+void mdct_backward(mdct_lookup *init, DATA_TYPE *in, DATA_TYPE *out){
+#endif
+  int n=init->n;
+  int n2=n>>1;
+  int n4=n>>2;
 
   /* rotate */
 
@@ -489,6 +868,8 @@ void mdct_backward(mdct_lookup *init, DATA_TYPE *in, DATA_TYPE *out){
   }
 }
 
+#endif
+
 void mdct_forward(mdct_lookup *init, DATA_TYPE *in, DATA_TYPE *out){
   int n=init->n;
   int n2=n>>1;
@@ -560,3 +941,63 @@ void mdct_forward(mdct_lookup *init, DATA_TYPE *in, DATA_TYPE *out){
     T+=2;
   }
 }
+
+#ifdef _V_SELFTEST
+
+/* Checks the vector inverse transform against the scalar one.  The two
+   do the same float operations in the same order, so they must agree
+   exactly, unless the compiler was allowed to reassociate them. */
+
+#include <stdio.h>
+
+int main(){
+#ifdef MDCT_SIMD128
+  int log2n;
+  unsigned int seed=1;
+
+  for(log2n=6;log2n<=13;log2n++){
+    int n=1<<log2n;
+    float *a=_ogg_malloc(sizeof(*a)*n);
+    float *b=_ogg_malloc(sizeof(*b)*n);
+    float peak=0.f,err=0.f;
+    mdct_lookup l;
+    int i,pass;
+
+    mdct_init(&l,n);
+    for(pass=0;pass<16;pass++){
+      for(i=0;i<n;i++){
+        seed=seed*1103515245+12345;
+        a[i]=b[i]=(float)((seed>>8)&0xffff)/32768.f-1.f;
+      }
+
+      mdct_backward_c(&l,a,a);
+      mdct_backward(&l,b,b);
+
+      for(i=0;i<n;i++){
+        float d=fabs(a[i]-b[i]);
+        if(fabs(a[i])>peak)peak=fabs(a[i]);
+        if(d>err)err=d;
+      }
+    }
+    mdct_clear(&l);
+    _ogg_free(a);
+    _ogg_free(b);
+
+    fprintf(stderr,"inverse MDCT n=%d: max error %g of %g... ",n,err,peak);
+#ifdef __FAST_MATH__
+    if(err>peak*1e-5f){
+#else
+    if(err!=0.f){
+#endif
+      fprintf(stderr,"failed\n");
+      exit(1);
+    }
+    fprintf(stderr,"OK\n");
+  }
+#else
+  fprintf(stderr,"built without VORBIS_SIMD128; no vector MDCT to check\n");
+#endif
+  return(0);
+}
+
+#endif
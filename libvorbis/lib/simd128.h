@@ -0,0 +1,96 @@
+/********************************************************************
+ *                                                                  *
+ * THIS FILE IS PART OF THE OggVorbis SOFTWARE CODEC SOURCE CODE.   *
+ * USE, DISTRIBUTION AND REPRODUCTION OF THIS LIBRARY SOURCE IS     *
+ * GOVERNED BY A BSD-STYLE SOURCE LICENSE INCLUDED WITH THIS SOURCE *
+ * IN 'COPYING'. PLEASE READ THESE TERMS BEFORE DISTRIBUTING.       *
+ *                                                                  *
+ * THE OggVorbis SOURCE CODE IS (C) COPYRIGHT 1994-2015             *
+ * by the Xiph.Org Foundation http://www.xiph.org/                  *
+ *                                                                  *
+ ********************************************************************
+
+ function: four-wide float vector operations for the synthesis path
+
+ Enabled with --enable-simd128 (VORBIS_SIMD128).  Each operation is a
+ single WebAssembly SIMD128 instruction where there is one, and the
+ equivalent SSE2 sequence otherwise, so the vector paths can be
+ checked natively against the scalar code.  Every lane sees the same
+ float operations in the same order as the scalar code it replaces.
+
+ ********************************************************************/
+
+#ifndef _V_SIMD128_H_
+#define _V_SIMD128_H_
+
+#ifdef VORBIS_SIMD128
+
+#if defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+
+typedef v128_t vf4;
+
+#define vf4_set(a,b,c,d) wasm_f32x4_make(a,b,c,d)
+#define vf4_splat(x)     wasm_f32x4_splat(x)
+#define vf4_load(p)      wasm_v128_load(p)
+#define vf4_store(p,v)   wasm_v128_store(p,v)
+#define vf4_add(a,b)     wasm_f32x4_add(a,b)
+#define vf4_sub(a,b)     wasm_f32x4_sub(a,b)
+#define vf4_mul(a,b)     wasm_f32x4_mul(a,b)
+#define vf4_xor(a,b)     wasm_v128_xor(a,b)
+/* (a[i0],a[i1],b[i2],b[i3]), as SSE's shufps */
+#define vf4_shuffle(a,b,i0,i1,i2,i3) \
+  wasm_i32x4_shuffle(a,b,i0,i1,(i2)+4,(i3)+4)
+/* two floats from p in the low half, two from q in the high half */
+#define vf4_load2x2(p,q) \
+  wasm_v128_load64_lane(q,wasm_v128_load64_zero(p),1)
+#define vf4_load2(p)     wasm_v128_load64_zero(p)
+#define vf4_store2(p,v)  wasm_v128_store64_lane(p,v,0)
+
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+
+typedef __m128 vf4;
+
+#define vf4_set(a,b,c,d) _mm_setr_ps(a,b,c,d)
+#define vf4_splat(x)     _mm_set1_ps(x)
+#define vf4_load(p)      _mm_loadu_ps(p)
+#define vf4_store(p,v)   _mm_storeu_ps(p,v)
+#define vf4_add(a,b)     _mm_add_ps(a,b)
+#define vf4_sub(a,b)     _mm_sub_ps(a,b)
+#define vf4_mul(a,b)     _mm_mul_ps(a,b)
+#define vf4_xor(a,b)     _mm_xor_ps(a,b)
+#define vf4_shuffle(a,b,i0,i1,i2,i3) \
+  _mm_shuffle_ps(a,b,_MM_SHUFFLE(i3,i2,i1,i0))
+#define vf4_load2x2(p,q) \
+  _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(),(const __m64 *)(p)), \
+               (const __m64 *)(q))
+#define vf4_load2(p)     _mm_loadl_pi(_mm_setzero_ps(),(const __m64 *)(p))
+#define vf4_store2(p,v)  _mm_storel_pi((__m64 *)(p),v)
+
+#else
+#error "VORBIS_SIMD128 requires WebAssembly SIMD128 or SSE2."
+#endif
+
+#define vf4_reverse(a)   vf4_shuffle(a,a,3,2,1,0)
+
+/* flips the sign of the odd lanes */
+#define vf4_negodd()     vf4_set(0.f,-0.f,0.f,-0.f)
+#define vf4_negall()     vf4_splat(-0.f)
+
+/* in place 4x4 transpose */
+#define vf4_transpose(r0,r1,r2,r3)                   \
+  do{                                                \
+    vf4 t0_=vf4_shuffle(r0,r1,0,1,0,1);              \
+    vf4 t1_=vf4_shuffle(r0,r1,2,3,2,3);              \
+    vf4 t2_=vf4_shuffle(r2,r3,0,1,0,1);              \
+    vf4 t3_=vf4_shuffle(r2,r3,2,3,2,3);              \
+    (r0)=vf4_shuffle(t0_,t2_,0,2,0,2);               \
+    (r1)=vf4_shuffle(t0_,t2_,1,3,1,3);               \
+    (r2)=vf4_shuffle(t1_,t3_,0,2,0,2);               \
+    (r3)=vf4_shuffle(t1_,t3_,1,3,1,3);               \
+  }while(0)
+
+#endif
+
+#endif
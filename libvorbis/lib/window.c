@@ -19,6 +19,7 @@
 #include "os.h"
 #include "misc.h"
 #include "window.h"
+#include "simd128.h"
 
 static const float vwin64[32] = {
   0.0009460463F, 0.0085006468F, 0.0235352254F, 0.0458950567F,
@@ -2133,3 +2134,17 @@ void _vorbis_apply_window(float *d,int *winno,long *blocksizes,
       d[i]=0.f;
   }
 }
+
+/* overlap/add of the previous block's right half (pcm, windowed by the
+   falling slope) with this block's left half (p, rising slope) */
+void _vorbis_overlap_add(float *pcm,const float *p,const float *w,int n){
+  int i=0;
+#ifdef VORBIS_SIMD128
+  for(;i+4<=n;i+=4)
+    vf4_store(pcm+i,vf4_add(
+      vf4_mul(vf4_load(pcm+i),vf4_reverse(vf4_load(w+n-i-4))),
+      vf4_mul(vf4_load(p+i),vf4_load(w+i))));
+#endif
+  for(;i<n;i++)
+    pcm[i]=pcm[i]*w[n-i-1] + p[i]*w[i];
+}
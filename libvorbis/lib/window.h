@@ -20,6 +20,8 @@
 extern const float *_vorbis_window_get(int n);
 extern void _vorbis_apply_window(float *d,int *winno,long *blocksizes,
                           int lW,int W,int nW);
+extern void _vorbis_overlap_add(float *pcm,const float *p,const float *w,
+                                int n);
 
 
 #endif
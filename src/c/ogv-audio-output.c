@@ -0,0 +1,519 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __wasm_simd128__
+#include <wasm_simd128.h>
+#endif
+
+#include "ogv-decoder-audio.h"
+#include "ogv-audio-output.h"
+
+// Filter taps either side of each output sample when not downsampling;
+// downsampling widens the filter to keep the same transition band.
+#define RESAMPLE_HALF_TAPS 24
+// Fraction of the output Nyquist rate to pass.
+#define RESAMPLE_BANDWIDTH 0.91
+#define RESAMPLE_KAISER_BETA 8.0
+// Filter phases stored; output between them is interpolated.
+#define RESAMPLE_PHASES 128
+
+// WSOLA hop and search range, in seconds. Frames are two hops long.
+#define WSOLA_HOP 0.015
+#define WSOLA_SEARCH 0.005
+
+static int gcd(int a, int b) {
+    while (b) {
+        int t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+static double bessel_i0(double x) {
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 50; k++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-12) {
+            break;
+        }
+    }
+    return sum;
+}
+
+/**
+ * Grow each channel of *planes to len samples. Contents are carried
+ * over; callers only grow these. Returns 0 if out of memory, leaving
+ * what was there still valid.
+ */
+static int grow_planes(float ***planes, int channels, int len) {
+    if (!*planes) {
+        *planes = calloc(channels, sizeof(float *));
+        if (!*planes) {
+            return 0;
+        }
+    }
+    for (int c = 0; c < channels; c++) {
+        float *plane = realloc((*planes)[c], sizeof(float) * len);
+        if (!plane) {
+            return 0;
+        }
+        (*planes)[c] = plane;
+    }
+    return 1;
+}
+
+static void free_planes(float **planes, int channels) {
+    if (planes) {
+        for (int c = 0; c < channels; c++) {
+            free(planes[c]);
+        }
+        free(planes);
+    }
+}
+
+static void release(AudioOutput *out) {
+    free(out->filter);
+    free(out->window);
+    free_planes(out->history, out->channels);
+    free_planes(out->wsola_in, out->channels);
+    free_planes(out->resampled, out->channels);
+    free_planes(out->output, out->channels);
+    out->filter = NULL;
+    out->window = NULL;
+    out->history = NULL;
+    out->wsola_in = NULL;
+    out->resampled = NULL;
+    out->output = NULL;
+    out->history_cap = 0;
+    out->wsola_cap = 0;
+    out->resampled_cap = 0;
+    out->output_cap = 0;
+    out->configured = 0;
+}
+
+/**
+ * Build the filter bank: RESAMPLE_PHASES + 1 rows of Kaiser-windowed
+ * sinc, each for an output sample that far between two input samples.
+ */
+static int design_filter(AudioOutput *out) {
+    double scale = (double)out->up / out->down;
+    if (scale > 1.0) {
+        scale = 1.0;
+    } else if (scale < 0.125) {
+        scale = 0.125;
+    }
+    // Round to a multiple of four taps for the vector dot product.
+    int half = ((int)ceil(RESAMPLE_HALF_TAPS / scale) + 1) & ~1;
+    double cutoff = 0.5 * scale * RESAMPLE_BANDWIDTH;
+    double norm = bessel_i0(RESAMPLE_KAISER_BETA);
+
+    out->taps = half * 2;
+    out->filter = malloc(sizeof(float) * (RESAMPLE_PHASES + 1) * out->taps);
+    if (!out->filter) {
+        return 0;
+    }
+    for (int p = 0; p <= RESAMPLE_PHASES; p++) {
+        float *row = out->filter + p * out->taps;
+        double frac = (double)p / RESAMPLE_PHASES;
+        double sum = 0.0;
+        for (int k = 0; k < out->taps; k++) {
+            double d = k - (half - 1) - frac;
+            double t = d / half;
+            double x = 2.0 * cutoff * d;
+            double sinc = (x == 0.0) ? 1.0 : sin(M_PI * x) / (M_PI * x);
+            double win = (t * t < 1.0) ? bessel_i0(RESAMPLE_KAISER_BETA * sqrt(1.0 - t * t)) / norm : 0.0;
+            row[k] = (float)(sinc * win);
+            sum += row[k];
+        }
+        // Unity gain at DC for every phase.
+        for (int k = 0; k < out->taps; k++) {
+            row[k] = (float)(row[k] / sum);
+        }
+    }
+    return 1;
+}
+
+/**
+ * Set up for the current rates. Returns 0 if out of memory, leaving
+ * the stage unconfigured.
+ */
+static int configure(AudioOutput *out) {
+    release(out);
+    int rate = out->out_rate ? out->out_rate : out->in_rate;
+    int g = gcd(rate, out->in_rate);
+    out->up = rate / g;
+    out->down = out->in_rate / g;
+    if (out->up != out->down) {
+        if (!design_filter(out) || !grow_planes(&out->history, out->channels, out->taps)) {
+            release(out);
+            return 0;
+        }
+        out->history_cap = out->taps;
+    }
+
+    out->hop = (int)(rate * WSOLA_HOP);
+    out->search = (int)(rate * WSOLA_SEARCH);
+    out->window = malloc(sizeof(float) * out->hop);
+    if (!out->window) {
+        release(out);
+        return 0;
+    }
+    for (int i = 0; i < out->hop; i++) {
+        // Rising half of a Hann window; it and its mirror sum to one.
+        out->window[i] = (float)(0.5 - 0.5 * cos(M_PI * (i + 0.5) / out->hop));
+    }
+    out->configured = 1;
+    audio_output_reset(out);
+    return 1;
+}
+
+void audio_output_init(AudioOutput *out, int channels, int rate) {
+    out->channels = channels;
+    out->in_rate = rate;
+    if (out->tempo == 0.0) {
+        out->tempo = 1.0;
+    }
+    out->configured = 0;
+}
+
+void audio_output_set_rate(AudioOutput *out, int rate) {
+    if (rate != out->out_rate) {
+        out->out_rate = rate;
+        out->configured = 0;
+    }
+}
+
+void audio_output_set_tempo(AudioOutput *out, double tempo) {
+    if (tempo < 0.5) {
+        tempo = 0.5;
+    } else if (tempo > 2.0) {
+        tempo = 2.0;
+    }
+    out->tempo = tempo;
+}
+
+void audio_output_reset(AudioOutput *out) {
+    if (out->history) {
+        // Start with the first input sample under the filter's centre.
+        int lead = out->taps / 2 - 1;
+        for (int c = 0; c < out->channels; c++) {
+            memset(out->history[c], 0, sizeof(float) * lead);
+        }
+        out->history_len = lead;
+    }
+    out->index = 0;
+    out->phase = 0;
+    out->wsola_active = 0;
+    out->wsola_len = 0;
+}
+
+void audio_output_free(AudioOutput *out) {
+    release(out);
+}
+
+static inline float dot(const float *a, const float *b, int n) {
+#ifdef __wasm_simd128__
+    v128_t acc = wasm_f32x4_splat(0.0f);
+    for (int i = 0; i < n; i += 4) {
+        acc = wasm_f32x4_add(acc, wasm_f32x4_mul(wasm_v128_load(a + i), wasm_v128_load(b + i)));
+    }
+    return wasm_f32x4_extract_lane(acc, 0) + wasm_f32x4_extract_lane(acc, 1) +
+           wasm_f32x4_extract_lane(acc, 2) + wasm_f32x4_extract_lane(acc, 3);
+#else
+    // Same summation order as the vector version.
+    float acc[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    for (int i = 0; i < n; i += 4) {
+        for (int j = 0; j < 4; j++) {
+            acc[j] += a[i + j] * b[i + j];
+        }
+    }
+    return acc[0] + acc[1] + acc[2] + acc[3];
+#endif
+}
+
+/**
+ * Resample into out->resampled, returning the number of samples made,
+ * or -1 if out of memory. pcm NULL appends silence. Output stops short
+ * of any sample centred at or past history position end.
+ */
+static int resample(AudioOutput *out, float **pcm, int sampleCount, int end) {
+    int needed = out->history_len + sampleCount;
+    if (needed > out->history_cap) {
+        if (!grow_planes(&out->history, out->channels, needed)) {
+            return -1;
+        }
+        out->history_cap = needed;
+    }
+    for (int c = 0; c < out->channels; c++) {
+        if (pcm) {
+            memcpy(out->history[c] + out->history_len, pcm[c], sizeof(float) * sampleCount);
+        } else {
+            memset(out->history[c] + out->history_len, 0, sizeof(float) * sampleCount);
+        }
+    }
+    out->history_len = needed;
+
+    int maxOut = (int)(((long long)(needed - out->index) * out->up) / out->down) + 1;
+    if (maxOut > out->resampled_cap) {
+        if (!grow_planes(&out->resampled, out->channels, maxOut)) {
+            return -1;
+        }
+        out->resampled_cap = maxOut;
+    }
+
+    const int centre = out->taps / 2 - 1;
+    int count = 0;
+    while (out->index + out->taps <= out->history_len &&
+           (long long)(out->index + centre) * out->up + out->phase < (long long)end * out->up) {
+        int pos = out->phase * RESAMPLE_PHASES;
+        const float *row = out->filter + (pos / out->up) * out->taps;
+        float weight = (float)(pos % out->up) / out->up;
+        for (int c = 0; c < out->channels; c++) {
+            const float *in = out->history[c] + out->index;
+            float a = dot(row, in, out->taps);
+            float b = weight ? dot(row + out->taps, in, out->taps) : a;
+            out->resampled[c][count] = a + (b - a) * weight;
+        }
+        count++;
+        out->phase += out->down;
+        out->index += out->phase / out->up;
+        out->phase %= out->up;
+    }
+
+    // Keep what the next output's taps still cover.
+    int drop = out->index < out->history_len ? out->index : out->history_len;
+    for (int c = 0; c < out->channels; c++) {
+        memmove(out->history[c], out->history[c] + drop, sizeof(float) * (out->history_len - drop));
+    }
+    out->history_len -= drop;
+    out->index -= drop;
+    return count;
+}
+
+static int ensure_output(AudioOutput *out, int len) {
+    if (len > out->output_cap) {
+        if (!grow_planes(&out->output, out->channels, len)) {
+            return 0;
+        }
+        out->output_cap = len;
+    }
+    return 1;
+}
+
+/**
+ * Find the frame start within the search range whose opening best
+ * matches the natural continuation of the previous frame. Correlation
+ * is on every fourth sample over a coarse grid, then refined.
+ */
+static int wsola_search(AudioOutput *out, int lo, int hi) {
+    const int target = out->prev + out->hop;
+    int best = lo;
+    double bestScore = -INFINITY;
+    for (int pass = 0; pass < 2; pass++) {
+        int from = lo, to = hi, step = 4;
+        if (pass) {
+            from = best - 3 > lo ? best - 3 : lo;
+            to = best + 3 < hi ? best + 3 : hi;
+            step = 1;
+        }
+        for (int cand = from; cand <= to; cand += step) {
+            double corr = 0.0, energy = 1e-9;
+            for (int c = 0; c < out->channels; c++) {
+                const float *x = out->wsola_in[c] + cand;
+                const float *y = out->wsola_in[c] + target;
+                for (int i = 0; i < out->hop; i += 4) {
+                    corr += x[i] * y[i];
+                    energy += x[i] * x[i];
+                }
+            }
+            double score = corr / sqrt(energy);
+            if (score > bestScore) {
+                bestScore = score;
+                best = cand;
+            }
+        }
+    }
+    return best;
+}
+
+/**
+ * Run samples through WSOLA into out->output from offset, returning
+ * the new end of output, or -1 if out of memory. advance gets the
+ * input consumed, in samples.
+ */
+static int wsola(AudioOutput *out, float **in, int count, int offset, int *advance) {
+    int needed = out->wsola_len + count;
+    if (needed > out->wsola_cap) {
+        if (!grow_planes(&out->wsola_in, out->channels, needed)) {
+            return -1;
+        }
+        out->wsola_cap = needed;
+    }
+    for (int c = 0; c < out->channels && count > 0; c++) {
+        memcpy(out->wsola_in[c] + out->wsola_len, in[c], sizeof(float) * count);
+    }
+    out->wsola_len = needed;
+
+    const int hop = out->hop;
+    if (!ensure_output(out, offset + (int)(out->wsola_len / (hop * out->tempo) + 2) * hop)) {
+        return -1;
+    }
+    while (1) {
+        int nominal = (int)(out->next + 0.5);
+        int lo = nominal - out->search, hi = nominal + out->search;
+        if (lo < 0) {
+            lo = 0;
+        }
+        if (hi + hop > out->wsola_len || out->prev + 2 * hop > out->wsola_len) {
+            break;
+        }
+        int best = wsola_search(out, lo, hi);
+        for (int c = 0; c < out->channels; c++) {
+            const float *fade = out->wsola_in[c] + out->prev + hop;
+            const float *rise = out->wsola_in[c] + best;
+            float *dest = out->output[c] + offset;
+            for (int i = 0; i < hop; i++) {
+                dest[i] = fade[i] * out->window[hop - 1 - i] + rise[i] * out->window[i];
+            }
+        }
+        offset += hop;
+        *advance += best + hop - out->mark;
+        out->mark = best + hop;
+        out->prev = best;
+        out->next += hop * out->tempo;
+    }
+
+    // Drop input no future frame or crossfade can reach.
+    int keep = (int)(out->next + 0.5) - out->search;
+    if (keep > out->prev + hop) {
+        keep = out->prev + hop;
+    }
+    if (keep > 0) {
+        for (int c = 0; c < out->channels; c++) {
+            memmove(out->wsola_in[c], out->wsola_in[c] + keep, sizeof(float) * (out->wsola_len - keep));
+        }
+        out->wsola_len -= keep;
+        out->prev -= keep;
+        out->next -= keep;
+        out->mark -= keep;
+    }
+    return offset;
+}
+
+/**
+ * Pass resampled samples on through the tempo change to JS. When
+ * draining, input WSOLA is still holding is played out at normal speed.
+ */
+static int emit(OGVAudioDecoder *decoder, AudioOutput *out,
+                float **samples, int count, int draining) {
+    int rate = out->out_rate ? out->out_rate : out->in_rate;
+
+    if (!out->wsola_active && (out->tempo == 1.0 || draining)) {
+        if (count > 0) {
+            ogvjs_callback_audio(decoder, samples, out->channels, count, (double)count / rate);
+        }
+        return 1;
+    }
+
+    int outCount = 0, advance = 0;
+    if (!out->wsola_active) {
+        // Pick up where the straight-through output left off: as if
+        // the previous frame ended on a crossfade into this input.
+        out->wsola_active = 1;
+        out->wsola_len = 0;
+        out->prev = -out->hop;
+        out->next = 0.0;
+        out->mark = 0;
+    }
+    if (out->tempo != 1.0) {
+        outCount = wsola(out, samples, count, 0, &advance);
+        if (outCount < 0) {
+            return 0;
+        }
+        if (!draining) {
+            if (outCount > 0) {
+                ogvjs_callback_audio(decoder, out->output, out->channels, outCount, (double)advance / rate);
+            }
+            return 1;
+        }
+        count = 0;
+    }
+
+    // Back to normal speed, or out of input. Carrying on from the
+    // natural continuation of the last frame is seamless.
+    int from = out->prev + out->hop;
+    int rest = out->wsola_len - from;
+    if (!ensure_output(out, outCount + rest + count)) {
+        return 0;
+    }
+    for (int c = 0; c < out->channels; c++) {
+        memcpy(out->output[c] + outCount, out->wsola_in[c] + from, sizeof(float) * rest);
+        if (count > 0) {
+            memcpy(out->output[c] + outCount + rest, samples[c], sizeof(float) * count);
+        }
+    }
+    outCount += rest + count;
+    advance += out->wsola_len - out->mark + count;
+    out->wsola_active = 0;
+    out->wsola_len = 0;
+    if (outCount > 0) {
+        ogvjs_callback_audio(decoder, out->output, out->channels, outCount, (double)advance / rate);
+    }
+    return 1;
+}
+
+int audio_output_write(OGVAudioDecoder *decoder, AudioOutput *out,
+                       float **pcm, int sampleCount, double discardPadding) {
+    if (!out->configured && !configure(out)) {
+        return 0;
+    }
+
+    // Padding is trimmed in stream samples, before the resampler and
+    // tempo change smear it into the audio either side.
+    int trim = (int)floor(fabs(discardPadding) * out->in_rate / 1000000000.0 + 0.5);
+    if (trim > sampleCount) {
+        trim = sampleCount;
+    }
+    float *trimmed[out->channels];
+    if (discardPadding < 0) {
+        for (int c = 0; c < out->channels; c++) {
+            trimmed[c] = pcm[c] + trim;
+        }
+        pcm = trimmed;
+    }
+    sampleCount -= trim;
+
+    float **samples = pcm;
+    int count = sampleCount;
+    if (out->history) {
+        count = resample(out, pcm, sampleCount, out->history_len + sampleCount);
+        if (count < 0) {
+            return 0;
+        }
+        samples = out->resampled;
+    }
+    return emit(decoder, out, samples, count, 0);
+}
+
+int audio_output_drain(OGVAudioDecoder *decoder, AudioOutput *out) {
+    if (!out->configured) {
+        return 1;
+    }
+    float **samples = NULL;
+    int count = 0;
+    if (out->history) {
+        // Push the last input through the filter on silence, stopping
+        // at the end of the real input.
+        count = resample(out, NULL, out->taps, out->history_len);
+        if (count < 0) {
+            return 0;
+        }
+        samples = out->resampled;
+    }
+    int ret = emit(decoder, out, samples, count, 1);
+    audio_output_reset(out);
+    return ret;
+}
@@ -0,0 +1,68 @@
+#include <stddef.h>
+
+// Output stage for the audio decoders. Decoded PCM is resampled to the
+// rate the audio device runs at, and its tempo can be changed without
+// changing pitch for live catch-up, so JS only has to queue the result.
+
+typedef struct {
+    // Stream format, from the codec headers.
+    int channels;
+    int in_rate;
+    // Output rate asked for by JS; 0 to keep the stream rate.
+    int out_rate;
+    double tempo;
+
+    // Windowed-sinc resampler. The rate ratio is kept in lowest terms,
+    // so the filter phase for each output sample is exact.
+    int configured;
+    int up;
+    int down;
+    int taps;
+    float *filter;
+    float **history;
+    int history_len;
+    int history_cap;
+    int index;
+    int phase;
+
+    // WSOLA tempo change: each hop crossfades from where the previous
+    // frame would carry on into the best-matching frame near where the
+    // tempo says we should be.
+    int wsola_active;
+    int hop;
+    int search;
+    float *window;
+    float **wsola_in;
+    int wsola_len;
+    int wsola_cap;
+    int prev;
+    double next;
+    int mark;
+
+    // Stage output, handed to ogvjs_callback_audio.
+    float **resampled;
+    int resampled_cap;
+    float **output;
+    int output_cap;
+} AudioOutput;
+
+// Called once the codec headers give the stream format.
+extern void audio_output_init(AudioOutput *out, int channels, int rate);
+
+extern void audio_output_set_rate(AudioOutput *out, int rate);
+extern void audio_output_set_tempo(AudioOutput *out, double tempo);
+
+// Drop anything held back, as after a seek.
+extern void audio_output_reset(AudioOutput *out);
+
+// Runs decoded samples through the stage and on to ogvjs_callback_audio.
+// discardPadding is in nanoseconds: positive trims that much off the end
+// of these samples, negative off the start. Returns 0 if out of memory.
+extern int audio_output_write(struct OGVAudioDecoder *decoder, AudioOutput *out,
+                              float **pcm, int sampleCount, double discardPadding);
+
+// At the end of the stream, passes on what the resampler and tempo
+// change are still holding back, then starts over.
+extern int audio_output_drain(struct OGVAudioDecoder *decoder, AudioOutput *out);
+
+extern void audio_output_free(AudioOutput *out);
@@ -3,12 +3,69 @@
 
 #include "ogv-buffer-queue.h"
 
+// How many empty slabs to hold on to for reuse after trimming or flushing.
+#define BQ_MAX_SPARE 8
+
+static BufferQueueSlab *bq_slab(BufferQueue *queue, size_t index) {
+    return &queue->slabs[(queue->head + index) & (queue->max - 1)];
+}
+
+/**
+ * Find the slab holding the given position.
+ * Only valid for bq_start(queue) <= pos < bq_end(queue).
+ */
+static BufferQueueSlab *bq_slab_at(BufferQueue *queue, int64_t pos) {
+    return bq_slab(queue, (size_t)((pos - bq_slab(queue, 0)->start) / BQ_SLAB_SIZE));
+}
+
+static char *bq_alloc_slab(BufferQueue *queue) {
+    if (queue->spareLen > 0) {
+        return queue->spare[--queue->spareLen];
+    }
+    return malloc(BQ_SLAB_SIZE);
+}
+
+static void bq_release_slab(BufferQueue *queue, char *bytes) {
+    if (queue->spareLen < BQ_MAX_SPARE) {
+        queue->spare[queue->spareLen++] = bytes;
+    } else {
+        free(bytes);
+    }
+}
+
+static void bq_push_slab(BufferQueue *queue) {
+    if (queue->len == queue->max) {
+        bq_trim(queue);
+    }
+    if (queue->len == queue->max) {
+        // Double the ring, unwrapping it so head is back at 0.
+        size_t max = queue->max * 2;
+        BufferQueueSlab *slabs = malloc(max * sizeof(BufferQueueSlab));
+        for (size_t i = 0; i < queue->len; i++) {
+            slabs[i] = *bq_slab(queue, i);
+        }
+        free(queue->slabs);
+        queue->slabs = slabs;
+        queue->head = 0;
+        queue->max = max;
+    }
+    BufferQueueSlab *slab = bq_slab(queue, queue->len);
+    slab->start = bq_end(queue);
+    slab->len = 0;
+    slab->bytes = bq_alloc_slab(queue);
+    queue->len++;
+}
+
 BufferQueue *bq_init(void) {
     BufferQueue *queue = malloc(sizeof(BufferQueue));
     queue->pos = 0;
+    queue->lastSeekTarget = -1;
+    queue->head = 0;
     queue->len = 0;
-    queue->max = 8;
-    queue->items = malloc(queue->max * sizeof(BufferQueueItem));
+    queue->max = 8; // must be a power of two
+    queue->slabs = malloc(queue->max * sizeof(BufferQueueSlab));
+    queue->spareLen = 0;
+    queue->spare = malloc(BQ_MAX_SPARE * sizeof(char *));
     return queue;
 }
 
@@ -16,14 +73,15 @@ int64_t bq_start(BufferQueue *queue) {
     if (queue->len == 0) {
         return queue->pos;
     }
-    return queue->items[0].start;
+    return bq_slab(queue, 0)->start;
 }
 
 int64_t bq_end(BufferQueue *queue) {
     if (queue->len == 0) {
         return queue->pos;
     }
-    return queue->items[queue->len - 1].start + queue->items[queue->len - 1].len;
+    BufferQueueSlab *last = bq_slab(queue, queue->len - 1);
+    return last->start + last->len;
 }
 
 int64_t bq_tell(BufferQueue *queue) {
@@ -49,45 +107,47 @@ int bq_seek(BufferQueue *queue, int64_t pos) {
 }
 
 void bq_trim(BufferQueue *queue) {
-    int shift = 0;
-    for (int i = 0; i < queue->len; i++) {
-        if (queue->items[i].start + queue->items[i].len < queue->pos) {
-            free(queue->items[i].bytes);
-            queue->items[i].bytes = NULL;
-            shift++;
-            continue;
+    // Keep the final slab even if it's been read through, so that
+    // subsequent appends stay adjacent to it.
+    while (queue->len > 1) {
+        BufferQueueSlab *slab = bq_slab(queue, 0);
+        if (slab->start + slab->len < queue->pos) {
+            bq_release_slab(queue, slab->bytes);
+            slab->bytes = NULL;
+            queue->head = (queue->head + 1) & (queue->max - 1);
+            queue->len--;
         } else {
             break;
         }
     }
-    if (shift) {
-        queue->len -= shift;
-        memmove(queue->items, queue->items + shift, queue->len * sizeof(BufferQueueItem));
-    }
 }
 
 void bq_flush(BufferQueue *queue) {
-    for (int i = 0; i < queue->len; i++) {
-        free(queue->items[i].bytes);
-        queue->items[i].bytes = NULL;
+    for (size_t i = 0; i < queue->len; i++) {
+        BufferQueueSlab *slab = bq_slab(queue, i);
+        bq_release_slab(queue, slab->bytes);
+        slab->bytes = NULL;
     }
+    queue->head = 0;
     queue->len = 0;
     queue->pos = 0;
 }
 
 void bq_append(BufferQueue *queue, const char *data, size_t len) {
-    if (queue->len == queue->max) {
-        bq_trim(queue);
-    }
-    if (queue->len == queue->max) {
-        queue->max += 8;
-        queue->items = realloc(queue->items, queue->max * sizeof(BufferQueueItem));
+    while (len > 0) {
+        if (queue->len == 0 || bq_slab(queue, queue->len - 1)->len == BQ_SLAB_SIZE) {
+            bq_push_slab(queue);
+        }
+        BufferQueueSlab *slab = bq_slab(queue, queue->len - 1);
+        size_t chunkLen = BQ_SLAB_SIZE - slab->len;
+        if (chunkLen > len) {
+            chunkLen = len;
+        }
+        memcpy(slab->bytes + slab->len, data, chunkLen);
+        slab->len += chunkLen;
+        data += chunkLen;
+        len -= chunkLen;
     }
-    queue->items[queue->len].start = bq_end(queue);
-    queue->items[queue->len].len = len;
-    queue->items[queue->len].bytes = malloc(len);
-    memcpy(queue->items[queue->len].bytes, data, len);
-    queue->len++;
 }
 
 int bq_read(BufferQueue *queue, char *data, size_t len) {
@@ -95,32 +155,45 @@ int bq_read(BufferQueue *queue, char *data, size_t len) {
         return -1;
     }
 
-    size_t offset = 0;
-    size_t remaining = len;
-    for (int i = 0; i < queue->len; i++) {
-        if (queue->items[i].start + queue->items[i].len < queue->pos) {
-            //printf("bq_read skipped item at pos %lld len %d\n", queue->items[i].start, queue->items[i].len);
-            continue;
+    while (len > 0) {
+        BufferQueueSlab *slab = bq_slab_at(queue, queue->pos);
+        size_t chunkStart = queue->pos - slab->start;
+        size_t chunkLen = slab->len - chunkStart;
+        if (chunkLen > len) {
+            chunkLen = len;
         }
-        size_t chunkStart = queue->pos - queue->items[i].start;
-        size_t chunkLen = queue->items[i].len - chunkStart;
-        if (chunkLen > remaining) {
-            chunkLen = remaining;
-        }
-        memcpy(data + offset, queue->items[i].bytes + chunkStart, chunkLen);
-        //printf("bq_read copy chunkStart %d chunkLen %d to offset %d; from item %d start %lld len %d (pos %lld)\n", chunkStart, chunkLen, offset, i, queue->items[i].start, queue->items[i].len, queue->pos);
+        memcpy(data, slab->bytes + chunkStart, chunkLen);
         queue->pos += chunkLen;
-        offset += chunkLen;
-        remaining -= chunkLen;
-        if (remaining <= 0) {
-            return 0;
-        }
+        data += chunkLen;
+        len -= chunkLen;
     }
-    return -1;
+    return 0;
+}
+
+/**
+ * Get a direct pointer to the next len bytes without consuming them.
+ * @returns 0 on success, or -1 if there isn't enough data buffered or
+ *          the bytes straddle a slab boundary; use bq_read in that case.
+ */
+int bq_peek(BufferQueue *queue, size_t len, const char **data) {
+    if (len == 0 || bq_headroom(queue) < len) {
+        return -1;
+    }
+    BufferQueueSlab *slab = bq_slab_at(queue, queue->pos);
+    size_t chunkStart = queue->pos - slab->start;
+    if (slab->len - chunkStart < len) {
+        return -1;
+    }
+    *data = slab->bytes + chunkStart;
+    return 0;
 }
 
 void bq_free(BufferQueue *queue) {
     bq_flush(queue);
-    free(queue->items);
+    for (size_t i = 0; i < queue->spareLen; i++) {
+        free(queue->spare[i]);
+    }
+    free(queue->spare);
+    free(queue->slabs);
     free(queue);
-};
+}
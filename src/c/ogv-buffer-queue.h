@@ -1,17 +1,27 @@
 #include <stdint.h>
 
+// Input is stored in fixed-size slabs so that appends don't need a
+// malloc per chunk, and a byte position maps to its slab arithmetically.
+#define BQ_SLAB_SIZE 65536
+
 typedef struct {
-	// Todo: turn this into a linked list
     char *bytes;
     int64_t start;
     size_t len;
-} BufferQueueItem;
+} BufferQueueSlab;
 
 typedef struct {
-    // Currently assumes all items are adjacent and in order
-    BufferQueueItem *items;
+    // Ring of slabs; all slabs are adjacent and in order, and every
+    // slab except the last one is completely full.
+    BufferQueueSlab *slabs;
+    size_t head;
     size_t len;
     size_t max;
+
+    // Emptied slab storage kept around for reuse.
+    char **spare;
+    size_t spareLen;
+
     int64_t pos;
     int64_t lastSeekTarget;
 } BufferQueue;
@@ -27,4 +37,5 @@ extern void bq_trim(BufferQueue *queue);
 extern void bq_flush(BufferQueue *queue);
 extern void bq_append(BufferQueue *queue, const char *data, size_t len);
 extern int bq_read(BufferQueue *queue, char *data, size_t len);
+extern int bq_peek(BufferQueue *queue, size_t len, const char **data);
 extern void bq_free(BufferQueue *queue);
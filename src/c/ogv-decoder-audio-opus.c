@@ -12,90 +12,171 @@
 #include "opus_helper.h"
 
 #include "ogv-decoder-audio.h"
+#include "ogv-audio-output.h"
 #include "ogv-ogg-support.h"
 
-double            audioSampleRate = 0;
-
-int               opusHeaders = 0;
-ogg_stream_state  opusStreamState;
-OpusMSDecoder    *opusDecoder = NULL;
-int               opusMappingFamily;
-int               opusChannels;
-int               opusPreskip;
-ogg_int64_t       opusPrevPacketGranpos;
-float             opusGain;
-int               opusStreams;
 /* 120ms at 48000 */
 #define OPUS_MAX_FRAME_SIZE (960*6)
 
-void ogv_audio_decoder_init(void) {
+struct OGVAudioDecoder {
+	double            audioSampleRate;
+
+	int               opusHeaders;
+	OpusMSDecoder    *opusDecoder;
+	int               opusMappingFamily;
+	int               opusChannels;
+	int               opusPreskip;
+	ogg_int64_t       opusPrevPacketGranpos;
+	float             opusGain;
+	int               opusStreams;
+
+	/* Output buffers, sized once the channel count is known */
+	float            *opusOutput;
+	float            *opusPcm;
+	float           **opusPcmp;
+
+	AudioOutput       output;
+};
+
+OGVAudioDecoder *ogv_audio_decoder_create(void) {
+	return calloc(1, sizeof(OGVAudioDecoder));
+}
+
+/**
+ * Returns 0, with none of them allocated, if out of memory.
+ */
+static int alloc_output_buffers(OGVAudioDecoder *decoder) {
+	decoder->opusOutput = malloc(sizeof (*decoder->opusOutput) * OPUS_MAX_FRAME_SIZE * decoder->opusChannels);
+	decoder->opusPcm = malloc(sizeof (*decoder->opusPcm) * OPUS_MAX_FRAME_SIZE * decoder->opusChannels);
+	decoder->opusPcmp = malloc(sizeof (*decoder->opusPcmp) * decoder->opusChannels);
+	if (!decoder->opusOutput || !decoder->opusPcm || !decoder->opusPcmp) {
+		free(decoder->opusOutput);
+		free(decoder->opusPcm);
+		free(decoder->opusPcmp);
+		decoder->opusOutput = NULL;
+		decoder->opusPcm = NULL;
+		decoder->opusPcmp = NULL;
+		return 0;
+	}
+	for (int c = 0; c < decoder->opusChannels; ++c) {
+		decoder->opusPcmp[c] = decoder->opusPcm + c * OPUS_MAX_FRAME_SIZE;
+	}
+	return 1;
+}
+
+/**
+ * Reorder Opus' interleaved samples into two-dimensional [channel][sample] form.
+ * Stereo gets its own fixed-stride loop so the compiler can vectorize it.
+ */
+static void deinterleave(const float *input, float **output, int channels, int sampleCount) {
+	if (channels == 2) {
+		float *left = output[0];
+		float *right = output[1];
+		for (int s = 0; s < sampleCount; ++s) {
+			left[s] = input[s * 2];
+			right[s] = input[s * 2 + 1];
+		}
+	} else {
+		for (int c = 0; c < channels; ++c) {
+			float *dest = output[c];
+			const float *src = input + c;
+			for (int s = 0; s < sampleCount; ++s) {
+				dest[s] = src[s * channels];
+			}
+		}
+	}
 }
 
-int ogv_audio_decoder_process_header(const char *data, size_t data_len) {
+int ogv_audio_decoder_process_header(OGVAudioDecoder *decoder, const char *data, size_t data_len) {
 	ogg_packet oggPacket;
 	ogv_ogg_import_packet(&oggPacket, data, data_len);
 
-	if (opusHeaders == 0) {
-		opusDecoder = opus_process_header(&oggPacket, &opusMappingFamily, &opusChannels, &opusPreskip, &opusGain, &opusStreams);
-		if (opusDecoder) {
-			opusHeaders = 1;
-			if (opusGain) {
-				opus_multistream_decoder_ctl(opusDecoder, OPUS_SET_GAIN(opusGain));
+	if (decoder->opusHeaders == 0) {
+		decoder->opusDecoder = opus_process_header(&oggPacket, &decoder->opusMappingFamily, &decoder->opusChannels, &decoder->opusPreskip, &decoder->opusGain, &decoder->opusStreams);
+		if (decoder->opusDecoder) {
+			decoder->opusHeaders = 1;
+			if (decoder->opusGain) {
+				opus_multistream_decoder_ctl(decoder->opusDecoder, OPUS_SET_GAIN(decoder->opusGain));
 			}
-			opusPrevPacketGranpos = 0;
-			opusHeaders = 1;
+			if (!alloc_output_buffers(decoder)) {
+				// fail!
+				return 0;
+			}
+			decoder->opusPrevPacketGranpos = 0;
+			decoder->opusHeaders = 1;
 			// process more headers
 			return 1;
 		} else {
 			// fail!
 			return 0;
 		}
-	} else if (opusHeaders == 1) {
+	} else if (decoder->opusHeaders == 1) {
 		// comment packet -- discard
-		opusHeaders++;
+		decoder->opusHeaders++;
 		return 1;
 	} else {
-		// opusDecoder should already be initialized
+		// decoder->opusDecoder should already be initialized
 		// Opus has a fixed internal sampling rate of 48000 Hz
-		audioSampleRate = 48000;
-		ogvjs_callback_init_audio(opusChannels, audioSampleRate);
+		decoder->audioSampleRate = 48000;
+		audio_output_init(&decoder->output, decoder->opusChannels, decoder->audioSampleRate);
+		ogvjs_callback_init_audio(decoder, decoder->opusChannels, decoder->audioSampleRate);
 		return 1;
 	}
 }
 
-int ogv_audio_decoder_process_audio(const char *data, size_t data_len) {
+int ogv_audio_decoder_process_audio(OGVAudioDecoder *decoder, const char *data, size_t data_len, double discardPadding) {
 	int ret = 0;
+	if (!decoder->opusPcmp) {
+		// Headers never got as far as setting up the output buffers.
+		return 0;
+	}
 
-	float *output = malloc(sizeof (float)*OPUS_MAX_FRAME_SIZE * opusChannels);
-	int sampleCount = opus_multistream_decode_float(opusDecoder, (unsigned char*) data, data_len, output, OPUS_MAX_FRAME_SIZE, 0);
+	int sampleCount = opus_multistream_decode_float(decoder->opusDecoder, (unsigned char*) data, data_len, decoder->opusOutput, OPUS_MAX_FRAME_SIZE, 0);
 	if (sampleCount < 0) {
 		//printf("Opus decoding error, code %d\n", sampleCount);
 		ret = 0;
 	} else {
-		int skip = opusPreskip;
+		int skip = decoder->opusPreskip;
+		ret = 1;
 		if (skip >= sampleCount) {
 			skip = sampleCount;
+		} else if (decoder->opusChannels == 1) {
+			// Already planar; point straight into the decode buffer.
+			float *pcmp = decoder->opusOutput + skip;
+			ret = audio_output_write(decoder, &decoder->output, &pcmp, sampleCount - skip, discardPadding);
 		} else {
-			// reorder Opus' interleaved samples into two-dimensional [channel][sample] form
-			float *pcm = malloc(sizeof (*pcm)*(sampleCount - skip) * opusChannels);
-			float **pcmp = malloc(sizeof (*pcmp) * opusChannels);
-			for (int c = 0; c < opusChannels; ++c) {
-				pcmp[c] = pcm + c * (sampleCount - skip);
-				for (int s = skip; s < sampleCount; ++s) {
-					pcmp[c][s - skip] = output[s * opusChannels + c];
-				}
-			}
-			ogvjs_callback_audio(pcmp, opusChannels, sampleCount - skip);
-			free(pcmp);
-			free(pcm);
+			deinterleave(decoder->opusOutput + skip * decoder->opusChannels, decoder->opusPcmp, decoder->opusChannels, sampleCount - skip);
+			ret = audio_output_write(decoder, &decoder->output, decoder->opusPcmp, sampleCount - skip, discardPadding);
 		}
-		opusPreskip -= skip;
-		ret = 1;
+		decoder->opusPreskip -= skip;
 	}
-	free(output);
 
 	return ret;
 }
 
-void ogv_audio_decoder_destroy(void) {
+void ogv_audio_decoder_set_output_rate(OGVAudioDecoder *decoder, int rate) {
+	audio_output_set_rate(&decoder->output, rate);
+}
+
+void ogv_audio_decoder_set_tempo(OGVAudioDecoder *decoder, double tempo) {
+	audio_output_set_tempo(&decoder->output, tempo);
+}
+
+void ogv_audio_decoder_flush(OGVAudioDecoder *decoder) {
+	audio_output_reset(&decoder->output);
+}
+
+int ogv_audio_decoder_drain(OGVAudioDecoder *decoder) {
+	return audio_output_drain(decoder, &decoder->output);
+}
+
+void ogv_audio_decoder_destroy(OGVAudioDecoder *decoder) {
+	if (decoder->opusDecoder) {
+		opus_multistream_decoder_destroy(decoder->opusDecoder);
+	}
+	free(decoder->opusOutput);
+	free(decoder->opusPcm);
+	free(decoder->opusPcmp);
+	audio_output_free(&decoder->output);
+	free(decoder);
 }
@@ -11,56 +11,63 @@
 #include <vorbis/codec.h>
 
 #include "ogv-decoder-audio.h"
+#include "ogv-audio-output.h"
 #include "ogv-ogg-support.h"
 
-double            audioSampleRate = 0;
-
 /* Audio decode state */
-int               vorbisHeaders = 0;
-int               vorbisProcessingHeaders;
-ogg_stream_state  vorbisStreamState;
-vorbis_info       vorbisInfo;
-vorbis_dsp_state  vorbisDspState;
-vorbis_block      vorbisBlock;
-vorbis_comment    vorbisComment;
-
-void ogv_audio_decoder_init(void) {
+struct OGVAudioDecoder {
+	double            audioSampleRate;
+
+	int               vorbisHeaders;
+	int               vorbisProcessingHeaders;
+	vorbis_info       vorbisInfo;
+	vorbis_dsp_state  vorbisDspState;
+	vorbis_block      vorbisBlock;
+	vorbis_comment    vorbisComment;
+
+	AudioOutput       output;
+};
+
+OGVAudioDecoder *ogv_audio_decoder_create(void) {
+	OGVAudioDecoder *decoder = calloc(1, sizeof(OGVAudioDecoder));
     /* init supporting Vorbis structures needed in header parsing */
-    vorbis_info_init(&vorbisInfo);
-    vorbis_comment_init(&vorbisComment);
+    vorbis_info_init(&decoder->vorbisInfo);
+    vorbis_comment_init(&decoder->vorbisComment);
+	return decoder;
 }
 
-int ogv_audio_decoder_process_header(const char *data, size_t data_len) {
+int ogv_audio_decoder_process_header(OGVAudioDecoder *decoder, const char *data, size_t data_len) {
 	ogg_packet oggPacket;
 	ogv_ogg_import_packet(&oggPacket, data, data_len);
 
-	if (vorbisHeaders == 0) {
+	if (decoder->vorbisHeaders == 0) {
 		oggPacket.b_o_s = 1; // hack!
 	}
 
-	vorbisProcessingHeaders = vorbis_synthesis_headerin(&vorbisInfo, &vorbisComment, &oggPacket);
-	if (vorbisProcessingHeaders == 0) {
+	decoder->vorbisProcessingHeaders = vorbis_synthesis_headerin(&decoder->vorbisInfo, &decoder->vorbisComment, &oggPacket);
+	if (decoder->vorbisProcessingHeaders == 0) {
 		// Completed another vorbis header (of 3 total)...
-		vorbisHeaders++;
+		decoder->vorbisHeaders++;
 	} else {
 		//printf("Invalid vorbis header?\n");
 		return 0;
 	}
 
-	if (vorbisHeaders < 3) {
+	if (decoder->vorbisHeaders < 3) {
 		return 1; // keep reading!
 	} else {
-		vorbis_synthesis_init(&vorbisDspState, &vorbisInfo);
-		vorbis_block_init(&vorbisDspState, &vorbisBlock);
+		vorbis_synthesis_init(&decoder->vorbisDspState, &decoder->vorbisInfo);
+		vorbis_block_init(&decoder->vorbisDspState, &decoder->vorbisBlock);
 
-		audioSampleRate = vorbisInfo.rate;
-		ogvjs_callback_init_audio(vorbisInfo.channels, audioSampleRate);
+		decoder->audioSampleRate = decoder->vorbisInfo.rate;
+		audio_output_init(&decoder->output, decoder->vorbisInfo.channels, decoder->audioSampleRate);
+		ogvjs_callback_init_audio(decoder, decoder->vorbisInfo.channels, decoder->audioSampleRate);
 
 		return 1;
 	}
 }
 
-int ogv_audio_decoder_process_audio(const char *data, size_t data_len) {
+int ogv_audio_decoder_process_audio(OGVAudioDecoder *decoder, const char *data, size_t data_len, double discardPadding) {
 	ogg_packet audioPacket;
 	ogv_ogg_import_packet(&audioPacket, data, data_len);
 
@@ -68,16 +75,16 @@ int ogv_audio_decoder_process_audio(const char *data, size_t data_len) {
     int foundSome = 0;
 
 
-	int ret = vorbis_synthesis(&vorbisBlock, &audioPacket);
+	int ret = vorbis_synthesis(&decoder->vorbisBlock, &audioPacket);
 	if (ret == 0) {
 		foundSome = 1;
-		vorbis_synthesis_blockin(&vorbisDspState, &vorbisBlock);
+		vorbis_synthesis_blockin(&decoder->vorbisDspState, &decoder->vorbisBlock);
 
 		float **pcm;
-		int sampleCount = vorbis_synthesis_pcmout(&vorbisDspState, &pcm);
-		ogvjs_callback_audio(pcm, vorbisInfo.channels, sampleCount);
+		int sampleCount = vorbis_synthesis_pcmout(&decoder->vorbisDspState, &pcm);
+		foundSome = audio_output_write(decoder, &decoder->output, pcm, sampleCount, discardPadding);
 
-		vorbis_synthesis_read(&vorbisDspState, sampleCount);
+		vorbis_synthesis_read(&decoder->vorbisDspState, sampleCount);
 	} else {
 		//printf("Vorbis decoder failed mysteriously? %d", ret);
 	}
@@ -85,11 +92,29 @@ int ogv_audio_decoder_process_audio(const char *data, size_t data_len) {
 	return foundSome;
 }
 
-void ogv_audio_decoder_destroy(void) {
-    if (vorbisHeaders) {
-        vorbis_info_clear(&vorbisInfo);
-        vorbis_dsp_clear(&vorbisDspState);
-        vorbis_block_clear(&vorbisBlock);
-        vorbis_comment_clear(&vorbisComment);
+void ogv_audio_decoder_set_output_rate(OGVAudioDecoder *decoder, int rate) {
+	audio_output_set_rate(&decoder->output, rate);
+}
+
+void ogv_audio_decoder_set_tempo(OGVAudioDecoder *decoder, double tempo) {
+	audio_output_set_tempo(&decoder->output, tempo);
+}
+
+void ogv_audio_decoder_flush(OGVAudioDecoder *decoder) {
+	audio_output_reset(&decoder->output);
+}
+
+int ogv_audio_decoder_drain(OGVAudioDecoder *decoder) {
+	return audio_output_drain(decoder, &decoder->output);
+}
+
+void ogv_audio_decoder_destroy(OGVAudioDecoder *decoder) {
+    if (decoder->vorbisHeaders == 3) {
+        vorbis_block_clear(&decoder->vorbisBlock);
+        vorbis_dsp_clear(&decoder->vorbisDspState);
     }
+    vorbis_comment_clear(&decoder->vorbisComment);
+    vorbis_info_clear(&decoder->vorbisInfo);
+    audio_output_free(&decoder->output);
+    free(decoder);
 }
@@ -1,3 +1,22 @@
+// Opaque per-stream decoder state, from ogv_audio_decoder_create().
+// Every callback gets back the handle it was raised for.
+typedef struct OGVAudioDecoder OGVAudioDecoder;
+
 // Callbacks
-extern void ogvjs_callback_init_audio(int channels, int rate);
-extern void ogvjs_callback_audio(float **buffers, int channels, int sampleCount);
+extern void ogvjs_callback_init_audio(OGVAudioDecoder *decoder, int channels, int rate);
+// duration is the stream time the samples cover, in seconds; it differs
+// from sampleCount / rate while the tempo is changed.
+extern void ogvjs_callback_audio(OGVAudioDecoder *decoder, float **buffers, int channels, int sampleCount, double duration);
+
+// Resample output to rate, as the audio device wants; 0 for the stream rate.
+extern void ogv_audio_decoder_set_output_rate(OGVAudioDecoder *decoder, int rate);
+
+// Speed up or slow down output without changing pitch, from 0.5 to 2.
+extern void ogv_audio_decoder_set_tempo(OGVAudioDecoder *decoder, double tempo);
+
+// Drop samples held back by the output stage, as after a seek.
+extern void ogv_audio_decoder_flush(OGVAudioDecoder *decoder);
+
+// At the end of the stream, send on what the output stage is holding
+// back through ogvjs_callback_audio. Returns 0 if out of memory.
+extern int ogv_audio_decoder_drain(OGVAudioDecoder *decoder);
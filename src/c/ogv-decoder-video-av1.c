@@ -4,73 +4,273 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <limits.h>
+#include <stdatomic.h>
 
 #include <stdio.h>
 
 #include <dav1d/dav1d.h>
 
 #include "ogv-decoder-video.h"
-#include "ogv-thread-support.h"
+
+#ifdef __EMSCRIPTEN_PTHREADS__
+#include <pthread.h>
+#endif
+
+static void fake_free_callback(const uint8_t *buf, void *user_data) {
+    // do nothing
+}
+
+typedef struct _DecodeState {
+    Dav1dPicture picture;
+    int success;
+    struct _DecodeState *next;
+} DecodedFrame;
+
+/* Picture buffer pool */
+
+// Lives at the start of each pooled allocation; picture data follows
+// after DAV1D_PICTURE_ALIGNMENT bytes so it stays aligned.
+typedef struct _PoolBuffer {
+    struct _PoolBuffer *next;
+    size_t size;
+} PoolBuffer;
+
+// One bucket per distinct picture allocation size. Normally only one
+// is in use, but resolution changes may briefly need a second.
+#define POOL_BUCKETS 4
+
+typedef struct {
+    size_t size;
+    PoolBuffer *free;
+    unsigned int lastUsed;
+} PoolBucket;
 
 /* Video decode state */
 
-static Dav1dContext *context = NULL;
+typedef struct {
+    Dav1dContext *context;
+
+    PoolBucket pool_buckets[POOL_BUCKETS];
+    unsigned int pool_clock;
+    // Counted off the main thread, read from it for stats.
+    _Atomic int pool_hits;
+    _Atomic int pool_misses;
+
+    DecodedFrame *frame_free_list;
+
+#ifdef __EMSCRIPTEN_PTHREADS__
+    // Pictures may be released from dav1d's worker threads or from the
+    // main thread, as well as from the decode thread.
+    pthread_mutex_t pool_mutex;
+#endif
+} DecoderState;
+
+#include "ogv-thread-support.h"
+
+#ifdef __EMSCRIPTEN_PTHREADS__
+#define pool_lock(state) pthread_mutex_lock(&(state)->pool_mutex)
+#define pool_unlock(state) pthread_mutex_unlock(&(state)->pool_mutex)
+#else
+#define pool_lock(state)
+#define pool_unlock(state)
+#endif
+
+static void pool_drain_bucket(PoolBucket *bucket) {
+    while (bucket->free) {
+        PoolBuffer *buffer = bucket->free;
+        bucket->free = buffer->next;
+        free(buffer);
+    }
+    bucket->size = 0;
+}
+
+// Must be called with the pool lock held.
+static PoolBucket *pool_find_bucket(DecoderState *state, size_t size, int create) {
+    PoolBucket *buckets = state->pool_buckets;
+    PoolBucket *oldest = &buckets[0];
+    for (int i = 0; i < POOL_BUCKETS; i++) {
+        if (buckets[i].size == size) {
+            return &buckets[i];
+        }
+        if (buckets[i].lastUsed < oldest->lastUsed) {
+            oldest = &buckets[i];
+        }
+    }
+    if (!create) {
+        return NULL;
+    }
+    // Reassign the least recently used size to this one.
+    pool_drain_bucket(oldest);
+    oldest->size = size;
+    return oldest;
+}
+
+static int pool_alloc_picture(Dav1dPicture *pic, void *cookie) {
+    DecoderState *state = (DecoderState *)cookie;
+    const int hbd = pic->p.bpc > 8;
+    const int aligned_w = (pic->p.w + 127) & ~127;
+    const int aligned_h = (pic->p.h + 127) & ~127;
+    const int has_chroma = pic->p.layout != DAV1D_PIXEL_LAYOUT_I400;
+    const int ss_ver = pic->p.layout == DAV1D_PIXEL_LAYOUT_I420;
+    const int ss_hor = pic->p.layout != DAV1D_PIXEL_LAYOUT_I444;
+    ptrdiff_t y_stride = aligned_w << hbd;
+    ptrdiff_t uv_stride = has_chroma ? y_stride >> ss_hor : 0;
+    // Same cache-set padding as dav1d's default allocator.
+    if (!(y_stride & 1023))
+        y_stride += DAV1D_PICTURE_ALIGNMENT;
+    if (!(uv_stride & 1023) && has_chroma)
+        uv_stride += DAV1D_PICTURE_ALIGNMENT;
+    const size_t y_sz = y_stride * aligned_h;
+    const size_t uv_sz = uv_stride * (aligned_h >> ss_ver);
+    const size_t size = DAV1D_PICTURE_ALIGNMENT + y_sz + 2 * uv_sz + DAV1D_PICTURE_ALIGNMENT;
+
+    pool_lock(state);
+    PoolBucket *bucket = pool_find_bucket(state, size, 1);
+    bucket->lastUsed = ++state->pool_clock;
+    PoolBuffer *buffer = bucket->free;
+    if (buffer) {
+        bucket->free = buffer->next;
+        atomic_fetch_add_explicit(&state->pool_hits, 1, memory_order_relaxed);
+    } else {
+        atomic_fetch_add_explicit(&state->pool_misses, 1, memory_order_relaxed);
+    }
+    pool_unlock(state);
+
+    if (!buffer) {
+        void *mem = NULL;
+        if (posix_memalign(&mem, DAV1D_PICTURE_ALIGNMENT, size)) {
+            return DAV1D_ERR(ENOMEM);
+        }
+        buffer = (PoolBuffer *)mem;
+        buffer->size = size;
+    }
+    buffer->next = NULL;
+
+    uint8_t *data = (uint8_t *)buffer + DAV1D_PICTURE_ALIGNMENT;
+    pic->stride[0] = y_stride;
+    pic->stride[1] = uv_stride;
+    pic->data[0] = data;
+    pic->data[1] = has_chroma ? data + y_sz : NULL;
+    pic->data[2] = has_chroma ? data + y_sz + uv_sz : NULL;
+    pic->allocator_data = buffer;
+    return 0;
+}
+
+static void pool_release_picture(Dav1dPicture *pic, void *cookie) {
+    DecoderState *state = (DecoderState *)cookie;
+    PoolBuffer *buffer = (PoolBuffer *)pic->allocator_data;
+    pool_lock(state);
+    PoolBucket *bucket = pool_find_bucket(state, buffer->size, 0);
+    if (bucket) {
+        buffer->next = bucket->free;
+        bucket->free = buffer;
+        buffer = NULL;
+    }
+    pool_unlock(state);
+    if (buffer) {
+        // Stale size from before a resolution change.
+        free(buffer);
+    }
+}
+
+static void pool_destroy(DecoderState *state) {
+    pool_lock(state);
+    for (int i = 0; i < POOL_BUCKETS; i++) {
+        pool_drain_bucket(&state->pool_buckets[i]);
+    }
+    while (state->frame_free_list) {
+        DecodedFrame *frame = state->frame_free_list;
+        state->frame_free_list = frame->next;
+        free(frame);
+    }
+    pool_unlock(state);
+#ifdef __EMSCRIPTEN_PTHREADS__
+    pthread_mutex_destroy(&state->pool_mutex);
+#endif
+}
+
+static DecodedFrame *frame_alloc(DecoderState *state) {
+    pool_lock(state);
+    DecodedFrame *frame = state->frame_free_list;
+    if (frame) {
+        state->frame_free_list = frame->next;
+    }
+    pool_unlock(state);
+    if (!frame) {
+        frame = malloc(sizeof(DecodedFrame));
+        if (!frame) {
+            return NULL;
+        }
+    }
+    frame->next = NULL;
+    return frame;
+}
+
+static void frame_free(DecoderState *state, DecodedFrame *frame) {
+    pool_lock(state);
+    frame->next = state->frame_free_list;
+    state->frame_free_list = frame;
+    pool_unlock(state);
+}
 
-static void do_init(void) {
+static void do_init(OGVVideoDecoder *decoder) {
+    DecoderState *state = &decoder->state;
     Dav1dSettings settings;
     dav1d_default_settings(&settings);
 
 #ifdef __EMSCRIPTEN_PTHREADS__
-	const int max_cores = 16; // max threads for UHD tiled decoding, plus some extra for frame threading
+    pthread_mutex_init(&state->pool_mutex, NULL);
+#endif
+    settings.allocator.cookie = state;
+    settings.allocator.alloc_picture_callback = pool_alloc_picture;
+    settings.allocator.release_picture_callback = pool_release_picture;
+#ifdef __EMSCRIPTEN_PTHREADS__
+	const int max_cores = 16; // dav1d workers; enough for UHD tiled decoding
 	int cores = emscripten_num_logical_cores();
 	if (cores > max_cores) {
 		cores = max_cores;
 	}
 
-    // As of March 2019, dav1d uses two threading settings, creating
-    // multiple small thread pools. This is kind of funky, but works.
-    // However it will create _a lot more threads_ than you might
-    // expect. Each frame thread will spawn one thread of its own
-    // plus one thread per tile, so it's roughly 5*tiles*frames total
-    // threads, even though they won't all be engaged at the same time.
-
-    // It's currently recommended to specify the target number of tiles
-    // which possibly should be something we can scale dynamically.
-    // We don't know ahead of time how many tiles will actually be used
-    // and if doing adaptive streaming it may change.
-    if (cores >= 4) {
-        settings.n_tile_threads = 4;
-    } else if (cores >= 2) {
-        settings.n_tile_threads = 2;
-    }
-
-    // Current recommendations are to use the number of logical processors
-    // as the number of frame threads, for maximum parallelism. This will
-    // buffer up frames and release them later, so don't forget the JS side
-    // needs to occasionally sync the state to force a frame early, such as
-    // after a seek or after the end of input.
-    settings.n_frame_threads = cores;
+    // dav1d runs frame setup, tile decoding and post-filtering as tasks
+    // on one pool of workers, so this is the total thread count however
+    // the stream is tiled.
+    settings.n_threads = cores;
+
+    // Frames decoded in parallel; 0 lets dav1d pick about sqrt(cores).
+    // Each one in flight adds a frame of output latency, so the JS side
+    // still needs to occasionally sync the state to force a frame early,
+    // such as after a seek or after the end of input.
+    settings.max_frame_delay = 0;
 #endif
 
-    dav1d_open(&context, &settings);
+    dav1d_open(&state->context, &settings);
 }
 
-static void fake_free_callback(const uint8_t *buf, void *user_data) {
-    // do nothing
+// Returns 1 if a picture was sent out, or a negative error such as -EAGAIN.
+static int get_picture(OGVVideoDecoder *decoder) {
+    Dav1dPicture picture = {0};
+    int ret = dav1d_get_picture(decoder->state.context, &picture);
+    if (ret < 0) {
+        return ret;
+    }
+    DecodedFrame *frame = frame_alloc(&decoder->state);
+    if (!frame) {
+        dav1d_picture_unref(&picture);
+        return DAV1D_ERR(ENOMEM);
+    }
+    frame->picture = picture;
+    frame->success = 1;
+    call_main_return(decoder, frame, 0);
+    return 1;
 }
 
-typedef struct _DecodeState {
-    Dav1dPicture picture;
-    int success;
-} DecodedFrame;
-
-static void process_frame_decode(const char *buf, size_t buf_len)
+static void process_frame_decode(OGVVideoDecoder *decoder, const char *buf, size_t buf_len)
 {
     if (buf) {
         Dav1dData data;
         dav1d_data_wrap(&data, (const uint8_t*)buf, buf_len, &fake_free_callback, NULL);
         do {
-            int ret = dav1d_send_data(context, &data);
+            int ret = dav1d_send_data(decoder->state.context, &data);
             if (!ret) {
                 // All right! success.
             } else if (ret == -EAGAIN) {
@@ -80,24 +280,13 @@ static void process_frame_decode(const char *buf, size_t buf_len)
                 break;
             }
 
-            DecodedFrame *frame = calloc(1, sizeof(DecodedFrame));
-            int ret2 = dav1d_get_picture(context, &frame->picture);
-            if (ret2 < 0) {
-                if (ret2 != -EAGAIN) {
-                    // Out of pictures. Go home and wait for more packets.
-                    free(frame);
-                    printf("dav1d_get_picture returned %d\n", ret2);
-                    break;
-                } else {
-                    // Is -EAGAIN? What does this mean exactly?
-                    free(frame);
-                    // fall through back to loop...?
-                }
-            } else {
-                // yay
-                frame->success = 1;
-                call_main_return(frame, 0);
+            int ret2 = get_picture(decoder);
+            if (ret2 < 0 && ret2 != -EAGAIN) {
+                // Out of pictures. Go home and wait for more packets.
+                printf("dav1d_get_picture returned %d\n", ret2);
+                break;
             }
+            // On -EAGAIN fall through back to loop
         } while (data.sz);
     }
 
@@ -105,30 +294,25 @@ static void process_frame_decode(const char *buf, size_t buf_len)
 
         // Drain any remaining pictures so we have them. (?)
         for (;;) {
-            DecodedFrame *frame = calloc(1, sizeof(DecodedFrame));
-            int ret = dav1d_get_picture(context, &frame->picture);
-            if (!ret) {
+            int ret = get_picture(decoder);
+            if (ret > 0) {
                 // yay
-                frame->success = 1;
-                call_main_return(frame, 0);
                 continue;
             } else if (ret == -EAGAIN) {
-                free(frame);
                 // Out of pictures. Go home and wait for more frames.
                 break;
             } else {
-                free(frame);
                 printf("dav1d_get_picture returned %d\n", ret);
                 break;
             }
         }
 
         // Issue a null callback
-        call_main_return(NULL, 0);
+        call_main_return(decoder, NULL, 0);
     }
 }
 
-static int process_frame_return(void *user_data)
+static int process_frame_return(OGVVideoDecoder *decoder, void *user_data)
 {
     if (!user_data) {
         // NULL indicated a sync point.
@@ -158,22 +342,32 @@ static int process_frame_return(void *user_data)
             // not yet supported
             abort();
     }
-    ogvjs_callback_frame(frame->picture.data[0], frame->picture.stride[0],
-                         frame->picture.data[1], frame->picture.stride[1],
-                         frame->picture.data[2], frame->picture.stride[1],
-                         width, height,
-                         chromaWidth, chromaHeight,
-                         frame->picture.p.w, frame->picture.p.h,
-                         0, 0,
-                         frame->picture.p.w, frame->picture.p.h);
+    frame_ring_output(decoder, &decoder->frames,
+                      frame->picture.data[0], frame->picture.stride[0],
+                      frame->picture.data[1], frame->picture.stride[1],
+                      frame->picture.data[2], frame->picture.stride[1],
+                      width, height,
+                      chromaWidth, chromaHeight,
+                      frame->picture.p.w, frame->picture.p.h,
+                      0, 0,
+                      frame->picture.p.w, frame->picture.p.h);
     dav1d_picture_unref(&frame->picture);
-    free(frame);
+    frame_free(&decoder->state, frame);
 
     return 1;
 }
 
-static void do_destroy(void) {
-    if (context) {
-        dav1d_close(&context);
+static void do_destroy(OGVVideoDecoder *decoder) {
+    if (decoder->state.context) {
+        dav1d_close(&decoder->state.context);
     }
+    pool_destroy(&decoder->state);
+}
+
+void ogv_video_decoder_stats(OGVVideoDecoder *decoder) {
+    ogvjs_callback_stat(decoder, "poolHits", atomic_load(&decoder->state.pool_hits));
+    ogvjs_callback_stat(decoder, "poolMisses", atomic_load(&decoder->state.pool_misses));
+    ogvjs_callback_stat(decoder, "frameSteals", decoder->frames.steals);
+    ogvjs_callback_stat(decoder, "frameDrops", decoder->frames.drops);
+    thread_stats(decoder);
 }
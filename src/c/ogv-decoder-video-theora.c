@@ -13,101 +13,198 @@
 #include "ogv-ogg-support.h"
 
 /* Video decode state */
-th_info           theoraInfo;
-th_comment        theoraComment;
-th_setup_info    *theoraSetupInfo;
-th_dec_ctx       *theoraDecoderContext;
-
-int               theoraHeaders = 0;
-int               theoraProcessingHeaders;
-
-static int display_width = 0;
-static int display_height = 0;
-
-void ogv_video_decoder_init(void) {
-    /* init supporting Theora structures needed in header parsing */
-    th_comment_init(&theoraComment);
-    th_info_init(&theoraInfo);
+typedef struct {
+	th_info           theoraInfo;
+	th_comment        theoraComment;
+	th_setup_info    *theoraSetupInfo;
+	th_dec_ctx       *theoraDecoderContext;
+
+	int               theoraHeaders;
+	int               theoraProcessingHeaders;
+
+	int               display_width;
+	int               display_height;
+
+	// Threads for libtheora to reconstruct each frame with.
+	int               threads;
+
+#ifdef __EMSCRIPTEN_PTHREADS__
+	// Copy of the packet that ended the headers, queued as the first
+	// frame; the decode thread frees it once decoded.
+	char             *firstPacket;
+#endif
+} DecoderState;
+
+// Header packets are parsed here on the main thread, before any frames
+// are queued; the decode thread only reads the results.
+#define OGV_VIDEO_DECODER_HEADERS 1
+
+#include "ogv-thread-support.h"
+
+static void do_init(OGVVideoDecoder *decoder) {
+	DecoderState *state = &decoder->state;
+#ifdef __EMSCRIPTEN_PTHREADS__
+	// libtheora runs reconstruction and filtering of each plane as
+	// separate jobs, so there's nothing for more than six threads to do.
+	const int max_threads = 6;
+	int cores = emscripten_num_logical_cores();
+	if (cores > max_threads) {
+		cores = max_threads;
+	}
+	state->threads = cores;
+#else
+	state->threads = 1;
+#endif
 }
 
-int ogv_video_decoder_async(void) {
-  return 0;
+static void do_destroy(OGVVideoDecoder *decoder) {
+	DecoderState *state = &decoder->state;
+	if (state->theoraDecoderContext) {
+		th_decode_free(state->theoraDecoderContext);
+		state->theoraDecoderContext = NULL;
+	}
+	th_setup_free(state->theoraSetupInfo);
+	th_comment_clear(&state->theoraComment);
+	th_info_clear(&state->theoraInfo);
+#ifdef __EMSCRIPTEN_PTHREADS__
+	free(state->firstPacket);
+#endif
 }
 
-int ogv_video_decoder_process_frame(const char *data, size_t data_len);
-
-int ogv_video_decoder_process_header(const char *data, size_t data_len) {
+int ogv_video_decoder_process_header(OGVVideoDecoder *decoder, const char *data, size_t data_len) {
+	DecoderState *state = &decoder->state;
 	ogg_packet oggPacket;
 	ogv_ogg_import_packet(&oggPacket, data, data_len);
 
-	// hack, theora looks for packet b_o_s
-	if (theoraHeaders == 0) {
+	if (state->theoraHeaders == 0) {
+		/* init supporting Theora structures needed in header parsing */
+		th_comment_init(&state->theoraComment);
+		th_info_init(&state->theoraInfo);
+
+		// hack, theora looks for packet b_o_s
 		oggPacket.b_o_s = 256;
 	}
-	theoraHeaders++;
+	state->theoraHeaders++;
 
-	theoraProcessingHeaders = th_decode_headerin(&theoraInfo, &theoraComment, &theoraSetupInfo, &oggPacket);
-	if (theoraProcessingHeaders == 0) {
+	state->theoraProcessingHeaders = th_decode_headerin(&state->theoraInfo, &state->theoraComment, &state->theoraSetupInfo, &oggPacket);
+	if (state->theoraProcessingHeaders == 0) {
 		// We've completed the theora header
-		theoraDecoderContext = th_decode_alloc(&theoraInfo, theoraSetupInfo);
-
-		int hdec = !(theoraInfo.pixel_fmt & 1);
-		int vdec = !(theoraInfo.pixel_fmt & 2);
+		int hdec = !(state->theoraInfo.pixel_fmt & 1);
+		int vdec = !(state->theoraInfo.pixel_fmt & 2);
 
-		display_width = theoraInfo.pic_width;
-		display_height = theoraInfo.pic_height;
-		if (theoraInfo.aspect_numerator > 0 && theoraInfo.aspect_denominator > 0) {
-			display_width = display_width * theoraInfo.aspect_numerator / theoraInfo.aspect_denominator;
+		state->display_width = state->theoraInfo.pic_width;
+		state->display_height = state->theoraInfo.pic_height;
+		if (state->theoraInfo.aspect_numerator > 0 && state->theoraInfo.aspect_denominator > 0) {
+			state->display_width = state->display_width * state->theoraInfo.aspect_numerator / state->theoraInfo.aspect_denominator;
 		}
-		ogvjs_callback_init_video(theoraInfo.frame_width, theoraInfo.frame_height,
-		                          theoraInfo.frame_width >> hdec, theoraInfo.frame_height >> vdec,
+		ogvjs_callback_init_video(decoder, state->theoraInfo.frame_width, state->theoraInfo.frame_height,
+		                          state->theoraInfo.frame_width >> hdec, state->theoraInfo.frame_height >> vdec,
 		                          0.0f, // don't expose fixed fps; we pretend it's variable to handle dupe frames more cleanly
-		                          theoraInfo.pic_width, theoraInfo.pic_height,
-		                          theoraInfo.pic_x, theoraInfo.pic_y,
-		                          display_width, display_height);
-		
+		                          state->theoraInfo.pic_width, state->theoraInfo.pic_height,
+		                          state->theoraInfo.pic_x, state->theoraInfo.pic_y,
+		                          state->display_width, state->display_height);
+
 		// Last header packet is also first data packet.
-		return ogv_video_decoder_process_frame(data, data_len);
-	} else if (theoraProcessingHeaders > 0) {
+#ifdef __EMSCRIPTEN_PTHREADS__
+		// The data is only ours for this call, so queue a copy. Its frame
+		// and completion come back like any other; the caller expects one
+		// more completion once the headers are done.
+		state->firstPacket = malloc(data_len);
+		if (!state->firstPacket) {
+			return 0;
+		}
+		memcpy(state->firstPacket, data, data_len);
+		// The queue is still empty, so there's room.
+		return ogv_video_decoder_process_frame(decoder, state->firstPacket, data_len);
+#else
+		return ogv_video_decoder_process_frame(decoder, data, data_len);
+#endif
+	} else if (state->theoraProcessingHeaders > 0) {
 		return 1;
 	} else {
-		//printf("Error parsing theora headers: %d.\n", theoraProcessingHeaders);
+		//printf("Error parsing theora headers: %d.\n", state->theoraProcessingHeaders);
+		return 0;
+	}
+}
+
+// The decoder context lives on the decode thread, along with the
+// worker threads libtheora starts for it.
+static int decoder_start(DecoderState *state) {
+	if (state->theoraDecoderContext) {
+		return 1;
+	}
+	if (state->theoraHeaders == 0 || state->theoraProcessingHeaders != 0) {
+		return 0;
+	}
+	state->theoraDecoderContext = th_decode_alloc(&state->theoraInfo, state->theoraSetupInfo);
+	if (!state->theoraDecoderContext) {
 		return 0;
 	}
+	if (state->threads > 1) {
+		// Falls back to decoding on this thread alone if it fails.
+		th_decode_ctl(state->theoraDecoderContext, TH_DECCTL_SET_THREADS, &state->threads, sizeof(state->threads));
+	}
+	return 1;
 }
 
-int ogv_video_decoder_process_frame(const char *data, size_t data_len) {
+static void process_frame_decode(OGVVideoDecoder *decoder, const char *data, size_t data_len) {
+	DecoderState *state = &decoder->state;
+	if (!data) {
+		// NULL data signals syncing the decoder state
+		call_main_return(decoder, NULL, 1);
+		return;
+	}
+	if (!decoder_start(state)) {
+		call_main_return(decoder, NULL, 0);
+		return;
+	}
+
 	ogg_packet oggPacket;
 	ogv_ogg_import_packet(&oggPacket, data, data_len);
 
-    int ret = th_decode_packetin(theoraDecoderContext, &oggPacket, NULL);
-    if (ret == 0 || ret == TH_DUPFRAME) {
+	int ret = th_decode_packetin(state->theoraDecoderContext, &oggPacket, NULL);
+#ifdef __EMSCRIPTEN_PTHREADS__
+	if (data == state->firstPacket) {
+		free(state->firstPacket);
+		state->firstPacket = NULL;
+	}
+#endif
+	if (ret == 0 || ret == TH_DUPFRAME) {
+		// The planes are libtheora's reference frames, which the next
+		// packet writes over, so wait for the main thread to copy them.
 		th_ycbcr_buffer ycbcr;
-		th_decode_ycbcr_out(theoraDecoderContext, ycbcr);
-
-		int hdec = !(theoraInfo.pixel_fmt & 1);
-		int vdec = !(theoraInfo.pixel_fmt & 2);
-
-		ogvjs_callback_frame(ycbcr[0].data, ycbcr[0].stride,
-							 ycbcr[1].data, ycbcr[1].stride,
-							 ycbcr[2].data, ycbcr[2].stride,
-							 theoraInfo.frame_width, theoraInfo.frame_height,
-							 theoraInfo.frame_width >> hdec, theoraInfo.frame_height >> vdec,
-							 theoraInfo.pic_width, theoraInfo.pic_height,
-							 theoraInfo.pic_x, theoraInfo.pic_y,
-							 display_width, display_height);
-        return 1;
-    } else {
-        //printf("Theora decoder failed mysteriously? %d\n", ret);
-        return 0;
-    }
+		th_decode_ycbcr_out(state->theoraDecoderContext, ycbcr);
+		call_main_return(decoder, ycbcr, 1);
+	} else {
+		//printf("Theora decoder failed mysteriously? %d\n", ret);
+		call_main_return(decoder, NULL, 0);
+	}
+}
+
+static int process_frame_return(OGVVideoDecoder *decoder, void *user_data) {
+	DecoderState *state = &decoder->state;
+	th_img_plane *ycbcr = (th_img_plane *)user_data;
+	if (!ycbcr) {
+		return 0;
+	}
+
+	int hdec = !(state->theoraInfo.pixel_fmt & 1);
+	int vdec = !(state->theoraInfo.pixel_fmt & 2);
+
+	frame_ring_output(decoder, &decoder->frames,
+	                  ycbcr[0].data, ycbcr[0].stride,
+	                  ycbcr[1].data, ycbcr[1].stride,
+	                  ycbcr[2].data, ycbcr[2].stride,
+	                  state->theoraInfo.frame_width, state->theoraInfo.frame_height,
+	                  state->theoraInfo.frame_width >> hdec, state->theoraInfo.frame_height >> vdec,
+	                  state->theoraInfo.pic_width, state->theoraInfo.pic_height,
+	                  state->theoraInfo.pic_x, state->theoraInfo.pic_y,
+	                  state->display_width, state->display_height);
+	return 1;
 }
 
-void ogv_video_decoder_destroy(void) {
-    if (theoraDecoderContext) {
-        th_decode_free(theoraDecoderContext);
-        theoraDecoderContext = NULL;
-    }
-	th_comment_clear(&theoraComment);
-	th_info_clear(&theoraInfo);
+void ogv_video_decoder_stats(OGVVideoDecoder *decoder) {
+	ogvjs_callback_stat(decoder, "frameSteals", decoder->frames.steals);
+	ogvjs_callback_stat(decoder, "frameDrops", decoder->frames.drops);
+	thread_stats(decoder);
 }
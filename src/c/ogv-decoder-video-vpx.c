@@ -6,44 +6,602 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <limits.h>
+#include <stdatomic.h>
 
 #define VPX_CODEC_DISABLE_COMPAT 1
 #include <vpx/vpx_decoder.h>
 #include <vpx/vp8dx.h>
 
 #include "ogv-decoder-video.h"
+
+#ifdef __EMSCRIPTEN_PTHREADS__
+#include <pthread.h>
+
+// Frame buffers handed to libvpx, so that decoded images can be passed
+// to the main thread by reference instead of being copied out.
+//
+// Each buffer holds one reference for the decoder, from the get callback
+// until the release callback, plus one for every image still waiting to
+// be sent out on the main thread. It can't be reused until all are gone.
+typedef struct _PoolFrame {
+	struct _PoolFrame *next;
+	uint8_t *data;
+	size_t size;
+	int refs;
+} PoolFrame;
+
+// The decoder overwrites its vpx_image_t on the next decode call,
+// so the main thread gets its own copy of the (small) image struct.
+typedef struct _FrameRef {
+	vpx_image_t image;
+	struct _FrameRef *next;
+} FrameRef;
+
+// How libvpx's worker threads are being used; reported as threadMode.
+enum {
+	THREAD_MODE_SINGLE = 0,      // no worker threads
+	THREAD_MODE_LOOP_FILTER = 1, // VP9: loop filter beside tile decoding
+	THREAD_MODE_ROW = 2,         // VP9: superblock rows, across tiles
+	THREAD_MODE_TILE = 3,        // VP9: a thread per tile column
+	THREAD_MODE_PARTITION = 4,   // VP8: a thread per token partition
+};
+
+// What a keyframe header says about how the frame can be split up.
+typedef struct {
+	int width;
+	int height;
+	int tile_cols;  // VP9
+	int tile_rows;  // VP9
+	int partitions; // VP8
+} KeyframeLayout;
+
+#endif
+
+typedef struct {
+	vpx_codec_ctx_t    vpxContext;
+	vpx_codec_iface_t *vpxDecoder;
+
+	// Counted off the main thread, read from it for stats.
+	_Atomic int pool_hits;
+	_Atomic int pool_misses;
+
+#ifdef __EMSCRIPTEN_PTHREADS__
+	int use_frame_pool;
+	PoolFrame *free_frames;
+	FrameRef *free_refs;
+	pthread_mutex_t pool_mutex;
+
+	// Adaptive threading; see schedule_keyframe(). Only the decode
+	// thread writes these; the atomics are also read for stats.
+	int max_threads;
+	int thread_target;
+	_Atomic int thread_mode;
+	_Atomic int threads;
+	_Atomic int reconfigs;
+	_Atomic int tile_cols;  // VP9
+	_Atomic int tile_rows;  // VP9
+	_Atomic int partitions; // VP8
+	_Atomic double decode_time; // moving average, ms
+	int decode_samples;
+#endif
+} DecoderState;
+
 #include "ogv-thread-support.h"
 
-static vpx_codec_ctx_t    vpxContext;
-static vpx_codec_iface_t *vpxDecoder;
+#ifdef __EMSCRIPTEN_PTHREADS__
 
-static void do_init(void) {
+static int pool_get_frame_buffer(void *priv, size_t min_size, vpx_codec_frame_buffer_t *fb) {
+	DecoderState *state = (DecoderState *)priv;
+	pthread_mutex_lock(&state->pool_mutex);
+	PoolFrame *frame = state->free_frames;
+	if (frame) {
+		state->free_frames = frame->next;
+	}
+	pthread_mutex_unlock(&state->pool_mutex);
+
+	if (frame && frame->size >= min_size) {
+		atomic_fetch_add_explicit(&state->pool_hits, 1, memory_order_relaxed);
+	} else {
+		atomic_fetch_add_explicit(&state->pool_misses, 1, memory_order_relaxed);
+		if (!frame) {
+			frame = calloc(1, sizeof(PoolFrame));
+			if (!frame) {
+				return -1;
+			}
+		}
+		// libvpx wants freshly allocated buffers zeroed.
+		free(frame->data);
+		frame->data = calloc(1, min_size);
+		if (!frame->data) {
+			free(frame);
+			return -1;
+		}
+		frame->size = min_size;
+	}
+	frame->next = NULL;
+	frame->refs = 1;
+
+	fb->data = frame->data;
+	fb->size = frame->size;
+	fb->priv = frame;
+	return 0;
+}
+
+static void pool_unref_frame(DecoderState *state, PoolFrame *frame) {
+	pthread_mutex_lock(&state->pool_mutex);
+	if (--frame->refs == 0) {
+		frame->next = state->free_frames;
+		state->free_frames = frame;
+	}
+	pthread_mutex_unlock(&state->pool_mutex);
+}
+
+static int pool_release_frame_buffer(void *priv, vpx_codec_frame_buffer_t *fb) {
+	pool_unref_frame((DecoderState *)priv, (PoolFrame *)fb->priv);
+	return 0;
+}
+
+// Returns NULL, holding no reference, if out of memory.
+static FrameRef *pool_ref_image(DecoderState *state, vpx_image_t *image) {
+	pthread_mutex_lock(&state->pool_mutex);
+	FrameRef *ref = state->free_refs;
+	if (ref) {
+		state->free_refs = ref->next;
+	}
+	((PoolFrame *)image->fb_priv)->refs++;
+	pthread_mutex_unlock(&state->pool_mutex);
+
+	if (!ref) {
+		ref = malloc(sizeof(FrameRef));
+		if (!ref) {
+			pool_unref_frame(state, (PoolFrame *)image->fb_priv);
+			return NULL;
+		}
+	}
+	ref->image = *image;
+	ref->next = NULL;
+	return ref;
+}
+
+static void pool_unref_image(DecoderState *state, FrameRef *ref) {
+	pool_unref_frame(state, (PoolFrame *)ref->image.fb_priv);
+	pthread_mutex_lock(&state->pool_mutex);
+	ref->next = state->free_refs;
+	state->free_refs = ref;
+	pthread_mutex_unlock(&state->pool_mutex);
+}
+
+static void pool_destroy(DecoderState *state) {
+	while (state->free_frames) {
+		PoolFrame *frame = state->free_frames;
+		state->free_frames = frame->next;
+		free(frame->data);
+		free(frame);
+	}
+	while (state->free_refs) {
+		FrameRef *ref = state->free_refs;
+		state->free_refs = ref->next;
+		free(ref);
+	}
+	pthread_mutex_destroy(&state->pool_mutex);
+}
 
 #ifdef OGV_VP9
-	vpxDecoder = vpx_codec_vp9_dx();
+
+typedef struct {
+	const uint8_t *data;
+	size_t len;
+	size_t pos; // in bits
+} BitReader;
+
+// Reads past the end come back as zeros; callers check pos afterwards.
+static int read_bits(BitReader *br, int n) {
+	int value = 0;
+	while (n-- > 0) {
+		size_t byte = br->pos >> 3;
+		int bit = 0;
+		if (byte < br->len) {
+			bit = (br->data[byte] >> (7 - (br->pos & 7))) & 1;
+		}
+		value = (value << 1) | bit;
+		br->pos++;
+	}
+	return value;
+}
+
+// Walks a VP9 keyframe's uncompressed header as far as the tile info.
+// Returns 0 for anything that isn't a complete keyframe header.
+static int parse_keyframe_layout(const uint8_t *data, size_t len, KeyframeLayout *layout) {
+	BitReader br = { data, len, 0 };
+	if (read_bits(&br, 2) != 2) {
+		return 0; // frame marker
+	}
+	int profile = read_bits(&br, 1);
+	profile |= read_bits(&br, 1) << 1;
+	if (profile == 3) {
+		read_bits(&br, 1);
+	}
+	if (read_bits(&br, 1)) {
+		return 0; // show_existing_frame
+	}
+	if (read_bits(&br, 1)) {
+		return 0; // inter frame
+	}
+	read_bits(&br, 1); // show_frame
+	int error_resilient = read_bits(&br, 1);
+	if (read_bits(&br, 24) != 0x498342) {
+		return 0; // sync code
+	}
+
+	// Color config
+	if (profile >= 2) {
+		read_bits(&br, 1); // bit depth
+	}
+	int odd_profile = (profile == 1 || profile == 3);
+	if (read_bits(&br, 3) != 7) { // not sRGB
+		read_bits(&br, 1 + (odd_profile ? 3 : 0));
+	} else if (odd_profile) {
+		read_bits(&br, 1);
+	}
+
+	layout->width = read_bits(&br, 16) + 1;
+	layout->height = read_bits(&br, 16) + 1;
+	if (read_bits(&br, 1)) {
+		read_bits(&br, 16); // render size
+		read_bits(&br, 16);
+	}
+	if (!error_resilient) {
+		read_bits(&br, 2); // refresh_frame_context, frame_parallel_decoding_mode
+	}
+	read_bits(&br, 2); // frame_context_idx
+
+	// Loop filter
+	read_bits(&br, 6 + 3);
+	if (read_bits(&br, 1) && read_bits(&br, 1)) {
+		for (int i = 0; i < 4 + 2; i++) {
+			if (read_bits(&br, 1)) {
+				read_bits(&br, 6 + 1);
+			}
+		}
+	}
+
+	// Quantizer
+	read_bits(&br, 8);
+	for (int i = 0; i < 3; i++) {
+		if (read_bits(&br, 1)) {
+			read_bits(&br, 4 + 1);
+		}
+	}
+
+	// Segmentation
+	if (read_bits(&br, 1)) {
+		if (read_bits(&br, 1)) { // update_map
+			for (int i = 0; i < 7; i++) {
+				if (read_bits(&br, 1)) {
+					read_bits(&br, 8);
+				}
+			}
+			if (read_bits(&br, 1)) { // temporal_update
+				for (int i = 0; i < 3; i++) {
+					if (read_bits(&br, 1)) {
+						read_bits(&br, 8);
+					}
+				}
+			}
+		}
+		if (read_bits(&br, 1)) { // update_data
+			// Alternate quantizer, loop filter level, reference and skip,
+			// with a sign on the first two.
+			static const int feature_bits[4] = { 8 + 1, 6 + 1, 2, 0 };
+			read_bits(&br, 1); // abs_delta
+			for (int i = 0; i < 8; i++) {
+				for (int j = 0; j < 4; j++) {
+					if (read_bits(&br, 1)) {
+						read_bits(&br, feature_bits[j]);
+					}
+				}
+			}
+		}
+	}
+
+	// Tile info
+	int sb_cols = (((layout->width + 7) >> 3) + 7) >> 3;
+	int min_log2 = 0;
+	while ((64 << min_log2) < sb_cols) {
+		min_log2++;
+	}
+	int max_log2 = 1;
+	while ((sb_cols >> max_log2) >= 4) {
+		max_log2++;
+	}
+	max_log2--;
+	int cols_log2 = min_log2;
+	while (cols_log2 < max_log2 && read_bits(&br, 1)) {
+		cols_log2++;
+	}
+	int rows_log2 = read_bits(&br, 1);
+	if (rows_log2) {
+		rows_log2 += read_bits(&br, 1);
+	}
+	layout->tile_cols = 1 << cols_log2;
+	layout->tile_rows = 1 << rows_log2;
+	layout->partitions = 1;
+
+	return br.pos <= len * 8;
+}
+
 #else
-	vpxDecoder = vpx_codec_vp8_dx();
+
+// VP8's boolean entropy decoder, as in RFC 6386 section 7.
+typedef struct {
+	const uint8_t *data;
+	const uint8_t *end;
+	unsigned int value;
+	unsigned int range;
+	int bit_count;
+} BoolReader;
+
+static int bool_next_byte(BoolReader *br) {
+	return br->data < br->end ? *br->data++ : 0;
+}
+
+static int read_bool(BoolReader *br, int prob) {
+	unsigned int split = 1 + (((br->range - 1) * prob) >> 8);
+	unsigned int big_split = split << 8;
+	int bit;
+	if (br->value >= big_split) {
+		bit = 1;
+		br->range -= split;
+		br->value -= big_split;
+	} else {
+		bit = 0;
+		br->range = split;
+	}
+	while (br->range < 128) {
+		br->value <<= 1;
+		br->range <<= 1;
+		if (++br->bit_count == 8) {
+			br->bit_count = 0;
+			br->value |= bool_next_byte(br);
+		}
+	}
+	return bit;
+}
+
+static int read_literal(BoolReader *br, int n) {
+	int value = 0;
+	while (n-- > 0) {
+		value = (value << 1) | read_bool(br, 128);
+	}
+	return value;
+}
+
+// Reads a VP8 keyframe header as far as the token partition count.
+// Returns 0 for anything that isn't a keyframe.
+static int parse_keyframe_layout(const uint8_t *data, size_t len, KeyframeLayout *layout) {
+	if (len < 10 || (data[0] & 1)) {
+		return 0; // too short, or an inter frame
+	}
+	if (data[3] != 0x9d || data[4] != 0x01 || data[5] != 0x2a) {
+		return 0; // start code
+	}
+	size_t first_part_size = (data[0] | (data[1] << 8) | (data[2] << 16)) >> 5;
+	if (first_part_size > len - 10) {
+		return 0;
+	}
+	layout->width = (data[6] | (data[7] << 8)) & 0x3fff;
+	layout->height = (data[8] | (data[9] << 8)) & 0x3fff;
+	layout->tile_cols = 1;
+	layout->tile_rows = 1;
+
+	BoolReader br = { data + 10, data + 10 + first_part_size, 0, 255, 0 };
+	br.value = bool_next_byte(&br) << 8;
+	br.value |= bool_next_byte(&br);
+
+	read_literal(&br, 2); // color space, clamping type
+	if (read_literal(&br, 1)) { // segmentation
+		int update_map = read_literal(&br, 1);
+		if (read_literal(&br, 1)) { // update_data
+			read_literal(&br, 1); // abs_delta
+			for (int i = 0; i < 4; i++) {
+				if (read_literal(&br, 1)) {
+					read_literal(&br, 7 + 1); // quantizer
+				}
+			}
+			for (int i = 0; i < 4; i++) {
+				if (read_literal(&br, 1)) {
+					read_literal(&br, 6 + 1); // loop filter level
+				}
+			}
+		}
+		if (update_map) {
+			for (int i = 0; i < 3; i++) {
+				if (read_literal(&br, 1)) {
+					read_literal(&br, 8);
+				}
+			}
+		}
+	}
+	read_literal(&br, 1 + 6 + 3); // filter type, level, sharpness
+	if (read_literal(&br, 1) && read_literal(&br, 1)) {
+		for (int i = 0; i < 4 + 4; i++) {
+			if (read_literal(&br, 1)) {
+				read_literal(&br, 6 + 1);
+			}
+		}
+	}
+	layout->partitions = 1 << read_literal(&br, 2);
+	return 1;
+}
+
 #endif
 
+static void open_decoder(DecoderState *state, int mode, int threads) {
 	vpx_codec_dec_cfg_t cfg;
+	cfg.threads = threads;
+	cfg.w = 0;
+	cfg.h = 0;
+	vpx_codec_dec_init(&state->vpxContext, state->vpxDecoder, &cfg, 0);
+
+	// Only VP9 supports external frame buffers; VP8 falls back to
+	// copying each frame out before handing it to the main thread.
+	state->use_frame_pool = (vpx_codec_set_frame_buffer_functions(&state->vpxContext,
+		pool_get_frame_buffer, pool_release_frame_buffer, state) == VPX_CODEC_OK);
+
+#ifdef OGV_VP9
+	// Both only take effect before the first frame is decoded.
+	vpx_codec_control(&state->vpxContext, VP9D_SET_ROW_MT, mode == THREAD_MODE_ROW);
+	vpx_codec_control(&state->vpxContext, VP9D_SET_LOOP_FILTER_OPT, mode == THREAD_MODE_TILE);
+#endif
+
+	atomic_store(&state->thread_mode, mode);
+	atomic_store(&state->threads, threads);
+	atomic_store(&state->decode_time, 0.0);
+	state->decode_samples = 0;
+}
+
+static void record_decode_time(DecoderState *state, double ms) {
+	double avg = atomic_load_explicit(&state->decode_time, memory_order_relaxed);
+	if (state->decode_samples++ == 0) {
+		avg = ms;
+	} else {
+		avg += (ms - avg) / 8;
+	}
+	atomic_store_explicit(&state->decode_time, avg, memory_order_relaxed);
+}
+
+// Moves the thread budget towards what keeps decoding comfortably
+// inside the frame duration: double it when running close to the
+// deadline, give one back when there's plenty of slack.
+static void adapt_thread_target(OGVVideoDecoder *decoder) {
+	DecoderState *state = &decoder->state;
+	double frame_duration = atomic_load(&decoder->frame_duration_us) / 1000.0;
+	if (frame_duration <= 0 || state->decode_samples < 8) {
+		return;
+	}
+	double decode_time = atomic_load_explicit(&state->decode_time, memory_order_relaxed);
+	int threads = atomic_load_explicit(&state->threads, memory_order_relaxed);
+	if (decode_time > frame_duration * 0.75) {
+		int target = threads * 2;
+		state->thread_target = target < state->max_threads ? target : state->max_threads;
+	} else if (decode_time < frame_duration * 0.25 && threads > 1) {
+		state->thread_target = threads - 1;
+	}
+}
+
+// libvpx fixes its thread count and threading mode when the decoder is
+// set up, so they can only change by starting over; a keyframe is the
+// one point where that loses nothing. Picks the mode the new layout
+// can actually use, with as many threads as it and the budget allow.
+static void schedule_keyframe(OGVVideoDecoder *decoder, const KeyframeLayout *layout) {
+	DecoderState *state = &decoder->state;
+	atomic_store_explicit(&state->tile_cols, layout->tile_cols, memory_order_relaxed);
+	atomic_store_explicit(&state->tile_rows, layout->tile_rows, memory_order_relaxed);
+	atomic_store_explicit(&state->partitions, layout->partitions, memory_order_relaxed);
+	adapt_thread_target(decoder);
+
+	int mode, limit;
+#ifdef OGV_VP9
+	if (layout->tile_rows > 1) {
+		// libvpx only spreads tiles or rows over threads with a single
+		// tile row; otherwise it can still loop filter on a second one.
+		mode = THREAD_MODE_LOOP_FILTER;
+		limit = 2;
+	} else if (layout->tile_cols >= state->thread_target) {
+		mode = THREAD_MODE_TILE;
+		limit = layout->tile_cols;
+	} else {
+		// Rows run as a wavefront, so only about half can be in flight.
+		mode = THREAD_MODE_ROW;
+		limit = ((layout->height + 63) >> 6) / 2;
+	}
+#else
+	mode = THREAD_MODE_PARTITION;
+	limit = layout->partitions;
+	int mb_rows = (layout->height + 15) >> 4;
+	if (limit > mb_rows) {
+		limit = mb_rows;
+	}
+#endif
+
+	int threads = state->thread_target < limit ? state->thread_target : limit;
+	if (threads <= 1) {
+		mode = THREAD_MODE_SINGLE;
+		threads = 1;
+	}
+	if (mode != atomic_load_explicit(&state->thread_mode, memory_order_relaxed) ||
+	    threads != atomic_load_explicit(&state->threads, memory_order_relaxed)) {
+		vpx_codec_destroy(&state->vpxContext);
+		open_decoder(state, mode, threads);
+		atomic_fetch_add_explicit(&state->reconfigs, 1, memory_order_relaxed);
+	}
+}
+
+#endif
+
+static void do_init(OGVVideoDecoder *decoder) {
+	DecoderState *state = &decoder->state;
+
+#ifdef OGV_VP9
+	state->vpxDecoder = vpx_codec_vp9_dx();
+#else
+	state->vpxDecoder = vpx_codec_vp8_dx();
+#endif
+
 #ifdef __EMSCRIPTEN_PTHREADS__
 	const int max_cores = 8; // max threads for UHD tiled decoding
 	int cores = emscripten_num_logical_cores();
 	if (cores > max_cores) {
 		cores = max_cores;
 	}
-	cfg.threads = cores;
+	state->max_threads = cores;
+	state->thread_target = cores;
+
+	// Until the first keyframe says otherwise, thread the way libvpx
+	// does by default.
+	pthread_mutex_init(&state->pool_mutex, NULL);
+#ifdef OGV_VP9
+	open_decoder(state, cores > 1 ? THREAD_MODE_TILE : THREAD_MODE_SINGLE, cores);
 #else
-	cfg.threads = 0;
+	open_decoder(state, cores > 1 ? THREAD_MODE_PARTITION : THREAD_MODE_SINGLE, cores);
 #endif
+#else
+	vpx_codec_dec_cfg_t cfg;
+	cfg.threads = 0;
 	cfg.w = 0; // ???
 	cfg.h = 0;
-	vpx_codec_dec_init(&vpxContext, vpxDecoder, &cfg, 0);
+	vpx_codec_dec_init(&state->vpxContext, state->vpxDecoder, &cfg, 0);
+#endif
 }
 
-void do_destroy(void)
+static void do_destroy(OGVVideoDecoder *decoder)
 {
-	// should tear instance down, but meh
+	DecoderState *state = &decoder->state;
+	vpx_codec_destroy(&state->vpxContext);
+#ifdef __EMSCRIPTEN_PTHREADS__
+	pool_destroy(state);
+#endif
+}
+
+void ogv_video_decoder_stats(OGVVideoDecoder *decoder) {
+	ogvjs_callback_stat(decoder, "poolHits", atomic_load(&decoder->state.pool_hits));
+	ogvjs_callback_stat(decoder, "poolMisses", atomic_load(&decoder->state.pool_misses));
+	ogvjs_callback_stat(decoder, "frameSteals", decoder->frames.steals);
+	ogvjs_callback_stat(decoder, "frameDrops", decoder->frames.drops);
+#ifdef __EMSCRIPTEN_PTHREADS__
+	DecoderState *state = &decoder->state;
+	ogvjs_callback_stat(decoder, "threadMode", atomic_load(&state->thread_mode));
+	ogvjs_callback_stat(decoder, "threads", atomic_load(&state->threads));
+	ogvjs_callback_stat(decoder, "threadReconfigs", atomic_load(&state->reconfigs));
+#ifdef OGV_VP9
+	ogvjs_callback_stat(decoder, "tileCols", atomic_load(&state->tile_cols));
+	ogvjs_callback_stat(decoder, "tileRows", atomic_load(&state->tile_rows));
+#else
+	ogvjs_callback_stat(decoder, "tokenPartitions", atomic_load(&state->partitions));
+#endif
+	ogvjs_callback_stat(decoder, "decodeTime", atomic_load(&state->decode_time));
+#endif
+	thread_stats(decoder);
 }
 
 static void copy_plane(vpx_image_t *dest, vpx_image_t *src, int plane, int width, int height) {
@@ -86,47 +644,84 @@ static vpx_image_t* copy_image(vpx_image_t *src) {
 	return dest;
 }
 
-static void process_frame_decode(const char *data, size_t data_len) {
+static void process_frame_decode(OGVVideoDecoder *decoder, const char *data, size_t data_len) {
+	DecoderState *state = &decoder->state;
 	if (!data) {
 		// NULL data signals syncing the decoder state
-		call_main_return(NULL, 1);
+		call_main_return(decoder, NULL, 1);
 		return;
 	}
 
-	int ret = vpx_codec_decode(&vpxContext, (const uint8_t *)data, data_len, NULL, 1);
+#ifdef __EMSCRIPTEN_PTHREADS__
+	KeyframeLayout layout;
+	if (parse_keyframe_layout((const uint8_t *)data, data_len, &layout)) {
+		schedule_keyframe(decoder, &layout);
+	}
+	double decode_start = emscripten_get_now();
+#endif
+
+	int ret = vpx_codec_decode(&state->vpxContext, (const uint8_t *)data, data_len, NULL, 1);
 	if (ret != VPX_CODEC_OK) {
-		call_main_return(NULL, 0);
+		call_main_return(decoder, NULL, 0);
 		return;
 	}
-	ret = vpx_codec_decode(&vpxContext, NULL, 0, NULL, 1);
+	ret = vpx_codec_decode(&state->vpxContext, NULL, 0, NULL, 1);
 	if (ret != VPX_CODEC_OK) {
-		call_main_return(NULL, 0);
+		call_main_return(decoder, NULL, 0);
 		return;
 	}
+#ifdef __EMSCRIPTEN_PTHREADS__
+	record_decode_time(state, emscripten_get_now() - decode_start);
+#endif
 
 	vpx_codec_iter_t iter = NULL;
 	vpx_image_t *image = NULL;
 	int foundImage = 0;
-	while ((image = vpx_codec_get_frame(&vpxContext, &iter))) {
+	while ((image = vpx_codec_get_frame(&state->vpxContext, &iter))) {
 		// send back to the main thread for extraction.
 		foundImage = 1;
 #ifdef __EMSCRIPTEN_PTHREADS__
-		// Copy off main thread and send asynchronously...
-		// This allows decoding to continue without waiting
-		// for the main thread.
-		call_main_return(copy_image(image), 0);
+		// Send asynchronously, holding a reference on the frame buffer
+		// (or else a copy, for VP8). This allows decoding to continue
+		// without waiting for the main thread.
+		if (state->use_frame_pool) {
+			// A NULL reference goes back as a failed completion.
+			call_main_return(decoder, pool_ref_image(state, image), 0);
+		} else {
+			call_main_return(decoder, copy_image(image), 0);
+		}
 #else
-		call_main_return(image, 1);
+		call_main_return(decoder, image, 1);
 #endif
 	}
 	if (!foundImage) {
-		call_main_return(NULL, 0);
+		call_main_return(decoder, NULL, 0);
 		return;
 	}
 }
 
-static int process_frame_return(void *user_data) {
+static void release_frame(DecoderState *state, void *user_data) {
+#ifdef __EMSCRIPTEN_PTHREADS__
+	if (state->use_frame_pool) {
+		// Let the frame buffer go back to the pool.
+		pool_unref_image(state, (FrameRef *)user_data);
+	} else {
+		// We were given a copy, so free it.
+		vpx_img_free((vpx_image_t *)user_data);
+	}
+#else
+	// Image will be freed implicitly by next decode call.
+#endif
+}
+
+static int process_frame_return(OGVVideoDecoder *decoder, void *user_data) {
+	DecoderState *state = &decoder->state;
 	vpx_image_t *image = (vpx_image_t*)user_data;
+#ifdef __EMSCRIPTEN_PTHREADS__
+	if (image && state->use_frame_pool) {
+		image = &((FrameRef *)user_data)->image;
+	}
+#endif
 	if (image) {
 		// image->h is inexplicably large for small sizes.
 		// don't both copying the extra, but make sure it's chroma-safe.
@@ -154,22 +749,19 @@ static int process_frame_return(void *user_data) {
 				break;
 			default:
 				//printf("Skipping frame with unknown picture type %d\n", (int)image->fmt);
+				release_frame(state, user_data);
 				return 0;
 		}
-		ogvjs_callback_frame(image->planes[0], image->stride[0],
-							 image->planes[1], image->stride[1],
-							 image->planes[2], image->stride[2],
-							 image->w, height,
-							 chromaWidth, chromaHeight,
-							 image->d_w, image->d_h, // crop size
-							 0, 0, // crop pos
-							 image->r_w, image->r_h); // render size
-#ifdef __EMSCRIPTEN_PTHREADS__
-		// We were given a copy, so free it.
-		vpx_img_free(image);
-#else
-		// Image will be freed implicitly by next decode call.
-#endif
+		frame_ring_output(decoder, &decoder->frames,
+		                  image->planes[0], image->stride[0],
+		                  image->planes[1], image->stride[1],
+		                  image->planes[2], image->stride[2],
+		                  image->w, height,
+		                  chromaWidth, chromaHeight,
+		                  image->d_w, image->d_h, // crop size
+		                  0, 0, // crop pos
+		                  image->r_w, image->r_h); // render size
+		release_frame(state, user_data);
 		return 1;
 	} else {
 		return 0;
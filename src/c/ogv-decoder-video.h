@@ -1,18 +1,56 @@
+// Opaque per-stream decoder state, from ogv_video_decoder_create().
+// Every callback gets back the handle it was raised for.
+typedef struct OGVVideoDecoder OGVVideoDecoder;
+
 // Callbacks
-extern void ogvjs_callback_init_video(int frameWidth, int frameHeight,
+extern void ogvjs_callback_init_video(OGVVideoDecoder *decoder,
+                                      int frameWidth, int frameHeight,
                                       int chromaWidth, int chromaHeight,
                                       double fps,
                                       int picWidth, int picHeight,
                                       int picX, int picY,
                                       int displayWidth, int displayHeight);
 
-extern void ogvjs_callback_frame(unsigned char *bufferY, int strideY,
-                                 unsigned char *bufferCb, int strideCb,
-                                 unsigned char *bufferCr, int strideCr,
+// Frame planes are already cropped to the visible area and tightly
+// packed, in a frame ring slot that JS hands back, along with the
+// serial, with ogv_video_decoder_release_frame() once it's done.
+extern void ogvjs_callback_frame(OGVVideoDecoder *decoder, int slot, unsigned int serial,
+                                 unsigned char *bufferY,
+                                 unsigned char *bufferCb,
+                                 unsigned char *bufferCr,
                                  int width, int height,
                                  int chromaWidth, int chromaHeight,
-                                 int picWidth, int picHeight,
-                                 int picX, int picY,
                                  int displayWidth, int displayHeight);
 
-extern void ogvjs_callback_async_complete(int ret, double cpuTime);
+// In RGBA output mode, the frame instead arrives as width x height
+// RGBA pixels, converted from a picWidth x picHeight crop.
+extern void ogvjs_callback_frame_rgba(OGVVideoDecoder *decoder, int slot, unsigned int serial,
+                                      unsigned char *bufferRGBA,
+                                      int width, int height,
+                                      int picWidth, int picHeight,
+                                      int displayWidth, int displayHeight);
+
+extern void ogvjs_callback_async_complete(OGVVideoDecoder *decoder, int ret, double cpuTime);
+
+// Decoder-specific counters, reported from ogv_video_decoder_stats().
+// Name must be a static ASCII string.
+extern void ogvjs_callback_stat(OGVVideoDecoder *decoder, const char *name, double value);
+
+extern void ogv_video_decoder_stats(OGVVideoDecoder *decoder);
+
+extern void ogv_video_decoder_release_frame(OGVVideoDecoder *decoder, int slot, unsigned int serial);
+
+// Heap space for the demuxer to write packets into, owned by the decoder
+// and freed with it once the decode thread is done. Returns NULL if it
+// can't be allocated.
+extern void *ogv_video_decoder_alloc_packet_arena(OGVVideoDecoder *decoder, size_t size);
+
+// Expected time between frames, in milliseconds, as a decoding deadline
+// for decoders that adapt their threading to the load.
+extern void ogv_video_decoder_set_frame_duration(OGVVideoDecoder *decoder, double ms);
+
+// Switch frame output to RGBA, scaled to width x height (0 for the
+// cropped frame size), with matrix 0 for BT.601 or 1 for BT.709.
+extern void ogv_video_decoder_set_rgba_output(OGVVideoDecoder *decoder, int enabled,
+                                              int width, int height,
+                                              int matrix, int fullRange);
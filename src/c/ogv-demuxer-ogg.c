@@ -12,92 +12,116 @@
 
 #include "ogv-demuxer.h"
 #include "ogv-buffer-queue.h"
-
-// Input buffer queue
-static BufferQueue *bufferQueue;
-
-/* Ogg and codec state for demux/decode */
-OGGZ *oggz;
-
-int hasVideo = 0;
-long videoStream;
-OggzStreamContent videoCodec;
-int videoHeadersComplete;
-char *videoCodecName = NULL;
-
-int hasAudio = 0;
-long audioStream;
-OggzStreamContent audioCodec;
-int audioHeadersComplete;
-char *audioCodecName = NULL;
-
-int hasSkeleton = 0;
-long skeletonStream;
-OggSkeleton *skeleton;
-int skeletonHeadersComplete;
+#include "ogv-seek-index.h"
 
 enum AppState {
 	STATE_BEGIN,
 	STATE_SKELETON,
 	STATE_DECODING
-} appState;
-
-static int processSkeleton(oggz_packet *packet, long serialno);
-static int processDecoding(oggz_packet *packet, long serialno);
-
-static int processBegin(oggz_packet *packet, long serialno)
+};
+
+enum ResyncState {
+	RESYNC_NONE,
+	RESYNC_KEYFRAME,
+	RESYNC_AUDIO
+};
+
+struct OGVDemuxer {
+	// Input buffer queue
+	BufferQueue *bufferQueue;
+
+	/* Ogg and codec state for demux/decode */
+	OGGZ *oggz;
+
+	int hasVideo;
+	long videoStream;
+	OggzStreamContent videoCodec;
+	int videoHeadersComplete;
+	char *videoCodecName;
+
+	int hasAudio;
+	long audioStream;
+	OggzStreamContent audioCodec;
+	int audioHeadersComplete;
+	char *audioCodecName;
+
+	int hasSkeleton;
+	long skeletonStream;
+	OggSkeleton *skeleton;
+	int skeletonHeadersComplete;
+
+	enum AppState appState;
+
+	// Seek index built up from the pages we've demuxed, for files without
+	// a Skeleton track.
+	SeekIndex keyframeIndex;
+	SeekIndex audioPageIndex;
+	ogg_int64_t lastAudioPageOffset;
+
+	// Joining a live stream partway, after a cached init segment: libogg
+	// skips to the next page by itself, and from there we drop video up
+	// to the first keyframe and audio from before it.
+	ogg_int64_t resyncOffset;
+	enum ResyncState resyncState;
+	float resyncTimestamp;
+};
+
+static int processSkeleton(OGVDemuxer *demuxer, oggz_packet *packet, long serialno);
+static int processDecoding(OGVDemuxer *demuxer, oggz_packet *packet, long serialno);
+
+static int processBegin(OGVDemuxer *demuxer, oggz_packet *packet, long serialno)
 {
 	int bos = (packet->op.b_o_s != 0);
-    //int bos = oggz_get_bos(oggz, serialno);
+    //int bos = oggz_get_bos(demuxer->oggz, serialno);
     //int bos = (packet->op.packetno == 0);
     if (!bos) {
         // Not a bitstream start -- move on to header decoding...
-		if (hasSkeleton) {
-	        appState = STATE_SKELETON;
-	        return processSkeleton(packet, serialno);
+		if (demuxer->hasSkeleton) {
+	        demuxer->appState = STATE_SKELETON;
+	        return processSkeleton(demuxer, packet, serialno);
 	    } else {
-			appState = STATE_DECODING;
-			ogvjs_callback_loaded_metadata(videoCodecName, audioCodecName);
-	        return processDecoding(packet, serialno);
+			demuxer->appState = STATE_DECODING;
+			ogvjs_callback_loaded_metadata(demuxer, demuxer->videoCodecName, demuxer->audioCodecName);
+	        return processDecoding(demuxer, packet, serialno);
 		}
     }
 
-    OggzStreamContent content = oggz_stream_get_content(oggz, serialno);
+    OggzStreamContent content = oggz_stream_get_content(demuxer->oggz, serialno);
 
-    if (!hasVideo && content == OGGZ_CONTENT_THEORA) {
-        hasVideo = 1;
-        videoCodec = content;
-        videoCodecName = "theora";
-        videoStream = serialno;
-        ogvjs_callback_video_packet((const char *)packet->op.packet, packet->op.bytes, -1, -1, 0);
+    if (!demuxer->hasVideo && content == OGGZ_CONTENT_THEORA) {
+        demuxer->hasVideo = 1;
+        demuxer->videoCodec = content;
+        demuxer->videoCodecName = "theora";
+        demuxer->videoStream = serialno;
+        ogvjs_callback_video_packet(demuxer, (const char *)packet->op.packet, packet->op.bytes, -1, -1, 0);
         return OGGZ_CONTINUE;
     }
 
-    if (!hasAudio && content == OGGZ_CONTENT_VORBIS) {
-        hasAudio = 1;
-        audioCodec = content;
-        audioCodecName = "vorbis";
-        audioStream = serialno;
-        ogvjs_callback_audio_packet((const char *)packet->op.packet, packet->op.bytes, -1, 0.0);
+    if (!demuxer->hasAudio && content == OGGZ_CONTENT_VORBIS) {
+        demuxer->hasAudio = 1;
+        demuxer->audioCodec = content;
+        demuxer->audioCodecName = "vorbis";
+        demuxer->audioStream = serialno;
+        ogvjs_callback_audio_packet(demuxer, (const char *)packet->op.packet, packet->op.bytes, -1, 0.0);
         return OGGZ_CONTINUE;
     }
 
-    if (!hasAudio && content == OGGZ_CONTENT_OPUS) {
-        hasAudio = 1;
-        audioCodec = content;
-        audioCodecName = "opus";
-        audioStream = serialno;
-        ogvjs_callback_audio_packet((const char *)packet->op.packet, packet->op.bytes, -1, 0.0);
+    if (!demuxer->hasAudio && content == OGGZ_CONTENT_OPUS) {
+        demuxer->hasAudio = 1;
+        demuxer->audioCodec = content;
+        demuxer->audioCodecName = "opus";
+        demuxer->audioStream = serialno;
+        ogvjs_callback_audio_packet(demuxer, (const char *)packet->op.packet, packet->op.bytes, -1, 0.0);
         return OGGZ_CONTINUE;
     }
 
-    if (!hasSkeleton && content == OGGZ_CONTENT_SKELETON) {
-        hasSkeleton = 1;
-        skeletonStream = serialno;
+    if (!demuxer->hasSkeleton && content == OGGZ_CONTENT_SKELETON) {
+        demuxer->hasSkeleton = 1;
+        demuxer->skeletonStream = serialno;
 
-        int ret = oggskel_decode_header(skeleton, &packet->op);
+        int ret = oggskel_decode_header(demuxer->skeleton, &packet->op);
         if (ret == 0) {
-            skeletonHeadersComplete = 1;
+            demuxer->skeletonHeadersComplete = 1;
         } else if (ret > 0) {
             // Just keep going
         } else {
@@ -108,71 +132,148 @@ static int processBegin(oggz_packet *packet, long serialno)
     return OGGZ_CONTINUE;
 }
 
-static int packet_is_keyframe_theora(oggz_packet *packet)
+static int packet_is_keyframe_theora(OGVDemuxer *demuxer, oggz_packet *packet)
 {
-	ogg_int64_t granulepos = oggz_tell_granulepos(oggz);
-	int granuleshift = oggz_get_granuleshift(oggz, videoStream);
+	ogg_int64_t granulepos = oggz_tell_granulepos(demuxer->oggz);
+	int granuleshift = oggz_get_granuleshift(demuxer->oggz, demuxer->videoStream);
 
 	ogg_int64_t key_frameno = (granulepos >> granuleshift);
 	return (granulepos == (key_frameno << granuleshift));
 }
 
-static float calc_keyframe_timestamp(oggz_packet *packet, long serialno)
+static float calc_keyframe_timestamp(OGVDemuxer *demuxer, oggz_packet *packet, long serialno)
 {
-	ogg_int64_t granulepos = oggz_tell_granulepos(oggz);
+	ogg_int64_t granulepos = oggz_tell_granulepos(demuxer->oggz);
 
-	int granuleshift = oggz_get_granuleshift(oggz, serialno);
+	int granuleshift = oggz_get_granuleshift(demuxer->oggz, serialno);
 
 	ogg_int64_t granulerate_n = 0;
 	ogg_int64_t granulerate_d = 0;
-	oggz_get_granulerate(oggz, serialno, &granulerate_n, &granulerate_d);
+	oggz_get_granulerate(demuxer->oggz, serialno, &granulerate_n, &granulerate_d);
 
 	return (float)(granulepos >> granuleshift) * (float)granulerate_d / (float)granulerate_n;
 }
 
-static int processSkeleton(oggz_packet *packet, long serialno)
+static int packet_is_header(OggzStreamContent content, oggz_packet *packet)
+{
+	const unsigned char *data = packet->op.packet;
+	long bytes = packet->op.bytes;
+	switch (content) {
+		case OGGZ_CONTENT_THEORA:
+			return bytes > 0 && (data[0] & 0x80);
+		case OGGZ_CONTENT_VORBIS:
+			return bytes > 0 && (data[0] & 1);
+		case OGGZ_CONTENT_OPUS:
+			return bytes >= 8 && memcmp(data, "Opus", 4) == 0;
+		default:
+			return 0;
+	}
+}
+
+static void indexPacket(OGVDemuxer *demuxer, oggz_packet *packet, long serialno)
+{
+	ogg_int64_t granulepos = oggz_tell_granulepos(demuxer->oggz);
+	if (granulepos < 0) {
+		return;
+	}
+	if (demuxer->hasVideo && serialno == demuxer->videoStream) {
+		if (packet->op.bytes > 0 && !packet_is_header(demuxer->videoCodec, packet) && packet_is_keyframe_theora(demuxer, packet)) {
+			seek_index_add(&demuxer->keyframeIndex, granulepos, oggz_tell_units(demuxer->oggz), packet->pos.begin_page_offset);
+		}
+	} else if (demuxer->hasAudio && serialno == demuxer->audioStream) {
+		ogg_int64_t offset = packet->pos.begin_page_offset;
+		if (offset != demuxer->lastAudioPageOffset && !packet_is_header(demuxer->audioCodec, packet)) {
+			demuxer->lastAudioPageOffset = offset;
+			seek_index_add(&demuxer->audioPageIndex, granulepos, oggz_tell_units(demuxer->oggz), offset);
+		}
+	}
+}
+
+static int processSkeleton(OGVDemuxer *demuxer, oggz_packet *packet, long serialno)
 {
-	float timestamp = oggz_tell_units(oggz) / 1000.0;
-	float keyframeTimestamp = calc_keyframe_timestamp(packet, serialno);
+	float timestamp = oggz_tell_units(demuxer->oggz) / 1000.0;
+	float keyframeTimestamp = calc_keyframe_timestamp(demuxer, packet, serialno);
+
+	indexPacket(demuxer, packet, serialno);
 
-    if (hasSkeleton && skeletonStream == serialno) {
-        int ret = oggskel_decode_header(skeleton, &packet->op);
+    if (demuxer->hasSkeleton && demuxer->skeletonStream == serialno) {
+        int ret = oggskel_decode_header(demuxer->skeleton, &packet->op);
         if (ret < 0) {
             //printf("Error processing skeleton packet: %d\n", ret);
             return OGGZ_STOP_ERR;
         }
         if (packet->op.e_o_s) {
-            skeletonHeadersComplete = 1;
-			appState = STATE_DECODING;
-			ogvjs_callback_loaded_metadata(videoCodecName, audioCodecName);
+            demuxer->skeletonHeadersComplete = 1;
+			demuxer->appState = STATE_DECODING;
+			ogvjs_callback_loaded_metadata(demuxer, demuxer->videoCodecName, demuxer->audioCodecName);
         }
     }
 
-    if (hasVideo && serialno == videoStream) {
-    	ogvjs_callback_video_packet((const char *)packet->op.packet, packet->op.bytes, timestamp, keyframeTimestamp, packet_is_keyframe_theora(packet));
+    if (demuxer->hasVideo && serialno == demuxer->videoStream) {
+    	ogvjs_callback_video_packet(demuxer, (const char *)packet->op.packet, packet->op.bytes, timestamp, keyframeTimestamp, packet_is_keyframe_theora(demuxer, packet));
     }
 
-    if (hasAudio && serialno == audioStream) {
-    	ogvjs_callback_audio_packet((const char *)packet->op.packet, packet->op.bytes, timestamp, 0.0);
+    if (demuxer->hasAudio && serialno == demuxer->audioStream) {
+    	ogvjs_callback_audio_packet(demuxer, (const char *)packet->op.packet, packet->op.bytes, timestamp, 0.0);
     }
 
 	return OGGZ_CONTINUE;
 }
 
-static int processDecoding(oggz_packet *packet, long serialno) {
-	float timestamp = oggz_tell_units(oggz) / 1000.0;
-	float keyframeTimestamp = calc_keyframe_timestamp(packet, serialno);
+/**
+ * After a mid-stream join, hold back packets until video can start at
+ * a keyframe, and audio along with it.
+ * @returns 1 if the packet should be dropped
+ */
+static int resyncDrop(OGVDemuxer *demuxer, oggz_packet *packet, long serialno, float timestamp)
+{
+	if (demuxer->resyncState == RESYNC_NONE || packet->pos.begin_page_offset < demuxer->resyncOffset) {
+		return 0;
+	}
+	if (!demuxer->hasVideo) {
+		demuxer->resyncState = RESYNC_NONE;
+		return 0;
+	}
+	if (demuxer->resyncState == RESYNC_KEYFRAME) {
+		// Granulepos may not be known yet after the gap, so check the
+		// Theora frame type bit; we also need a timestamp to start from.
+		if (serialno == demuxer->videoStream && timestamp >= 0 &&
+			packet->op.bytes > 0 && !(packet->op.packet[0] & 0xc0)) {
+			demuxer->resyncState = RESYNC_AUDIO;
+			demuxer->resyncTimestamp = timestamp;
+			return 0;
+		}
+		return 1;
+	}
+	if (demuxer->hasAudio && serialno == demuxer->audioStream) {
+		if (timestamp < demuxer->resyncTimestamp) {
+			return 1;
+		}
+		demuxer->resyncState = RESYNC_NONE;
+	}
+	return 0;
+}
+
+static int processDecoding(OGVDemuxer *demuxer, oggz_packet *packet, long serialno) {
+	float timestamp = oggz_tell_units(demuxer->oggz) / 1000.0;
+	float keyframeTimestamp = calc_keyframe_timestamp(demuxer, packet, serialno);
+
+	indexPacket(demuxer, packet, serialno);
+
+	if (resyncDrop(demuxer, packet, serialno, timestamp)) {
+		return OGGZ_CONTINUE;
+	}
 
-    if (hasVideo && serialno == videoStream) {
+    if (demuxer->hasVideo && serialno == demuxer->videoStream) {
 			if (packet->op.bytes > 0) {
 				// Skip 0-byte Theora packets, they're dupe frames.
-				ogvjs_callback_video_packet((const char *)packet->op.packet, packet->op.bytes, timestamp, keyframeTimestamp, packet_is_keyframe_theora(packet));
+				ogvjs_callback_video_packet(demuxer, (const char *)packet->op.packet, packet->op.bytes, timestamp, keyframeTimestamp, packet_is_keyframe_theora(demuxer, packet));
 				return OGGZ_STOP_OK;
 			}
     }
 
-    if (hasAudio && serialno == audioStream) {
-    	ogvjs_callback_audio_packet((const char *)packet->op.packet, packet->op.bytes, timestamp, 0.0);
+    if (demuxer->hasAudio && serialno == demuxer->audioStream) {
+    	ogvjs_callback_audio_packet(demuxer, (const char *)packet->op.packet, packet->op.bytes, timestamp, 0.0);
 		return OGGZ_STOP_OK;
     }
 
@@ -181,13 +282,14 @@ static int processDecoding(oggz_packet *packet, long serialno) {
 
 static int readPacketCallback(OGGZ *oggz, oggz_packet *packet, long serialno, void *user_data)
 {
-    switch (appState) {
+	OGVDemuxer *demuxer = (OGVDemuxer *)user_data;
+    switch (demuxer->appState) {
         case STATE_BEGIN:
-            return processBegin(packet, serialno);
+            return processBegin(demuxer, packet, serialno);
         case STATE_SKELETON:
-            return processSkeleton(packet, serialno);
+            return processSkeleton(demuxer, packet, serialno);
         case STATE_DECODING:
-            return processDecoding(packet, serialno);
+            return processDecoding(demuxer, packet, serialno);
         default:
             //printf("Invalid state in Ogg readPacketCallback");
             return OGGZ_STOP_ERR;
@@ -241,32 +343,47 @@ static long tellCallback(void *user_handle)
 	return (long)bq_tell(bq);
 }
 
-void ogv_demuxer_init(void) {
-    appState = STATE_BEGIN;
-	bufferQueue = bq_init();
-	oggz = oggz_new(OGGZ_READ | OGGZ_AUTO);
-	oggz_set_read_callback(oggz, -1, readPacketCallback, NULL);
-	oggz_io_set_read(oggz, readCallback, bufferQueue);
-	oggz_io_set_seek(oggz, seekCallback, bufferQueue);
-	oggz_io_set_tell(oggz, tellCallback, bufferQueue);
-    skeleton = oggskel_new();
+OGVDemuxer *ogv_demuxer_create(void) {
+	OGVDemuxer *demuxer = calloc(1, sizeof(OGVDemuxer));
+    demuxer->appState = STATE_BEGIN;
+	demuxer->bufferQueue = bq_init();
+	demuxer->oggz = oggz_new(OGGZ_READ | OGGZ_AUTO);
+	oggz_set_read_callback(demuxer->oggz, -1, readPacketCallback, demuxer);
+	oggz_io_set_read(demuxer->oggz, readCallback, demuxer->bufferQueue);
+	oggz_io_set_seek(demuxer->oggz, seekCallback, demuxer->bufferQueue);
+	oggz_io_set_tell(demuxer->oggz, tellCallback, demuxer->bufferQueue);
+    demuxer->skeleton = oggskel_new();
+	seek_index_init(&demuxer->keyframeIndex);
+	seek_index_init(&demuxer->audioPageIndex);
+	demuxer->lastAudioPageOffset = -1;
+	return demuxer;
 }
 
-void ogv_demuxer_receive_input(char *buffer, int bufsize) {
-	bq_append(bufferQueue, buffer, bufsize);
+void ogv_demuxer_receive_input(OGVDemuxer *demuxer, char *buffer, int bufsize) {
+	bq_append(demuxer->bufferQueue, buffer, bufsize);
 }
 
-int ogv_demuxer_process(void) {
+/**
+ * Mark the end of a cached init segment: input from here on comes from
+ * partway through a live stream.
+ */
+void ogv_demuxer_resync(OGVDemuxer *demuxer)
+{
+	demuxer->resyncOffset = bq_end(demuxer->bufferQueue);
+	demuxer->resyncState = RESYNC_KEYFRAME;
+}
+
+int ogv_demuxer_process(OGVDemuxer *demuxer) {
 	do {
 		// read at most this many bytes in one go
 		// should be enough to resync ogg stream
-		int64_t headroom = bq_headroom(bufferQueue);
+		int64_t headroom = bq_headroom(demuxer->bufferQueue);
 		size_t bufsize = 65536;
 		if (headroom < bufsize) {
 			bufsize = headroom;
 		}
 
-		int ret = oggz_read(oggz, bufsize);
+		int ret = oggz_read(demuxer->oggz, bufsize);
 		//printf("demuxer returned %d on %d bytes\n", ret, bufsize);
 		if (ret == OGGZ_ERR_STOP_OK) {
 			// We got a packet!
@@ -287,20 +404,22 @@ int ogv_demuxer_process(void) {
 	return 0;
 }
 
-void ogv_demuxer_destroy(void) {
-	oggskel_destroy(skeleton);
-    oggz_close(oggz);
-	bq_free(bufferQueue);
-	bufferQueue = NULL;
+void ogv_demuxer_destroy(OGVDemuxer *demuxer) {
+	seek_index_free(&demuxer->keyframeIndex);
+	seek_index_free(&demuxer->audioPageIndex);
+	oggskel_destroy(demuxer->skeleton);
+    oggz_close(demuxer->oggz);
+	bq_free(demuxer->bufferQueue);
+	free(demuxer);
 }
 
 /**
  * @return segment length in bytes, or -1 if unknown
  */
-long ogv_demuxer_media_length(void) {
+long ogv_demuxer_media_length(OGVDemuxer *demuxer) {
     ogg_int64_t segment_len = -1;
-    if (skeletonHeadersComplete) {
-        oggskel_get_segment_len(skeleton, &segment_len);
+    if (demuxer->skeletonHeadersComplete) {
+        oggskel_get_segment_len(demuxer->skeleton, &segment_len);
     }
     return (long)segment_len;
 }
@@ -308,19 +427,19 @@ long ogv_demuxer_media_length(void) {
 /**
  * @return segment duration in seconds, or -1 if unknown
  */
-float ogv_demuxer_media_duration(void) {
-    if (skeletonHeadersComplete) {
+float ogv_demuxer_media_duration(OGVDemuxer *demuxer) {
+    if (demuxer->skeletonHeadersComplete) {
         ogg_uint16_t ver_maj = -1, ver_min = -1;
-        oggskel_get_ver_maj(skeleton, &ver_maj);
-        oggskel_get_ver_min(skeleton, &ver_min);
+        oggskel_get_ver_maj(demuxer->skeleton, &ver_maj);
+        oggskel_get_ver_min(demuxer->skeleton, &ver_min);
     
         ogg_int32_t serial_nos[2];
         size_t nstreams = 0;
-        if (videoStream) {
-            serial_nos[nstreams++] = videoStream;
+        if (demuxer->videoStream) {
+            serial_nos[nstreams++] = demuxer->videoStream;
         }
-        if (audioStream) {
-            serial_nos[nstreams++] = audioStream;
+        if (demuxer->audioStream) {
+            serial_nos[nstreams++] = demuxer->audioStream;
         }
         
         double firstSample = -1,
@@ -331,10 +450,10 @@ float ogv_demuxer_media_duration(void) {
                         last_sample_num = -1,
                         last_sample_denum = -1;
 
-            oggskel_get_first_sample_num(skeleton, serial_nos[i], &first_sample_num);
-            oggskel_get_first_sample_denum(skeleton, serial_nos[i], &first_sample_denum);
-            oggskel_get_last_sample_num(skeleton, serial_nos[i], &last_sample_num);
-            oggskel_get_last_sample_denum(skeleton, serial_nos[i], &last_sample_denum);
+            oggskel_get_first_sample_num(demuxer->skeleton, serial_nos[i], &first_sample_num);
+            oggskel_get_first_sample_denum(demuxer->skeleton, serial_nos[i], &first_sample_denum);
+            oggskel_get_last_sample_num(demuxer->skeleton, serial_nos[i], &last_sample_num);
+            oggskel_get_last_sample_denum(demuxer->skeleton, serial_nos[i], &last_sample_denum);
             
             double firstStreamSample = (double)first_sample_num / (double)first_sample_denum;
             if (firstSample == -1 || firstStreamSample < firstSample) {
@@ -352,42 +471,76 @@ float ogv_demuxer_media_duration(void) {
     return -1;
 }
 
-int ogv_demuxer_seekable(void)
+int ogv_demuxer_seekable(OGVDemuxer *demuxer)
 {
 	// even if we don't have the skeleton tracks, we allow bisection
 	return 1;
 }
 
-long ogv_demuxer_keypoint_offset(long time_ms)
+long ogv_demuxer_keypoint_offset(OGVDemuxer *demuxer, long time_ms)
 {
     ogg_int64_t offset = -1;
-    if (skeletonHeadersComplete) {
+    if (demuxer->skeletonHeadersComplete) {
         ogg_int32_t serial_nos[2];
         size_t nstreams = 0;
-        if (hasVideo) {
-            serial_nos[nstreams++] = videoStream;
-        } else if (hasAudio) {
-			serial_nos[nstreams++] = audioStream;
+        if (demuxer->hasVideo) {
+            serial_nos[nstreams++] = demuxer->videoStream;
+        } else if (demuxer->hasAudio) {
+			serial_nos[nstreams++] = demuxer->audioStream;
 		}
-        oggskel_get_keypoint_offset(skeleton, serial_nos, nstreams, time_ms, &offset);
-    }
+        oggskel_get_keypoint_offset(demuxer->skeleton, serial_nos, nstreams, time_ms, &offset);
+    } else if (demuxer->hasVideo) {
+		offset = seek_index_lookup(&demuxer->keyframeIndex, time_ms);
+	} else if (demuxer->hasAudio) {
+		offset = seek_index_lookup(&demuxer->audioPageIndex, time_ms);
+	}
     return (long)offset;
 }
 
-int ogv_demuxer_seek_to_keypoint(long time_ms)
+int ogv_demuxer_seek_to_keypoint(OGVDemuxer *demuxer, long time_ms)
 {
 	return 0;
 }
 
-void ogv_demuxer_flush(void)
+void ogv_demuxer_flush(OGVDemuxer *demuxer)
 {
-	oggz_purge(oggz);
+	oggz_purge(demuxer->oggz);
 
 	// Need to "seek" to clear out stored units
-	int ret = oggz_seek(oggz, 0, SEEK_CUR);
+	int ret = oggz_seek(demuxer->oggz, 0, SEEK_CUR);
 	if (ret < 0) {
 		//printf("Failed to 'seek' oggz %d\n", ret);
 	}
 
-	bq_flush(bufferQueue);
+	bq_flush(demuxer->bufferQueue);
+
+	seek_index_break(&demuxer->keyframeIndex);
+	seek_index_break(&demuxer->audioPageIndex);
+	demuxer->lastAudioPageOffset = -1;
+}
+
+size_t ogv_demuxer_index_size(OGVDemuxer *demuxer)
+{
+	SeekIndex *indexes[2] = { &demuxer->keyframeIndex, &demuxer->audioPageIndex };
+	return seek_index_export_size(indexes, 2);
+}
+
+/**
+ * Write the seek index into the given buffer, which must have room
+ * for ogv_demuxer_index_size() bytes.
+ */
+void ogv_demuxer_index_export(OGVDemuxer *demuxer, char *buffer)
+{
+	SeekIndex *indexes[2] = { &demuxer->keyframeIndex, &demuxer->audioPageIndex };
+	seek_index_export(indexes, 2, buffer);
+}
+
+/**
+ * Merge a previously exported seek index into ours.
+ * @return 1 on success, 0 if the data isn't a valid index
+ */
+int ogv_demuxer_index_import(OGVDemuxer *demuxer, const char *buffer, size_t len)
+{
+	SeekIndex *indexes[2] = { &demuxer->keyframeIndex, &demuxer->audioPageIndex };
+	return seek_index_import(indexes, 2, buffer, len);
 }
@@ -12,35 +12,118 @@
 
 #include "ogv-demuxer.h"
 #include "ogv-buffer-queue.h"
+#include "ogv-seek-index.h"
 
-static nestegg        *demuxContext;
-static BufferQueue    *bufferQueue;
+enum AppState {
+    STATE_BEGIN,
+    STATE_DECODING,
+    STATE_SEEKING,
+    STATE_BISECTING
+};
 
-static bool            hasVideo = false;
-static unsigned int    videoTrack = 0;
-static int             videoCodec = -1;
-static char           *videoCodecName = NULL;
+enum ScanState {
+    SCAN_HEADER,
+    SCAN_PAYLOAD,
+    SCAN_FAILED
+};
 
-static bool            hasAudio = false;
-static unsigned int    audioTrack = 0;
-static int             audioCodec = -1;
-static char           *audioCodecName = NULL;
+enum ResyncState {
+    RESYNC_NONE,
+    RESYNC_KEYFRAME,
+    RESYNC_AUDIO
+};
 
-static int64_t         seekTime;
-static unsigned int    seekTrack;
-static int64_t         startPosition;
+// Cluster id, size, Timecode id, size and value take at most this many bytes.
+#define CLUSTER_HEADER_MAX 32
 
-static double          lastKeyframeKimestamp = -1;
+// Element boundaries found ahead of nestegg as input arrives, so it's
+// only asked for a packet once a whole block is buffered rather than
+// parsing a partial one, failing and starting over when more comes.
+// Each byte is looked at once: headers are gathered across appends,
+// and payloads are just waited out.
+typedef struct {
+    enum ScanState  state;
+    // Stream offset of the next byte to look at.
+    int64_t         pos;
+    // Element id and data size being gathered.
+    unsigned char   header[12];
+    size_t          headerLen;
+    int64_t         id;
+    int64_t         payloadStart;
+    int64_t         payloadEnd;
+    // End of the last complete SimpleBlock or BlockGroup.
+    int64_t         blockEnd;
+    // Start of a cluster whose Timecode hasn't been seen yet, or -1.
+    int64_t         clusterOffset;
+} ElementScan;
 
-enum AppState {
-    STATE_BEGIN,
-    STATE_DECODING,
-    STATE_SEEKING
-} appState;
+struct OGVDemuxer {
+    nestegg        *demuxContext;
+    BufferQueue    *bufferQueue;
+
+    bool            hasVideo;
+    unsigned int    videoTrack;
+    int             videoCodec;
+    char           *videoCodecName;
+
+    bool            hasAudio;
+    unsigned int    audioTrack;
+    int             audioCodec;
+    char           *audioCodecName;
+
+    int64_t         seekTime;
+    unsigned int    seekTrack;
+    int64_t         startPosition;
+
+    double          lastKeyframeKimestamp;
+
+    // Cluster positions seen so far, for seeking in files without cues.
+    SeekIndex       clusterIndex;
+    uint64_t        timecodeScale;
+    int64_t         segmentEnd;
+
+    // Cluster to seek to when there are no cues, and the bounds of the
+    // bisection search that finds it when it's not indexed yet.
+    int64_t         seekOffset;
+    int64_t         bisectLow;
+    int64_t         bisectHigh;
+    int64_t         bisectPos;
 
-void ogv_demuxer_init(void) {
-    appState = STATE_BEGIN;
-    bufferQueue = bq_init();
+    ElementScan     scan;
+
+    // Joining a live stream partway, after a cached init segment: input
+    // is dropped up to the next cluster, then video up to the first
+    // keyframe and audio from before it.
+    bool            resyncScanning;
+    unsigned char   resyncTail[CLUSTER_HEADER_MAX - 1];
+    size_t          resyncTailLen;
+    enum ResyncState resyncState;
+    float           resyncTimestamp;
+
+    enum AppState   appState;
+};
+
+#define ID_EBML 0x1a45dfa3LL
+#define ID_SEGMENT 0x18538067LL
+#define ID_CLUSTER 0x1f43b675LL
+#define ID_TIMECODE 0xe7LL
+#define ID_BLOCK_GROUP 0xa0LL
+#define ID_SIMPLE_BLOCK 0xa3LL
+
+// Stop bisecting and demux linearly once the range is this small.
+#define BISECT_MIN_RANGE 131072
+
+OGVDemuxer *ogv_demuxer_create(void) {
+    OGVDemuxer *demuxer = calloc(1, sizeof(OGVDemuxer));
+    demuxer->appState = STATE_BEGIN;
+    demuxer->bufferQueue = bq_init();
+    demuxer->videoCodec = -1;
+    demuxer->audioCodec = -1;
+    demuxer->lastKeyframeKimestamp = -1;
+    seek_index_init(&demuxer->clusterIndex);
+    demuxer->timecodeScale = 1000000;
+    demuxer->segmentEnd = -1;
+    return demuxer;
 }
 
 static void logCallback(nestegg *context, unsigned int severity, char const * format, ...)
@@ -96,7 +179,24 @@ static int64_t tellCallback(void * userdata)
     return bq_tell((BufferQueue *)userdata);
 }
 
-static nestegg_io ioCallbacks = {
+// Lend packet data straight out of the input slabs. Packets are freed
+// before any more input is appended or trimmed, so it stays put.
+static int borrowCallback(void const ** buffer, size_t length, void * userdata)
+{
+    BufferQueue *queue = (BufferQueue *)userdata;
+    const char *data;
+    if (bq_peek(queue, length, &data)) {
+        // Straddles a slab boundary, or isn't all here yet.
+        return 0;
+    }
+    if (bq_seek(queue, bq_tell(queue) + length)) {
+        return -1;
+    }
+    *buffer = data;
+    return 1;
+}
+
+static const nestegg_io ioCallbacks = {
 	readCallback,
 	seekCallback,
 	tellCallback,
@@ -104,149 +204,455 @@ static nestegg_io ioCallbacks = {
 };
 
 /**
- * Safe read of EBML id or data size int64 from a data stream.
+ * Safe read of EBML id or data size int64 from a byte buffer.
  * @returns byte count of the ebml number on success, or 0 on failure
  */
-static int read_ebml_int64(BufferQueue *bufferQueue, int64_t *val, int keep_mask_bit)
+static int read_ebml_int64(const unsigned char *data, size_t len, int64_t *val, int keep_mask_bit)
 {
     // Count of initial 0 bits plus first 1 bit encode total number of bytes.
     // Rest of the bits are a big-endian number.
-    char first;
-    if (bq_read(bufferQueue, &first, 1)) {
+    if (len < 1) {
         //printf("out of bytes at start of field\n");
         return 0;
     }
+    unsigned char first = data[0];
     if (first == 0) {
         //printf("zero field\n");
         return 0;
     }
 
     int shift = 0;
-    while (((unsigned char)first & 0x80) == 0) {
+    while ((first & 0x80) == 0) {
         shift++;
-        first = (unsigned char)first << 1;
+        first = first << 1;
     }
     int byteCount = shift + 1;
+    if (len < byteCount) {
+        //printf("out of bytes in field\n");
+        return 0;
+    }
 
     if (!keep_mask_bit) {
         // id keeps the mask bit, data size strips it
         first = first & 0x7f;
     }
     // Save the top bits from that first byte.
-    *val = (unsigned char)first >> shift;
+    *val = first >> shift;
     for (int i = 1; i < byteCount; i++) {
-        char next;
-        if (bq_read(bufferQueue, &next, 1)) {
-            //printf("out of bytes in field\n");
-            return 0;
-        }
-        *val = *val << 8 | (unsigned char)next;
+        *val = *val << 8 | data[i];
     }
     //printf("byteCount %d; val %lld\n", byteCount, *val);
     return byteCount;
 }
 
-static int readyForNextPacket(void)
+/**
+ * Look at up to *len upcoming bytes without moving the read position,
+ * in place if possible or else copied into scratch.
+ * @returns pointer to the bytes, with *len reduced to what's available,
+ *          or NULL if there's nothing to read
+ */
+static const unsigned char *peekBytes(OGVDemuxer *demuxer, unsigned char *scratch, size_t *len)
+{
+    int64_t headroom = bq_headroom(demuxer->bufferQueue);
+    if (headroom < *len) {
+        *len = headroom;
+    }
+    const unsigned char *data;
+    if (bq_peek(demuxer->bufferQueue, *len, (const char **)&data)) {
+        // Straddles a slab boundary, or nothing to read.
+        int64_t pos = bq_tell(demuxer->bufferQueue);
+        if (*len == 0 || bq_read(demuxer->bufferQueue, (char *)scratch, *len)) {
+            return NULL;
+        }
+        bq_seek(demuxer->bufferQueue, pos);
+        data = scratch;
+    }
+    return data;
+}
+
+static int readyForNextPacket(OGVDemuxer *demuxer)
 {
-    int64_t pos = bq_tell(bufferQueue);
     int ok = 0;
-    
+
+    // An EBML id plus data size takes at most 16 bytes.
+    unsigned char scratch[16];
+    size_t len = sizeof(scratch);
+    const unsigned char *data = peekBytes(demuxer, scratch, &len);
+    if (!data) {
+        return 0;
+    }
+    int64_t headroom = bq_headroom(demuxer->bufferQueue);
+
     int64_t id, size;
     int idSize, sizeSize;
-    
-    idSize = read_ebml_int64(bufferQueue, &id, 1);
+
+    idSize = read_ebml_int64(data, len, &id, 1);
     if (idSize) {
         if (id != 0x1c53bb6bLL) {
             // Right now we only care about reading the cues.
             // If used elsewhere, unpack that. ;)
             ok = 1;
         }
-        sizeSize = read_ebml_int64(bufferQueue, &size, 0);
+        sizeSize = read_ebml_int64(data + idSize, len - idSize, &size, 0);
         if (sizeSize) {
-            //printf("packet is %llx, size is %lld, headroom %lld\n", id, size, bq_headroom(bufferQueue));
-            if (bq_headroom(bufferQueue) >= size) {
+            //printf("packet is %llx, size is %lld, headroom %lld\n", id, size, headroom);
+            if (headroom - idSize - sizeSize >= size) {
                 ok = 1;
             }
         }
     }
-    /*
-    if (!ok) {
-        printf("not ready for packet! %lld/%lld %d %d %llx %lld\n", bq_tell(bufferQueue), bq_headroom(bufferQueue), idSize, sizeSize, id, size);
-    } else {
-        printf("ready for packet! %lld/%lld %d %d %llx %lld\n", bq_tell(bufferQueue), bq_headroom(bufferQueue), idSize, sizeSize, id, size);
-    }
-    */
-    bq_seek(bufferQueue, pos);
     return ok;
 }
 
-static int processBegin(void) {
+/**
+ * Parse a Cluster's id and size, and the Timecode that must lead it.
+ * @returns 1 if the data starts with a cluster header, or 0
+ */
+static int read_cluster_header(const unsigned char *data, size_t len, uint64_t *timecode)
+{
+    int64_t id, size;
+    size_t pos = 0;
+    int n = read_ebml_int64(data, len, &id, 1);
+    if (!n || id != ID_CLUSTER) {
+        return 0;
+    }
+    pos += n;
+    n = read_ebml_int64(data + pos, len - pos, &size, 0);
+    if (!n) {
+        return 0;
+    }
+    pos += n;
+    n = read_ebml_int64(data + pos, len - pos, &id, 1);
+    if (!n || id != ID_TIMECODE) {
+        return 0;
+    }
+    pos += n;
+    n = read_ebml_int64(data + pos, len - pos, &size, 0);
+    if (!n || size < 1 || size > 8 || len - pos - n < size) {
+        return 0;
+    }
+    pos += n;
+    *timecode = 0;
+    for (int i = 0; i < size; i++) {
+        *timecode = *timecode << 8 | data[pos + i];
+    }
+    return 1;
+}
+
+static int64_t cluster_time_ms(OGVDemuxer *demuxer, uint64_t timecode)
+{
+    return (int64_t)(timecode * demuxer->timecodeScale / 1000000);
+}
+
+/**
+ * If a cluster starts at the read position, add it to the index.
+ */
+static void indexCluster(OGVDemuxer *demuxer)
+{
+    unsigned char scratch[CLUSTER_HEADER_MAX];
+    size_t len = sizeof(scratch);
+    const unsigned char *data = peekBytes(demuxer, scratch, &len);
+    uint64_t timecode;
+    if (data && read_cluster_header(data, len, &timecode)) {
+        seek_index_add(&demuxer->clusterIndex, timecode, cluster_time_ms(demuxer, timecode), bq_tell(demuxer->bufferQueue));
+    }
+}
+
+/**
+ * Scan forward from the read position for the start of a cluster
+ * before the given limit, leaving the read position on it if found.
+ * @returns 1 if found, 0 if more data is needed, or -1 if there is none
+ */
+static int findCluster(OGVDemuxer *demuxer, int64_t limit, int64_t *offset, uint64_t *timecode)
+{
+    unsigned char buffer[4096];
+    while (1) {
+        int64_t pos = bq_tell(demuxer->bufferQueue);
+        int64_t len = limit - pos;
+        if (len <= 0) {
+            return -1;
+        }
+        if (len > sizeof(buffer)) {
+            len = sizeof(buffer);
+        }
+        int64_t headroom = bq_headroom(demuxer->bufferQueue);
+        if (headroom < len) {
+            if (headroom < CLUSTER_HEADER_MAX) {
+                return 0;
+            }
+            len = headroom;
+        }
+        bq_read(demuxer->bufferQueue, (char *)buffer, len);
+
+        // Unless this is the last stretch before the limit, leave a
+        // header's worth of overlap for the next pass.
+        int last = (pos + len == limit);
+        size_t end = last ? len : len - CLUSTER_HEADER_MAX + 1;
+        for (size_t i = 0; i < end; i++) {
+            if (buffer[i] == 0x1f && read_cluster_header(buffer + i, len - i, timecode)) {
+                *offset = pos + i;
+                bq_seek(demuxer->bufferQueue, *offset);
+                return 1;
+            }
+        }
+        if (last) {
+            return -1;
+        }
+        bq_seek(demuxer->bufferQueue, pos + end);
+    }
+}
+
+/**
+ * Find where the segment ends, from the EBML and Segment headers at the
+ * start of the file, so we know how far to bisect. Leaves it at -1 if
+ * unknown, such as for live streams.
+ */
+static void readSegmentEnd(OGVDemuxer *demuxer)
+{
+    unsigned char scratch[256];
+    size_t len = sizeof(scratch);
+    const unsigned char *data = peekBytes(demuxer, scratch, &len);
+    if (!data) {
+        return;
+    }
+
+    int64_t id, size;
+    size_t pos = 0;
+    int n = read_ebml_int64(data, len, &id, 1);
+    if (!n || id != ID_EBML) {
+        return;
+    }
+    pos += n;
+    n = read_ebml_int64(data + pos, len - pos, &size, 0);
+    if (!n || size > len - pos - n) {
+        return;
+    }
+    pos += n + size;
+
+    n = read_ebml_int64(data + pos, len - pos, &id, 1);
+    if (!n || id != ID_SEGMENT) {
+        return;
+    }
+    pos += n;
+    n = read_ebml_int64(data + pos, len - pos, &size, 0);
+    if (!n) {
+        return;
+    }
+    pos += n;
+    // All-ones size means unknown.
+    if (size == (int64_t)((1ULL << (7 * n)) - 1)) {
+        return;
+    }
+    demuxer->segmentEnd = bq_tell(demuxer->bufferQueue) + pos + size;
+}
+
+/**
+ * Start scanning element boundaries afresh at the read position,
+ * which must be at the start of an element.
+ */
+static void scanReset(OGVDemuxer *demuxer)
+{
+    ElementScan *scan = &demuxer->scan;
+    scan->state = SCAN_HEADER;
+    scan->pos = bq_tell(demuxer->bufferQueue);
+    scan->headerLen = 0;
+    scan->blockEnd = scan->pos;
+    scan->clusterOffset = -1;
+}
+
+/**
+ * Copy out buffered bytes at an offset ahead of the read position.
+ */
+static void readAhead(OGVDemuxer *demuxer, int64_t offset, unsigned char *buffer, size_t len)
+{
+    int64_t pos = bq_tell(demuxer->bufferQueue);
+    bq_seek(demuxer->bufferQueue, offset);
+    bq_read(demuxer->bufferQueue, (char *)buffer, len);
+    bq_seek(demuxer->bufferQueue, pos);
+}
+
+/**
+ * Length of an EBML id or size from its first byte, or 0 if invalid.
+ */
+static size_t ebml_length(unsigned char first, size_t max)
+{
+    size_t n = 1;
+    for (unsigned char mask = 0x80; mask && !(first & mask); mask >>= 1) {
+        n++;
+    }
+    return n <= max ? n : 0;
+}
+
+/**
+ * Scan element boundaries through whatever input has arrived since
+ * last time. Clusters are indexed as their timecodes go by.
+ */
+static void scanElements(OGVDemuxer *demuxer)
+{
+    ElementScan *scan = &demuxer->scan;
+    int64_t end = bq_end(demuxer->bufferQueue);
+
+    while (scan->state != SCAN_FAILED) {
+        if (scan->state == SCAN_PAYLOAD) {
+            if (end < scan->payloadEnd) {
+                return;
+            }
+            if (scan->id == ID_TIMECODE && scan->clusterOffset >= 0) {
+                size_t len = scan->payloadEnd - scan->payloadStart;
+                if (len >= 1 && len <= 8) {
+                    unsigned char bytes[8];
+                    uint64_t timecode = 0;
+                    readAhead(demuxer, scan->payloadStart, bytes, len);
+                    for (size_t i = 0; i < len; i++) {
+                        timecode = timecode << 8 | bytes[i];
+                    }
+                    seek_index_add(&demuxer->clusterIndex, timecode, cluster_time_ms(demuxer, timecode), scan->clusterOffset);
+                }
+            } else if (scan->id == ID_SIMPLE_BLOCK || scan->id == ID_BLOCK_GROUP) {
+                scan->blockEnd = scan->payloadEnd;
+            }
+            scan->clusterOffset = -1;
+            scan->pos = scan->payloadEnd;
+            scan->state = SCAN_HEADER;
+            scan->headerLen = 0;
+            continue;
+        }
+
+        // Gather the id and size, which may arrive over several appends.
+        // Bytes past the header are only peeked at, not consumed.
+        size_t len = sizeof(scan->header) - scan->headerLen;
+        if (end - scan->pos < (int64_t)len) {
+            len = end - scan->pos;
+        }
+        if (len) {
+            readAhead(demuxer, scan->pos, scan->header + scan->headerLen, len);
+        }
+        size_t avail = scan->headerLen + len;
+        if (!avail) {
+            return;
+        }
+        size_t idLen = ebml_length(scan->header[0], 4);
+        size_t sizeLen = (idLen && avail > idLen) ? ebml_length(scan->header[idLen], 8) : 0;
+        if (!idLen || (avail > idLen && !sizeLen)) {
+            scan->state = SCAN_FAILED;
+            return;
+        }
+        if (avail < idLen + sizeLen || !sizeLen) {
+            // All header so far; wait for the rest.
+            scan->pos += len;
+            scan->headerLen = avail;
+            return;
+        }
+        scan->pos += idLen + sizeLen - scan->headerLen;
+        scan->headerLen = idLen + sizeLen;
+
+        int64_t id, size;
+        if (!read_ebml_int64(scan->header, idLen, &id, 1) ||
+            !read_ebml_int64(scan->header + idLen, sizeLen, &size, 0)) {
+            scan->state = SCAN_FAILED;
+            return;
+        }
+        int unknownSize = (size == (int64_t)((1ULL << (7 * sizeLen)) - 1));
+
+        if (id == ID_SEGMENT || id == ID_CLUSTER) {
+            // Step inside; its children are what we're after.
+            scan->clusterOffset = (id == ID_CLUSTER) ? scan->pos - (int64_t)scan->headerLen : -1;
+            scan->headerLen = 0;
+            continue;
+        }
+        if (unknownSize) {
+            // Can't tell where it ends without understanding it.
+            scan->state = SCAN_FAILED;
+            return;
+        }
+        scan->id = id;
+        scan->payloadStart = scan->pos;
+        scan->payloadEnd = scan->pos + size;
+        scan->state = SCAN_PAYLOAD;
+    }
+}
+
+static int processBegin(OGVDemuxer *demuxer) {
 	// This will read through headers, hopefully we have enough data
 	// or else it may fail and explode.
-    ioCallbacks.userdata = (void *)bufferQueue;
-	if (nestegg_init(&demuxContext, ioCallbacks, logCallback, bq_headroom(bufferQueue)) < 0) {
+    nestegg_io io = ioCallbacks;
+    io.userdata = (void *)demuxer->bufferQueue;
+    readSegmentEnd(demuxer);
+	if (nestegg_init(&demuxer->demuxContext, io, logCallback, bq_headroom(demuxer->bufferQueue)) < 0) {
 		// Seek back to start so it can retry when more data is available.
-		bq_seek(bufferQueue, 0);
+		bq_seek(demuxer->bufferQueue, 0);
 		return 0;
 	}
 
+	nestegg_set_pooled_packets(demuxer->demuxContext, borrowCallback);
+	scanReset(demuxer);
+
 	// The first cluster starts a few bytes back, since we've already
 	// peeked-ahead its type and size.
-	startPosition = bq_tell(bufferQueue) - 12;
+	demuxer->startPosition = bq_tell(demuxer->bufferQueue) - 12;
+
+	if (nestegg_tstamp_scale(demuxer->demuxContext, &demuxer->timecodeScale) < 0 || demuxer->timecodeScale == 0) {
+		demuxer->timecodeScale = 1000000;
+	}
+	int64_t pos = bq_tell(demuxer->bufferQueue);
+	if (!bq_seek(demuxer->bufferQueue, demuxer->startPosition)) {
+		indexCluster(demuxer);
+		bq_seek(demuxer->bufferQueue, pos);
+	}
 
 	// Look through the tracks finding our video and audio
 	unsigned int tracks;
-	if (nestegg_track_count(demuxContext, &tracks) < 0) {
+	if (nestegg_track_count(demuxer->demuxContext, &tracks) < 0) {
 		tracks = 0;
 	}
 	for (unsigned int track = 0; track < tracks; track++) {
-		int trackType = nestegg_track_type(demuxContext, track);
-		int codec = nestegg_track_codec_id(demuxContext, track);
+		int trackType = nestegg_track_type(demuxer->demuxContext, track);
+		int codec = nestegg_track_codec_id(demuxer->demuxContext, track);
 		
-		if (trackType == NESTEGG_TRACK_VIDEO && !hasVideo) {
+		if (trackType == NESTEGG_TRACK_VIDEO && !demuxer->hasVideo) {
 			if (codec == NESTEGG_CODEC_VP8) {
-				hasVideo = 1;
-				videoTrack = track;
-				videoCodec = codec;
-				videoCodecName = "vp8";
+				demuxer->hasVideo = 1;
+				demuxer->videoTrack = track;
+				demuxer->videoCodec = codec;
+				demuxer->videoCodecName = "vp8";
 			}
 			if (codec == NESTEGG_CODEC_VP9) {
-				hasVideo = 1;
-				videoTrack = track;
-				videoCodec = codec;
-				videoCodecName = "vp9";
+				demuxer->hasVideo = 1;
+				demuxer->videoTrack = track;
+				demuxer->videoCodec = codec;
+				demuxer->videoCodecName = "vp9";
 			}
             if (codec == NESTEGG_CODEC_AV1) {
-                hasVideo = 1;
-				videoTrack = track;
-				videoCodec = codec;
-				videoCodecName = "av1";
+                demuxer->hasVideo = 1;
+				demuxer->videoTrack = track;
+				demuxer->videoCodec = codec;
+				demuxer->videoCodecName = "av1";
             }
 		}
 		
-		if (trackType == NESTEGG_TRACK_AUDIO && !hasAudio) {
+		if (trackType == NESTEGG_TRACK_AUDIO && !demuxer->hasAudio) {
 			if (codec == NESTEGG_CODEC_VORBIS) {
-				hasAudio = 1;
-				audioTrack = track;
-				audioCodec = codec;
-				audioCodecName = "vorbis";
+				demuxer->hasAudio = 1;
+				demuxer->audioTrack = track;
+				demuxer->audioCodec = codec;
+				demuxer->audioCodecName = "vorbis";
 			}
 			if (codec == NESTEGG_CODEC_OPUS) {
-				hasAudio = 1;
-				audioTrack = track;
-				audioCodec = codec;
-				audioCodecName = "opus";
+				demuxer->hasAudio = 1;
+				demuxer->audioTrack = track;
+				demuxer->audioCodec = codec;
+				demuxer->audioCodecName = "opus";
 			}
 		}
 	}
 
-	if (hasVideo) {
+	if (demuxer->hasVideo) {
 		nestegg_video_params videoParams;
-		if (nestegg_track_video_params(demuxContext, videoTrack, &videoParams) < 0) {
+		if (nestegg_track_video_params(demuxer->demuxContext, demuxer->videoTrack, &videoParams) < 0) {
 			// failed! something is wrong...
-			hasVideo = 0;
+			demuxer->hasVideo = 0;
 		} else {
-			ogvjs_callback_init_video(videoParams.width, videoParams.height,
+			ogvjs_callback_init_video(demuxer, videoParams.width, videoParams.height,
 			                          videoParams.width >> 1, videoParams.height >> 1, // @todo assuming 4:2:0
 			                          0, // @todo get fps
 			                          videoParams.width - videoParams.crop_left - videoParams.crop_right,
@@ -256,45 +662,89 @@ static int processBegin(void) {
 		}
 	}
 
-	if (hasAudio) {
+	if (demuxer->hasAudio) {
 		nestegg_audio_params audioParams;
-		if (nestegg_track_audio_params(demuxContext, audioTrack, &audioParams) < 0) {
+		if (nestegg_track_audio_params(demuxer->demuxContext, demuxer->audioTrack, &audioParams) < 0) {
 			// failed! something is wrong
-			hasAudio = 0;
+			demuxer->hasAudio = 0;
 		} else {
 			unsigned int codecDataCount;
-			nestegg_track_codec_data_count(demuxContext, audioTrack, &codecDataCount);
+			nestegg_track_codec_data_count(demuxer->demuxContext, demuxer->audioTrack, &codecDataCount);
 			
             for (unsigned int i = 0; i < codecDataCount; i++) {
                 unsigned char *data;
                 size_t len;
-                int ret = nestegg_track_codec_data(demuxContext, audioTrack, i, &data, &len);
+                int ret = nestegg_track_codec_data(demuxer->demuxContext, demuxer->audioTrack, i, &data, &len);
                 if (ret < 0) {
                 	//printf("failed to read codec data %d\n", i);
                 	abort();
                 }
                 // ... store these!
-                ogvjs_callback_audio_packet((char *)data, len, -1, 0.0);
+                ogvjs_callback_audio_packet(demuxer, (char *)data, len, -1, 0.0);
 			}
 		}
 	}
 
-	appState = STATE_DECODING;
-	ogvjs_callback_loaded_metadata(videoCodecName, audioCodecName);
+	demuxer->appState = STATE_DECODING;
+	ogvjs_callback_loaded_metadata(demuxer, demuxer->videoCodecName, demuxer->audioCodecName);
 
 	return 1;
 }
 
-static int processDecoding(void) {
+/**
+ * After a mid-stream join, hold back packets until video can start at
+ * a keyframe, and audio along with it.
+ * @returns 1 if the packet should be dropped
+ */
+static int resyncDrop(OGVDemuxer *demuxer, int isVideo, int isKeyframe, float timestamp)
+{
+    if (demuxer->resyncState == RESYNC_NONE) {
+        return 0;
+    }
+    if (!demuxer->hasVideo) {
+        demuxer->resyncState = RESYNC_NONE;
+        return 0;
+    }
+    if (demuxer->resyncState == RESYNC_KEYFRAME) {
+        if (isVideo && isKeyframe) {
+            demuxer->resyncState = RESYNC_AUDIO;
+            demuxer->resyncTimestamp = timestamp;
+            return 0;
+        }
+        return 1;
+    }
+    if (!isVideo) {
+        if (timestamp < demuxer->resyncTimestamp) {
+            return 1;
+        }
+        demuxer->resyncState = RESYNC_NONE;
+    }
+    return 0;
+}
+
+static int processDecoding(OGVDemuxer *demuxer) {
 	//printf("webm processDecoding: reading next packet...\n");
 
-	// Do the nestegg_read_packet dance until it fails to read more data,
-	// at which point we ask for more. Hope it doesn't explode.
+	// Only hand over to nestegg once a whole block is buffered. If the
+	// scan couldn't follow the stream, fall back to the
+	// nestegg_read_packet dance until it fails to read more data.
+	ElementScan *scan = &demuxer->scan;
+	if (scan->pos < bq_tell(demuxer->bufferQueue)) {
+		scanReset(demuxer);
+	}
+	scanElements(demuxer);
+	if (scan->state == SCAN_FAILED) {
+		// Clusters are only seen from out here as they start.
+		indexCluster(demuxer);
+	} else if (scan->blockEnd <= bq_tell(demuxer->bufferQueue)) {
+		return 0;
+	}
+
 	nestegg_packet *packet = NULL;
-	int ret = nestegg_read_packet(demuxContext, &packet);
+	int ret = nestegg_read_packet(demuxer->demuxContext, &packet);
 	if (ret == 0) {
 		// End of stream? Usually means we need more data.
-		nestegg_read_reset(demuxContext);
+		nestegg_read_reset(demuxer->demuxContext);
 		return 0;
 	} else if (ret < 0) {
 		// Unknown unrecoverable error
@@ -313,16 +763,24 @@ static int processDecoding(void) {
 		size_t data_len = 0;
 		nestegg_packet_data(packet, 0, &data, &data_len);
 
-		if (hasVideo && track == videoTrack) {
+		if (demuxer->hasVideo && track == demuxer->videoTrack) {
           int isKeyframe = (nestegg_packet_has_keyframe(packet) == NESTEGG_PACKET_HAS_KEYFRAME_TRUE);
           if (isKeyframe) {
-            lastKeyframeKimestamp = timestamp;
+            demuxer->lastKeyframeKimestamp = timestamp;
+          }
+          if (resyncDrop(demuxer, 1, isKeyframe, timestamp)) {
+            // Nothing to predict from yet after a mid-stream join.
+          } else {
+            ogvjs_callback_video_packet(demuxer, (char *)data, data_len, timestamp, demuxer->lastKeyframeKimestamp, isKeyframe);
           }
-			ogvjs_callback_video_packet((char *)data, data_len, timestamp, lastKeyframeKimestamp, isKeyframe);
-		} else if (hasAudio && track == audioTrack) {
+		} else if (demuxer->hasAudio && track == demuxer->audioTrack) {
             int64_t discard_padding = 0;
             nestegg_packet_discard_padding(packet, &discard_padding);
-			ogvjs_callback_audio_packet((char *)data, data_len, timestamp, (double)discard_padding);
+            if (resyncDrop(demuxer, 0, 0, timestamp)) {
+                // Before the video we're starting from.
+            } else {
+                ogvjs_callback_audio_packet(demuxer, (char *)data, data_len, timestamp, (double)discard_padding);
+            }
 		} else {
 			// throw away unknown packets
 		}
@@ -332,84 +790,240 @@ static int processDecoding(void) {
 	}
 }
 
-static int processSeeking(void)
+static int processSeeking(OGVDemuxer *demuxer)
 {
-    bufferQueue->lastSeekTarget = -1;
+    demuxer->bufferQueue->lastSeekTarget = -1;
     int r;
-    if (nestegg_has_cues(demuxContext)) {
-      r = nestegg_track_seek(demuxContext, seekTrack, seekTime);
+    if (nestegg_has_cues(demuxer->demuxContext)) {
+      r = nestegg_track_seek(demuxer->demuxContext, demuxer->seekTrack, demuxer->seekTime);
     } else {
       // Audio WebM files often do not contain cues.
-      // Seek back to the start of the file, then demux from there.
+      // Seek to the cluster we picked out, then demux from there;
       // high-level code will do a linear search to the target.
-      r = nestegg_offset_seek(demuxContext, startPosition);
+      r = nestegg_offset_seek(demuxer->demuxContext, demuxer->seekOffset);
     }
     
     if (r) {
-        if (bufferQueue->lastSeekTarget == -1) {
+        if (demuxer->bufferQueue->lastSeekTarget == -1) {
             // Maybe we just need more data?
-            //printf("is seeking processing... FAILED at %lld %lld %lld\n", bufferQueue->pos, bq_start(bufferQueue), bq_end(bufferQueue));
+            //printf("is seeking processing... FAILED at %lld %lld %lld\n", demuxer->bufferQueue->pos, bq_start(demuxer->bufferQueue), bq_end(demuxer->bufferQueue));
         } else {
             // We need to go off and load stuff...
-            //printf("is seeking processing... MOAR SEEK %lld %lld %lld\n", bufferQueue->lastSeekTarget, bq_start(bufferQueue), bq_end(bufferQueue));
-            int64_t target = bufferQueue->lastSeekTarget;
-            bq_flush(bufferQueue);
-            bufferQueue->pos = target;
-            ogvjs_callback_seek(target);
+            //printf("is seeking processing... MOAR SEEK %lld %lld %lld\n", demuxer->bufferQueue->lastSeekTarget, bq_start(demuxer->bufferQueue), bq_end(demuxer->bufferQueue));
+            int64_t target = demuxer->bufferQueue->lastSeekTarget;
+            bq_flush(demuxer->bufferQueue);
+            demuxer->bufferQueue->pos = target;
+            ogvjs_callback_seek(demuxer, target);
         }
         // Return false to indicate we need i/o
         return 0;
     } else {
-        appState = STATE_DECODING;
+        demuxer->appState = STATE_DECODING;
+        seek_index_break(&demuxer->clusterIndex);
+        scanReset(demuxer);
         // Roll over to packet processing.
         // Return true to indicate we should keep reading.
         return 1;
     }
 }
 
-void ogv_demuxer_receive_input(const char *buffer, int bufsize) {
+/**
+ * Move the read position to the given offset, asking for i/o if it
+ * isn't buffered.
+ * @returns 1 if the data is ready, or 0 if we need to wait for it
+ */
+static int seekForRead(OGVDemuxer *demuxer, int64_t offset)
+{
+    if (bq_seek(demuxer->bufferQueue, offset) == 0) {
+        return 1;
+    }
+    bq_flush(demuxer->bufferQueue);
+    demuxer->bufferQueue->pos = offset;
+    ogvjs_callback_seek(demuxer, offset);
+    return 0;
+}
+
+/**
+ * Take the next step in the bisection over cluster headers, or finish
+ * and seek to the cluster it found.
+ */
+static int bisectStep(OGVDemuxer *demuxer)
+{
+    if (demuxer->bisectHigh - demuxer->bisectLow <= BISECT_MIN_RANGE) {
+        demuxer->seekOffset = demuxer->bisectLow;
+        demuxer->appState = STATE_SEEKING;
+        return processSeeking(demuxer);
+    }
+    demuxer->bisectPos = demuxer->bisectLow + (demuxer->bisectHigh - demuxer->bisectLow) / 2;
+    demuxer->appState = STATE_BISECTING;
+    return seekForRead(demuxer, demuxer->bisectPos);
+}
+
+/**
+ * Pick the cluster to seek to from the index, or start bisecting
+ * between the nearest indexed clusters if it's in a gap.
+ */
+static int startClusterSeek(OGVDemuxer *demuxer)
+{
+    int64_t time_ms = demuxer->seekTime / 1000000;
+    size_t i = seek_index_find_time(&demuxer->clusterIndex, time_ms);
+    SeekIndexEntry *entries = demuxer->clusterIndex.entries;
+
+    demuxer->bisectLow = (i > 0) ? entries[i - 1].offset : demuxer->startPosition;
+    if (i < demuxer->clusterIndex.len) {
+        if (i > 0 && entries[i].contiguous) {
+            // Indexed straight through; we know just where to go.
+            demuxer->bisectHigh = demuxer->bisectLow;
+        } else {
+            demuxer->bisectHigh = entries[i].offset;
+        }
+    } else if (demuxer->segmentEnd > demuxer->bisectLow) {
+        demuxer->bisectHigh = demuxer->segmentEnd;
+    } else {
+        // Don't know where the end is; demux forward from the last
+        // cluster we know of.
+        demuxer->bisectHigh = demuxer->bisectLow;
+    }
+    return bisectStep(demuxer);
+}
+
+static int processBisecting(OGVDemuxer *demuxer)
+{
+    int64_t offset;
+    uint64_t timecode;
+    int ret = findCluster(demuxer, demuxer->bisectHigh, &offset, &timecode);
+    if (ret == 0) {
+        // need more data
+        return 0;
+    }
+    if (ret > 0) {
+        int64_t time_ms = cluster_time_ms(demuxer, timecode);
+        seek_index_break(&demuxer->clusterIndex);
+        seek_index_add(&demuxer->clusterIndex, timecode, time_ms, offset);
+        seek_index_break(&demuxer->clusterIndex);
+        if (time_ms * 1000000 <= demuxer->seekTime) {
+            demuxer->bisectLow = offset;
+        } else {
+            demuxer->bisectHigh = offset;
+        }
+    } else {
+        // Nothing starts between here and the upper bound, so the
+        // cluster we want is before the probe point.
+        demuxer->bisectHigh = demuxer->bisectPos;
+    }
+    return bisectStep(demuxer);
+}
+
+/**
+ * Drop input up to the next cluster start, carrying the last few bytes
+ * over in case a cluster header straddles two appends.
+ */
+static void resyncInput(OGVDemuxer *demuxer, const char *buffer, size_t bufsize)
+{
+    const unsigned char *data = (const unsigned char *)buffer;
+    size_t tailLen = demuxer->resyncTailLen;
+    uint64_t timecode;
+
+    // A header starting in the carried-over bytes is checked against
+    // a copy of them followed by as much of the new input as it can
+    // take up, so the input itself never needs copying.
+    unsigned char scratch[2 * sizeof(demuxer->resyncTail)];
+    size_t head = bufsize < sizeof(demuxer->resyncTail) ? bufsize : sizeof(demuxer->resyncTail);
+    memcpy(scratch, demuxer->resyncTail, tailLen);
+    memcpy(scratch + tailLen, data, head);
+    for (size_t i = 0; i < tailLen; i++) {
+        if (scratch[i] == 0x1f && read_cluster_header(scratch + i, tailLen + head - i, &timecode)) {
+            bq_append(demuxer->bufferQueue, (const char *)scratch + i, tailLen - i);
+            bq_append(demuxer->bufferQueue, buffer, bufsize);
+            demuxer->resyncScanning = false;
+            demuxer->resyncTailLen = 0;
+            return;
+        }
+    }
+
+    for (size_t i = 0; i < bufsize; i++) {
+        if (data[i] == 0x1f && read_cluster_header(data + i, bufsize - i, &timecode)) {
+            bq_append(demuxer->bufferQueue, buffer + i, bufsize - i);
+            demuxer->resyncScanning = false;
+            demuxer->resyncTailLen = 0;
+            return;
+        }
+    }
+
+    size_t len = tailLen + head,
+           keep = len < sizeof(demuxer->resyncTail) ? len : sizeof(demuxer->resyncTail);
+    if (bufsize > head) {
+        memcpy(demuxer->resyncTail, data + bufsize - keep, keep);
+    } else {
+        memcpy(demuxer->resyncTail, scratch + len - keep, keep);
+    }
+    demuxer->resyncTailLen = keep;
+}
+
+void ogv_demuxer_receive_input(OGVDemuxer *demuxer, const char *buffer, int bufsize) {
     if (bufsize > 0) {
-        bq_append(bufferQueue, buffer, bufsize);
+        if (demuxer->resyncScanning) {
+            resyncInput(demuxer, buffer, bufsize);
+        } else {
+            bq_append(demuxer->bufferQueue, buffer, bufsize);
+        }
     }
 }
 
-int ogv_demuxer_process(void) {
-	if (appState == STATE_BEGIN) {
-        return processBegin();
-    } else if (appState == STATE_DECODING) {
-        return processDecoding();
-    } else if (appState == STATE_SEEKING) {
-        if (readyForNextPacket()) {
-            return processSeeking();
+/**
+ * Mark the end of a cached init segment: input from here on comes from
+ * partway through a live stream, and picks up at its next cluster.
+ */
+void ogv_demuxer_resync(OGVDemuxer *demuxer)
+{
+    demuxer->resyncScanning = true;
+    demuxer->resyncTailLen = 0;
+    demuxer->resyncState = RESYNC_KEYFRAME;
+}
+
+int ogv_demuxer_process(OGVDemuxer *demuxer) {
+	if (demuxer->appState == STATE_BEGIN) {
+        return processBegin(demuxer);
+    } else if (demuxer->appState == STATE_DECODING) {
+        return processDecoding(demuxer);
+    } else if (demuxer->appState == STATE_SEEKING) {
+        if (readyForNextPacket(demuxer)) {
+            return processSeeking(demuxer);
         } else {
             // need more data
             //printf("not ready to read the cues\n");
             return 0;
         }
+    } else if (demuxer->appState == STATE_BISECTING) {
+        return processBisecting(demuxer);
 	} else {
 		// uhhh...
-		//printf("Invalid appState in ogv_demuxer_process\n");
+		//printf("Invalid demuxer->appState in ogv_demuxer_process\n");
         return 0;
 	}
 }
 
-void ogv_demuxer_destroy(void) {
-	// should probably tear stuff down, eh
-    bq_free(bufferQueue);
-    bufferQueue = NULL;
+void ogv_demuxer_destroy(OGVDemuxer *demuxer) {
+    if (demuxer->demuxContext) {
+        nestegg_destroy(demuxer->demuxContext);
+    }
+    seek_index_free(&demuxer->clusterIndex);
+    bq_free(demuxer->bufferQueue);
+    free(demuxer);
 }
 
-void ogv_demuxer_flush(void) {
-    bq_flush(bufferQueue);
+void ogv_demuxer_flush(OGVDemuxer *demuxer) {
+    bq_flush(demuxer->bufferQueue);
     // we may not need to handle the packet queue because this only
     // happens after seeking and nestegg handles that internally
-    lastKeyframeKimestamp = -1;
+    demuxer->lastKeyframeKimestamp = -1;
+    seek_index_break(&demuxer->clusterIndex);
 }
 
 /**
  * @return segment length in bytes, or -1 if unknown
  */
-long ogv_demuxer_media_length(void) {
+long ogv_demuxer_media_length(OGVDemuxer *demuxer) {
 	// @todo check if this is needed? maybe an ogg-specific thing
 	return -1;
 }
@@ -417,39 +1031,61 @@ long ogv_demuxer_media_length(void) {
 /**
  * @return segment duration in seconds, or -1 if unknown
  */
-float ogv_demuxer_media_duration(void) {
+float ogv_demuxer_media_duration(OGVDemuxer *demuxer) {
 	uint64_t duration_ns;
-    if (nestegg_duration(demuxContext, &duration_ns) < 0) {
+    if (nestegg_duration(demuxer->demuxContext, &duration_ns) < 0) {
     	return -1;
     } else {
 	    return duration_ns / 1000000000.0;
 	}
 }
 
-int ogv_demuxer_seekable(void)
+int ogv_demuxer_seekable(OGVDemuxer *demuxer)
 {
   // Audio WebM files often have no cues; allow brute-force seeking
   // by linear demuxing through hopefully-cached data.
 	return 1;
 }
 
-long ogv_demuxer_keypoint_offset(long time_ms)
+long ogv_demuxer_keypoint_offset(OGVDemuxer *demuxer, long time_ms)
 {
 	// can't do with nestegg's API; use ogv_demuxer_seek_to_keypoint instead
 	return -1;
 }
 
-int ogv_demuxer_seek_to_keypoint(long time_ms)
+int ogv_demuxer_seek_to_keypoint(OGVDemuxer *demuxer, long time_ms)
 {
-    appState = STATE_SEEKING;
-    seekTime = (int64_t)time_ms * 1000000LL;
-    if (hasVideo) {
-        seekTrack = videoTrack;
-    } else if (hasAudio) {
-        seekTrack = audioTrack;
+    demuxer->appState = STATE_SEEKING;
+    demuxer->seekTime = (int64_t)time_ms * 1000000LL;
+    if (demuxer->hasVideo) {
+        demuxer->seekTrack = demuxer->videoTrack;
+    } else if (demuxer->hasAudio) {
+        demuxer->seekTrack = demuxer->audioTrack;
     } else {
         return 0;
     }
-    processSeeking();
+    if (nestegg_has_cues(demuxer->demuxContext)) {
+        processSeeking(demuxer);
+    } else {
+        startClusterSeek(demuxer);
+    }
     return 1;
 }
+
+size_t ogv_demuxer_index_size(OGVDemuxer *demuxer)
+{
+	SeekIndex *indexes[1] = { &demuxer->clusterIndex };
+	return seek_index_export_size(indexes, 1);
+}
+
+void ogv_demuxer_index_export(OGVDemuxer *demuxer, char *buffer)
+{
+	SeekIndex *indexes[1] = { &demuxer->clusterIndex };
+	seek_index_export(indexes, 1, buffer);
+}
+
+int ogv_demuxer_index_import(OGVDemuxer *demuxer, const char *buffer, size_t len)
+{
+	SeekIndex *indexes[1] = { &demuxer->clusterIndex };
+	return seek_index_import(indexes, 1, buffer, len);
+}
@@ -1,16 +1,21 @@
+// Opaque per-stream demuxer state, from ogv_demuxer_create().
+// Every callback gets back the handle it was raised for.
+typedef struct OGVDemuxer OGVDemuxer;
+
 // Callbacks
-extern void ogvjs_callback_init_audio(int channels, int rate);
+extern void ogvjs_callback_init_audio(OGVDemuxer *demuxer, int channels, int rate);
 
-extern void ogvjs_callback_init_video(int frameWidth, int frameHeight,
+extern void ogvjs_callback_init_video(OGVDemuxer *demuxer,
+                                      int frameWidth, int frameHeight,
                                       int chromaWidth, int chromaHeight,
                                       double fps,
                                       int picWidth, int picHeight,
                                       int picX, int picY,
                                       int displayWidth, int displayHeight);
 
-extern void ogvjs_callback_loaded_metadata(const char *videoCodec, const char *audioCodec);
-extern void ogvjs_callback_video_packet(const char *buffer, size_t len, float frameTimestamp, float keyframeTimestamp, int isKeyframe);
-extern void ogvjs_callback_audio_packet(const char *buffer, size_t len, float audioTimestamp, double discardPadding);
-extern int ogvjs_callback_frame_ready(void);
-extern int ogvjs_callback_audio_ready(void);
-extern void ogvjs_callback_seek(int64_t offset);
+extern void ogvjs_callback_loaded_metadata(OGVDemuxer *demuxer, const char *videoCodec, const char *audioCodec);
+extern void ogvjs_callback_video_packet(OGVDemuxer *demuxer, const char *buffer, size_t len, float frameTimestamp, float keyframeTimestamp, int isKeyframe);
+extern void ogvjs_callback_audio_packet(OGVDemuxer *demuxer, const char *buffer, size_t len, float audioTimestamp, double discardPadding);
+extern int ogvjs_callback_frame_ready(OGVDemuxer *demuxer);
+extern int ogvjs_callback_audio_ready(OGVDemuxer *demuxer);
+extern void ogvjs_callback_seek(OGVDemuxer *demuxer, int64_t offset);
@@ -0,0 +1,137 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "ogv-decoder-video.h"
+#include "ogv-frame-ring.h"
+
+/**
+ * Find a slot for the next frame, preferring free ones in ring order.
+ * If JS is still holding every slot, the oldest one that's big enough
+ * is taken back; JS may still have views on it, so a held slot is
+ * never freed or moved. Returns -1 to skip the frame.
+ */
+static int frame_ring_acquire(FrameRing *ring, size_t size) {
+    int slot = -1;
+    for (int i = 0; i < FRAME_RING_SIZE; i++) {
+        int n = (ring->next + i) % FRAME_RING_SIZE;
+        if (!ring->slots[n].in_use) {
+            slot = n;
+            break;
+        }
+    }
+    if (slot < 0) {
+        for (int i = 0; i < FRAME_RING_SIZE; i++) {
+            if (ring->slots[i].size >= size &&
+                (slot < 0 || (int)(ring->slots[i].serial - ring->slots[slot].serial) < 0)) {
+                slot = i;
+            }
+        }
+        if (slot < 0) {
+            ring->drops++;
+            return -1;
+        }
+        ring->steals++;
+    }
+    ring->next = (slot + 1) % FRAME_RING_SIZE;
+
+    FrameRingSlot *s = &ring->slots[slot];
+    if (s->size < size) {
+        // Contents don't need to survive, so skip realloc's copy.
+        free(s->data);
+        s->data = malloc(size);
+        s->size = s->data ? size : 0;
+        if (!s->data) {
+            return -1;
+        }
+    }
+    s->in_use = 1;
+    s->serial = ring->serial++;
+    return slot;
+}
+
+static void copy_plane(unsigned char *dest, const unsigned char *src, int stride,
+                       int x, int y, int width, int height) {
+    src += (ptrdiff_t)y * stride + x;
+    for (int row = 0; row < height; row++) {
+        memcpy(dest, src, width);
+        dest += width;
+        src += stride;
+    }
+}
+
+void frame_ring_output(OGVVideoDecoder *decoder, FrameRing *ring,
+                       const unsigned char *bufferY, int strideY,
+                       const unsigned char *bufferCb, int strideCb,
+                       const unsigned char *bufferCr, int strideCr,
+                       int width, int height,
+                       int chromaWidth, int chromaHeight,
+                       int picWidth, int picHeight,
+                       int picX, int picY,
+                       int displayWidth, int displayHeight) {
+    if (ring->rgba.enabled) {
+        int outWidth, outHeight;
+        rgba_output_size(&ring->rgba, picWidth, picHeight, &outWidth, &outHeight);
+        int slot = frame_ring_acquire(ring, (size_t)outWidth * outHeight * 4);
+        if (slot < 0) {
+            return;
+        }
+        unsigned char *rgba = ring->slots[slot].data;
+        if (!rgba_output_convert(&ring->rgba, rgba, outWidth, outHeight,
+                                 bufferY, strideY, bufferCb, strideCb, bufferCr, strideCr,
+                                 width, height, chromaWidth, chromaHeight,
+                                 picWidth, picHeight, picX, picY)) {
+            frame_ring_release(ring, slot, ring->slots[slot].serial);
+            return;
+        }
+        ogvjs_callback_frame_rgba(decoder, slot, ring->slots[slot].serial, rgba,
+                                  outWidth, outHeight,
+                                  picWidth, picHeight,
+                                  displayWidth, displayHeight);
+        return;
+    }
+
+    // Chroma starts on the sample covering the even luma position at or
+    // before the crop, and runs through the one covering its last pixel.
+    int chromaX = (picX & ~1) * chromaWidth / width;
+    int chromaY = (picY & ~1) * chromaHeight / height;
+    int chromaPicWidth = ((picX + picWidth) * chromaWidth + width - 1) / width - chromaX;
+    int chromaPicHeight = ((picY + picHeight) * chromaHeight + height - 1) / height - chromaY;
+
+    size_t lenY = (size_t)picWidth * picHeight;
+    size_t lenC = (size_t)chromaPicWidth * chromaPicHeight;
+    int slot = frame_ring_acquire(ring, lenY + lenC * 2);
+    if (slot < 0) {
+        return;
+    }
+
+    unsigned char *outY = ring->slots[slot].data;
+    unsigned char *outCb = outY + lenY;
+    unsigned char *outCr = outCb + lenC;
+    copy_plane(outY, bufferY, strideY, picX, picY, picWidth, picHeight);
+    copy_plane(outCb, bufferCb, strideCb, chromaX, chromaY, chromaPicWidth, chromaPicHeight);
+    copy_plane(outCr, bufferCr, strideCr, chromaX, chromaY, chromaPicWidth, chromaPicHeight);
+
+    ogvjs_callback_frame(decoder, slot, ring->slots[slot].serial,
+                         outY, outCb, outCr,
+                         picWidth, picHeight,
+                         chromaPicWidth, chromaPicHeight,
+                         displayWidth, displayHeight);
+}
+
+void frame_ring_release(FrameRing *ring, int slot, unsigned int serial) {
+    // A stale release, for a frame whose slot was since taken back,
+    // must not free the slot from under the newer frame.
+    if (slot >= 0 && slot < FRAME_RING_SIZE && ring->slots[slot].serial == serial) {
+        ring->slots[slot].in_use = 0;
+    }
+}
+
+void frame_ring_free(FrameRing *ring) {
+    for (int i = 0; i < FRAME_RING_SIZE; i++) {
+        free(ring->slots[i].data);
+        ring->slots[i].data = NULL;
+        ring->slots[i].size = 0;
+        ring->slots[i].in_use = 0;
+    }
+    rgba_output_free(&ring->rgba);
+}
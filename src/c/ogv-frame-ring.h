@@ -0,0 +1,43 @@
+#include <stddef.h>
+
+#include "ogv-rgba-output.h"
+
+// Output frames are cropped to the visible area and packed into a
+// fixed set of heap slots, which JS reads in place until it releases
+// them. Enough slots to cover the player's decoded frame pipeline plus
+// the frame on screen; slots are only allocated once they're needed.
+#define FRAME_RING_SIZE 16
+
+typedef struct {
+    unsigned char *data;
+    size_t size;
+    int in_use;
+    // Output order, for picking a slot to take back if none are free.
+    // Also handed to JS with the frame, so a release that comes in
+    // after the slot was taken back can be told apart.
+    unsigned int serial;
+} FrameRingSlot;
+
+typedef struct {
+    FrameRingSlot slots[FRAME_RING_SIZE];
+    int next;
+    unsigned int serial;
+    // Times a slot still held by JS had to be reused.
+    int steals;
+    // Frames skipped because every slot was held, and none big enough.
+    int drops;
+    // When enabled, slots hold converted RGBA pixels instead of planes.
+    RGBAOutput rgba;
+} FrameRing;
+
+extern void frame_ring_output(struct OGVVideoDecoder *decoder, FrameRing *ring,
+                              const unsigned char *bufferY, int strideY,
+                              const unsigned char *bufferCb, int strideCb,
+                              const unsigned char *bufferCr, int strideCr,
+                              int width, int height,
+                              int chromaWidth, int chromaHeight,
+                              int picWidth, int picHeight,
+                              int picX, int picY,
+                              int displayWidth, int displayHeight);
+extern void frame_ring_release(FrameRing *ring, int slot, unsigned int serial);
+extern void frame_ring_free(FrameRing *ring);
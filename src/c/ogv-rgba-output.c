@@ -0,0 +1,304 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __wasm_simd128__
+#include <wasm_simd128.h>
+#endif
+
+#include "ogv-rgba-output.h"
+
+void rgba_output_configure(RGBAOutput *out, int enabled,
+                           int width, int height,
+                           int matrix, int fullRange) {
+    out->enabled = enabled;
+    out->width = (width > 0 && height > 0) ? width : 0;
+    out->height = (width > 0 && height > 0) ? height : 0;
+    out->matrix = matrix;
+    out->full_range = fullRange;
+
+    double kr = 0.299, kb = 0.114;
+    if (matrix == RGBA_MATRIX_BT709) {
+        kr = 0.2126;
+        kb = 0.0722;
+    }
+    double kg = 1.0 - kr - kb;
+    // Limited range luma runs 16-235 and chroma 16-240.
+    double ys = fullRange ? 1.0 : 255.0 / 219.0;
+    double cs = fullRange ? 1.0 : 255.0 / 224.0;
+    out->y_offset = fullRange ? 0 : 16;
+    out->y_scale = (int)(ys * 65536.0 + 0.5);
+    out->cr_r = (int)(2.0 * (1.0 - kr) * cs * 65536.0 + 0.5);
+    out->cb_g = (int)(2.0 * kb * (1.0 - kb) / kg * cs * 65536.0 + 0.5);
+    out->cr_g = (int)(2.0 * kr * (1.0 - kr) / kg * cs * 65536.0 + 0.5);
+    out->cb_b = (int)(2.0 * (1.0 - kb) * cs * 65536.0 + 0.5);
+}
+
+void rgba_output_size(const RGBAOutput *out, int picWidth, int picHeight,
+                      int *outWidth, int *outHeight) {
+    if (out->width && out->height) {
+        *outWidth = out->width;
+        *outHeight = out->height;
+    } else {
+        *outWidth = picWidth;
+        *outHeight = picHeight;
+    }
+}
+
+void rgba_output_free(RGBAOutput *out) {
+    free(out->scratch);
+    out->scratch = NULL;
+    out->scratch_size = 0;
+}
+
+static inline unsigned char clamp_byte(int v) {
+    return v < 0 ? 0 : (v > 255 ? 255 : v);
+}
+
+#ifdef __wasm_simd128__
+static inline void widen_u8(v128_t v, v128_t out[4]) {
+    v128_t lo = wasm_u16x8_extend_low_u8x16(v);
+    v128_t hi = wasm_u16x8_extend_high_u8x16(v);
+    out[0] = wasm_u32x4_extend_low_u16x8(lo);
+    out[1] = wasm_u32x4_extend_high_u16x8(lo);
+    out[2] = wasm_u32x4_extend_low_u16x8(hi);
+    out[3] = wasm_u32x4_extend_high_u16x8(hi);
+}
+
+static inline v128_t narrow_u8(const v128_t v[4]) {
+    return wasm_u8x16_narrow_i16x8(wasm_i16x8_narrow_i32x4(v[0], v[1]),
+                                   wasm_i16x8_narrow_i32x4(v[2], v[3]));
+}
+#endif
+
+/**
+ * Convert one row of pixels. Chroma is halved horizontally if hshift
+ * is set, and starts on the sample for the row's first pixel.
+ */
+static void convert_row(const RGBAOutput *out, unsigned char *dest,
+                        const unsigned char *y,
+                        const unsigned char *cb,
+                        const unsigned char *cr,
+                        int n, int hshift) {
+    int x = 0;
+#ifdef __wasm_simd128__
+    // Same arithmetic as the scalar loop, sixteen pixels at a time;
+    // narrowing saturates where the scalar loop clamps.
+    const v128_t yOffset = wasm_i32x4_splat(out->y_offset);
+    const v128_t yScale = wasm_i32x4_splat(out->y_scale);
+    const v128_t crR = wasm_i32x4_splat(out->cr_r);
+    const v128_t cbG = wasm_i32x4_splat(out->cb_g);
+    const v128_t crG = wasm_i32x4_splat(out->cr_g);
+    const v128_t cbB = wasm_i32x4_splat(out->cb_b);
+    const v128_t bias = wasm_i32x4_splat(128);
+    const v128_t round = wasm_i32x4_splat(32768);
+    const v128_t alpha = wasm_i8x16_splat(-1);
+    for (; x + 16 <= n; x += 16) {
+        v128_t u, v;
+        if (hshift) {
+            u = wasm_v128_load64_zero(cb + (x >> 1));
+            v = wasm_v128_load64_zero(cr + (x >> 1));
+            u = wasm_i8x16_shuffle(u, u, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7);
+            v = wasm_i8x16_shuffle(v, v, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7);
+        } else {
+            u = wasm_v128_load(cb + x);
+            v = wasm_v128_load(cr + x);
+        }
+        v128_t ys[4], us[4], vs[4], r[4], g[4], b[4];
+        widen_u8(wasm_v128_load(y + x), ys);
+        widen_u8(u, us);
+        widen_u8(v, vs);
+        for (int i = 0; i < 4; i++) {
+            v128_t luma = wasm_i32x4_add(wasm_i32x4_mul(wasm_i32x4_sub(ys[i], yOffset), yScale), round);
+            v128_t du = wasm_i32x4_sub(us[i], bias);
+            v128_t dv = wasm_i32x4_sub(vs[i], bias);
+            r[i] = wasm_i32x4_shr(wasm_i32x4_add(luma, wasm_i32x4_mul(crR, dv)), 16);
+            g[i] = wasm_i32x4_shr(wasm_i32x4_sub(wasm_i32x4_sub(luma, wasm_i32x4_mul(cbG, du)),
+                                                 wasm_i32x4_mul(crG, dv)), 16);
+            b[i] = wasm_i32x4_shr(wasm_i32x4_add(luma, wasm_i32x4_mul(cbB, du)), 16);
+        }
+        v128_t r8 = narrow_u8(r), g8 = narrow_u8(g), b8 = narrow_u8(b);
+
+        v128_t rgLo = wasm_i8x16_shuffle(r8, g8, 0, 16, 1, 17, 2, 18, 3, 19, 4, 20, 5, 21, 6, 22, 7, 23);
+        v128_t rgHi = wasm_i8x16_shuffle(r8, g8, 8, 24, 9, 25, 10, 26, 11, 27, 12, 28, 13, 29, 14, 30, 15, 31);
+        v128_t baLo = wasm_i8x16_shuffle(b8, alpha, 0, 16, 1, 17, 2, 18, 3, 19, 4, 20, 5, 21, 6, 22, 7, 23);
+        v128_t baHi = wasm_i8x16_shuffle(b8, alpha, 8, 24, 9, 25, 10, 26, 11, 27, 12, 28, 13, 29, 14, 30, 15, 31);
+        unsigned char *d = dest + x * 4;
+        wasm_v128_store(d, wasm_i16x8_shuffle(rgLo, baLo, 0, 8, 1, 9, 2, 10, 3, 11));
+        wasm_v128_store(d + 16, wasm_i16x8_shuffle(rgLo, baLo, 4, 12, 5, 13, 6, 14, 7, 15));
+        wasm_v128_store(d + 32, wasm_i16x8_shuffle(rgHi, baHi, 0, 8, 1, 9, 2, 10, 3, 11));
+        wasm_v128_store(d + 48, wasm_i16x8_shuffle(rgHi, baHi, 4, 12, 5, 13, 6, 14, 7, 15));
+    }
+#endif
+    for (; x < n; x++) {
+        int c = x >> hshift;
+        int luma = (y[x] - out->y_offset) * out->y_scale + 32768;
+        int du = cb[c] - 128;
+        int dv = cr[c] - 128;
+        unsigned char *d = dest + x * 4;
+        d[0] = clamp_byte((luma + out->cr_r * dv) >> 16);
+        d[1] = clamp_byte((luma - out->cb_g * du - out->cr_g * dv) >> 16);
+        d[2] = clamp_byte((luma + out->cb_b * du) >> 16);
+        d[3] = 255;
+    }
+}
+
+typedef struct {
+    const unsigned char *y, *cb, *cr;
+    int strideY, strideCb, strideCr;
+    int hshift, vshift;
+} Planes;
+
+/**
+ * Integer ratio: each output pixel averages the kx by ky box of
+ * source pixels it covers, chroma included.
+ */
+static void box_row(const Planes *p, unsigned char *rowY, unsigned char *rowCb, unsigned char *rowCr,
+                    int outWidth, int picX, int top, int kx, int ky) {
+    int area = kx * ky;
+    for (int ox = 0; ox < outWidth; ox++) {
+        int left = picX + ox * kx;
+        int sumY = 0, sumCb = 0, sumCr = 0;
+        for (int j = 0; j < ky; j++) {
+            int sy = top + j;
+            const unsigned char *ly = p->y + (ptrdiff_t)sy * p->strideY;
+            const unsigned char *lcb = p->cb + (ptrdiff_t)(sy >> p->vshift) * p->strideCb;
+            const unsigned char *lcr = p->cr + (ptrdiff_t)(sy >> p->vshift) * p->strideCr;
+            for (int i = 0; i < kx; i++) {
+                int sx = left + i;
+                sumY += ly[sx];
+                sumCb += lcb[sx >> p->hshift];
+                sumCr += lcr[sx >> p->hshift];
+            }
+        }
+        rowY[ox] = (sumY + area / 2) / area;
+        rowCb[ox] = (sumCb + area / 2) / area;
+        rowCr[ox] = (sumCr + area / 2) / area;
+    }
+}
+
+/**
+ * Bilinear tap for output position o of outLen, covering picLen source
+ * pixels from offset. Positions are pixel centres; shift maps luma to
+ * chroma sample positions, and taps stay within lo..hi.
+ */
+static void bilinear_tap(int o, int outLen, int picLen, int offset, int shift,
+                         int lo, int hi, int *i0, int *i1, int *w) {
+    int64_t pos = ((int64_t)(2 * o + 1) * picLen << 16) / (2 * outLen);
+    pos = ((pos + ((int64_t)offset << 16)) >> shift) - 32768;
+    if (pos < (int64_t)lo << 16) {
+        pos = (int64_t)lo << 16;
+    } else if (pos > (int64_t)hi << 16) {
+        pos = (int64_t)hi << 16;
+    }
+    *i0 = (int)(pos >> 16);
+    *i1 = *i0 < hi ? *i0 + 1 : hi;
+    *w = (int)(pos & 0xffff) >> 8;
+}
+
+static inline unsigned char bilinear(const unsigned char *r0, const unsigned char *r1,
+                                     int x0, int x1, int wx, int wy) {
+    int top = r0[x0] * (256 - wx) + r0[x1] * wx;
+    int bottom = r1[x0] * (256 - wx) + r1[x1] * wx;
+    return (top * (256 - wy) + bottom * wy + 32768) >> 16;
+}
+
+int rgba_output_convert(RGBAOutput *out, unsigned char *dest,
+                        int outWidth, int outHeight,
+                        const unsigned char *bufferY, int strideY,
+                        const unsigned char *bufferCb, int strideCb,
+                        const unsigned char *bufferCr, int strideCr,
+                        int width, int height,
+                        int chromaWidth, int chromaHeight,
+                        int picWidth, int picHeight,
+                        int picX, int picY) {
+    Planes p = {
+        bufferY, bufferCb, bufferCr,
+        strideY, strideCb, strideCr,
+        chromaWidth < width ? 1 : 0,
+        chromaHeight < height ? 1 : 0
+    };
+
+    if (outWidth == picWidth && outHeight == picHeight) {
+        for (int row = 0; row < outHeight; row++) {
+            int sy = picY + row;
+            const unsigned char *y = p.y + (ptrdiff_t)sy * p.strideY + picX;
+            const unsigned char *cb = p.cb + (ptrdiff_t)(sy >> p.vshift) * p.strideCb + (picX >> p.hshift);
+            const unsigned char *cr = p.cr + (ptrdiff_t)(sy >> p.vshift) * p.strideCr + (picX >> p.hshift);
+            unsigned char *d = dest + (size_t)row * outWidth * 4;
+            int n = picWidth;
+            if (picX & p.hshift) {
+                // Odd crop: the first pixel shares chroma with its left neighbour.
+                convert_row(out, d, y, cb, cr, 1, 0);
+                d += 4;
+                y++;
+                cb++;
+                cr++;
+                n--;
+            }
+            convert_row(out, d, y, cb, cr, n, p.hshift);
+        }
+        return 1;
+    }
+
+    // Scaled: resample each output row to full-resolution Y, Cb and Cr
+    // first, then convert it as 4:4:4.
+    size_t tables = (size_t)outWidth * 6 * sizeof(int);
+    size_t size = tables + (size_t)outWidth * 3;
+    if (out->scratch_size < size) {
+        free(out->scratch);
+        out->scratch = malloc(size);
+        out->scratch_size = out->scratch ? size : 0;
+        if (!out->scratch) {
+            return 0;
+        }
+    }
+    int *lx0 = (int *)out->scratch;
+    int *lx1 = lx0 + outWidth;
+    int *lwx = lx1 + outWidth;
+    int *cx0 = lwx + outWidth;
+    int *cx1 = cx0 + outWidth;
+    int *cwx = cx1 + outWidth;
+    unsigned char *rowY = out->scratch + tables;
+    unsigned char *rowCb = rowY + outWidth;
+    unsigned char *rowCr = rowCb + outWidth;
+
+    int kx = picWidth / outWidth;
+    int ky = picHeight / outHeight;
+    int box = kx * outWidth == picWidth && ky * outHeight == picHeight;
+    if (!box) {
+        for (int ox = 0; ox < outWidth; ox++) {
+            bilinear_tap(ox, outWidth, picWidth, picX, 0,
+                         picX, picX + picWidth - 1, &lx0[ox], &lx1[ox], &lwx[ox]);
+            bilinear_tap(ox, outWidth, picWidth, picX, p.hshift,
+                         picX >> p.hshift, (picX + picWidth - 1) >> p.hshift,
+                         &cx0[ox], &cx1[ox], &cwx[ox]);
+        }
+    }
+
+    for (int row = 0; row < outHeight; row++) {
+        if (box) {
+            box_row(&p, rowY, rowCb, rowCr, outWidth, picX, picY + row * ky, kx, ky);
+        } else {
+            int ly0, ly1, lwy, cy0, cy1, cwy;
+            bilinear_tap(row, outHeight, picHeight, picY, 0,
+                         picY, picY + picHeight - 1, &ly0, &ly1, &lwy);
+            bilinear_tap(row, outHeight, picHeight, picY, p.vshift,
+                         picY >> p.vshift, (picY + picHeight - 1) >> p.vshift,
+                         &cy0, &cy1, &cwy);
+            const unsigned char *y0 = p.y + (ptrdiff_t)ly0 * p.strideY;
+            const unsigned char *y1 = p.y + (ptrdiff_t)ly1 * p.strideY;
+            const unsigned char *cb0 = p.cb + (ptrdiff_t)cy0 * p.strideCb;
+            const unsigned char *cb1 = p.cb + (ptrdiff_t)cy1 * p.strideCb;
+            const unsigned char *cr0 = p.cr + (ptrdiff_t)cy0 * p.strideCr;
+            const unsigned char *cr1 = p.cr + (ptrdiff_t)cy1 * p.strideCr;
+            for (int ox = 0; ox < outWidth; ox++) {
+                rowY[ox] = bilinear(y0, y1, lx0[ox], lx1[ox], lwx[ox], lwy);
+                rowCb[ox] = bilinear(cb0, cb1, cx0[ox], cx1[ox], cwx[ox], cwy);
+                rowCr[ox] = bilinear(cr0, cr1, cx0[ox], cx1[ox], cwx[ox], cwy);
+            }
+        }
+        convert_row(out, dest + (size_t)row * outWidth * 4, rowY, rowCb, rowCr, outWidth, 0);
+    }
+    return 1;
+}
@@ -0,0 +1,51 @@
+#include <stddef.h>
+
+// Optional RGBA output for the video decoders, for canvases without
+// WebGL: frames are colour converted, and optionally scaled down to the
+// canvas size, in C so JS can putImageData the result as-is.
+
+#define RGBA_MATRIX_BT601 0
+#define RGBA_MATRIX_BT709 1
+
+typedef struct {
+    int enabled;
+    // Output size; 0 to keep the cropped frame size.
+    int width;
+    int height;
+    int matrix;
+    int full_range;
+
+    // Fixed-point conversion factors, 16 fractional bits.
+    int y_offset;
+    int y_scale;
+    int cr_r;
+    int cb_g;
+    int cr_g;
+    int cb_b;
+
+    // Row and column working space for scaling.
+    unsigned char *scratch;
+    size_t scratch_size;
+} RGBAOutput;
+
+extern void rgba_output_configure(RGBAOutput *out, int enabled,
+                                  int width, int height,
+                                  int matrix, int fullRange);
+
+// Size of the RGBA image rgba_output_convert() makes from a crop.
+extern void rgba_output_size(const RGBAOutput *out, int picWidth, int picHeight,
+                             int *outWidth, int *outHeight);
+
+// Converts the crop into dest, which holds outWidth * outHeight pixels.
+// Returns 0 if scratch space couldn't be allocated.
+extern int rgba_output_convert(RGBAOutput *out, unsigned char *dest,
+                               int outWidth, int outHeight,
+                               const unsigned char *bufferY, int strideY,
+                               const unsigned char *bufferCb, int strideCb,
+                               const unsigned char *bufferCr, int strideCr,
+                               int width, int height,
+                               int chromaWidth, int chromaHeight,
+                               int picWidth, int picHeight,
+                               int picX, int picY);
+
+extern void rgba_output_free(RGBAOutput *out);
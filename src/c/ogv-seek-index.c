@@ -0,0 +1,231 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "ogv-seek-index.h"
+
+/*
+ * Serialized form, for shipping a pre-built index alongside the media.
+ * All values little-endian:
+ *
+ *   "OGVI" magic, u32 version, u32 list count,
+ *   then per list: u32 entry count,
+ *   then per entry: i64 timecode, i64 time_ms, i64 offset, u8 contiguous
+ */
+#define SEEK_INDEX_VERSION 1
+#define SEEK_INDEX_HEADER_SIZE 12
+#define SEEK_INDEX_LIST_SIZE 4
+#define SEEK_INDEX_ENTRY_SIZE 25
+
+/**
+ * @return index of the first entry with offset >= the given offset
+ */
+static size_t seek_index_find_offset(SeekIndex *index, int64_t offset) {
+    size_t low = 0, high = index->len;
+    while (low < high) {
+        size_t mid = (low + high) / 2;
+        if (index->entries[mid].offset < offset) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+void seek_index_init(SeekIndex *index) {
+    index->entries = NULL;
+    index->len = 0;
+    index->max = 0;
+    index->last = -1;
+}
+
+void seek_index_add(SeekIndex *index, int64_t timecode, int64_t time_ms, int64_t offset) {
+    size_t i = seek_index_find_offset(index, offset);
+    if (i < index->len && index->entries[i].offset == offset) {
+        // Already seen; just note that we got here linearly.
+        if (index->last >= 0 && (size_t)index->last + 1 == i) {
+            index->entries[i].contiguous = 1;
+        }
+        index->last = i;
+        return;
+    }
+    if (index->len == index->max) {
+        index->max = index->max ? index->max * 2 : 256;
+        index->entries = realloc(index->entries, index->max * sizeof(SeekIndexEntry));
+    }
+    memmove(&index->entries[i + 1], &index->entries[i], (index->len - i) * sizeof(SeekIndexEntry));
+    index->len++;
+
+    SeekIndexEntry *entry = &index->entries[i];
+    entry->timecode = timecode;
+    entry->time_ms = time_ms;
+    entry->offset = offset;
+    entry->contiguous = (index->last >= 0 && (size_t)index->last + 1 == i);
+    if (i + 1 < index->len) {
+        // We landed in the middle of a gap, so the next one isn't
+        // known to follow this one directly.
+        index->entries[i + 1].contiguous = 0;
+    }
+    index->last = i;
+}
+
+/**
+ * @return number of entries at or before the given time
+ */
+size_t seek_index_find_time(SeekIndex *index, int64_t time_ms) {
+    size_t low = 0, high = index->len;
+    while (low < high) {
+        size_t mid = (low + high) / 2;
+        if (index->entries[mid].time_ms <= time_ms) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+/**
+ * @return offset of the last entry at or before the given time, or -1
+ *         if that part of the stream hasn't been fully indexed
+ */
+int64_t seek_index_lookup(SeekIndex *index, int64_t time_ms) {
+    size_t i = seek_index_find_time(index, time_ms);
+    if (i == 0 || i == index->len) {
+        return -1;
+    }
+    // Only trust it if nothing could be hiding between the two entries
+    // around the target.
+    if (!index->entries[i].contiguous) {
+        return -1;
+    }
+    return index->entries[i - 1].offset;
+}
+
+/**
+ * Note that whatever gets added next doesn't directly follow what
+ * came before, e.g. after a seek.
+ */
+void seek_index_break(SeekIndex *index) {
+    index->last = -1;
+}
+
+void seek_index_free(SeekIndex *index) {
+    free(index->entries);
+    index->entries = NULL;
+    index->len = 0;
+    index->max = 0;
+    index->last = -1;
+}
+
+static char *write_u32(char *dest, uint32_t val) {
+    for (int i = 0; i < 4; i++) {
+        *dest++ = (char)(val >> (i * 8));
+    }
+    return dest;
+}
+
+static char *write_i64(char *dest, int64_t val) {
+    for (int i = 0; i < 8; i++) {
+        *dest++ = (char)((uint64_t)val >> (i * 8));
+    }
+    return dest;
+}
+
+static const char *read_u32(const char *src, uint32_t *val) {
+    *val = 0;
+    for (int i = 0; i < 4; i++) {
+        *val |= (uint32_t)(unsigned char)*src++ << (i * 8);
+    }
+    return src;
+}
+
+static const char *read_i64(const char *src, int64_t *val) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; i++) {
+        v |= (uint64_t)(unsigned char)*src++ << (i * 8);
+    }
+    *val = (int64_t)v;
+    return src;
+}
+
+size_t seek_index_export_size(SeekIndex **indexes, int count) {
+    size_t size = SEEK_INDEX_HEADER_SIZE;
+    for (int n = 0; n < count; n++) {
+        size += SEEK_INDEX_LIST_SIZE + indexes[n]->len * SEEK_INDEX_ENTRY_SIZE;
+    }
+    return size;
+}
+
+/**
+ * Write out the given lists; buffer must have room for
+ * seek_index_export_size() bytes.
+ */
+void seek_index_export(SeekIndex **indexes, int count, char *buffer) {
+    memcpy(buffer, "OGVI", 4);
+    char *dest = write_u32(buffer + 4, SEEK_INDEX_VERSION);
+    dest = write_u32(dest, count);
+    for (int n = 0; n < count; n++) {
+        dest = write_u32(dest, indexes[n]->len);
+        for (size_t i = 0; i < indexes[n]->len; i++) {
+            SeekIndexEntry *entry = &indexes[n]->entries[i];
+            dest = write_i64(dest, entry->timecode);
+            dest = write_i64(dest, entry->time_ms);
+            dest = write_i64(dest, entry->offset);
+            *dest++ = (char)entry->contiguous;
+        }
+    }
+}
+
+/**
+ * Merge previously exported lists into ours.
+ * @return 1 on success, 0 if the data isn't a valid index for these lists
+ */
+int seek_index_import(SeekIndex **indexes, int count, const char *buffer, size_t len) {
+    uint32_t version, lists;
+    if (len < SEEK_INDEX_HEADER_SIZE || memcmp(buffer, "OGVI", 4) != 0) {
+        return 0;
+    }
+    const char *src = read_u32(buffer + 4, &version);
+    src = read_u32(src, &lists);
+    if (version != SEEK_INDEX_VERSION || lists != (uint32_t)count) {
+        return 0;
+    }
+
+    // Check the whole thing fits before touching anything.
+    const char *end = buffer + len;
+    const char *check = src;
+    for (int n = 0; n < count; n++) {
+        uint32_t entries;
+        if (end - check < SEEK_INDEX_LIST_SIZE) {
+            return 0;
+        }
+        check = read_u32(check, &entries);
+        if ((size_t)(end - check) / SEEK_INDEX_ENTRY_SIZE < entries) {
+            return 0;
+        }
+        check += (size_t)entries * SEEK_INDEX_ENTRY_SIZE;
+    }
+
+    for (int n = 0; n < count; n++) {
+        SeekIndex *index = indexes[n];
+        int64_t lastOffset = index->last >= 0 ? index->entries[index->last].offset : -1;
+        uint32_t entries;
+        src = read_u32(src, &entries);
+        index->last = -1;
+        for (uint32_t i = 0; i < entries; i++) {
+            int64_t timecode, time_ms, offset;
+            src = read_i64(src, &timecode);
+            src = read_i64(src, &time_ms);
+            src = read_i64(src, &offset);
+            int contiguous = *src++;
+            if (!contiguous) {
+                index->last = -1;
+            }
+            seek_index_add(index, timecode, time_ms, offset);
+        }
+        // Keep tracking the pass we were in the middle of, if any.
+        index->last = lastOffset >= 0 ? (long)seek_index_find_offset(index, lastOffset) : -1;
+    }
+    return 1;
+}
@@ -0,0 +1,33 @@
+#include <stddef.h>
+#include <stdint.h>
+
+// Byte offsets of seek points (keyframes, pages, clusters) seen while
+// demuxing, kept sorted by offset, which is also time order.
+typedef struct {
+    // Container-level position: granulepos for Ogg, cluster timecode for WebM.
+    int64_t timecode;
+    int64_t time_ms;
+    int64_t offset;
+    // Set if no entry of this kind can exist between this one and the
+    // one before it, i.e. both were read in one linear pass.
+    int contiguous;
+} SeekIndexEntry;
+
+typedef struct {
+    SeekIndexEntry *entries;
+    size_t len;
+    size_t max;
+    // Last entry added since the last break, or -1.
+    long last;
+} SeekIndex;
+
+extern void seek_index_init(SeekIndex *index);
+extern void seek_index_add(SeekIndex *index, int64_t timecode, int64_t time_ms, int64_t offset);
+extern size_t seek_index_find_time(SeekIndex *index, int64_t time_ms);
+extern int64_t seek_index_lookup(SeekIndex *index, int64_t time_ms);
+extern void seek_index_break(SeekIndex *index);
+extern void seek_index_free(SeekIndex *index);
+
+extern size_t seek_index_export_size(SeekIndex **indexes, int count);
+extern void seek_index_export(SeekIndex **indexes, int count, char *buffer);
+extern int seek_index_import(SeekIndex **indexes, int count, const char *buffer, size_t len);
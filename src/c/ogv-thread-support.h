@@ -1,51 +1,110 @@
 #include <stdlib.h>
 
+#include "ogv-frame-ring.h"
+
+// Per-stream decode thread glue shared by the Theora, VP8/VP9 and AV1
+// decoders. The including file defines its codec state as DecoderState
+// first; it ends up embedded in each OGVVideoDecoder as decoder->state.
+// Codecs with header packets define OGV_VIDEO_DECODER_HEADERS and their
+// own ogv_video_decoder_process_header.
+
 #ifdef __EMSCRIPTEN_PTHREADS__
 #include <emscripten/emscripten.h>
 #include <emscripten/threading.h>
+#include <math.h>
 #include <pthread.h>
-
-static double cpu_time = 0.0;
-static double cpu_delta = 0.0;
-
-static pthread_t decode_thread;
-static pthread_mutex_t decode_mutex; // to hold critical section
-static pthread_cond_t ping_cond; // to trigger on new input
+#include <stdatomic.h>
+#include <stdint.h>
 
 typedef struct {
 	const char *data;
 	size_t data_len;
 } decode_queue_t;
 
-// Leave lots of room since this is a static buffer for now.
-// Maybe it should be a linked list.
-static const int decode_queue_size = 128;
-static decode_queue_t decode_queue[decode_queue_size];
-static int decode_queue_start = 0;
-static int decode_queue_end = 0;
+// Bounded single-producer (main thread), single-consumer (decode thread)
+// ring. Must be a power of two. The producer only writes decode_queue_end
+// and the consumer only writes decode_queue_start, so no lock is needed.
+// One slot is always kept free for the shutdown request.
+#define DECODE_QUEUE_SIZE 128
+
+// data_len of the NULL packet that tells the decode thread to exit.
+#define DECODE_QUEUE_SHUTDOWN ((size_t)-1)
+
+// Completion message for the main thread. Records are recycled through
+// the decoder's free list, so decoding doesn't allocate one per frame.
+typedef struct main_thread_call {
+	OGVVideoDecoder *decoder;
+	void *user_data;
+	struct main_thread_call *next;
+	int pooled;
+} main_thread_call_t;
+#endif
+
+struct OGVVideoDecoder {
+	DecoderState state;
+
+	// Cropped output frames; only touched from the main thread.
+	FrameRing frames;
+
+	// Heap space the demuxer writes packets into for in-place decoding.
+	// Queued packets may point into it, so it lives until the decoder
+	// itself is torn down.
+	void *packet_arena;
+
+#ifdef __EMSCRIPTEN_PTHREADS__
+	double cpu_time;
+	double cpu_delta;
+
+	pthread_t decode_thread;
+
+	decode_queue_t decode_queue[DECODE_QUEUE_SIZE];
+	_Atomic uint32_t decode_queue_start;
+	_Atomic uint32_t decode_queue_end;
+
+	// Set while the decode thread is parked on decode_queue_end.
+	_Atomic int decode_thread_waiting;
+
+	// Queue stats, readable from the main thread.
+	_Atomic int decode_queue_max_depth;
+	_Atomic int decode_queue_full_count;
+	_Atomic int64_t decode_queue_wait_us;
 
+	// Expected time between frames, set from the main thread, for
+	// decoders that size their worker threads to keep up.
+	_Atomic int frame_duration_us;
+
+	// Completion records the main thread has handed back.
+	pthread_mutex_t call_mutex;
+	main_thread_call_t *call_free;
+#else
+	int process_frame_status;
+#endif
+};
+
+#ifdef __EMSCRIPTEN_PTHREADS__
 static void *decode_thread_run(void *arg);
 #endif
 
-static void do_init(void);
-static void do_destroy(void);
-static void process_frame_decode(const char *data, size_t data_len);
-static int process_frame_return(void *user_data);
+static void do_init(OGVVideoDecoder *decoder);
+static void do_destroy(OGVVideoDecoder *decoder);
+static void process_frame_decode(OGVVideoDecoder *decoder, const char *data, size_t data_len);
+static int process_frame_return(OGVVideoDecoder *decoder, void *user_data);
 
-void ogv_video_decoder_init(void) {
+OGVVideoDecoder *ogv_video_decoder_create(void) {
+	OGVVideoDecoder *decoder = calloc(1, sizeof(OGVVideoDecoder));
 #ifdef __EMSCRIPTEN_PTHREADS__
-	pthread_mutex_init(&decode_mutex, NULL);
-	pthread_cond_init(&ping_cond, NULL);
-	int ret = pthread_create(&decode_thread, NULL, decode_thread_run, NULL);
+	pthread_mutex_init(&decoder->call_mutex, NULL);
+	int ret = pthread_create(&decoder->decode_thread, NULL, decode_thread_run, decoder);
 	if (ret) {
 		abort();
 	}
 #else
-  do_init();
+  do_init(decoder);
 #endif
+	return decoder;
 }
 
-int ogv_video_decoder_async(void) {
+int ogv_video_decoder_async(OGVVideoDecoder *decoder) {
 #ifdef __EMSCRIPTEN_PTHREADS__
 	return 1;
 #else
@@ -53,84 +112,236 @@ int ogv_video_decoder_async(void) {
 #endif
 }
 
-void ogv_video_decoder_destroy(void) {
-	do_destroy();
 #ifdef __EMSCRIPTEN_PTHREADS__
-	pthread_exit(NULL);
+static void decode_queue_push(OGVVideoDecoder *decoder, const char *data, size_t data_len);
+#endif
+
+void ogv_video_decoder_destroy(OGVVideoDecoder *decoder) {
+#ifdef __EMSCRIPTEN_PTHREADS__
+	// Anything still queued is decoded first; the decode thread then
+	// hands the decoder back to the main thread to be torn down, after
+	// the completions it has already sent.
+	decode_queue_push(decoder, NULL, DECODE_QUEUE_SHUTDOWN);
+#else
+	do_destroy(decoder);
+	frame_ring_free(&decoder->frames);
+	free(decoder->packet_arena);
+	free(decoder);
+#endif
+}
+
+void *ogv_video_decoder_alloc_packet_arena(OGVVideoDecoder *decoder, size_t size) {
+	if (!decoder->packet_arena) {
+		decoder->packet_arena = malloc(size);
+	}
+	return decoder->packet_arena;
+}
+
+void ogv_video_decoder_release_frame(OGVVideoDecoder *decoder, int slot, unsigned int serial) {
+	frame_ring_release(&decoder->frames, slot, serial);
+}
+
+void ogv_video_decoder_set_rgba_output(OGVVideoDecoder *decoder, int enabled,
+                                       int width, int height,
+                                       int matrix, int fullRange) {
+	rgba_output_configure(&decoder->frames.rgba, enabled, width, height, matrix, fullRange);
+}
+
+void ogv_video_decoder_set_frame_duration(OGVVideoDecoder *decoder, double ms) {
+#ifdef __EMSCRIPTEN_PTHREADS__
+	atomic_store(&decoder->frame_duration_us, (int)(ms * 1000.0));
+#else
+	// nothing to schedule when single-threaded
 #endif
 }
 
 
-int ogv_video_decoder_process_header(const char *data, size_t data_len) {
+#ifndef OGV_VIDEO_DECODER_HEADERS
+int ogv_video_decoder_process_header(OGVVideoDecoder *decoder, const char *data, size_t data_len) {
 	// no header packets for VP8/VP9/AV1
 	return 0;
 }
+#endif
 
 #ifdef __EMSCRIPTEN_PTHREADS__
 
-// Send to background worker, then wake main thread on callback
-int ogv_video_decoder_process_frame(const char *data, size_t data_len) {
-	pthread_mutex_lock(&decode_mutex);
+static void decode_queue_push(OGVVideoDecoder *decoder, const char *data, size_t data_len) {
+	uint32_t end = atomic_load_explicit(&decoder->decode_queue_end, memory_order_relaxed);
+	decoder->decode_queue[end & (DECODE_QUEUE_SIZE - 1)].data = data;
+	decoder->decode_queue[end & (DECODE_QUEUE_SIZE - 1)].data_len = data_len;
+	atomic_store(&decoder->decode_queue_end, end + 1);
+
+	// Only pay for a wake when the decode thread is actually parked.
+	if (atomic_load(&decoder->decode_thread_waiting)) {
+		emscripten_futex_wake((volatile void *)&decoder->decode_queue_end, 1);
+	}
+}
+
+// Send to background worker, then wake main thread on callback.
+// Returns 0 without queueing anything if the decode queue is full;
+// the caller should hold on to the packet and try again after the
+// next completion callback.
+int ogv_video_decoder_process_frame(OGVVideoDecoder *decoder, const char *data, size_t data_len) {
+	uint32_t end = atomic_load_explicit(&decoder->decode_queue_end, memory_order_relaxed);
+	uint32_t start = atomic_load_explicit(&decoder->decode_queue_start, memory_order_acquire);
+	uint32_t depth = end - start;
+	if (depth >= DECODE_QUEUE_SIZE - 1) {
+		atomic_fetch_add_explicit(&decoder->decode_queue_full_count, 1, memory_order_relaxed);
+		return 0;
+	}
 
-	decode_queue[decode_queue_end].data = data;
-	decode_queue[decode_queue_end].data_len = data_len;
-	decode_queue_end = (decode_queue_end + 1) % decode_queue_size;
+	if ((int)depth + 1 > atomic_load_explicit(&decoder->decode_queue_max_depth, memory_order_relaxed)) {
+		atomic_store_explicit(&decoder->decode_queue_max_depth, depth + 1, memory_order_relaxed);
+	}
 
-	pthread_cond_signal(&ping_cond);
-	pthread_mutex_unlock(&decode_mutex);
+	decode_queue_push(decoder, data, data_len);
 	return 1;
 }
 
-static void main_thread_return(void *user_data, float delta) {
-	int ret = process_frame_return(user_data);
+// Takes a completion record off the free list, or makes a new one until
+// there are enough for as many as are ever in flight at once.
+static main_thread_call_t *call_alloc(OGVVideoDecoder *decoder) {
+	pthread_mutex_lock(&decoder->call_mutex);
+	main_thread_call_t *call = decoder->call_free;
+	if (call) {
+		decoder->call_free = call->next;
+	}
+	pthread_mutex_unlock(&decoder->call_mutex);
+	if (!call) {
+		call = malloc(sizeof(main_thread_call_t));
+	}
+	return call;
+}
+
+static void call_recycle(OGVVideoDecoder *decoder, main_thread_call_t *call) {
+	pthread_mutex_lock(&decoder->call_mutex);
+	call->next = decoder->call_free;
+	decoder->call_free = call;
+	pthread_mutex_unlock(&decoder->call_mutex);
+}
+
+static void main_thread_return(void *arg, float delta) {
+	main_thread_call_t *call = (main_thread_call_t *)arg;
+	OGVVideoDecoder *decoder = call->decoder;
+	void *user_data = call->user_data;
+	if (call->pooled) {
+		call_recycle(decoder, call);
+	}
+	int ret = process_frame_return(decoder, user_data);
+
+	ogvjs_callback_async_complete(decoder, ret, (double)delta);
+}
 
-	ogvjs_callback_async_complete(ret, (double)delta);
+static void main_thread_destroy(void *arg, float delta) {
+	OGVVideoDecoder *decoder = (OGVVideoDecoder *)arg;
+	pthread_join(decoder->decode_thread, NULL);
+	do_destroy(decoder);
+	frame_ring_free(&decoder->frames);
+	// Only now is nothing left decoding out of the arena.
+	free(decoder->packet_arena);
+	// Completions sent before this have all run, so every record is
+	// back on the free list.
+	while (decoder->call_free) {
+		main_thread_call_t *next = decoder->call_free->next;
+		free(decoder->call_free);
+		decoder->call_free = next;
+	}
+	pthread_mutex_destroy(&decoder->call_mutex);
+	free(decoder);
 }
 
 static void *decode_thread_run(void *arg) {
-	do_init();
+	OGVVideoDecoder *decoder = (OGVVideoDecoder *)arg;
+	do_init(decoder);
+	uint32_t start = 0;
 	while (1) {
-		pthread_mutex_lock(&decode_mutex);
-		while (decode_queue_end == decode_queue_start) {
-			pthread_cond_wait(&ping_cond, &decode_mutex);
+		uint32_t end = atomic_load_explicit(&decoder->decode_queue_end, memory_order_acquire);
+		if (end == start) {
+			// Park until the producer moves the end marker.
+			// The futex wait returns at once if it already has.
+			double wait_start = emscripten_get_now();
+			atomic_store(&decoder->decode_thread_waiting, 1);
+			end = atomic_load(&decoder->decode_queue_end);
+			while (end == start) {
+				emscripten_futex_wait((volatile void *)&decoder->decode_queue_end, end, INFINITY);
+				end = atomic_load(&decoder->decode_queue_end);
+			}
+			atomic_store(&decoder->decode_thread_waiting, 0);
+			atomic_fetch_add_explicit(&decoder->decode_queue_wait_us,
+			                          (int64_t)((emscripten_get_now() - wait_start) * 1000.0),
+			                          memory_order_relaxed);
+		}
+
+		// Drain everything queued so far as one batch, without going
+		// back to the shared end marker or the futex between packets.
+		while (start != end) {
+			decode_queue_t item = decoder->decode_queue[start & (DECODE_QUEUE_SIZE - 1)];
+			// Free the slot before decoding so a completion callback
+			// for this packet always finds room for the next one.
+			start++;
+			atomic_store_explicit(&decoder->decode_queue_start, start, memory_order_release);
+
+			if (!item.data && item.data_len == DECODE_QUEUE_SHUTDOWN) {
+				emscripten_async_run_in_main_runtime_thread_(EM_FUNC_SIG_VIF, main_thread_destroy, decoder, 0.0f);
+				return NULL;
+			}
+
+			decoder->cpu_time = emscripten_get_now() - decoder->cpu_delta;
+			process_frame_decode(decoder, item.data, item.data_len);
+			// Capture any CPU time that didn't result in a frame
+			decoder->cpu_delta = emscripten_get_now() - decoder->cpu_time;
 		}
-		decode_queue_t item;
-		item = decode_queue[decode_queue_start];
-		decode_queue_start = (decode_queue_start + 1) % decode_queue_size;
-		pthread_mutex_unlock(&decode_mutex);
-
-		cpu_time = emscripten_get_now() - cpu_delta;
-		process_frame_decode(item.data, item.data_len);
-		// Capture any CPU time that didn't result in a frame
-		cpu_delta = emscripten_get_now() - cpu_time;
 	}
+	return NULL;
+}
+
+static void thread_stats(OGVVideoDecoder *decoder) {
+	uint32_t end = atomic_load(&decoder->decode_queue_end);
+	uint32_t start = atomic_load(&decoder->decode_queue_start);
+	ogvjs_callback_stat(decoder, "queueDepth", end - start);
+	ogvjs_callback_stat(decoder, "queueMaxDepth", atomic_load(&decoder->decode_queue_max_depth));
+	ogvjs_callback_stat(decoder, "queueFull", atomic_load(&decoder->decode_queue_full_count));
+	ogvjs_callback_stat(decoder, "queueWaitTime", atomic_load(&decoder->decode_queue_wait_us) / 1000.0);
 }
 
-static void call_main_return(void *user_data, int sync) {
+static void call_main_return(OGVVideoDecoder *decoder, void *user_data, int sync) {
 	double right_now = emscripten_get_now();
-	double delta = right_now - cpu_time;
-	cpu_time = right_now;
+	double delta = right_now - decoder->cpu_time;
+	decoder->cpu_time = right_now;
+	main_thread_call_t local;
+	main_thread_call_t *call = sync ? NULL : call_alloc(decoder);
+	if (!call) {
+		// Synchronous calls, and any we can't get a record for, wait on
+		// the main thread with the record on our stack.
+		call = &local;
+		sync = 1;
+	}
+	call->decoder = decoder;
+	call->user_data = user_data;
+	call->pooled = (call != &local);
 	if (sync) {
-		emscripten_sync_run_in_main_runtime_thread_(EM_FUNC_SIG_VIF, main_thread_return, user_data, (float)delta);
+		emscripten_sync_run_in_main_runtime_thread_(EM_FUNC_SIG_VIF, main_thread_return, call, (float)delta);
 	} else {
-		emscripten_async_run_in_main_runtime_thread_(EM_FUNC_SIG_VIF, main_thread_return, user_data, (float)delta);
+		emscripten_async_run_in_main_runtime_thread_(EM_FUNC_SIG_VIF, main_thread_return, call, (float)delta);
 	}
 }
 
 #else
 
-static int process_frame_status = 0;
-
 // Single-threaded
-int ogv_video_decoder_process_frame(const char *data, size_t data_len) {
-	process_frame_status = 0;
-	process_frame_decode(data, data_len);
-	return process_frame_status;
+int ogv_video_decoder_process_frame(OGVVideoDecoder *decoder, const char *data, size_t data_len) {
+	decoder->process_frame_status = 0;
+	process_frame_decode(decoder, data, data_len);
+	return decoder->process_frame_status;
 }
 
-static void call_main_return(void *user_data, int sync) {
+static void call_main_return(OGVVideoDecoder *decoder, void *user_data, int sync) {
 	(void)sync;
-	process_frame_status = process_frame_return(user_data);
+	decoder->process_frame_status = process_frame_return(decoder, user_data);
+}
+
+static void thread_stats(OGVVideoDecoder *decoder) {
+	// no queue when single-threaded
 }
 
 #endif
@@ -0,0 +1,73 @@
+/**
+ * Maps time in the audio queued for playback back to stream time, for
+ * audio that the decoder has already sped up or slowed down.
+ *
+ * Kept as a piecewise-linear list of [output, stream] time points, one
+ * per change in tempo; past either end, time runs at normal speed.
+ */
+class OGVAudioTimeMap {
+	constructor() {
+		this.reset(0);
+	}
+
+	/**
+	 * Start over, with the next audio queued to play at output time.
+	 *
+	 * @param number output seconds
+	 */
+	reset(output) {
+		this._points = [[output, 0]];
+	}
+
+	/**
+	 * Record a buffer queued for playback.
+	 *
+	 * @param number outputDuration seconds of audio queued
+	 * @param number streamDuration seconds of the stream it covers
+	 */
+	append(outputDuration, streamDuration) {
+		if (outputDuration <= 0) {
+			return;
+		}
+		let points = this._points,
+			last = points[points.length - 1],
+			next = [last[0] + outputDuration, last[1] + streamDuration];
+		if (points.length > 1) {
+			// Extend the last segment if the tempo hasn't changed.
+			let prev = points[points.length - 2],
+				slope = (last[1] - prev[1]) / (last[0] - prev[0]);
+			if (Math.abs(slope - streamDuration / outputDuration) < 1e-6) {
+				points[points.length - 1] = next;
+				return;
+			}
+		}
+		points.push(next);
+	}
+
+	/**
+	 * Stream time for a playback position, relative to the last reset.
+	 * Points before the position are dropped, so positions asked for
+	 * should only go forward.
+	 *
+	 * @param number output seconds
+	 * @return number stream seconds
+	 */
+	map(output) {
+		let points = this._points;
+		while (points.length > 2 && points[1][0] <= output) {
+			points.shift();
+		}
+		let i = 0;
+		if (points.length > 1 && output >= points[1][0]) {
+			i = 1;
+		}
+		let start = points[i],
+			end = points[i + 1];
+		if (!end || output < start[0]) {
+			return start[1] + (output - start[0]);
+		}
+		return start[1] + (output - start[0]) * (end[1] - start[1]) / (end[0] - start[0]);
+	}
+}
+
+export default OGVAudioTimeMap;
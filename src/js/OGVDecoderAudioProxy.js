@@ -4,6 +4,7 @@ class OGVDecoderAudioProxy extends OGVProxyClass({
 	loadedMetadata: false,
 	audioFormat: null,
 	audioBuffer: null,
+	audioBufferDuration: 0,
 	cpuTime: 0
 }) {
 	init(callback) {
@@ -11,11 +12,27 @@ class OGVDecoderAudioProxy extends OGVProxyClass({
 	}
 
 	processHeader(data, callback) {
-		this.proxy('processHeader', [data], callback, [data]);
+		this.proxy('processHeader', [data], callback, this.packetTransfers(data));
 	}
 
-	processAudio(data, callback) {
-		this.proxy('processAudio', [data], callback, [data]);
+	processAudio(data, discardPadding, callback) {
+		this.proxy('processAudio', [data, discardPadding], callback, this.packetTransfers(data));
+	}
+
+	drain(callback) {
+		this.proxy('drain', [], callback);
+	}
+
+	setOutputRate(rate) {
+		this.proxy('setOutputRate', [rate], () => {});
+	}
+
+	setTempo(tempo) {
+		this.proxy('setTempo', [tempo], () => {});
+	}
+
+	flush() {
+		this.proxy('flush', [], () => {});
 	}
 
 	close() {
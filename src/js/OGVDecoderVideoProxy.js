@@ -4,18 +4,19 @@ class OGVDecoderVideoProxy extends OGVProxyClass({
 	loadedMetadata: false,
 	videoFormat: null,
 	frameBuffer: null,
-	cpuTime: 0
+	cpuTime: 0,
+	decoderStats: {}
 }) {
 	init(callback) {
 		this.proxy('init', [], callback);
 	}
 
 	processHeader(data, callback) {
-		this.proxy('processHeader', [data], callback, [data]);
+		this.proxy('processHeader', [data], callback, this.packetTransfers(data));
 	}
 
 	processFrame(data, callback) {
-		this.proxy('processFrame', [data], callback, [data]);
+		this.proxy('processFrame', [data], callback, this.packetTransfers(data));
 	}
 
 	close() {
@@ -26,12 +27,21 @@ class OGVDecoderVideoProxy extends OGVProxyClass({
 		this.proxy('sync', [], () => {});
 	}
 
-	recycleFrame(frame) {
-		this.proxy('recycleFrame', [frame], () => {}, [
-			frame.y.bytes.buffer,
-			frame.u.bytes.buffer,
-			frame.v.bytes.buffer
-		]);
+	setFrameDuration(ms) {
+		this.proxy('setFrameDuration', [ms], () => {});
+	}
+
+	setRGBAOutput(enabled, width, height, matrix, fullRange) {
+		this.proxy('setRGBAOutput', [enabled, width, height, matrix, fullRange], () => {});
+	}
+
+	acquireFrame() {
+		// Frames come across already copied out of the worker's heap.
+		return this.frameBuffer;
+	}
+
+	releaseFrame(frame) {
+		// Nothing to hand back.
 	}
 }
 
@@ -0,0 +1,110 @@
+/**
+ * Bounded FIFO of live input chunks pushed in by the host page,
+ * with enough bookkeeping to estimate where the live edge is.
+ *
+ * @params options object {
+ *   maxBytes: number; queued bytes beyond which push() refuses input
+ * }
+ */
+class OGVLiveQueue {
+	constructor(options = {}) {
+		this.maxBytes = options.maxBytes || 8 * 1024 * 1024;
+		this.clear();
+	}
+
+	clear() {
+		this._chunks = [];
+		this.byteLength = 0;
+		this.overflows = 0;
+		this.ended = false;
+
+		// Media time of the newest chunk, if the host told us.
+		this.newestTimestamp = -1;
+
+		// Otherwise we assume a live source produces media in real
+		// time, and extrapolate from the chunk arrival times.
+		this._baseTimestamp = -1;
+		this._firstArrival = -1;
+		this._lastArrival = -1;
+	}
+
+	get length() {
+		return this._chunks.length;
+	}
+
+	/**
+	 * Queue a chunk of input.
+	 *
+	 * @param ArrayBuffer data
+	 * @param number timestamp media time in seconds at the end of the chunk, or -1
+	 * @param number now arrival time in ms
+	 * @return boolean false if the queue is full; caller should retry later
+	 */
+	push(data, timestamp, now) {
+		if (this.byteLength && this.byteLength + data.byteLength > this.maxBytes) {
+			this.overflows++;
+			return false;
+		}
+		this._chunks.push(data);
+		this.byteLength += data.byteLength;
+		if (timestamp >= 0) {
+			this.newestTimestamp = Math.max(this.newestTimestamp, timestamp);
+		}
+		if (this._firstArrival < 0) {
+			this._firstArrival = now;
+		}
+		this._lastArrival = now;
+		return true;
+	}
+
+	/**
+	 * Take everything queued as a single buffer, so the demuxer sees
+	 * one input call however many chunks arrived in the meantime.
+	 *
+	 * @return ArrayBuffer or null if empty
+	 */
+	drain() {
+		let chunks = this._chunks;
+		if (!chunks.length) {
+			return null;
+		}
+		let data = chunks[0];
+		if (chunks.length > 1) {
+			let bytes = new Uint8Array(this.byteLength),
+				offset = 0;
+			chunks.forEach((chunk) => {
+				bytes.set(new Uint8Array(chunk), offset);
+				offset += chunk.byteLength;
+			});
+			data = bytes.buffer;
+		}
+		this._chunks = [];
+		this.byteLength = 0;
+		return data;
+	}
+
+	/**
+	 * Anchor arrival-time extrapolation to the media time at which
+	 * the first received chunk starts playing.
+	 */
+	calibrate(timestamp) {
+		if (this._baseTimestamp < 0 && this._firstArrival >= 0) {
+			this._baseTimestamp = timestamp;
+		}
+	}
+
+	/**
+	 * Media time of the newest received data in seconds, or -1 if unknown.
+	 */
+	get liveEdge() {
+		if (this.newestTimestamp >= 0) {
+			return this.newestTimestamp;
+		}
+		if (this._baseTimestamp >= 0) {
+			return this._baseTimestamp + (this._lastArrival - this._firstArrival) / 1000;
+		}
+		return -1;
+	}
+}
+
+export default OGVLiveQueue;
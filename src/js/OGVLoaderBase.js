@@ -9,10 +9,15 @@ const scriptMap = {
 	OGVDemuxerWebMW: 'ogv-demuxer-webm-wasm.js',
 	OGVDecoderAudioOpus: 'ogv-decoder-audio-opus.js',
 	OGVDecoderAudioOpusW: 'ogv-decoder-audio-opus-wasm.js',
+	OGVDecoderAudioOpusSIMDW: 'ogv-decoder-audio-opus-simd-wasm.js',
 	OGVDecoderAudioVorbis: 'ogv-decoder-audio-vorbis.js',
 	OGVDecoderAudioVorbisW: 'ogv-decoder-audio-vorbis-wasm.js',
+	OGVDecoderAudioVorbisSIMDW: 'ogv-decoder-audio-vorbis-simd-wasm.js',
 	OGVDecoderVideoTheora: 'ogv-decoder-video-theora.js',
 	OGVDecoderVideoTheoraW: 'ogv-decoder-video-theora-wasm.js',
+	OGVDecoderVideoTheoraSIMDW: 'ogv-decoder-video-theora-simd-wasm.js',
+	OGVDecoderVideoTheoraMTW: 'ogv-decoder-video-theora-mt-wasm.js',
+	OGVDecoderVideoTheoraSIMDMTW: 'ogv-decoder-video-theora-simd-mt-wasm.js',
 	OGVDecoderVideoVP8: 'ogv-decoder-video-vp8.js',
 	OGVDecoderVideoVP8W: 'ogv-decoder-video-vp8-wasm.js',
 	OGVDecoderVideoVP8MTW: 'ogv-decoder-video-vp8-mt-wasm.js',
@@ -20,10 +20,13 @@ const proxyInfo = {
 const proxyTypes = {
 	OGVDecoderAudioOpus: 'audio',
 	OGVDecoderAudioOpusW: 'audio',
+	OGVDecoderAudioOpusSIMDW: 'audio',
 	OGVDecoderAudioVorbis: 'audio',
 	OGVDecoderAudioVorbisW: 'audio',
+	OGVDecoderAudioVorbisSIMDW: 'audio',
 	OGVDecoderVideoTheora: 'video',
 	OGVDecoderVideoTheoraW: 'video',
+	OGVDecoderVideoTheoraSIMDW: 'video',
 	OGVDecoderVideoVP8: 'video',
 	OGVDecoderVideoVP8W: 'video',
 	OGVDecoderVideoVP9: 'video',
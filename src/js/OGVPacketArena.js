@@ -0,0 +1,133 @@
+/* global SharedArrayBuffer */
+
+/**
+ * Ring of compressed packet storage shared between the demuxer and a
+ * decoder, so a packet is written once and read in place rather than
+ * sliced out of one heap and copied into another.
+ *
+ * Packets are handed out as Uint8Array views on the arena; each one is
+ * described by its offset and length, with the timestamps and keyframe
+ * flag riding along in the demuxer's packet queue. Space is reclaimed
+ * once the oldest packets have been released, so a packet that is
+ * consumed out of order just holds back the ring until the ones before
+ * it go too.
+ *
+ * The backing store may be a region of a decoder's own (shared) heap,
+ * or a standalone SharedArrayBuffer that can be posted to a worker
+ * without copying.
+ */
+class OGVPacketArena {
+	/**
+	 * @param {ArrayBuffer|SharedArrayBuffer} buffer
+	 * @param {number} byteOffset start of the arena within buffer
+	 * @param {number} byteLength size of the arena
+	 */
+	constructor(buffer, byteOffset, byteLength) {
+		this.buffer = buffer;
+		this.byteOffset = byteOffset;
+		this.byteLength = byteLength;
+
+		// Next write position, relative to byteOffset.
+		this.head = 0;
+
+		// Live packets in allocation order.
+		this.live = [];
+	}
+
+	/**
+	 * Create a standalone arena.
+	 *
+	 * @param {number} byteLength
+	 * @param {boolean} shared if true, only return an arena that can be
+	 *        shared with a worker without copying it
+	 * @returns {OGVPacketArena|null}
+	 */
+	static create(byteLength, shared) {
+		if (typeof SharedArrayBuffer === 'function' &&
+			(typeof crossOriginIsolated === 'undefined' || crossOriginIsolated)) {
+			try {
+				return new OGVPacketArena(new SharedArrayBuffer(byteLength), 0, byteLength);
+			} catch (e) {
+				// Fall through.
+			}
+		}
+		if (shared) {
+			return null;
+		}
+		return new OGVPacketArena(new ArrayBuffer(byteLength), 0, byteLength);
+	}
+
+	/**
+	 * Reserve space for a packet.
+	 *
+	 * @param {number} len
+	 * @returns {Uint8Array|null} view to write the packet into,
+	 *          or null if there's not enough room right now
+	 */
+	alloc(len) {
+		if (len <= 0) {
+			return null;
+		}
+		let offset = this.head;
+		if (this.live.length) {
+			let tail = this.live[0].offset;
+			if (offset >= tail) {
+				// Free space runs to the end, then wraps around to the tail.
+				if (offset + len > this.byteLength) {
+					if (len >= tail) {
+						return null;
+					}
+					offset = 0;
+				}
+			} else if (offset + len >= tail) {
+				return null;
+			}
+		} else {
+			offset = 0;
+			if (len > this.byteLength) {
+				return null;
+			}
+		}
+
+		let bytes = new Uint8Array(this.buffer, this.byteOffset + offset, len);
+		this.live.push({
+			offset: offset,
+			bytes: bytes,
+			released: false
+		});
+		this.head = offset + len;
+		return bytes;
+	}
+
+	/**
+	 * Give a packet's space back to the arena. Packets that didn't come
+	 * from this arena are ignored, so callers can release whatever they
+	 * were handed.
+	 *
+	 * @param {Uint8Array|ArrayBuffer} bytes
+	 */
+	release(bytes) {
+		if (!bytes || bytes.buffer !== this.buffer) {
+			return;
+		}
+		for (let i = 0; i < this.live.length; i++) {
+			if (this.live[i].bytes === bytes) {
+				this.live[i].released = true;
+				break;
+			}
+		}
+		while (this.live.length && this.live[0].released) {
+			this.live.shift();
+		}
+	}
+
+	/**
+	 * Drop all outstanding packets.
+	 */
+	reset() {
+		this.live.splice(0, this.live.length);
+		this.head = 0;
+	}
+}
+
+export default OGVPacketArena;
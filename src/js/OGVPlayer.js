@@ -8,10 +8,13 @@ import dynamicaudio_swf from 'audio-feeder/dist/dynamicaudio.swf';
 
 // Internal deps
 import OGVLoader from './OGVLoaderWeb.js';
+import OGVAudioTimeMap from './OGVAudioTimeMap.js';
 import Bisector from './Bisector.js';
 import extend from './extend.js';
+import OGVLiveQueue from './OGVLiveQueue.js';
 import OGVMediaError from './OGVMediaError.js';
 import OGVMediaType from './OGVMediaType.js';
+import OGVRGBAFrameSink from './OGVRGBAFrameSink.js';
 import OGVTimeRanges from './OGVTimeRanges.js';
 import OGVWrapperCodec from './OGVWrapperCodec.js';
 let sumanNum = 1;
@@ -92,6 +95,15 @@ OGVJSElement.prototype = Object.create(HTMLElement.prototype, {});
  *                 'base': string; base URL for additional resources, such as Flash audio shim
  *                 'webGL': bool; pass true to use WebGL acceleration if available
  *                 'forceWebGL': bool; pass true to require WebGL even if not detected
+ *                 'rgbaOutput': bool; without WebGL, have the decoder convert and downscale frames to RGBA
+ *                 'rgbaColorMatrix': string; 'bt601' (default) or 'bt709' for rgbaOutput
+ *                 'rgbaFullRange': bool; treat YUV input as full range for rgbaOutput
+ *                 'audioResample': bool; resample to the device rate and change live tempo in the audio decoder (default true)
+ *                 'liveTargetLatency': number; seconds behind the live edge to aim for (default 2)
+ *                 'liveMaxLatency': number; seconds behind at which to skip to a keyframe (default 3x target)
+ *                 'liveMaxTempo': number; cap on the catch-up speedup of the audio (default 1.25)
+ *                 'liveMaxQueueBytes': number; cap on input queued by pushLiveChunk (default 8 MiB)
+ *                 'liveInitSegment': ArrayBuffer; cached stream headers, for joining a live stream partway
  */
 class OGVPlayer extends OGVJSElement {
 	constructor(options) {
@@ -165,6 +177,8 @@ class OGVPlayer extends OGVJSElement {
 		this._videoInfo = null;
 		this._actionQueue = [];
 		this._audioFeeder = null;
+		this._audioOutputStage = false; // decoder resamples and changes tempo
+		this._audioTimeMap = new OGVAudioTimeMap();
 		this._muted = false;
 		this._initialPlaybackPosition = 0.0;
 		this._initialPlaybackOffset = 0.0;
@@ -176,6 +190,8 @@ class OGVPlayer extends OGVJSElement {
 		this._streamEnded = false;
 		this._mediaError = null;
 		this._dataEnded = false;
+		// Set once the decoder's held-back audio is collected at the end.
+		this._audioDrained = false;
 		this._byteLength = 0;
 		this._duration = null;
 		this._lastSeenTimestamp = null;
@@ -189,6 +205,19 @@ class OGVPlayer extends OGVJSElement {
 
 		this._stream = undefined;
 
+		// Live ingest, fed by pushLiveChunk()
+		this._liveQueue = new OGVLiveQueue({
+			maxBytes: options.liveMaxQueueBytes
+		});
+		this._liveTargetLatency = options.liveTargetLatency || 2; // s
+		this._liveMaxLatency = options.liveMaxLatency || this._liveTargetLatency * 3; // s
+		this._liveMaxTempo = options.liveMaxTempo || 1.25;
+		this._liveWaiting = false; // demuxer starved for input
+		this._liveSkipGoal = -1; // catching up to this media time, or -1
+		this._liveTempo = 1.0; // catch-up speedup on top of playbackRate
+		this._liveLatency = 0; // s
+		this._liveSkips = 0;
+
 		// Benchmark data, exposed via getPlaybackStats()
 		this._framesProcessed = 0; // frames
 		this._targetPerFrameTime = 1000 / 60; // ms
@@ -684,7 +713,7 @@ class OGVPlayer extends OGVJSElement {
 				set: function setPlaybackRate(val) {
 					var newRate = Number(val) || 1.0;
 					if (this._audioFeeder) {
-						this._audioFeeder.tempo = newRate;
+						this._audioFeeder.tempo = newRate * (this._audioOutputStage ? 1.0 : this._liveTempo);
 					} else if (!this._paused) { // Change while playing
 						// Move to the coordinate system created by the new tempo
 						this._initialPlaybackOffset = this._getPlaybackTime();
@@ -695,6 +724,16 @@ class OGVPlayer extends OGVJSElement {
 				}
 			},
 
+			/**
+			 * Seconds between the newest live input and the playback position
+			 * @property liveLatency {number}
+			 */
+			liveLatency: {
+				get: function getLiveLatency() {
+					return this._liveLatency;
+				}
+			},
+
 			/**
 			 * @property played {OGVTimeRanges}
 			 * @todo implement correctly more or less
@@ -949,6 +988,18 @@ class OGVPlayer extends OGVJSElement {
 		let audioFeeder = this._audioFeeder = new AudioFeeder(audioOptions);
 		audioFeeder.init(this._audioInfo.channels, this._audioInfo.rate);
 
+		// Have the decoder resample to the device rate and apply live
+		// catch-up tempo, so buffers go straight to the output queue.
+		this._audioOutputStage = options.audioResample !== false;
+		if (this._audioOutputStage) {
+			if (audioFeeder.targetRate && audioFeeder.targetRate != this._audioInfo.rate) {
+				this._codec.setAudioOutputRate(audioFeeder.targetRate);
+				audioFeeder.rate = audioFeeder.targetRate;
+			}
+			this._codec.setAudioTempo(this._liveTempo);
+			this._audioTimeMap.reset(0);
+		}
+
 		//Fire when _audioFeeder is populated
 		if (this.onaudiofeedercreated)
 			this.onaudiofeedercreated(this._audioFeeder);
@@ -966,7 +1017,7 @@ class OGVPlayer extends OGVJSElement {
 
 		audioFeeder.volume = this.volume;
 		audioFeeder.muted = this.muted;
-		audioFeeder.tempo = this.playbackRate;
+		audioFeeder.tempo = this.playbackRate * (this._audioOutputStage ? 1.0 : this._liveTempo);
 
 		// If we're in a background tab, timers may be throttled.
 		// audioFeeder will call us when buffers need refilling,
@@ -1008,7 +1059,7 @@ class OGVPlayer extends OGVJSElement {
 		if (this._audioFeeder) {
 			this._audioFeeder.start();
 			let state = this._audioFeeder.getPlaybackState();
-			this._initialPlaybackPosition = state.playbackPosition;
+			this._initialPlaybackPosition = this._audioPosition(state);
 		} else {
 			this._initialPlaybackPosition = this._playbackRate * getTimestamp() / 1000;
 		}
@@ -1040,7 +1091,7 @@ class OGVPlayer extends OGVJSElement {
 			let position;
 			if (this._audioFeeder) {
 				state = state || this._audioFeeder.getPlaybackState();
-				position = state.playbackPosition;
+				position = this._audioPosition(state);
 			} else {
 				// @fixme handle paused/stoped time better
 				position = this._playbackRate * getTimestamp() / 1000;
@@ -1049,6 +1100,53 @@ class OGVPlayer extends OGVJSElement {
 		}
 	}
 
+	/**
+	 * Audio feeder playback position in stream time, undoing any tempo
+	 * change the decoder made.
+	 *
+	 * @return {number} seconds
+	 */
+	_audioPosition(state) {
+		if (this._audioOutputStage) {
+			return this._audioTimeMap.map(state.playbackPosition);
+		}
+		return state.playbackPosition;
+	}
+
+	_flushAudioFeeder() {
+		this._audioFeeder.flush();
+		if (this._audioOutputStage) {
+			// Audio already handed to the device still plays out first.
+			let state = this._audioFeeder.getPlaybackState();
+			this._audioTimeMap.reset(state.playbackPosition +
+				this._audioFeeder.durationBuffered * this._audioFeeder.tempo);
+		}
+	}
+
+	/**
+	 * Queue the codec's last decoded audio for playback.
+	 *
+	 * @return {boolean} whether there was any
+	 */
+	_bufferDecodedAudio() {
+		let buffer = this._codec.audioBuffer;
+		if (!buffer) {
+			return false;
+		}
+		// Keep track of how much time we spend queueing audio as well
+		// This is slow when using the Flash shim on IE 10/11
+		this._bufferTime += this._time(() => {
+			if (this._audioFeeder) {
+				this._audioFeeder.bufferData(buffer);
+				if (this._audioOutputStage && buffer.length) {
+					this._audioTimeMap.append(buffer[0].length / this._audioFeeder.rate,
+						this._codec.audioBufferDuration);
+				}
+			}
+		});
+		return true;
+	}
+
 	// called when stopping old video on load()
 	_stopVideo() {
 		this._log("STOPPING");
@@ -1066,6 +1164,13 @@ class OGVPlayer extends OGVJSElement {
 		// Abort all queued actions
 		this._actionQueue.splice(0, this._actionQueue.length);
 
+		// Live input belongs to the old stream
+		this._liveQueue.clear();
+		this._liveWaiting = false;
+		this._liveSkipGoal = -1;
+		this._liveTempo = 1.0;
+		this._liveLatency = 0;
+
 		if (this._stream) {
 			// @todo fire an abort event if still loading
 			// @todo fire an emptied event if previously had data
@@ -1079,6 +1184,7 @@ class OGVPlayer extends OGVJSElement {
 			this._pendingFrame = 0;
 			this._pendingAudio = 0;
 			this._dataEnded = false;
+			this._audioDrained = false;
 		}
 		this._videoInfo = null;
 		this._audioInfo = null;
@@ -1179,7 +1285,7 @@ class OGVPlayer extends OGVJSElement {
 		}
 
 		if (this._codec && data.yCbCrBuffer) {
-			this._codec.recycleFrame(data.yCbCrBuffer);
+			this._codec.releaseFrame(data.yCbCrBuffer);
 		}
 	}
 
@@ -1192,6 +1298,7 @@ class OGVPlayer extends OGVJSElement {
 		}
 		this._streamEnded = false;
 		this._dataEnded = false;
+		this._audioDrained = false;
 		this._ended = false;
 		this._stream.seek(offset).then(() => {
 			this._readBytesAndWait();
@@ -1241,7 +1348,7 @@ class OGVPlayer extends OGVJSElement {
 			this._stopPlayback();
 			this._prebufferingAudio = false;
 			if (this._audioFeeder) {
-				this._audioFeeder.flush();
+				this._flushAudioFeeder();
 			}
 			this._state = State.SEEKING;
 			this._seekTargetTime = toTime;
@@ -1274,11 +1381,15 @@ class OGVPlayer extends OGVJSElement {
 	_doSeek(toTime) {
 		this._streamEnded = false;
 		this._dataEnded = false;
+		this._audioDrained = false;
 		this._ended = false;
 		this._state = State.SEEKING;
 		this._seekTargetTime = toTime;
 		this._lastSeekPosition = -1;
 
+		this._decodedFrames.forEach((frame) => {
+			this._codec.releaseFrame(frame.yCbCrBuffer);
+		});
 		this._decodedFrames = [];
 		this._pendingFrames = [];
 		this._pendingFrame = 0;
@@ -1373,6 +1484,7 @@ class OGVPlayer extends OGVJSElement {
 			// We landed between frames. Show the last frame.
 			let frame = this._decodedFrames.shift();
 			this._drawFrame(frame.yCbCrBuffer);
+			this._codec.releaseFrame(frame.yCbCrBuffer);
 			finishedSeeking();
 		} else if (this._codec.hasVideo && this._codec.frameReady) {
 			// Exact seek, no decoded frames.
@@ -1627,6 +1739,32 @@ class OGVPlayer extends OGVJSElement {
 		}
 
 		this._frameSink = YUVCanvas.attach(this._canvas, canvasOptions);
+		if (this._options.rgbaOutput && !(this._frameSink instanceof YUVCanvas.WebGLFrameSink)) {
+			this._frameSink = new OGVRGBAFrameSink(this._canvas);
+			this._setupRGBAOutput();
+		}
+	}
+
+	/**
+	 * Have the decoder convert frames for the RGBA frame sink, scaled
+	 * down to what the element shows in device pixels.
+	 */
+	_setupRGBAOutput() {
+		let info = this._videoInfo,
+			ratio = window.devicePixelRatio || 1,
+			scale = Math.min(1,
+				(this.offsetWidth || info.displayWidth) * ratio / info.displayWidth,
+				(this.offsetHeight || info.displayHeight) * ratio / info.displayHeight),
+			width = Math.max(1, Math.round(info.displayWidth * scale)),
+			height = Math.max(1, Math.round(info.displayHeight * scale));
+		if (width === info.cropWidth && height === info.cropHeight) {
+			// No scaling needed; this also follows resolution changes.
+			width = 0;
+			height = 0;
+		}
+		this._codec.setRGBAOutput(true, width, height,
+			this._options.rgbaColorMatrix === 'bt709' ? 1 : 0,
+			!!this._options.rgbaFullRange);
 	}
 
 	_doProcessing() {
@@ -1808,6 +1946,7 @@ class OGVPlayer extends OGVJSElement {
 						this._codec.flush(() => {
 							this._streamEnded = false;
 							this._dataEnded = false;
+							this._audioDrained = false;
 							this._seekStream(0);
 						});
 					}
@@ -1913,6 +2052,10 @@ class OGVPlayer extends OGVJSElement {
 			// ok we're done for now!
 			this._log('paused during playback; stopping loop');
 
+		} else if (this._liveSkipGoal >= 0) {
+
+			this._doProcessLiveSkip();
+
 		} else {
 
 			if ((!codec.hasAudio || codec.audioReady || this._pendingAudio || this._dataEnded) &&
@@ -1988,6 +2131,12 @@ class OGVPlayer extends OGVJSElement {
 					readyForAudioDecode = this._codec.audioReady && (this._audioEndTimestamp < playbackPosition);
 				}
 
+				if (!this._prebufferingAudio && this._updateLiveLatency(playbackPosition)) {
+					// Too far behind; skip ahead on the next pass.
+					this._pingProcessing();
+					return;
+				}
+
 				// console.log('suman ======> SUMAN DO PROECSS PLAY INVOKE ');
 				if (this._codec.hasVideo) {
 				//	console.log('======> SUMAN DO PROECSS PLAY INVOKE =====>');
@@ -2154,7 +2303,7 @@ class OGVPlayer extends OGVJSElement {
 								
 								// Save the buffer until it's time to draw
 								this._decodedFrames.push({
-									yCbCrBuffer: this._codec.frameBuffer,
+									yCbCrBuffer: this._codec.acquireFrame(),
 									videoCpuTime: this._codec.videoCpuTime,
 									frameEndTimestamp: nextFrameEndTimestamp
 								});
@@ -2199,16 +2348,8 @@ class OGVPlayer extends OGVJSElement {
 							this._audioEndTimestamp = nextAudioEndTimestamp;
 
 							if (ok) {
-								let buffer = this._codec.audioBuffer;
-								if (buffer) {
-									// console.log('suman suman media from player decode audio ');
-									// Keep track of how much time we spend queueing audio as well
-									// This is slow when using the Flash shim on IE 10/11
-									this._bufferTime += this._time(() => {
-										if (this._audioFeeder) {
-											this._audioFeeder.bufferData(buffer);
-										}
-									});
+								// console.log('suman suman media from player decode audio ');
+								if (this._bufferDecodedAudio()) {
 									if (!this._codec.hasVideo) {
 										this._framesProcessed++; // pretend!
 										let frame = {
@@ -2278,6 +2419,22 @@ class OGVPlayer extends OGVJSElement {
 						this._pingProcessing();
 					}, targetTimer);
 
+				} else if (this._dataEnded && !(this._pendingAudio || this._pendingFrame || this._decodedFrames.length) &&
+					codec.hasAudio && !codec.audioReady && !this._audioDrained) {
+
+					// Collect the tail end the decoder held back for
+					// resampling or tempo changes.
+					this._log('play loop: draining audio');
+					this._audioDrained = true;
+					this._pendingAudio++;
+					this._codec.drainAudio((ok) => {
+						this._pendingAudio--;
+						if (ok) {
+							this._bufferDecodedAudio();
+						}
+						this._pingProcessing();
+					});
+
 				} else if (this._dataEnded && !(this._pendingAudio || this._pendingFrame || this._decodedFrames.length)) {
 					this._log('play loop: playback reached end of data ' + [this._pendingAudio, this._pendingFrame, this._decodedFrames.length]);
 					let finalDelay = 0;
@@ -2324,6 +2481,123 @@ class OGVPlayer extends OGVJSElement {
 		}
 	}
 
+	/**
+	 * Track how far behind the live edge we're playing, and steer back
+	 * toward the target latency with a bounded audio speedup.
+	 *
+	 * @return boolean true if we need to skip ahead to a keyframe
+	 */
+	_updateLiveLatency(playbackPosition) {
+		let queue = this._liveQueue;
+		queue.calibrate(playbackPosition);
+		let edge = queue.liveEdge;
+		if (edge < 0) {
+			// Not a live stream, or no idea where the edge is.
+			return false;
+		}
+
+		let latency = this._liveLatency = Math.max(0, edge - playbackPosition),
+			excess = latency - this._liveTargetLatency;
+		if (latency > this._liveMaxLatency) {
+			this._log('live: ' + latency + 's behind, skipping ahead');
+			this._liveSkips++;
+			this._liveSkipGoal = playbackPosition + excess;
+			this._setLiveTempo(1.0);
+			return true;
+		}
+		if (excess > 0) {
+			// Reach full speed by the time we'd have to skip.
+			let ramp = excess / (this._liveMaxLatency - this._liveTargetLatency);
+			this._setLiveTempo(1.0 + (this._liveMaxTempo - 1.0) * Math.min(1, ramp));
+		} else {
+			this._setLiveTempo(1.0);
+		}
+		return false;
+	}
+
+	_setLiveTempo(tempo) {
+		// Quantize so we're not retuning the audio feeder every frame.
+		tempo = Math.round(tempo * 20) / 20;
+		if (tempo != this._liveTempo && this._audioFeeder) {
+			this._log('live: tempo ' + tempo);
+			this._liveTempo = tempo;
+			if (this._audioOutputStage) {
+				this._codec.setAudioTempo(tempo);
+			} else {
+				this._audioFeeder.tempo = this._playbackRate * tempo;
+			}
+		}
+	}
+
+	/**
+	 * Discard input up to the first keyframe at or past the live skip
+	 * goal, then restart the clock there.
+	 */
+	_doProcessLiveSkip() {
+		let codec = this._codec;
+
+		if (this._pendingAudio) {
+			// Let in-flight audio land before we flush the feeder.
+			this._log('live skip: waiting on audio decode');
+			return;
+		}
+
+		let dropFrame = (frame) => {
+			this._lateFrames++;
+			this._framesProcessed++; // pretend!
+			frame.dropped = true;
+			this._doFrameComplete(frame);
+		};
+		// _doFrameComplete hands each frame's buffer back to the codec.
+		this._decodedFrames.forEach(dropFrame);
+		this._decodedFrames = [];
+		this._pendingFrames.forEach(dropFrame);
+		this._pendingFrames = [];
+		this._pendingFrame = 0;
+
+		let goal = this._liveSkipGoal,
+			videoFound = !codec.hasVideo;
+		while (!videoFound && codec.frameReady) {
+			if (codec.frameTimestamp >= goal && codec.nextKeyframeTimestamp == codec.frameTimestamp) {
+				videoFound = true;
+				goal = codec.frameTimestamp;
+			} else {
+				let frame = {
+					frameEndTimestamp: codec.frameTimestamp
+				};
+				// note: this is a known synchronous operation :)
+				codec.discardFrame(() => {/*fake*/ });
+				dropFrame(frame);
+			}
+		}
+		while (codec.hasAudio && codec.audioReady && codec.audioTimestamp < goal) {
+			codec.discardAudio(() => {/*fake*/ });
+		}
+		let audioFound = !codec.hasAudio || codec.audioReady;
+
+		if (!(videoFound && audioFound) && !this._dataEnded) {
+			this._log('live skip: looking for keyframe past ' + goal);
+			this._doProcessPlayDemux();
+			return;
+		}
+
+		this._log('live skip: resuming at ' + goal);
+		this._liveSkipGoal = -1;
+		this._frameEndTimestamp = goal;
+		this._audioEndTimestamp = goal;
+		if (this._audioFeeder) {
+			this._stopPlayback();
+			this._flushAudioFeeder();
+			codec.flushAudio();
+			this._initialPlaybackOffset = goal;
+			this._prebufferingAudio = true;
+		} else {
+			this._startPlayback(goal);
+		}
+		this._fireEventAsync('timeupdate');
+		this._pingProcessing();
+	}
+
 	_doProcessPlayDemuxOld() {
 		console.log('====> CHECK demux has packet or not');
 		console.log('====> suman bogati demux play demux ');
@@ -2444,44 +2718,54 @@ class OGVPlayer extends OGVJSElement {
 
 
 	_readBytesAndWait() {
-		// if (this._stream.buffering || this._stream.seeking) {
-		// 	this._log('readBytesAndWait during i/o');
-		// 	return;
-		// }
-
-		// if (sumanNum > 4) return; // suman did changes
-		// if (allBuffers.length > 0) {
-		// 	const data = allBuffers.shift();
-		const data = virtualclass.liveStream.getChunkForOgvPlayer()
+		if (!this._liveQueue.length && typeof virtualclass !== 'undefined') {
+			this._pollLiveStream();
+		}
+
+		// Hand over everything that's arrived, not just one chunk,
+		// so we don't fall further behind the live edge.
+		let data = this._liveQueue.drain();
 		if (data) {
-			sumanNum++;
+			this._liveWaiting = false;
 			this._log('got input ' + [data.byteLength]);
-			// console.log('suman ====> suman got input, suman media hello');
-	
-			if (data.byteLength) {
-				// Save chunk to pass into the codec's buffer
-				this._actionQueue.push(() => {
-					this._codec.receiveInput(data, () => {
-						// console.log('suman got input, ping processing after input');
-						this._pingProcessing();
-					});
+
+			// Save chunk to pass into the codec's buffer
+			this._actionQueue.push(() => {
+				this._codec.receiveInput(data, () => {
+					this._pingProcessing();
 				});
-			}
-			// if (this._stream.eof) {
-			// 	// @todo record doneness in networkState
-			// 	this._log('stream is at end!');
-			// 	this._streamEnded = true;
-			// }
+			});
 			if (this._isProcessing()) {
 				// We're waiting on the codec already...
 			} else {
 				// Let the read/decode/draw loop know we're out!
-				console.log('got input, ping processing after input 2');
 				this._pingProcessing();
 			}
-			delete virtualclass.liveStream.listStream[virtualclass.liveStream.tempFile];
-			virtualclass.liveStream.currentExecuted = virtualclass.liveStream.tempFile;
-	//	}
+		} else if (this._liveQueue.ended) {
+			this._log('live stream is at end!');
+			this._streamEnded = true;
+			this._pingProcessing();
+		} else {
+			// pushLiveChunk() will wake us up.
+			this._log('waiting on live input');
+			this._liveWaiting = true;
+		}
+	}
+
+	/**
+	 * Pick up a chunk from the virtualclass live stream, for hosts
+	 * that hand over input when polled instead of via pushLiveChunk().
+	 */
+	_pollLiveStream() {
+		let liveStream = virtualclass.liveStream,
+			data = liveStream.getChunkForOgvPlayer();
+		if (data) {
+			if (data.byteLength && !this._liveQueue.push(data, -1, getTimestamp())) {
+				// Leave it with the host until we have room.
+				return;
+			}
+			delete liveStream.listStream[liveStream.tempFile];
+			liveStream.currentExecuted = liveStream.tempFile;
 		}
 	}
 
@@ -2538,6 +2822,9 @@ class OGVPlayer extends OGVJSElement {
 		if (this._detectedType) {
 			codecOptions.type = this._detectedType;
 		}
+		if (this._options.seekIndex) {
+			codecOptions.seekIndex = this._options.seekIndex;
+		}
 		this._codec = new OGVWrapperCodec(codecOptions);
 
 		this._lastVideoCpuTime = 0;
@@ -2560,15 +2847,29 @@ class OGVPlayer extends OGVJSElement {
 			}
 		};
 		this._codec.init(() => {
-			this._codec.receiveInput(firstBuffer, () => {
-				this._readBytesAndWait()
-			});
+			let initSegment = this._options.liveInitSegment;
+			if (initSegment) {
+				// Joining partway: headers from the cache, then the live
+				// input picks up at its next cluster or page.
+				this._codec.receiveInput(initSegment, () => {
+					this._codec.resync(() => {
+						this._codec.receiveInput(firstBuffer, () => {
+							this._readBytesAndWait()
+						});
+					});
+				});
+			} else {
+				this._codec.receiveInput(firstBuffer, () => {
+					this._readBytesAndWait()
+				});
+			}
 		});
 	}
 
 	_loadCodec(buf, callback) {
 		// @todo use the demuxer and codec interfaces directly
-		let hdr = new Uint8Array(buf);
+		// Live input may start anywhere; the cached headers know the type.
+		let hdr = new Uint8Array(this._options.liveInitSegment || buf);
 		if (hdr.length > 4 &&
 			hdr[0] == 'O'.charCodeAt(0) &&
 			hdr[1] == 'g'.charCodeAt(0) &&
@@ -2832,10 +3133,61 @@ class OGVPlayer extends OGVJSElement {
 			droppedAudio: this._droppedAudio,
 			delayedAudio: this._delayedAudio,
 			jitter: this._totalJitter / this._framesProcessed,
-			lateFrames: this._lateFrames
+			lateFrames: this._lateFrames,
+			liveLatency: this._liveLatency,
+			liveQueueBytes: this._liveQueue.byteLength,
+			liveQueueOverflows: this._liveQueue.overflows,
+			liveSkips: this._liveSkips,
+			liveTempo: this._liveTempo,
+			videoDecoderStats: this._codec ? this._codec.videoDecoderStats : {}
 		};
 	}
 
+	/**
+	 * Feed the next chunk of a live stream, continuing on from whatever
+	 * the stream source supplied at load time.
+	 *
+	 * @param ArrayBuffer data
+	 * @param number timestamp optional media time in seconds at the end of the chunk
+	 * @return boolean false if the input queue is full; retry later
+	 */
+	pushLiveChunk(data, timestamp = -1) {
+		if (!this._liveQueue.push(data, timestamp, getTimestamp())) {
+			this._log('live input queue full at ' + this._liveQueue.byteLength + ' bytes');
+			return false;
+		}
+		this._wakeForLiveInput();
+		return true;
+	}
+
+	/**
+	 * Signal that no more live chunks are coming, so playback can end.
+	 */
+	endLiveStream() {
+		this._liveQueue.ended = true;
+		this._wakeForLiveInput();
+	}
+
+	_wakeForLiveInput() {
+		if (this._liveWaiting) {
+			this._liveWaiting = false;
+			this._pingProcessing(0);
+		}
+	}
+
+	/**
+	 * Get the demuxer's seek index as built up so far, so it can be
+	 * passed back in later via the seekIndex option.
+	 * @param function callback takes an ArrayBuffer, or null
+	 */
+	exportSeekIndex(callback) {
+		if (this._codec && this._codec.demuxer) {
+			this._codec.exportSeekIndex(callback);
+		} else {
+			callback(null);
+		}
+	}
+
 	resetPlaybackStats() {
 		this._framesProcessed = 0;
 		this._playTime = 0;
@@ -82,6 +82,15 @@ function OGVProxyClass(initialProps) {
 			}
 		}
 
+		/**
+		 * Packets from a shared packet arena are Uint8Array views on a
+		 * SharedArrayBuffer, which post without copying; only plain
+		 * ArrayBuffers need to be transferred.
+		 */
+		packetTransfers(data) {
+			return (data instanceof ArrayBuffer) ? [data] : [];
+		}
+
 		terminate() {
 			if (this.worker) {
 				this.worker.terminate();
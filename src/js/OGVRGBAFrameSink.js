@@ -0,0 +1,53 @@
+import YUVCanvas from 'yuv-canvas';
+
+/**
+ * Frame sink for the video decoders' RGBA output mode, used in place of
+ * yuv-canvas's software sink when WebGL isn't available. Frames arrive
+ * converted and scaled, so drawing is a copy into one reused ImageData.
+ * Any YUV frames decoded before the switch go the usual software way.
+ *
+ * @param HTMLCanvasElement canvas
+ */
+class OGVRGBAFrameSink {
+	constructor(canvas) {
+		this.canvas = canvas;
+		this.ctx = canvas.getContext('2d');
+		this.imageData = null;
+		this.imageBytes = null;
+		this.software = null;
+	}
+
+	drawFrame(buffer) {
+		if (!buffer.rgba) {
+			if (!this.software) {
+				this.software = new YUVCanvas.SoftwareFrameSink(this.canvas);
+			}
+			this.software.drawFrame(buffer);
+			return;
+		}
+
+		let format = buffer.format,
+			canvas = this.canvas;
+		if (canvas.width !== format.width || canvas.height !== format.height) {
+			// The canvas is styled to the display size; the browser
+			// scales back up from there if we were asked for less.
+			canvas.width = format.width;
+			canvas.height = format.height;
+		}
+		if (!this.imageData ||
+			this.imageData.width !== format.width ||
+			this.imageData.height !== format.height) {
+			this.imageData = this.ctx.createImageData(format.width, format.height);
+			this.imageBytes = new Uint8Array(this.imageData.data.buffer);
+		}
+		// Same element type on both sides keeps this a plain memcpy.
+		this.imageBytes.set(buffer.rgba.bytes);
+		this.ctx.putImageData(this.imageData, 0, 0);
+	}
+
+	clear() {
+		this.ctx.clearRect(0, 0, this.canvas.width, this.canvas.height);
+	}
+}
+
+export default OGVRGBAFrameSink;
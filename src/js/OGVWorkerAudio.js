@@ -4,6 +4,7 @@ let proxy = new OGVWorkerSupport([
 	'loadedMetadata',
 	'audioFormat',
 	'audioBuffer',
+	'audioBufferDuration',
 	'cpuTime'
 ], {
 	init: function(_args, callback) {
@@ -17,9 +18,30 @@ let proxy = new OGVWorkerSupport([
 	},
 
 	processAudio: function(args, callback) {
-		this.target.processAudio(args[0], (ok) => {
+		this.target.processAudio(args[0], args[1], (ok) => {
 			callback([ok]);
 		});
+	},
+
+	drain: function(args, callback) {
+		this.target.drain((ok) => {
+			callback([ok]);
+		});
+	},
+
+	setOutputRate: function(args, callback) {
+		this.target.setOutputRate(args[0]);
+		callback();
+	},
+
+	setTempo: function(args, callback) {
+		this.target.setTempo(args[0]);
+		callback();
+	},
+
+	flush: function(args, callback) {
+		this.target.flush();
+		callback();
 	}
 });
 
@@ -81,13 +81,32 @@ class OGVWorkerSupport {
 							}
 						}
 					} else if (propName == 'frameBuffer') {
-						// We already extract ahead of time now,
-						// so transfer the small buffers.
+						// Frames are views on the decoder's heap. Copy the
+						// cropped planes out to transfer, and give the slot
+						// straight back.
 						props[propName] = propVal;
 						if (propVal) {
-							transfers.push(propVal.y.bytes.buffer);
-							transfers.push(propVal.u.bytes.buffer);
-							transfers.push(propVal.v.bytes.buffer);
+							let frame = this.target.acquireFrame(),
+								copy;
+							if (frame.rgba) {
+								copy = {
+									format: frame.format,
+									rgba: {bytes: frame.rgba.bytes.slice(), stride: frame.rgba.stride}
+								};
+								transfers.push(copy.rgba.bytes.buffer);
+							} else {
+								copy = {
+									format: frame.format,
+									y: {bytes: frame.y.bytes.slice(), stride: frame.y.stride},
+									u: {bytes: frame.u.bytes.slice(), stride: frame.u.stride},
+									v: {bytes: frame.v.bytes.slice(), stride: frame.v.stride}
+								};
+								transfers.push(copy.y.bytes.buffer);
+								transfers.push(copy.u.bytes.buffer);
+								transfers.push(copy.v.bytes.buffer);
+							}
+							this.target.releaseFrame(frame);
+							props[propName] = copy;
 						}
 					} else {
 						props[propName] = propVal;
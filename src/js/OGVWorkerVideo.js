@@ -4,7 +4,8 @@ let proxy = new OGVWorkerSupport([
 	'loadedMetadata',
 	'videoFormat',
 	'frameBuffer',
-	'cpuTime'
+	'cpuTime',
+	'decoderStats'
 ], {
 	init: function(_args, callback) {
 		this.target.init(callback);
@@ -27,8 +28,13 @@ let proxy = new OGVWorkerSupport([
 		callback();
 	},
 
-	recycleFrame: function(args, callback) {
-		// this.target.recycleFrame(args[0]);
+	setFrameDuration: function(args, callback) {
+		this.target.setFrameDuration(args[0]);
+		callback();
+	},
+
+	setRGBAOutput: function(args, callback) {
+		this.target.setRGBAOutput(args[0], args[1], args[2], args[3], args[4]);
 		callback();
 	}
 });
@@ -8,6 +8,11 @@
  * @license MIT-style
  */
 import OGVLoader from './OGVLoaderWeb.js';
+import OGVPacketArena from './OGVPacketArena.js';
+
+// Room for a few seconds of high-bitrate packets, keyframes included.
+const VIDEO_ARENA_SIZE = 8 * 1024 * 1024;
+const AUDIO_ARENA_SIZE = 512 * 1024;
 
 class OGVWrapperCodec {
 	constructor(options) {
@@ -16,8 +21,17 @@ class OGVWrapperCodec {
 		this.demuxer = null;
 		this.videoDecoder = null;
 		this.audioDecoder = null;
+		this.videoArena = null;
+		this.audioArena = null;
 		this.flushIter = 0;
 
+		// Frame duration last passed on to the video decoder, in ms.
+		this.frameDuration = 0;
+
+		// Rate the audio decoder resamples to; 0 for the stream rate.
+		this.audioOutputRate = 0;
+		this.lastFrameTimestamp = -1;
+
 		this.loadedMetadata = false;
 		this.processing = false;
 
@@ -64,6 +78,15 @@ class OGVWrapperCodec {
 					}
 				}
 			},
+			audioBufferDuration: {
+				get: function() {
+					if (this.hasAudio) {
+						return this.audioDecoder.audioBufferDuration;
+					} else {
+						return 0;
+					}
+				}
+			},
 			hasVideo: {
 				get: function() {
 					return this.loadedMetadata && !!this.videoDecoder;
@@ -138,6 +161,15 @@ class OGVWrapperCodec {
 						return 0;
 					}
 				}
+			},
+			videoDecoderStats: {
+				get: function() {
+					if (this.videoDecoder) {
+						return this.videoDecoder.decoderStats;
+					} else {
+						return {};
+					}
+				}
 			}
 		});
 
@@ -182,8 +214,15 @@ class OGVWrapperCodec {
 					}
 				};
 				demuxer.init(() => {
-					this.processing = false;
-					callback();
+					if (this.options.seekIndex) {
+						demuxer.importSeekIndex(this.options.seekIndex, () => {
+							this.processing = false;
+							callback();
+						});
+					} else {
+						this.processing = false;
+						callback();
+					}
 				});
 			});
 		});
@@ -202,12 +241,18 @@ class OGVWrapperCodec {
 			this.audioDecoder.close();
 			this.audioDecoder = null;
 		}
+		this.videoArena = null;
+		this.audioArena = null;
 	}
 
 	receiveInput(data, callback) {
 		this.demuxer.receiveInput(data, callback);
 	}
 
+	resync(callback) {
+		this.demuxer.resync(callback);
+	}
+
 	process(callback) {
 		if (this.processing) {
 			throw new Error('reentrancy fail on OGVWrapperCodec.process');
@@ -251,6 +296,7 @@ class OGVWrapperCodec {
 				this.demuxer.dequeueAudioPacket((packet, _discardPadding) => {
 					this.audioBytes += packet.byteLength;
 					this.audioDecoder.processHeader(packet, (ret) => {
+						this.releaseAudioPacket(packet);
 						finish(true);
 					});
 				});
@@ -274,6 +320,7 @@ class OGVWrapperCodec {
 				this.demuxer.dequeueVideoPacket((packet) => {
 					this.videoBytes += packet.byteLength;
 					this.videoDecoder.processHeader(packet, () => {
+						this.releaseVideoPacket(packet);
 						finish(true);
 					});
 				});
@@ -310,9 +357,11 @@ class OGVWrapperCodec {
 		let cb = this.flushSafe(callback),
 			timestamp = this.frameTimestamp,
 			keyframeTimestamp = this.keyframeTimestamp;
+		this.updateFrameDuration(timestamp);
 		this.demuxer.dequeueVideoPacket((packet) => {
 			this.videoBytes += packet.byteLength;
 			this.videoDecoder.processFrame(packet, (ok) => {
+				this.releaseVideoPacket(packet);
 				// console.log('====> suman orginal process video frame');
 				// hack
 				let fb = this.videoDecoder.frameBuffer;
@@ -325,37 +374,51 @@ class OGVWrapperCodec {
 		});
 	}
 
+	/**
+	 * Keep the video decoder's idea of the frame deadline current.
+	 * WebM doesn't record a frame rate, so fall back to the spacing
+	 * between frame timestamps.
+	 */
+	updateFrameDuration(timestamp) {
+		let fps = this.videoFormat ? this.videoFormat.fps : 0,
+			duration = 0;
+		if (fps > 0) {
+			duration = 1000 / fps;
+		} else if (this.lastFrameTimestamp >= 0) {
+			duration = (timestamp - this.lastFrameTimestamp) * 1000;
+		}
+		this.lastFrameTimestamp = timestamp;
+		if (duration > 0 && duration < 1000 && Math.abs(duration - this.frameDuration) >= 1) {
+			this.frameDuration = duration;
+			this.videoDecoder.setFrameDuration(duration);
+		}
+	}
+
 	decodeAudio(callback) {
 		let cb = this.flushSafe(callback);
 		this.demuxer.dequeueAudioPacket((packet, discardPadding) => {
 			this.audioBytes += packet.byteLength;
 			// console.log('====> Suman audio byte length ' + this.audioBytes);
-			this.audioDecoder.processAudio(packet, (ret) => {
-				if (discardPadding) {
-					// discardPadding is in nanoseconds
-					// negative value trims from beginning
-					// positive value trims from end
-					let samples = this.audioDecoder.audioBuffer;
-					let trimmed = [];
-					for (let channel of samples) {
-						let trim = Math.round(discardPadding * this.audioFormat.rate / 1000000000);
-						if (trim > 0) {
-							trimmed.push(channel.subarray(0, channel.length - Math.min(trim, channel.length)));
-						} else {
-							trimmed.push(channel.subarray(Math.min(Math.abs(trim), channel.length), channel.length));
-						}
-					}
-					// kinda hacky for now
-					this.audioDecoder.audioBuffer = trimmed;
-				}
+			// The decoder trims discardPadding itself, ahead of resampling.
+			this.audioDecoder.processAudio(packet, discardPadding, (ret) => {
+				this.releaseAudioPacket(packet);
 				return cb(ret);
 			});
 		});
 	}
 
+	/**
+	 * At the end of the stream, get back the audio the decoder is holding
+	 * for resampling or tempo changes, in audioBuffer.
+	 */
+	drainAudio(callback) {
+		this.audioDecoder.drain(this.flushSafe(callback));
+	}
+
 	discardFrame(callback) {
 		this.demuxer.dequeueVideoPacket((packet) => {
 			this.videoBytes += packet.byteLength;
+			this.releaseVideoPacket(packet);
 			callback();
 		});
 	}
@@ -363,24 +426,118 @@ class OGVWrapperCodec {
 	discardAudio(callback) {
 		this.demuxer.dequeueAudioPacket((packet, _discardPadding) => {
 			this.audioBytes += packet.byteLength;
+			this.releaseAudioPacket(packet);
 			callback();
 		});
 	}
 
 	flush(callback) {
 		this.flushIter++;
+		this.lastFrameTimestamp = -1;
+		this.flushAudio();
 		this.demuxer.flush(callback);
 	}
 
+	/**
+	 * Drop audio the decoder is holding back for resampling or tempo
+	 * changes, so it doesn't turn up ahead of audio from a new position.
+	 */
+	flushAudio() {
+		if (this.audioDecoder) {
+			this.audioDecoder.flush();
+		}
+	}
+
 	sync() {
 		if (this.videoDecoder) {
 			this.videoDecoder.sync();
 		}
 	}
 
-	recycleFrame(frame) {
+	releaseVideoPacket(packet) {
+		if (this.videoArena) {
+			this.videoArena.release(packet);
+		}
+	}
+
+	releaseAudioPacket(packet) {
+		if (this.audioArena) {
+			this.audioArena.release(packet);
+		}
+	}
+
+	/**
+	 * Give the demuxer an arena to write one kind of packet into, so
+	 * packets reach the decoder without being sliced and copied again.
+	 * Prefers a region of the decoder's own heap, which it can decode
+	 * from in place; otherwise a standalone arena, which must be shared
+	 * memory for a decoder running in a worker.
+	 */
+	setupPacketArena(kind, decoder, inWorker, callback) {
+		let size = (kind === 'video') ? VIDEO_ARENA_SIZE : AUDIO_ARENA_SIZE;
+		let attach = (arena) => {
+			this[kind + 'Arena'] = arena;
+			this.demuxer[kind + 'Arena'] = arena;
+			callback();
+		};
+		if (decoder.allocPacketArena) {
+			decoder.allocPacketArena(size, (region) => {
+				if (region) {
+					attach(new OGVPacketArena(region.buffer, region.byteOffset, region.byteLength));
+				} else {
+					attach(OGVPacketArena.create(size, inWorker));
+				}
+			});
+		} else {
+			attach(OGVPacketArena.create(size, inWorker));
+		}
+	}
+
+	/**
+	 * Have the audio decoder resample its output to rate, so audioBuffer
+	 * can be queued for the audio device without further processing.
+	 */
+	setAudioOutputRate(rate) {
+		if (this.audioDecoder) {
+			this.audioOutputRate = rate;
+			this.audioDecoder.setOutputRate(rate);
+		}
+	}
+
+	/**
+	 * Have the audio decoder play back faster or slower, keeping pitch.
+	 * audioBufferDuration still gives the stream time each buffer covers.
+	 */
+	setAudioTempo(tempo) {
+		if (this.audioDecoder) {
+			this.audioDecoder.setTempo(tempo);
+		}
+	}
+
+	/**
+	 * Have the video decoder hand out RGBA frames, scaled to
+	 * width x height (0 for the frame size), instead of YUV planes.
+	 */
+	setRGBAOutput(enabled, width, height, matrix, fullRange) {
+		if (this.videoDecoder) {
+			this.videoDecoder.setRGBAOutput(enabled, width, height, matrix, fullRange);
+		}
+	}
+
+	/**
+	 * Take ownership of the current frameBuffer, keeping its storage from
+	 * being reused until it's passed back to releaseFrame.
+	 */
+	acquireFrame() {
+		if (this.videoDecoder) {
+			return this.videoDecoder.acquireFrame();
+		}
+		return null;
+	}
+
+	releaseFrame(frame) {
 		if (this.videoDecoder) {
-			this.videoDecoder.recycleFrame(frame);
+			this.videoDecoder.releaseFrame(frame);
 		}
 	}
 
@@ -391,15 +548,25 @@ class OGVWrapperCodec {
 	seekToKeypoint(timeSeconds, callback) {
 		this.demuxer.seekToKeypoint(timeSeconds, this.flushSafe(callback));
 	}
+
+	exportSeekIndex(callback) {
+		this.demuxer.exportSeekIndex(callback);
+	}
+
+	importSeekIndex(data, callback) {
+		this.demuxer.importSeekIndex(data, callback);
+	}
 	
 	loadAudioCodec(callback) {
 		if (this.demuxer.audioCodec) {
-			let wasm = !!this.options.wasm;
+			let wasm = !!this.options.wasm,
+				simd = !!this.options.simd;
 			let audioClassMap = {
-				vorbis: wasm ? 'OGVDecoderAudioVorbisW' : 'OGVDecoderAudioVorbis',
-				opus: wasm ? 'OGVDecoderAudioOpusW' : 'OGVDecoderAudioOpus'
+				vorbis: wasm ? (simd ? 'OGVDecoderAudioVorbisSIMDW' : 'OGVDecoderAudioVorbisW') : 'OGVDecoderAudioVorbis',
+				opus: wasm ? (simd ? 'OGVDecoderAudioOpusSIMDW' : 'OGVDecoderAudioOpusW') : 'OGVDecoderAudioOpus'
 			};
 			let className = audioClassMap[this.demuxer.audioCodec];
+			let inWorker = !!this.options.worker;
 			this.processing = true;
 			OGVLoader.loadClass(className, (audioCodecClass) => {
 				let audioOptions = {};
@@ -410,12 +577,14 @@ class OGVWrapperCodec {
 					this.audioDecoder = decoder;
 					decoder.init(() => {
 						this.loadedAudioMetadata = decoder.loadedMetadata;
-						this.processing = false;
-						callback();
+						this.setupPacketArena('audio', decoder, inWorker, () => {
+							this.processing = false;
+							callback();
+						});
 					});
 				});
 			}, {
-				worker: this.options.worker
+				worker: inWorker
 			});
 		} else {
 			callback();
@@ -428,7 +597,11 @@ class OGVWrapperCodec {
 				simd = !!this.options.simd,
 				threading = !!this.options.threading;
 			let videoClassMap = {
-				theora: wasm ? 'OGVDecoderVideoTheoraW' : 'OGVDecoderVideoTheora',
+				theora: wasm ? (threading ? (simd ? 'OGVDecoderVideoTheoraSIMDMTW'
+				                                  : 'OGVDecoderVideoTheoraMTW')
+				                          : (simd ? 'OGVDecoderVideoTheoraSIMDW'
+				                                  : 'OGVDecoderVideoTheoraW'))
+				             : 'OGVDecoderVideoTheora',
 				vp8: wasm ? (threading ? 'OGVDecoderVideoVP8MTW' : 'OGVDecoderVideoVP8W') : 'OGVDecoderVideoVP8',
 				vp9: wasm ? (threading ? (simd ? 'OGVDecoderVideoVP9SIMDMTW'
 											   : 'OGVDecoderVideoVP9MTW')
@@ -442,6 +615,7 @@ class OGVWrapperCodec {
 						  : 'OGVDecoderVideoAV1',
 			};
 			let className = videoClassMap[this.demuxer.videoCodec];
+			let inWorker = !!this.options.worker && !threading;
 			this.processing = true;
 			OGVLoader.loadClass(className, (videoCodecClass) => {
 				let videoOptions = {};
@@ -458,12 +632,14 @@ class OGVWrapperCodec {
 					decoder.init(() => {
 						this.loadedVideoMetadata = decoder.loadedMetadata;
 						// console.log('====> suman processing load video codec 1');
-						this.processing = false;
-						callback();
+						this.setupPacketArena('video', decoder, inWorker, () => {
+							this.processing = false;
+							callback();
+						});
 					});
 				});
 			}, {
-				worker: this.options.worker && !this.options.threading
+				worker: inWorker
 			});
 		} else {
 			callback();
@@ -5,15 +5,17 @@
 
 mergeInto(LibraryManager.library, {
 
-	ogvjs_callback_init_audio: function(channels, rate) {
-		Module['audioFormat'] = {
+	ogvjs_callback_init_audio: function(handle, channels, rate) {
+		var stream = Module.streams[handle];
+		stream['audioFormat'] = {
 			'channels': channels,
 			'rate': rate
 		};
-		Module['loadedMetadata'] = true;
+		stream['loadedMetadata'] = true;
 	},
 
-	ogvjs_callback_audio: function(buffers, channels, sampleCount) {
+	ogvjs_callback_audio: function(handle, buffers, channels, sampleCount, duration) {
+		var stream = Module.streams[handle];
 		// buffers is an array of pointers to float arrays for each channel
 		var heap = wasmMemory.buffer;
 		var ptrs = new Uint32Array(heap, buffers, channels);
@@ -34,7 +36,8 @@ mergeInto(LibraryManager.library, {
 			}
 		}
 
-		Module['audioBuffer'] = outputBuffers;
+		stream['audioBuffer'] = outputBuffers;
+		stream['audioBufferDuration'] = duration;
 	}
 
 });
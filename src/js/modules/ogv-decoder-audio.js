@@ -18,104 +18,199 @@ function reallocInputBuffer(size) {
 	return inputBuffer;
 }
 
+// Packets come in either as ArrayBuffers or as Uint8Array views
+// on a packet arena.
+function packetBytes(data) {
+	return ArrayBuffer.isView(data) ? data : new Uint8Array(data);
+}
+
 var getTimestamp;
 if (typeof performance === 'undefined' || typeof performance.now === 'undefined') {
 	getTimestamp = Date.now;
 } else {
 	getTimestamp = performance.now.bind(performance);
 }
-function time(func) {
-	var start = getTimestamp(),
-		ret;
-	ret = func();
-	Module['cpuTime'] += (getTimestamp() - start);
-	return ret;
-}
-
-// - Properties
-
-/**
- * @property boolean
- */
-Module['loadedMetadata'] = !!options['audioFormat'];
 
 /**
- * @property object
+ * Each stream has its own decoder state on the C side, all sharing this
+ * one module instance and its heap. The module itself is the default one.
  */
-Module['audioFormat'] = options['audioFormat'] || null;
+Module.streams = {};
 
-/**
- * Last-decoded audio packet
- * @property object
- */
-Module['audioBuffer'] = null;
+function setupStream(stream, options) {
+	stream.handle = 0;
 
-/**
- * Running tally of CPU time spent in the decoder.
- * @property number
- */
-Module['cpuTime'] = 0;
-
-/**
- * Are we in the middle of an asynchronous processing operation?
- * @property boolean
- */
-Object.defineProperty(Module, 'processing', {
-	get: function getProcessing() {
-		return false;
+	function time(func) {
+		var start = getTimestamp(),
+			ret;
+		ret = func();
+		stream['cpuTime'] += (getTimestamp() - start);
+		return ret;
 	}
-});
 
-// - public methods
-
-Module['init'] = function(callback) {
-	time(function() {
-		Module['_ogv_audio_decoder_init']();
+	// - Properties
+
+	/**
+	 * @property boolean
+	 */
+	stream['loadedMetadata'] = !!options['audioFormat'];
+
+	/**
+	 * @property object
+	 */
+	stream['audioFormat'] = options['audioFormat'] || null;
+
+	/**
+	 * Last-decoded audio packet, at the output rate; null if the decoder's
+	 * output stage held it all back.
+	 * @property object
+	 */
+	stream['audioBuffer'] = null;
+
+	/**
+	 * Stream time covered by audioBuffer, in seconds.
+	 * @property number
+	 */
+	stream['audioBufferDuration'] = 0;
+
+	/**
+	 * Running tally of CPU time spent in the decoder.
+	 * @property number
+	 */
+	stream['cpuTime'] = 0;
+
+	/**
+	 * Are we in the middle of an asynchronous processing operation?
+	 * @property boolean
+	 */
+	Object.defineProperty(stream, 'processing', {
+		get: function getProcessing() {
+			return false;
+		}
 	});
-	callback();
-};
 
-/**
- * Process a header packet
- *
- * @param ArrayBuffer data
- * @param function callback on completion
- */
-Module['processHeader'] = function(data, callback) {
-	var ret = time(function() {
-		// Map the ArrayBuffer into emscripten's runtime heap
-		var len = data.byteLength;
-		var buffer = reallocInputBuffer(len);
-		var dest = new Uint8Array(wasmMemory.buffer, buffer, len);
-		dest.set(new Uint8Array(data));
-
-		return Module['_ogv_audio_decoder_process_header'](buffer, len);
-	});
-	callback(ret);
-};
+	// - public methods
+
+	stream['init'] = function(callback) {
+		time(function() {
+			stream.handle = Module['_ogv_audio_decoder_create']();
+			Module.streams[stream.handle] = stream;
+		});
+		callback();
+	};
+
+	/**
+	 * Process a header packet
+	 *
+	 * @param ArrayBuffer data
+	 * @param function callback on completion
+	 */
+	stream['processHeader'] = function(data, callback) {
+		var ret = time(function() {
+			// Map the ArrayBuffer into emscripten's runtime heap
+			var len = data.byteLength;
+			var buffer = reallocInputBuffer(len);
+			var dest = new Uint8Array(wasmMemory.buffer, buffer, len);
+			dest.set(packetBytes(data));
+
+			return Module['_ogv_audio_decoder_process_header'](stream.handle, buffer, len);
+		});
+		callback(ret);
+	};
+
+	/**
+	 * Decode the given audio data packet; fills out the audioBuffer property on success
+	 *
+	 * @param ArrayBuffer data
+	 * @param number discardPadding nanoseconds to trim off the end of the
+	 *        packet's samples, or off the start if negative
+	 * @param function callback on completion
+	 */
+	stream['processAudio'] = function(data, discardPadding, callback) {
+		var ret = time(function() {
+			// Map the ArrayBuffer into emscripten's runtime heap
+			var len = data.byteLength;
+			var buffer = reallocInputBuffer(len);
+			var dest = new Uint8Array(wasmMemory.buffer, buffer, len);
+			dest.set(packetBytes(data));
+
+			stream['audioBuffer'] = null;
+			stream['audioBufferDuration'] = 0;
+			return Module['_ogv_audio_decoder_process_audio'](stream.handle, buffer, len, discardPadding || 0);
+		});
+		callback(ret);
+	};
+
+	/**
+	 * At the end of the stream, get back the audio the output stage is
+	 * still holding for resampling or tempo changes, in audioBuffer.
+	 *
+	 * @param function callback on completion
+	 */
+	stream['drain'] = function(callback) {
+		var ret = time(function() {
+			stream['audioBuffer'] = null;
+			stream['audioBufferDuration'] = 0;
+			return Module['_ogv_audio_decoder_drain'](stream.handle);
+		});
+		callback(ret);
+	};
+
+	/**
+	 * Resample decoded audio to the given rate, so it can be queued for
+	 * the audio device as-is.
+	 *
+	 * @param number rate in Hz, or 0 for the stream's own rate
+	 */
+	stream['setOutputRate'] = function(rate) {
+		if (stream.handle) {
+			Module['_ogv_audio_decoder_set_output_rate'](stream.handle, rate);
+		}
+	};
+
+	/**
+	 * Play decoded audio faster or slower without changing its pitch.
+	 *
+	 * @param number tempo from 0.5 to 2
+	 */
+	stream['setTempo'] = function(tempo) {
+		if (stream.handle) {
+			Module['_ogv_audio_decoder_set_tempo'](stream.handle, tempo);
+		}
+	};
+
+	/**
+	 * Drop any audio the output stage is holding back, as after a seek.
+	 */
+	stream['flush'] = function() {
+		if (stream.handle) {
+			Module['_ogv_audio_decoder_flush'](stream.handle);
+		}
+	};
+
+	/**
+	 * Close out any resources required by the decoder module
+	 */
+	stream.close = function() {
+		if (stream.handle) {
+			Module['_ogv_audio_decoder_destroy'](stream.handle);
+			delete Module.streams[stream.handle];
+			stream.handle = 0;
+		}
+	};
+
+	return stream;
+}
 
-/**
- * Decode the given audio data packet; fills out the audioBuffer property on success
- *
- * @param ArrayBuffer data
- * @param function callback on completion
- */
-Module['processAudio'] = function(data, callback) {
-	var ret = time(function() {
-		// Map the ArrayBuffer into emscripten's runtime heap
-		var len = data.byteLength;
-		var buffer = reallocInputBuffer(len);
-		var dest = new Uint8Array(wasmMemory.buffer, buffer, len);
-		dest.set(new Uint8Array(data));
-
-		return Module['_ogv_audio_decoder_process_audio'](buffer, len);
-	});
-	callback(ret);
-};
+setupStream(Module, options);
 
 /**
- * Close out any resources required by the decoder module
+ * Set up another decoder in the same module instance, with the same
+ * interface as the module itself.
+ *
+ * @param object streamOptions
+ * @returns object
  */
-Module.close = function() {
-	// no-op
+Module['createStream'] = function(streamOptions) {
+	return setupStream({}, streamOptions || {});
 };
@@ -2,6 +2,7 @@
 /* global options */
 /* global ArrayBuffer */
 /* global wasmMemory */
+/* global SharedArrayBuffer */
 
 // Resizable input buffer to store input packets
 
@@ -19,151 +20,360 @@ function reallocInputBuffer(size) {
 	return inputBuffer;
 }
 
+// Packets come in either as ArrayBuffers or as Uint8Array views
+// on a packet arena.
+function packetBytes(data) {
+	return ArrayBuffer.isView(data) ? data : new Uint8Array(data);
+}
+
 var getTimestamp;
 if (typeof performance === 'undefined' || typeof performance.now === 'undefined') {
 	getTimestamp = Date.now;
 } else {
 	getTimestamp = performance.now.bind(performance);
 }
-function time(func) {
-	var start = getTimestamp(),
-		ret;
-	ret = func();
-	Module['cpuTime'] += (getTimestamp() - start);
-	return ret;
-}
-
-// - Properties
 
-/**
- * @property boolean
- */
-Module['loadedMetadata'] = !!options['videoFormat'];
+// Stat names are static C strings; only decode each one once.
+var statNames = {};
+Module.statName = function(ptr) {
+	if (!statNames[ptr]) {
+		var str = "", heap = new Uint8Array(wasmMemory.buffer);
+		for (var i = ptr; heap[i] != 0; i++) {
+			str += String.fromCharCode(heap[i]);
+		}
+		statNames[ptr] = str;
+	}
+	return statNames[ptr];
+};
 
 /**
- * @property object
+ * Each stream has its own decoder state on the C side, all sharing this
+ * one module instance and its heap. The module itself is the default one.
  */
-Module['videoFormat'] = options['videoFormat'] || null;
+Module.streams = {};
 
-/**
- * Last-decoded video packet
- * @property object
- */
-Module['frameBuffer'] = null;
+function setupStream(stream, options) {
+	stream.handle = 0;
 
-/**
- * Running tally of CPU time spent in the decoder.
- * @property number
- */
-Module['cpuTime'] = 0;
+	function time(func) {
+		var start = getTimestamp(),
+			ret;
+		ret = func();
+		stream['cpuTime'] += (getTimestamp() - start);
+		return ret;
+	}
 
-/**
- * Are we in the middle of an asynchronous processing operation?
- * @property boolean
- */
-Object.defineProperty(Module, 'processing', {
-	get: function getProcessing() {
-		return false;
+	stream.pendingStats = null;
+	function updateStats() {
+		stream.pendingStats = {};
+		Module['_ogv_video_decoder_stats'](stream.handle);
+		var stats = stream.pendingStats,
+			old = stream['decoderStats'];
+		stream.pendingStats = null;
+		for (var name in stats) {
+			if (stats[name] !== old[name]) {
+				stream['decoderStats'] = stats;
+				return;
+			}
+		}
 	}
-});
 
-// - public methods
+	// - Properties
 
-Module['init'] = function(callback) {
-	time(function() {
-		Module['_ogv_video_decoder_init']();
-	});
-	callback();
-};
+	/**
+	 * @property boolean
+	 */
+	stream['loadedMetadata'] = !!options['videoFormat'];
 
-/**
- * Process a header packet
- *
- * @param ArrayBuffer data
- * @param function callback on completion
- */
-Module['processHeader'] = function(data, callback) {
-	var ret = time(function() {
-		// Map the ArrayBuffer into emscripten's runtime heap
-		var len = data.byteLength;
-		var buffer = reallocInputBuffer(len);
-		var dest = new Uint8Array(wasmMemory.buffer, buffer, len);
-		dest.set(new Uint8Array(data));
-
-		return Module['_ogv_video_decoder_process_header'](buffer, len);
-	});
-	callback(ret);
-};
+	/**
+	 * @property object
+	 */
+	stream['videoFormat'] = options['videoFormat'] || null;
 
-Module.callbacks = [];
+	/**
+	 * Last-decoded video packet
+	 * @property object
+	 */
+	stream['frameBuffer'] = null;
 
-/**
- * Decode the given video data packet; fills out the frameBuffer property on success
- *
- * @param ArrayBuffer data
- * @param function callback on completion
- */
-Module['processFrame'] = function(data, callback) {
-	var isAsync = Module['_ogv_video_decoder_async']();
-
-	// Map the ArrayBuffer into emscripten's runtime heap
-	var len = data.byteLength;
-	var buffer = Module['_malloc'](len);
-	function callbackWrapper(ret) {
-		Module['_free'](buffer);
-		callback(ret);
-	}
-	if (isAsync) {
-		Module.callbacks.push(callbackWrapper);
-	}
+	/**
+	 * Running tally of CPU time spent in the decoder.
+	 * @property number
+	 */
+	stream['cpuTime'] = 0;
 
-	var ret = time(function() {
-		var dest = new Uint8Array(wasmMemory.buffer, buffer, len);
-		dest.set(new Uint8Array(data));
-		return Module['_ogv_video_decoder_process_frame'](buffer, len)
+	/**
+	 * Decoder-specific counters, such as buffer pool usage.
+	 * Replaced with a new object whenever any of them change.
+	 * @property object
+	 */
+	stream['decoderStats'] = {};
+
+	/**
+	 * Are we in the middle of an asynchronous processing operation?
+	 * @property boolean
+	 */
+	Object.defineProperty(stream, 'processing', {
+		get: function getProcessing() {
+			return false;
+		}
 	});
-	if (!isAsync) {
-		callbackWrapper(ret);
-	}
-};
 
-/**
- * Close out any resources required by the decoder module
- */
-Module['close'] = function() {
-	// no-op
-};
+	// - public methods
 
-/**
- * Force an async decoder to flush any decoded frames out,
- * without losing any state.
- */
-Module['sync'] = function() {
-	var isAsync = Module['_ogv_video_decoder_async']();
-	if (isAsync) {
-		Module.callbacks.push(function() {
-			// no-op
-		});
+	stream['init'] = function(callback) {
 		time(function() {
-			Module['_ogv_video_decoder_process_frame'](0, 0)
+			stream.handle = Module['_ogv_video_decoder_create']();
+			Module.streams[stream.handle] = stream;
 		});
-	}
-};
+		callback();
+	};
+
+	/**
+	 * Process a header packet
+	 *
+	 * @param ArrayBuffer data
+	 * @param function callback on completion
+	 */
+	stream['processHeader'] = function(data, callback) {
+		var hadMetadata = stream['loadedMetadata'];
+		var ret = time(function() {
+			// Map the ArrayBuffer into emscripten's runtime heap
+			var len = data.byteLength;
+			var buffer = reallocInputBuffer(len);
+			var dest = new Uint8Array(wasmMemory.buffer, buffer, len);
+			dest.set(packetBytes(data));
+
+			return Module['_ogv_video_decoder_process_header'](stream.handle, buffer, len);
+		});
+		if (ret && !hadMetadata && stream['loadedMetadata'] &&
+			Module['_ogv_video_decoder_async'](stream.handle)) {
+			// The packet that ended the headers was queued as the first
+			// frame; its completion is the next one back.
+			stream.callbacks.push(function() {
+				updateStats();
+			});
+		}
+		callback(ret);
+	};
+
+	stream.callbacks = [];
+
+	/**
+	 * Packets waiting for room in an async decoder's queue, in order.
+	 * The decoder refuses packets while its queue is full; we try again
+	 * each time it completes one.
+	 */
+	stream.pendingFrames = [];
+
+	stream.sendPendingFrames = function() {
+		var pending = stream.pendingFrames;
+		while (pending.length > 0) {
+			var frame = pending[0];
+			stream.callbacks.push(frame.callback);
+			var ret = time(function() {
+				return Module['_ogv_video_decoder_process_frame'](stream.handle, frame.buffer, frame.len);
+			});
+			if (!ret) {
+				// Still full.
+				stream.callbacks.pop();
+				return;
+			}
+			pending.shift();
+		}
+	};
+
+	/**
+	 * Decode the given video data packet; fills out the frameBuffer property on success
+	 *
+	 * @param ArrayBuffer data
+	 * @param function callback on completion
+	 */
+	stream['processFrame'] = function(data, callback) {
+		var isAsync = Module['_ogv_video_decoder_async'](stream.handle);
 
-Module['recycledFrames'] = [];
+		var len = data.byteLength,
+			owned = !(stream.packetArena && data.buffer === stream.packetArena['buffer']),
+			buffer;
+		if (owned) {
+			// Map the ArrayBuffer into emscripten's runtime heap
+			buffer = Module['_malloc'](len);
+			time(function() {
+				var dest = new Uint8Array(wasmMemory.buffer, buffer, len);
+				dest.set(packetBytes(data));
+			});
+		} else {
+			// The demuxer wrote it straight into our heap; decode in place.
+			// The caller keeps the arena space reserved until we call back.
+			buffer = data.byteOffset;
+		}
+		function callbackWrapper(ret) {
+			if (owned) {
+				Module['_free'](buffer);
+			}
+			updateStats();
+			callback(ret);
+		}
+
+		if (isAsync) {
+			stream.pendingFrames.push({
+				buffer: buffer,
+				len: len,
+				owned: owned,
+				callback: callbackWrapper
+			});
+			stream.sendPendingFrames();
+		} else {
+			var ret = time(function() {
+				return Module['_ogv_video_decoder_process_frame'](stream.handle, buffer, len)
+			});
+			callbackWrapper(ret);
+		}
+	};
+
+	/**
+	 * Close out any resources required by the decoder module
+	 */
+	stream['close'] = function() {
+		if (stream.handle) {
+			// Packets the decoder never accepted are still ours to free.
+			var pending = stream.pendingFrames;
+			for (var i = 0; i < pending.length; i++) {
+				if (pending[i].owned) {
+					Module['_free'](pending[i].buffer);
+				}
+			}
+			pending.splice(0, pending.length);
+			// The decoder frees the packet arena itself, once the decode
+			// thread has finished with anything still queued out of it.
+			Module['_ogv_video_decoder_destroy'](stream.handle);
+			stream.packetArena = null;
+			delete Module.streams[stream.handle];
+			stream.handle = 0;
+		}
+	};
+
+	/**
+	 * Force an async decoder to flush any decoded frames out,
+	 * without losing any state.
+	 */
+	stream['sync'] = function() {
+		var isAsync = Module['_ogv_video_decoder_async'](stream.handle);
+		if (isAsync) {
+			stream.pendingFrames.push({
+				buffer: 0,
+				len: 0,
+				callback: function() {
+					// no-op
+				}
+			});
+			stream.sendPendingFrames();
+		}
+	};
+
+	/**
+	 * Tell the decoder how often frames are due, in milliseconds, so a
+	 * threaded decoder can size its workers to keep up.
+	 *
+	 * @param number ms
+	 */
+	stream['setFrameDuration'] = function(ms) {
+		if (stream.handle) {
+			Module['_ogv_video_decoder_set_frame_duration'](stream.handle, ms);
+		}
+	};
+
+	/**
+	 * Switch frame output between YUV planes and RGBA pixels, which the
+	 * decoder converts and scales down itself for drawing without WebGL.
+	 *
+	 * @param boolean enabled
+	 * @param number width output size, or 0 for the cropped frame size
+	 * @param number height
+	 * @param number matrix 0 for BT.601, 1 for BT.709
+	 * @param boolean fullRange
+	 */
+	stream['setRGBAOutput'] = function(enabled, width, height, matrix, fullRange) {
+		if (stream.handle) {
+			Module['_ogv_video_decoder_set_rgba_output'](stream.handle, enabled ? 1 : 0,
+				width, height, matrix, fullRange ? 1 : 0);
+		}
+	};
+
+	/**
+	 * Heap region handed out by allocPacketArena, if any.
+	 */
+	stream.packetArena = null;
+
+	/**
+	 * Set aside part of the heap for a packet arena, so the demuxer can
+	 * write packets where we can decode them without another copy.
+	 * Only possible when the heap is shared memory, which stays put
+	 * when it grows; otherwise calls back with null.
+	 *
+	 * @param number size in bytes
+	 * @param function callback
+	 *        takes an object with buffer, byteOffset and byteLength
+	 */
+	stream['allocPacketArena'] = function(size, callback) {
+		var heap = wasmMemory.buffer;
+		if (stream.packetArena || typeof SharedArrayBuffer !== 'function' ||
+			!(heap instanceof SharedArrayBuffer)) {
+			callback(null);
+			return;
+		}
+		var ptr = Module['_ogv_video_decoder_alloc_packet_arena'](stream.handle, size);
+		if (!ptr) {
+			// Out of heap; keep copying each packet in instead.
+			callback(null);
+			return;
+		}
+		stream.packetArena = {
+			'buffer': heap,
+			'byteOffset': ptr,
+			'byteLength': size
+		};
+		callback(stream.packetArena);
+	};
+
+	/**
+	 * Take ownership of the current frameBuffer. Its planes are views on
+	 * the decoder's heap, valid until it's handed back with releaseFrame;
+	 * a frame that's never acquired is released when the next one comes.
+	 *
+	 * @returns YUVBuffer
+	 */
+	stream['acquireFrame'] = function() {
+		var frame = stream['frameBuffer'];
+		if (frame) {
+			frame.acquired = true;
+		}
+		return frame;
+	};
+
+	/**
+	 * Give a frame's heap storage back to the decoder for reuse.
+	 * @param YUVBuffer frame
+	 */
+	stream['releaseFrame'] = function(frame) {
+		if (frame && !frame.released && stream.handle) {
+			frame.released = true;
+			Module['_ogv_video_decoder_release_frame'](stream.handle, frame.slot, frame.serial);
+		}
+	};
+
+	return stream;
+}
+
+setupStream(Module, options);
 
 /**
- * Recycle a YUVBuffer object for later use.
- * @param YUVBuffer frame
+ * Set up another decoder in the same module instance, with the same
+ * interface as the module itself.
+ *
+ * @param object streamOptions
+ * @returns object
  */
-Module['recycleFrame'] = function(frame) {
-	var arr = Module['recycledFrames'];
-	arr.push(frame);
-	if (arr.length > 16) {
-		arr.shift();
-	}
+Module['createStream'] = function(streamOptions) {
+	return setupStream({}, streamOptions || {});
 };
-
-// We need to check for IE's rendering engine because of its
-// terrible TypedArray 'set' method performance.
-var trident = typeof navigator === 'object' && navigator.userAgent.match(/Trident/);
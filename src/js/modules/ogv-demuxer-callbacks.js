@@ -5,13 +5,14 @@
 
 mergeInto(LibraryManager.library, {
 
-	ogvjs_callback_init_video: function(frameWidth, frameHeight,
+	ogvjs_callback_init_video: function(handle, frameWidth, frameHeight,
 	                                    chromaWidth, chromaHeight,
                                         fps,
                                         picWidth, picHeight,
                                         picX, picY,
                                         displayWidth, displayHeight) {
-		Module['videoFormat'] = {
+		var stream = Module.streams[handle];
+		stream['videoFormat'] = {
 			'width': frameWidth,
 			'height': frameHeight,
 			'chromaWidth': chromaWidth,
@@ -26,14 +27,16 @@ mergeInto(LibraryManager.library, {
 		};
 	},
 
-	ogvjs_callback_init_audio: function(channels, rate) {
-		Module['audioFormat'] = {
+	ogvjs_callback_init_audio: function(handle, channels, rate) {
+		var stream = Module.streams[handle];
+		stream['audioFormat'] = {
 			'channels': channels,
 			'rate': rate
 		};
 	},
 
-	ogvjs_callback_loaded_metadata: function(videoCodecStr, audioCodecStr) {
+	ogvjs_callback_loaded_metadata: function(handle, videoCodecStr, audioCodecStr) {
+		var stream = Module.streams[handle];
 		function stringify(ptr) {
 			// Only works right on ASCII!
 			var str = "", heap = new Uint8Array(wasmMemory.buffer);
@@ -44,59 +47,56 @@ mergeInto(LibraryManager.library, {
 		}
 
 		if (videoCodecStr) {
-			Module['videoCodec'] = stringify(videoCodecStr);
+			stream['videoCodec'] = stringify(videoCodecStr);
 		}
 		if (audioCodecStr) {
-			Module['audioCodec'] = stringify(audioCodecStr);
+			stream['audioCodec'] = stringify(audioCodecStr);
 		}
 
-		var len = Module['_ogv_demuxer_media_duration']();
+		var len = Module['_ogv_demuxer_media_duration'](handle);
 		if (len >= 0) {
-			Module['duration'] = len;
+			stream['duration'] = len;
 		} else {
-			Module['duration'] = NaN;
+			stream['duration'] = NaN;
 		}
 
-		Module['loadedMetadata'] = true;
+		stream['loadedMetadata'] = true;
 	},
 
-	ogvjs_callback_video_packet: function(buffer, len, frameTimestamp, keyframeTimestamp, isKeyframe) {
-		// Note IE 10 doesn't have ArrayBuffer.slice
-		var heap = wasmMemory.buffer;
-		Module['videoPackets'].push({
-			'data': heap.slice
-				? heap.slice(buffer, buffer + len)
-				: (new Uint8Array(new Uint8Array(heap, buffer, len))).buffer,
+	ogvjs_callback_video_packet: function(handle, buffer, len, frameTimestamp, keyframeTimestamp, isKeyframe) {
+		var stream = Module.streams[handle];
+		stream['videoPackets'].push({
+			'data': Module.copyPacket(stream['videoArena'], buffer, len),
 			'timestamp': frameTimestamp,
 			'keyframeTimestamp': keyframeTimestamp,
 			'isKeyframe': !!isKeyframe
 		});
 	},
 
-	ogvjs_callback_audio_packet: function(buffer, len, audioTimestamp, discardPadding) {
-		// Note IE 10 doesn't have ArrayBuffer.slice
-		var heap = wasmMemory.buffer;
-		Module['audioPackets'].push({
-			'data': heap.slice
-				? heap.slice(buffer, buffer + len)
-				: (new Uint8Array(new Uint8Array(heap, buffer, len))).buffer,
+	ogvjs_callback_audio_packet: function(handle, buffer, len, audioTimestamp, discardPadding) {
+		var stream = Module.streams[handle];
+		stream['audioPackets'].push({
+			'data': Module.copyPacket(stream['audioArena'], buffer, len),
 			'timestamp': audioTimestamp,
 			'discardPadding': discardPadding
 		});
 	},
 
-	ogvjs_callback_frame_ready: function() {
-		return (Module['videoPackets'].length > 0) ? 1 : 0;
+	ogvjs_callback_frame_ready: function(handle) {
+		var stream = Module.streams[handle];
+		return (stream['videoPackets'].length > 0) ? 1 : 0;
 	},
 
-	ogvjs_callback_audio_ready: function() {
-		return (Module['audioPackets'].length > 0) ? 1 : 0;
+	ogvjs_callback_audio_ready: function(handle) {
+		var stream = Module.streams[handle];
+		return (stream['audioPackets'].length > 0) ? 1 : 0;
 	},
 
-	ogvjs_callback_seek: function(offsetLow, offsetHigh) {
+	ogvjs_callback_seek: function(handle, offsetLow, offsetHigh) {
+		var stream = Module.streams[handle];
 		var offset = offsetLow + offsetHigh * 0x100000000;
-		if (Module['onseek']) {
-			Module['onseek'](offset);
+		if (stream['onseek']) {
+			stream['onseek'](offset);
 		}
 	}
 
@@ -23,215 +23,336 @@ if (typeof performance === 'undefined' || typeof performance.now === 'undefined'
 } else {
 	getTimestamp = performance.now.bind(performance);
 }
-function time(func) {
-	var start = getTimestamp(),
-		ret;
-	ret = func();
-	var delta = (getTimestamp() - start);
-	Module['cpuTime'] += delta;
-	//console.log('demux time ' + delta);
-	return ret;
-}
-
-// - Properties
-
-Module['loadedMetadata'] = false;
-Module['videoCodec'] = null;
-Module['audioCodec'] = null;
-Module['duration'] = NaN;
-Module['onseek'] = null;
-Module['cpuTime'] = 0;
 
-Module['audioPackets'] = [];
-Object.defineProperty(Module, 'hasAudio', {
-	get: function() {
-		return Module['loadedMetadata'] && Module['audioCodec'];
-	}
-});
-Object.defineProperty(Module, 'audioReady', {
-	get: function() {
-		return Module['audioPackets'].length > 0;
-	}
-});
-Object.defineProperty(Module, 'audioTimestamp', {
-	get: function() {
-		if (Module['audioPackets'].length > 0) {
-			return Module['audioPackets'][0]['timestamp'];
-		} else {
-			return -1;
-		}
+/**
+ * Copy a packet out of the heap, into the given packet arena if there is
+ * one with room for it, or into a fresh ArrayBuffer otherwise.
+ */
+Module.copyPacket = function(arena, buffer, len) {
+	var heap = wasmMemory.buffer;
+	var bytes = arena ? arena['alloc'](len) : null;
+	if (bytes) {
+		bytes.set(new Uint8Array(heap, buffer, len));
+		return bytes;
 	}
-});
+	// Note IE 10 doesn't have ArrayBuffer.slice
+	return heap.slice
+		? heap.slice(buffer, buffer + len)
+		: (new Uint8Array(new Uint8Array(heap, buffer, len))).buffer;
+};
 
-Module['videoPackets'] = [];
-Object.defineProperty(Module, 'hasVideo', {
-	get: function() {
-		return Module['loadedMetadata'] && Module['videoCodec'];
-	}
-});
-Object.defineProperty(Module, 'frameReady', {
-	get: function() {
-		return Module['videoPackets'].length > 0;
-	}
-});
-Object.defineProperty(Module, 'frameTimestamp', {
-	get: function() {
-		if (Module['videoPackets'].length > 0) {
-			return Module['videoPackets'][0]['timestamp'];
-		} else {
-			return -1;
-		}
-	}
-});
-Object.defineProperty(Module, 'keyframeTimestamp', {
-	get: function() {
-		if (Module['videoPackets'].length > 0) {
-			return Module['videoPackets'][0]['keyframeTimestamp'];
-		} else {
-			return -1;
-		}
-	}
-});
 /**
- * If we've seen a future keyframe in the queue, what is it?
- * @property number
+ * Drop queued packets, handing any arena space back.
  */
-Object.defineProperty(Module, 'nextKeyframeTimestamp', {
-	get: function() {
-		for (var i = 0; i < Module['videoPackets'].length; i++) {
-			var packet = Module['videoPackets'][i];
-			if (packet['isKeyframe']) {
-				return packet['timestamp'];
-			}
+function dropPackets(packets, arena) {
+	if (arena) {
+		for (var i = 0; i < packets.length; i++) {
+			arena['release'](packets[i]['data']);
 		}
-		return -1;
 	}
-});
+	packets.splice(0, packets.length);
+}
 
 /**
- * Are we in the middle of an asynchronous processing operation?
- * @property boolean
+ * Each stream has its own demuxer state on the C side, all sharing this
+ * one module instance and its heap. The module itself is the default one.
  */
-Object.defineProperty(Module, 'processing', {
-	get: function getProcessing() {
-		return false;
-	}
-});
+Module.streams = {};
 
-Object.defineProperty(Module, 'seekable', {
-	get: function() {
-		return !!Module['_ogv_demuxer_seekable']();
+function setupStream(stream) {
+	stream.handle = 0;
+
+	function time(func) {
+		var start = getTimestamp(),
+			ret;
+		ret = func();
+		var delta = (getTimestamp() - start);
+		stream['cpuTime'] += delta;
+		//console.log('demux time ' + delta);
+		return ret;
 	}
-});
 
-// - public methods
+	// - Properties
+
+	stream['loadedMetadata'] = false;
+	stream['videoCodec'] = null;
+	stream['audioCodec'] = null;
+	stream['duration'] = NaN;
+	stream['onseek'] = null;
+	stream['cpuTime'] = 0;
+
+	/**
+	 * Optional packet arenas (see OGVPacketArena) to write packets into
+	 * instead of slicing each one out of the heap into its own buffer.
+	 * Whoever dequeues a packet is responsible for releasing it.
+	 */
+	stream['videoArena'] = null;
+	stream['audioArena'] = null;
 
-Module['init'] = function(callback) {
-	time(function() {
-		Module['_ogv_demuxer_init']();
+	stream['audioPackets'] = [];
+	Object.defineProperty(stream, 'hasAudio', {
+		get: function() {
+			return stream['loadedMetadata'] && stream['audioCodec'];
+		}
+	});
+	Object.defineProperty(stream, 'audioReady', {
+		get: function() {
+			return stream['audioPackets'].length > 0;
+		}
+	});
+	Object.defineProperty(stream, 'audioTimestamp', {
+		get: function() {
+			if (stream['audioPackets'].length > 0) {
+				return stream['audioPackets'][0]['timestamp'];
+			} else {
+				return -1;
+			}
+		}
 	});
-	callback();
-};
 
-/**
- * Queue up some data for later processing...
- *
- * @param ArrayBuffer data
- * @param function callback on completion
- */
-Module['receiveInput'] = function(data, callback) {
-	var ret = time(function() {
-		// Map the ArrayBuffer into emscripten's runtime heap
-		var len = data.byteLength;
-		var buffer = reallocInputBuffer(len);
-		var dest = new Uint8Array(wasmMemory.buffer, buffer, len);
-		dest.set(new Uint8Array(data));
-		Module['_ogv_demuxer_receive_input'](buffer, len);
+	stream['videoPackets'] = [];
+	Object.defineProperty(stream, 'hasVideo', {
+		get: function() {
+			return stream['loadedMetadata'] && stream['videoCodec'];
+		}
+	});
+	Object.defineProperty(stream, 'frameReady', {
+		get: function() {
+			return stream['videoPackets'].length > 0;
+		}
+	});
+	Object.defineProperty(stream, 'frameTimestamp', {
+		get: function() {
+			if (stream['videoPackets'].length > 0) {
+				return stream['videoPackets'][0]['timestamp'];
+			} else {
+				return -1;
+			}
+		}
+	});
+	Object.defineProperty(stream, 'keyframeTimestamp', {
+		get: function() {
+			if (stream['videoPackets'].length > 0) {
+				return stream['videoPackets'][0]['keyframeTimestamp'];
+			} else {
+				return -1;
+			}
+		}
+	});
+	/**
+	 * If we've seen a future keyframe in the queue, what is it?
+	 * @property number
+	 */
+	Object.defineProperty(stream, 'nextKeyframeTimestamp', {
+		get: function() {
+			for (var i = 0; i < stream['videoPackets'].length; i++) {
+				var packet = stream['videoPackets'][i];
+				if (packet['isKeyframe']) {
+					return packet['timestamp'];
+				}
+			}
+			return -1;
+		}
 	});
-	callback();
-};
 
-/**
- * Process previously queued data into packets.
- *
- * 'more' parameter to callback function is 'true' if there
- * are more packets to be processed in the queued data,
- * or 'false' if there aren't.
- *
- * @param function callback on completion
- */
-Module['process'] = function(callback) {
-	var ret = time(function() {
-		return Module['_ogv_demuxer_process']();
+	/**
+	 * Are we in the middle of an asynchronous processing operation?
+	 * @property boolean
+	 */
+	Object.defineProperty(stream, 'processing', {
+		get: function getProcessing() {
+			return false;
+		}
 	});
-	callback(!!ret);
-};
 
-Module['dequeueVideoPacket'] = function(callback) {
-	if (Module['videoPackets'].length) {
-		var packet = Module['videoPackets'].shift()['data'];
-		callback(packet);
-	} else {
-		callback(null);
-	}
-};
+	Object.defineProperty(stream, 'seekable', {
+		get: function() {
+			return !!Module['_ogv_demuxer_seekable'](stream.handle);
+		}
+	});
 
-Module['dequeueAudioPacket'] = function(callback) {
-	if (Module['audioPackets'].length) {
-		var packet = Module['audioPackets'].shift();
-		callback(packet['data'], packet['discardPadding']);
-	} else {
-		callback(null);
-	}
-};
+	// - public methods
 
-/**
- * Return the offset of the relevant keyframe or other position
- * just before the given presentation timestamp
- *
- * @param number timeSeconds
- * @param function callback
- *        takes the calculated byte offset as a Number
- */
-Module['getKeypointOffset'] = function(timeSeconds, callback) {
-	var offset = time(function() {
-		return Module['_ogv_demuxer_keypoint_offset'](timeSeconds * 1000);
-	});
-	callback(offset);
-};
+	stream['init'] = function(callback) {
+		time(function() {
+			stream.handle = Module['_ogv_demuxer_create']();
+			Module.streams[stream.handle] = stream;
+		});
+		callback();
+	};
 
-/**
- * Initiate seek to the nearest keyframe or other position just before
- * the given presentation timestamp. This may trigger seek requests, and
- * it may take some time before processing returns more packets.
- *
- * @param number timeSeconds
- * @param function callback
- *        boolean param indicates whether seeking was initiated or not.
- */
-Module['seekToKeypoint'] = function(timeSeconds, callback) {
-	var ret = time(function() {
-		return Module['_ogv_demuxer_seek_to_keypoint'](timeSeconds * 1000);
-	});
-	if (ret) {
-		Module['audioPackets'].splice(0, Module['audioPackets'].length);
-		Module['videoPackets'].splice(0, Module['videoPackets'].length);
-	}
-	callback(!!ret);
-};
+	/**
+	 * Queue up some data for later processing...
+	 *
+	 * @param ArrayBuffer data
+	 * @param function callback on completion
+	 */
+	stream['receiveInput'] = function(data, callback) {
+		var ret = time(function() {
+			// Map the ArrayBuffer into emscripten's runtime heap
+			var len = data.byteLength;
+			var buffer = reallocInputBuffer(len);
+			var dest = new Uint8Array(wasmMemory.buffer, buffer, len);
+			dest.set(new Uint8Array(data));
+			Module['_ogv_demuxer_receive_input'](stream.handle, buffer, len);
+		});
+		callback();
+	};
 
-Module['flush'] = function(callback) {
-	time(function() {
-		Module['audioPackets'].splice(0, Module['audioPackets'].length);
-		Module['videoPackets'].splice(0, Module['videoPackets'].length);
-		Module['_ogv_demuxer_flush']();
-	});
-	callback();
-};
+	/**
+	 * Mark the end of a cached init segment: input from here on comes
+	 * from partway through a live stream. The demuxer picks up at the
+	 * next cluster or page, and starts video at the first keyframe.
+	 *
+	 * @param function callback on completion
+	 */
+	stream['resync'] = function(callback) {
+		time(function() {
+			Module['_ogv_demuxer_resync'](stream.handle);
+		});
+		callback();
+	};
+
+	/**
+	 * Process previously queued data into packets.
+	 *
+	 * 'more' parameter to callback function is 'true' if there
+	 * are more packets to be processed in the queued data,
+	 * or 'false' if there aren't.
+	 *
+	 * @param function callback on completion
+	 */
+	stream['process'] = function(callback) {
+		var ret = time(function() {
+			return Module['_ogv_demuxer_process'](stream.handle);
+		});
+		callback(!!ret);
+	};
+
+	stream['dequeueVideoPacket'] = function(callback) {
+		if (stream['videoPackets'].length) {
+			var packet = stream['videoPackets'].shift()['data'];
+			callback(packet);
+		} else {
+			callback(null);
+		}
+	};
+
+	stream['dequeueAudioPacket'] = function(callback) {
+		if (stream['audioPackets'].length) {
+			var packet = stream['audioPackets'].shift();
+			callback(packet['data'], packet['discardPadding']);
+		} else {
+			callback(null);
+		}
+	};
+
+	/**
+	 * Return the offset of the relevant keyframe or other position
+	 * just before the given presentation timestamp
+	 *
+	 * @param number timeSeconds
+	 * @param function callback
+	 *        takes the calculated byte offset as a Number
+	 */
+	stream['getKeypointOffset'] = function(timeSeconds, callback) {
+		var offset = time(function() {
+			return Module['_ogv_demuxer_keypoint_offset'](stream.handle, timeSeconds * 1000);
+		});
+		callback(offset);
+	};
+
+	/**
+	 * Initiate seek to the nearest keyframe or other position just before
+	 * the given presentation timestamp. This may trigger seek requests, and
+	 * it may take some time before processing returns more packets.
+	 *
+	 * @param number timeSeconds
+	 * @param function callback
+	 *        boolean param indicates whether seeking was initiated or not.
+	 */
+	stream['seekToKeypoint'] = function(timeSeconds, callback) {
+		var ret = time(function() {
+			return Module['_ogv_demuxer_seek_to_keypoint'](stream.handle, timeSeconds * 1000);
+		});
+		if (ret) {
+			dropPackets(stream['audioPackets'], stream['audioArena']);
+			dropPackets(stream['videoPackets'], stream['videoArena']);
+		}
+		callback(!!ret);
+	};
+
+	/**
+	 * Export the seek index built up so far, for loading in a later session.
+	 *
+	 * @param function callback
+	 *        takes an ArrayBuffer, or null if there's no index to export
+	 */
+	stream['exportSeekIndex'] = function(callback) {
+		var data = time(function() {
+			var len = Module['_ogv_demuxer_index_size'](stream.handle);
+			if (!len) {
+				return null;
+			}
+			var buffer = Module['_malloc'](len);
+			Module['_ogv_demuxer_index_export'](stream.handle, buffer);
+			var data = new Uint8Array(wasmMemory.buffer, buffer, len).slice().buffer;
+			Module['_free'](buffer);
+			return data;
+		});
+		callback(data);
+	};
+
+	/**
+	 * Merge in a seek index from exportSeekIndex or a server-side pre-pass,
+	 * letting getKeypointOffset answer for ranges we haven't read yet.
+	 *
+	 * @param ArrayBuffer data
+	 * @param function callback
+	 *        boolean param indicates whether the index was accepted
+	 */
+	stream['importSeekIndex'] = function(data, callback) {
+		var ret = time(function() {
+			var len = data.byteLength;
+			var buffer = reallocInputBuffer(len);
+			var dest = new Uint8Array(wasmMemory.buffer, buffer, len);
+			dest.set(new Uint8Array(data));
+			return Module['_ogv_demuxer_index_import'](stream.handle, buffer, len);
+		});
+		callback(!!ret);
+	};
+
+	stream['flush'] = function(callback) {
+		time(function() {
+			dropPackets(stream['audioPackets'], stream['audioArena']);
+			dropPackets(stream['videoPackets'], stream['videoArena']);
+			Module['_ogv_demuxer_flush'](stream.handle);
+		});
+		callback();
+	};
+
+	/**
+	 * Close out any resources required by the demuxer module
+	 */
+	stream['close'] = function() {
+		if (stream.handle) {
+			Module['_ogv_demuxer_destroy'](stream.handle);
+			delete Module.streams[stream.handle];
+			stream.handle = 0;
+		}
+	};
+
+	return stream;
+}
+
+setupStream(Module);
 
 /**
- * Close out any resources required by the demuxer module
+ * Set up another demuxer in the same module instance, with the same
+ * interface as the module itself.
+ *
+ * @returns object
  */
-Module['close'] = function() {
-	// no-op
+Module['createStream'] = function() {
+	return setupStream({});
 };